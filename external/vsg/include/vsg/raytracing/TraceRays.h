@@ -15,6 +15,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/commands/Command.h>
 #include <vsg/raytracing/RayTracingShaderGroup.h>
 #include <vsg/raytracing/RayTracingShaderBindingTable.h>
+#include <vsg/state/Buffer.h>
 
 namespace vsg
 {
@@ -31,6 +32,11 @@ namespace vsg
         uint32_t width = 0;
         uint32_t height = 0;
         uint32_t depth = 0;
+
+        /// if set the dimensions are read from a VkTraceRaysIndirectCommandKHR in this buffer instead, requires
+        /// VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT and VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+        ref_ptr<Buffer> indirectBuffer;
+        VkDeviceSize indirectOffset = 0;
     };
 
 } // namespace vsg
@@ -54,6 +54,10 @@ namespace vsg
 
         ref_ptr<Queue> getQueue(uint32_t queueFamilyIndex, uint32_t queueIndex = 0);
 
+        /// VkPipelineCache passed to the creation of graphics, compute and ray tracing pipelines on this device.
+        /// Not owned by the Device, the application has to keep it valid while pipelines are compiled.
+        VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+
     protected:
         virtual ~Device();
 
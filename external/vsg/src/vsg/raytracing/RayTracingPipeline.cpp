@@ -151,7 +151,7 @@ RayTracingPipeline::Implementation::Implementation(Context& context, RayTracingP
 
     pipelineInfo.maxPipelineRayRecursionDepth = rayTracingPipeline->maxRecursionDepth();
 
-    VkResult result = extensions->vkCreateRayTracingPipelinesKHR(*_device, VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &pipelineInfo, _device->getAllocationCallbacks(), &_pipeline);
+    VkResult result = extensions->vkCreateRayTracingPipelinesKHR(*_device, VK_NULL_HANDLE, _device->pipelineCache, 1, &pipelineInfo, _device->getAllocationCallbacks(), &_pipeline);
     if (result == VK_SUCCESS)
     {
         rayTracingPipeline->_bindingTable->pipeline = _pipeline;
@@ -47,6 +47,21 @@ void TraceRays::record(CommandBuffer& commandBuffer) const
     auto hitShaderBindingTable = stridedDeviceAddress(bindingTable->bindingTable[2]);
     auto callableShaderBindingTable = stridedDeviceAddress(bindingTable->bindingTable[3]);
 
+    if (indirectBuffer)
+    {
+        VkBufferDeviceAddressInfo info{};
+        info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+        info.buffer = indirectBuffer->vk(device->deviceID);
+        extensions->vkCmdTraceRaysIndirectKHR(
+            commandBuffer,
+            &raygenShaderBindingTable,
+            &missShaderBindingTable,
+            &hitShaderBindingTable,
+            &callableShaderBindingTable,
+            extensions->vkGetBufferDeviceAddressKHR(device->getDevice(), &info) + indirectOffset);
+        return;
+    }
+
     extensions->vkCmdTraceRaysKHR(
         commandBuffer,
         &raygenShaderBindingTable,
@@ -178,7 +178,7 @@ GraphicsPipeline::Implementation::Implementation(Context& context, Device* devic
         pipelineState->apply(context, pipelineInfo);
     }
 
-    VkResult result = vkCreateGraphicsPipelines(*device, VK_NULL_HANDLE, 1, &pipelineInfo, _device->getAllocationCallbacks(), &_pipeline);
+    VkResult result = vkCreateGraphicsPipelines(*device, device->pipelineCache, 1, &pipelineInfo, _device->getAllocationCallbacks(), &_pipeline);
 
     context.scratchMemory->release();
 
@@ -54,6 +54,7 @@ namespace vsgXchange
         static constexpr const char* generate_sharp_normals = "generate_sharp_normals";
         static constexpr const char* crease_angle = "crease_angle"; /// float
         static constexpr const char* two_sided = "two_sided"; ///  bool
+        static constexpr const char* texture_cache = "texture_cache"; /// std::string, directory of the block compressed texture cache
 
         bool readOptions(vsg::Options& options, vsg::CommandLine& arguments) const override;
 
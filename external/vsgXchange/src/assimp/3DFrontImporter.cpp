@@ -12,6 +12,9 @@
 #include <algorithm>
 #include <filesystem>
 #include <cstring>
+#include <cctype>
+#include <cstdlib>
+#include <charconv>
 
 
 namespace fs = std::filesystem;
@@ -59,6 +62,222 @@ static void DeepCopyAiMesh(aiMesh* source, aiMesh*& target)
     // TODO: copy remaining data
 }
 
+// sometimes vertex data is stored as string instead of floats in the json
+static float ParseFloat(const std::string& str)
+{
+    const char* begin = str.data();
+    const char* end = begin + str.size();
+    while (begin != end && std::isspace(static_cast<unsigned char>(*begin)))
+    {
+        ++begin;
+    }
+    if (begin != end && *begin == '+')
+    {
+        ++begin;
+    }
+    float value = 0.0f;
+#if defined(__cpp_lib_to_chars)
+    auto [ptr, error] = std::from_chars(begin, end, value);
+    if (error != std::errc())
+    {
+        throw DeadlyImportError("Failed to parse number \"" + str + "\".");
+    }
+#else
+    char* parse_end = nullptr;
+    value = std::strtof(begin, &parse_end);
+    if (parse_end == begin)
+    {
+        throw DeadlyImportError("Failed to parse number \"" + str + "\".");
+    }
+#endif
+    return value;
+}
+
+/*
+ * Sax handler which builds the json dom of a 3D-FRONT scene file, except for the vertex and index arrays
+ * of the room meshes. Those make up most of the file and are written straight into flat arrays instead,
+ * which avoids creating a json value per number.
+ */
+class SceneJsonSaxHandler : public nlohmann::json_sax<nlohmann::json>
+{
+public:
+    SceneJsonSaxHandler(nlohmann::json& root, std::vector<AI3DFrontImporter::RawMeshArrays>& raw_mesh_arrays)
+        : _root(root), _raw_mesh_arrays(raw_mesh_arrays)
+    {
+    }
+
+    bool null() override
+    {
+        HandleValue(nullptr);
+        return true;
+    }
+    bool boolean(bool val) override
+    {
+        HandleValue(val);
+        return true;
+    }
+    bool number_integer(number_integer_t val) override
+    {
+        if (_float_target != nullptr || _index_target != nullptr)
+        {
+            return StreamNumber(val);
+        }
+        HandleValue(val);
+        return true;
+    }
+    bool number_unsigned(number_unsigned_t val) override
+    {
+        if (_float_target != nullptr || _index_target != nullptr)
+        {
+            return StreamNumber(val);
+        }
+        HandleValue(val);
+        return true;
+    }
+    bool number_float(number_float_t val, const string_t& s) override
+    {
+        if (_float_target != nullptr || _index_target != nullptr)
+        {
+            return StreamNumber(val);
+        }
+        HandleValue(val);
+        return true;
+    }
+    bool string(string_t& val) override
+    {
+        if (_float_target != nullptr)
+        {
+            _float_target->push_back(ParseFloat(val));
+            return true;
+        }
+        if (_index_target != nullptr)
+        {
+            _index_target->push_back(static_cast<uint32_t>(ParseFloat(val)));
+            return true;
+        }
+        HandleValue(val);
+        return true;
+    }
+    bool binary(binary_t& val) override
+    {
+        HandleValue(std::move(val));
+        return true;
+    }
+    bool start_object(std::size_t elements) override
+    {
+        _ref_stack.push_back(HandleValue(nlohmann::json::value_t::object));
+        return true;
+    }
+    bool key(string_t& val) override
+    {
+        _current_key = val;
+        _object_element = &(*_ref_stack.back())[val];
+        return true;
+    }
+    bool end_object() override
+    {
+        _ref_stack.pop_back();
+        return true;
+    }
+    bool start_array(std::size_t elements) override
+    {
+        // root -> "mesh" -> mesh object -> vertex or index array
+        if (_ref_stack.size() == 3 && _ref_stack[1] == _mesh_list && _ref_stack.back()->is_object())
+        {
+            auto& raw_arrays = _raw_mesh_arrays.back();
+            if (_current_key == "xyz")
+            {
+                _float_target = &raw_arrays.positions;
+            }
+            else if (_current_key == "normal")
+            {
+                _float_target = &raw_arrays.normals;
+            }
+            else if (_current_key == "uv")
+            {
+                _float_target = &raw_arrays.tex_coords;
+            }
+            else if (_current_key == "faces")
+            {
+                _index_target = &raw_arrays.indices;
+            }
+            if (_float_target != nullptr || _index_target != nullptr)
+            {
+                // keep an empty array in the dom so that the structure of the mesh is unchanged
+                *_object_element = nlohmann::json::array();
+                return true;
+            }
+        }
+        bool is_mesh_list = _ref_stack.size() == 1 && _current_key == "mesh";
+        _ref_stack.push_back(HandleValue(nlohmann::json::value_t::array));
+        if (is_mesh_list)
+        {
+            _mesh_list = _ref_stack.back();
+        }
+        return true;
+    }
+    bool end_array() override
+    {
+        if (_float_target != nullptr || _index_target != nullptr)
+        {
+            _float_target = nullptr;
+            _index_target = nullptr;
+            return true;
+        }
+        _ref_stack.pop_back();
+        return true;
+    }
+    bool parse_error(std::size_t position, const std::string& last_token,
+                     const nlohmann::detail::exception& ex) override
+    {
+        throw DeadlyImportError("Failed to parse 3D-FRONT scene: " + std::string(ex.what()));
+    }
+
+private:
+    template<typename Value>
+    nlohmann::json* HandleValue(Value&& value)
+    {
+        if (_ref_stack.empty())
+        {
+            _root = nlohmann::json(std::forward<Value>(value));
+            return &_root;
+        }
+        if (_ref_stack.back()->is_array())
+        {
+            _ref_stack.back()->emplace_back(std::forward<Value>(value));
+            if (_ref_stack.back() == _mesh_list)
+            {
+                _raw_mesh_arrays.emplace_back();
+            }
+            return &_ref_stack.back()->back();
+        }
+        *_object_element = nlohmann::json(std::forward<Value>(value));
+        return _object_element;
+    }
+    template<typename Number>
+    bool StreamNumber(Number value)
+    {
+        if (_float_target != nullptr)
+        {
+            _float_target->push_back(static_cast<float>(value));
+        }
+        else
+        {
+            _index_target->push_back(static_cast<uint32_t>(value));
+        }
+        return true;
+    }
+
+    nlohmann::json& _root;
+    std::vector<AI3DFrontImporter::RawMeshArrays>& _raw_mesh_arrays;
+    std::vector<nlohmann::json*> _ref_stack;
+    nlohmann::json* _object_element = nullptr;
+    nlohmann::json* _mesh_list = nullptr;
+    std::string _current_key;
+    std::vector<float>* _float_target = nullptr;
+    std::vector<uint32_t>* _index_target = nullptr;
+};
+
 float AI3DFrontImporter::ceiling_light_strength = 0.8f;
 float AI3DFrontImporter::lamp_light_strength = 7.0f;
 std::unordered_map<std::string, uint32_t> AI3DFrontImporter::category_to_id_map;
@@ -127,7 +346,9 @@ void AI3DFrontImporter::InternReadFile(const std::string& pFile, aiScene* pScene
         throw DeadlyImportError("Failed to open file " + pFile + ".");
     }
     nlohmann::json scene_json;
-    scene_file >> scene_json;
+    std::vector<RawMeshArrays> raw_mesh_arrays;
+    SceneJsonSaxHandler sax_handler(scene_json, raw_mesh_arrays);
+    nlohmann::json::sax_parse(scene_file, &sax_handler);
 
     std::vector<fs::path> furniture_directories;
     std::vector<fs::path> texture_directories;
@@ -140,7 +361,7 @@ void AI3DFrontImporter::InternReadFile(const std::string& pFile, aiScene* pScene
     LoadMaterials(texture_directories, scene_json, pScene, material_id_to_index_map, material_uv_rotations);
 
     std::unordered_map<std::string, std::vector<uint32_t>> model_uid_to_mesh_indices_map;
-    LoadMeshes(scene_json, material_id_to_index_map, material_uv_rotations, pScene, model_uid_to_mesh_indices_map);
+    LoadMeshes(scene_json, raw_mesh_arrays, material_id_to_index_map, material_uv_rotations, pScene, model_uid_to_mesh_indices_map);
 
     // load furniture
     Assimp::Importer importer;
@@ -424,7 +645,7 @@ void AI3DFrontImporter::LoadMaterials(const std::vector<std::filesystem::path>&
         }
     }
 }
-void AI3DFrontImporter::LoadMeshes(const nlohmann::json& scene_json,
+void AI3DFrontImporter::LoadMeshes(const nlohmann::json& scene_json, const std::vector<RawMeshArrays>& raw_mesh_arrays,
                                    const std::unordered_map<std::string, uint32_t>& material_id_to_index_map,
                                    const std::vector<float>& material_uv_rotations, aiScene* pScene,
                                    std::unordered_map<std::string, std::vector<uint32_t>>& model_uid_to_mesh_indices_map)
@@ -448,9 +669,12 @@ void AI3DFrontImporter::LoadMeshes(const nlohmann::json& scene_json,
 
             aiMaterial* material = pScene->mMaterials[ai_mesh->mMaterialIndex];
             aiUVTransform ai_uv_transform;
-            if (material->Get(AI_MATKEY_UVTRANSFORM_DIFFUSE(0), ai_uv_transform) == AI_SUCCESS)
+            bool has_uv_transform = material->Get(AI_MATKEY_UVTRANSFORM_DIFFUSE(0), ai_uv_transform) == AI_SUCCESS;
+            aiMatrix3x3 uv_rotation_matrix;
+            if (has_uv_transform)
             {
                 ai_uv_transform.mRotation = material_uv_rotations[ai_mesh->mMaterialIndex];
+                aiMatrix3x3::RotationZ(ai_uv_transform.mRotation, uv_rotation_matrix);
             }
             auto obj_type = std::string(raw_mesh["type"]);
             std::transform(obj_type.begin(), obj_type.end(), obj_type.begin(),
@@ -470,98 +694,57 @@ void AI3DFrontImporter::LoadMeshes(const nlohmann::json& scene_json,
             }
             material->AddProperty(&category_id, 1, AI_MATKEY_CATEGORY_ID);
 
-            // parse vertices, normals and tex coords
-            const auto& raw_vertices = raw_mesh["xyz"];
-            ai_mesh->mNumVertices = raw_vertices.size() / 3;
+            // vertices, normals and tex coords were already parsed by the sax handler
+            const auto& raw_arrays = raw_mesh_arrays[mesh_index];
+            ai_mesh->mNumVertices = raw_arrays.positions.size() / 3;
             if (ai_mesh->mNumVertices > 0)
             {
-                const auto& raw_normals = raw_mesh["normal"];
-                const auto& raw_tex_coords = raw_mesh["uv"];
-
+                if (raw_arrays.normals.size() < raw_arrays.positions.size() ||
+                    raw_arrays.tex_coords.size() < ai_mesh->mNumVertices * 2)
+                {
+                    throw DeadlyImportError("Mesh " + std::string(raw_mesh["uid"]) + " has incomplete vertex data.");
+                }
                 ai_mesh->mVertices = new aiVector3D[ai_mesh->mNumVertices];
                 ai_mesh->mNormals = new aiVector3D[ai_mesh->mNumVertices];
                 ai_mesh->mTextureCoords[0] = new aiVector3D[ai_mesh->mNumVertices];
-                for (int i = 0; i < ai_mesh->mNumVertices; i++)
+                const float* positions = raw_arrays.positions.data();
+                const float* normals = raw_arrays.normals.data();
+                const float* tex_coords = raw_arrays.tex_coords.data();
+                for (uint32_t i = 0; i < ai_mesh->mNumVertices; i++)
                 {
-                    int x_index = i * 3;
-                    int y_index = x_index + 1;
-                    int z_index = x_index + 2;
-                    int u_index = i * 2;
-                    int v_index = u_index + 1;
-
-                    // sometimes vertex data is stored as string instead of floats in the json
-                    if (raw_vertices[x_index].is_string())
-                    {
-                        ai_mesh->mVertices[i] = aiVector3D(
-                            std::stof(std::string(raw_vertices[x_index])),
-                            std::stof(std::string(raw_vertices[y_index])),
-                            std::stof(std::string(raw_vertices[z_index]))
-                        );
-                    }
-                    else
-                    {
-                        ai_mesh->mVertices[i] = aiVector3D(raw_vertices[x_index], raw_vertices[y_index], raw_vertices[z_index]);
-                    }
-                    if (raw_normals[x_index].is_string())
-                    {
-                        ai_mesh->mNormals[i] = aiVector3D(
-                            std::stof(std::string(raw_normals[x_index])),
-                            std::stof(std::string(raw_normals[y_index])),
-                            std::stof(std::string(raw_normals[z_index]))
-                        );
-                    }
-                    else
-                    {
-                        ai_mesh->mNormals[i] = aiVector3D(raw_normals[x_index], raw_normals[y_index], raw_normals[z_index]);
-                    }
-                    if (raw_tex_coords[u_index].is_string())
-                    {
-                        ai_mesh->mTextureCoords[0][i] = aiVector3D(
-                            std::stof(std::string(raw_normals[u_index])),
-                            std::stof(std::string(raw_tex_coords[v_index])),
-                            0
-                        );
-                    }
-                    else
-                    {
-                        ai_mesh->mTextureCoords[0][i] = aiVector3D(raw_tex_coords[u_index], raw_tex_coords[v_index], 0);
-                    }
                     // small offset to prevent z-fighting with objects on the floor
-                    ai_mesh->mVertices[i].y += 0.0001;
-
-                    // transform uv coords based on material
-                    if (material->Get(AI_MATKEY_UVTRANSFORM_DIFFUSE(0), ai_uv_transform) == AI_SUCCESS)
+                    ai_mesh->mVertices[i] = aiVector3D(positions[i * 3], positions[i * 3 + 1] + 0.0001f, positions[i * 3 + 2]);
+                    ai_mesh->mNormals[i] = aiVector3D(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]);
+                    ai_mesh->mTextureCoords[0][i] = aiVector3D(tex_coords[i * 2], tex_coords[i * 2 + 1], 0);
+                }
+                // transform uv coords based on material
+                if (has_uv_transform)
+                {
+                    for (uint32_t i = 0; i < ai_mesh->mNumVertices; i++)
                     {
                         auto& tex_coord = ai_mesh->mTextureCoords[0][i];
                         tex_coord.x *= ai_uv_transform.mScaling.x;
                         tex_coord.y *= ai_uv_transform.mScaling.y;
-                        aiMatrix3x3 rotation_matrix;
-                        aiMatrix3x3::RotationZ(ai_uv_transform.mRotation, rotation_matrix);
-                        tex_coord = rotation_matrix * tex_coord;
+                        tex_coord = uv_rotation_matrix * tex_coord;
                         tex_coord.x += ai_uv_transform.mTranslation.x;
                         tex_coord.y += ai_uv_transform.mTranslation.y;
                     }
                 }
             }
             // parse indices
-            const auto& raw_indices = raw_mesh["faces"];
+            const auto& raw_indices = raw_arrays.indices;
             ai_mesh->mNumFaces = raw_indices.size() / 3;
             if (ai_mesh->mNumFaces > 0)
             {
                 ai_mesh->mFaces = new aiFace[ai_mesh->mNumFaces];
-                for (int i = 0; i < ai_mesh->mNumFaces; i++)
+                for (uint32_t i = 0; i < ai_mesh->mNumFaces; i++)
                 {
-                    int index_0 = i * 3;
-                    int index_1 = index_0 + 1;
-                    int index_2 = index_0 + 2;
-
-                    ai_mesh->mFaces[i] = aiFace();
                     auto& face = ai_mesh->mFaces[i];
                     face.mNumIndices = 3;
                     face.mIndices = new unsigned int[3];
-                    face.mIndices[0] = raw_indices[index_2];
-                    face.mIndices[1] = raw_indices[index_1];
-                    face.mIndices[2] = raw_indices[index_0];
+                    face.mIndices[0] = raw_indices[i * 3 + 2];
+                    face.mIndices[1] = raw_indices[i * 3 + 1];
+                    face.mIndices[2] = raw_indices[i * 3];
                 }
             }
             model_uid_to_mesh_indices_map[raw_mesh["uid"]].push_back(mesh_index++);
@@ -5,6 +5,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <filesystem>
 
 #define AI_MATKEY_CATEGORY_ID "$mat.categoryid",0,0
@@ -19,6 +20,16 @@
 class AI3DFrontImporter : public Assimp::BaseImporter
 {
 public:
+    // flat vertex data of a single entry in the "mesh" list of the scene file
+    // the arrays are streamed out of the json while parsing and are not part of the json dom
+    struct RawMeshArrays
+    {
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> tex_coords;
+        std::vector<uint32_t> indices;
+    };
+
     static void ReadConfig(const nlohmann::json config_json);
     
     bool CanRead(const std::string& pFile, Assimp::IOSystem* pIOHandler, bool checkSig) const override;
@@ -31,7 +42,8 @@ private:
     std::unordered_map<std::string, std::string> LoadJidToCategoryMap(const std::vector<std::filesystem::path>& furniture_directories);
     void LoadMaterials(const std::vector<std::filesystem::path>& texture_directories, const nlohmann::json& scene_json, aiScene* pScene,
                        std::unordered_map<std::string, uint32_t>& material_id_to_index_map, std::vector<float>& material_uv_rotations);
-    void LoadMeshes(const nlohmann::json& scene_json, const std::unordered_map<std::string, uint32_t>& material_id_to_index_map,
+    void LoadMeshes(const nlohmann::json& scene_json, const std::vector<RawMeshArrays>& raw_mesh_arrays,
+                    const std::unordered_map<std::string, uint32_t>& material_id_to_index_map,
                     const std::vector<float>& material_uv_rotations, aiScene* pScene,
                     std::unordered_map<std::string, std::vector<uint32_t>>& model_uid_to_mesh_indices_map);
 
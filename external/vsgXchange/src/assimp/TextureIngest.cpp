@@ -0,0 +1,509 @@
+#include "TextureIngest.h"
+
+#include <vsg/io/FileSystem.h>
+#include <vsg/io/read.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+using vsgXchange::TextureUsage;
+
+namespace
+{
+    // increase whenever the encoders or the file layout change to invalidate old cache entries
+    const uint32_t kIngestVersion = 1;
+
+    // alpha values below this are treated as transparent by the ray tracing scene visitor
+    const uint8_t kAlphaMaskThreshold = 3;
+
+    struct Image
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<vsg::ubvec4> texels;
+
+        const vsg::ubvec4& at(uint32_t x, uint32_t y) const
+        {
+            return texels[std::min(y, height - 1) * width + std::min(x, width - 1)];
+        }
+    };
+
+    bool isPowerOfTwo(uint32_t v) { return v != 0 && (v & (v - 1)) == 0; }
+
+    uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+    {
+        auto bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    float srgbToLinear(uint8_t value)
+    {
+        static const auto table = []() {
+            std::array<float, 256> t{};
+            for (int i = 0; i < 256; ++i)
+            {
+                float c = static_cast<float>(i) / 255.0f;
+                t[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return t;
+        }();
+        return table[value];
+    }
+
+    uint8_t linearToSrgb(float value)
+    {
+        value = std::clamp(value, 0.0f, 1.0f);
+        float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+        return static_cast<uint8_t>(std::lround(c * 255.0f));
+    }
+
+    uint8_t toUnorm(float value) { return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f)); }
+
+    // 2x2 box filter, sRGB color channels are decoded to linear space first and normals are renormalized
+    Image downsample(const Image& source, TextureUsage usage)
+    {
+        Image result;
+        result.width = std::max(source.width / 2, 1u);
+        result.height = std::max(source.height / 2, 1u);
+        result.texels.resize(result.width * result.height);
+        for (uint32_t y = 0; y < result.height; ++y)
+        {
+            for (uint32_t x = 0; x < result.width; ++x)
+            {
+                const vsg::ubvec4* texels[4] = {&source.at(x * 2, y * 2), &source.at(x * 2 + 1, y * 2),
+                                                &source.at(x * 2, y * 2 + 1), &source.at(x * 2 + 1, y * 2 + 1)};
+                vsg::vec4 sum;
+                for (auto texel : texels)
+                {
+                    if (usage == TextureUsage::Color)
+                    {
+                        sum += vsg::vec4(srgbToLinear(texel->r), srgbToLinear(texel->g), srgbToLinear(texel->b),
+                                         texel->a / 255.0f);
+                    }
+                    else
+                    {
+                        sum += vsg::vec4(texel->r, texel->g, texel->b, texel->a) / 255.0f;
+                    }
+                }
+                sum /= 4.0f;
+
+                auto& out = result.texels[y * result.width + x];
+                if (usage == TextureUsage::Color)
+                {
+                    out.set(linearToSrgb(sum.r), linearToSrgb(sum.g), linearToSrgb(sum.b), toUnorm(sum.a));
+                }
+                else if (usage == TextureUsage::Normal)
+                {
+                    vsg::vec3 n(sum.x * 2.0f - 1.0f, sum.y * 2.0f - 1.0f, sum.z * 2.0f - 1.0f);
+                    float length = vsg::length(n);
+                    n = length > 0.0f ? n / length : vsg::vec3(0.0f, 0.0f, 1.0f);
+                    out.set(toUnorm(n.x * 0.5f + 0.5f), toUnorm(n.y * 0.5f + 0.5f), toUnorm(n.z * 0.5f + 0.5f), 255);
+                }
+                else
+                {
+                    out.set(toUnorm(sum.r), toUnorm(sum.g), toUnorm(sum.b), toUnorm(sum.a));
+                }
+            }
+        }
+        return result;
+    }
+
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(uint8_t* block) :
+            _block(block) {}
+
+        void write(uint32_t value, uint32_t bitCount)
+        {
+            for (uint32_t i = 0; i < bitCount; ++i, ++_position)
+            {
+                if (value & (1u << i)) _block[_position / 8] |= static_cast<uint8_t>(1u << (_position % 8));
+            }
+        }
+
+    private:
+        uint8_t* _block;
+        uint32_t _position = 0;
+    };
+
+    // BC4: two 8 bit endpoints with 3 bit indices into 8 interpolated values
+    void encodeBC4Block(const uint8_t values[16], uint8_t* block)
+    {
+        uint8_t maxValue = *std::max_element(values, values + 16);
+        uint8_t minValue = *std::min_element(values, values + 16);
+
+        std::array<int, 8> palette{maxValue, minValue};
+        for (int i = 1; i < 7; ++i)
+        {
+            palette[i + 1] = ((7 - i) * maxValue + i * minValue + 3) / 7;
+        }
+
+        std::memset(block, 0, 8);
+        BitWriter writer(block);
+        writer.write(maxValue, 8);
+        writer.write(minValue, 8);
+        for (int i = 0; i < 16; ++i)
+        {
+            uint32_t best = 0;
+            int bestError = 256;
+            for (uint32_t p = 0; p < 8 && maxValue != minValue; ++p)
+            {
+                int error = std::abs(palette[p] - values[i]);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            writer.write(best, 3);
+        }
+    }
+
+    // BC7 mode 6: a single subset with 7.7.7.7 endpoints, one p-bit per endpoint and 4 bit indices
+    void encodeBC7Block(const vsg::ubvec4 texels[16], uint8_t* block)
+    {
+        static const int weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        // principal axis of the block colors
+        vsg::vec4 mean;
+        for (int i = 0; i < 16; ++i) mean += vsg::vec4(texels[i].r, texels[i].g, texels[i].b, texels[i].a);
+        mean /= 16.0f;
+        float covariance[4][4] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            vsg::vec4 d = vsg::vec4(texels[i].r, texels[i].g, texels[i].b, texels[i].a) - mean;
+            for (int r = 0; r < 4; ++r)
+                for (int c = 0; c < 4; ++c) covariance[r][c] += d[r] * d[c];
+        }
+        vsg::vec4 axis(1.0f, 1.0f, 1.0f, 1.0f);
+        for (int iteration = 0; iteration < 8; ++iteration)
+        {
+            vsg::vec4 next;
+            for (int r = 0; r < 4; ++r)
+                for (int c = 0; c < 4; ++c) next[r] += covariance[r][c] * axis[c];
+            float length = vsg::length(next);
+            if (length < 1e-6f) break;
+            axis = next / length;
+        }
+        float minT = 0.0f, maxT = 0.0f;
+        for (int i = 0; i < 16; ++i)
+        {
+            vsg::vec4 d = vsg::vec4(texels[i].r, texels[i].g, texels[i].b, texels[i].a) - mean;
+            float t = d.x * axis.x + d.y * axis.y + d.z * axis.z + d.w * axis.w;
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        vsg::vec4 endpoints[2] = {mean + axis * minT, mean + axis * maxT};
+
+        // quantize the endpoints to 7 bits plus the p-bit that fits best
+        std::array<std::array<int, 4>, 2> quantized;
+        std::array<int, 2> pBits;
+        for (int e = 0; e < 2; ++e)
+        {
+            float bestError = std::numeric_limits<float>::max();
+            for (int p = 0; p < 2; ++p)
+            {
+                std::array<int, 4> q;
+                float error = 0.0f;
+                for (int c = 0; c < 4; ++c)
+                {
+                    q[c] = std::clamp(static_cast<int>(std::lround((endpoints[e][c] - p) / 2.0f)), 0, 127);
+                    float d = static_cast<float>((q[c] << 1) | p) - endpoints[e][c];
+                    error += d * d;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    quantized[e] = q;
+                    pBits[e] = p;
+                }
+            }
+        }
+
+        auto computeIndices = [&](std::array<uint32_t, 16>& indices) {
+            std::array<std::array<int, 4>, 16> palette;
+            for (int w = 0; w < 16; ++w)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    int e0 = (quantized[0][c] << 1) | pBits[0];
+                    int e1 = (quantized[1][c] << 1) | pBits[1];
+                    palette[w][c] = ((64 - weights[w]) * e0 + weights[w] * e1 + 32) >> 6;
+                }
+            }
+            for (int i = 0; i < 16; ++i)
+            {
+                int bestError = std::numeric_limits<int>::max();
+                for (uint32_t w = 0; w < 16; ++w)
+                {
+                    int error = 0;
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        int d = palette[w][c] - texels[i][c];
+                        error += d * d;
+                    }
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        indices[i] = w;
+                    }
+                }
+            }
+        };
+
+        std::array<uint32_t, 16> indices;
+        computeIndices(indices);
+        // the msb of the first index is implicitly zero, swap the endpoints if needed
+        if (indices[0] & 8)
+        {
+            std::swap(quantized[0], quantized[1]);
+            std::swap(pBits[0], pBits[1]);
+            for (auto& index : indices) index = 15 - index;
+        }
+
+        std::memset(block, 0, 16);
+        BitWriter writer(block);
+        writer.write(1u << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            writer.write(quantized[0][c], 7);
+            writer.write(quantized[1][c], 7);
+        }
+        writer.write(pBits[0], 1);
+        writer.write(pBits[1], 1);
+        writer.write(indices[0], 3);
+        for (int i = 1; i < 16; ++i) writer.write(indices[i], 4);
+    }
+
+    VkFormat formatForUsage(TextureUsage usage)
+    {
+        switch (usage)
+        {
+        case TextureUsage::Normal: return VK_FORMAT_BC5_UNORM_BLOCK;
+        case TextureUsage::Occlusion: return VK_FORMAT_BC4_UNORM_BLOCK;
+        default: return VK_FORMAT_BC7_UNORM_BLOCK;
+        }
+    }
+
+    uint32_t blockSize(VkFormat format) { return format == VK_FORMAT_BC4_UNORM_BLOCK ? 8 : 16; }
+
+    std::vector<uint8_t> encodeLevel(const Image& image, TextureUsage usage)
+    {
+        const VkFormat format = formatForUsage(usage);
+        const uint32_t blocksX = std::max((image.width + 3) / 4, 1u);
+        const uint32_t blocksY = std::max((image.height + 3) / 4, 1u);
+        std::vector<uint8_t> encoded(blocksX * blocksY * blockSize(format));
+        uint8_t* block = encoded.data();
+        for (uint32_t by = 0; by < blocksY; ++by)
+        {
+            for (uint32_t bx = 0; bx < blocksX; ++bx, block += blockSize(format))
+            {
+                vsg::ubvec4 texels[16];
+                for (uint32_t i = 0; i < 16; ++i) texels[i] = image.at(bx * 4 + i % 4, by * 4 + i / 4);
+
+                if (format == VK_FORMAT_BC7_UNORM_BLOCK)
+                {
+                    encodeBC7Block(texels, block);
+                    continue;
+                }
+                uint8_t channel[16];
+                for (int i = 0; i < 16; ++i) channel[i] = texels[i].r;
+                encodeBC4Block(channel, block);
+                if (format == VK_FORMAT_BC5_UNORM_BLOCK)
+                {
+                    for (int i = 0; i < 16; ++i) channel[i] = texels[i].g;
+                    encodeBC4Block(channel, block + 8);
+                }
+            }
+        }
+        return encoded;
+    }
+
+    template<typename T>
+    void writeValue(std::ostream& out, T value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    // minimal KTX2 writer: no supercompression, no key/value data, a basic data format descriptor for the BC format
+    bool writeKtx2(const fs::path& path, VkFormat format, uint32_t width, uint32_t height,
+                   const std::vector<std::vector<uint8_t>>& levels)
+    {
+        uint32_t colorModel = 0;
+        std::vector<std::array<uint32_t, 4>> samples;
+        switch (format)
+        {
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+            colorModel = 131; // KHR_DF_MODEL_BC4
+            samples.push_back({0 | (63u << 16) | (0u << 24), 0, 0, 0xFFFFFFFF});
+            break;
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            colorModel = 132; // KHR_DF_MODEL_BC5
+            samples.push_back({0 | (63u << 16) | (0u << 24), 0, 0, 0xFFFFFFFF});
+            samples.push_back({64 | (63u << 16) | (1u << 24), 0, 0, 0xFFFFFFFF});
+            break;
+        default:
+            colorModel = 134; // KHR_DF_MODEL_BC7
+            samples.push_back({0 | (127u << 16) | (0u << 24), 0, 0, 0xFFFFFFFF});
+            break;
+        }
+        const uint32_t basicBlockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+        const uint32_t dfdByteLength = 4 + basicBlockSize;
+
+        const uint32_t levelCount = static_cast<uint32_t>(levels.size());
+        const uint32_t levelIndexOffset = 80;
+        const uint32_t dfdByteOffset = levelIndexOffset + 24 * levelCount;
+        const uint64_t alignment = blockSize(format);
+
+        // level data is stored from the smallest to the largest mip level
+        std::vector<uint64_t> levelOffsets(levelCount);
+        uint64_t offset = dfdByteOffset + dfdByteLength;
+        for (uint32_t level = levelCount; level-- > 0;)
+        {
+            offset = (offset + alignment - 1) / alignment * alignment;
+            levelOffsets[level] = offset;
+            offset += levels[level].size();
+        }
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out) return false;
+
+        const uint8_t identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+        out.write(reinterpret_cast<const char*>(identifier), sizeof(identifier));
+        writeValue<uint32_t>(out, format);
+        writeValue<uint32_t>(out, 1); // typeSize
+        writeValue<uint32_t>(out, width);
+        writeValue<uint32_t>(out, height);
+        writeValue<uint32_t>(out, 0); // pixelDepth
+        writeValue<uint32_t>(out, 0); // layerCount
+        writeValue<uint32_t>(out, 1); // faceCount
+        writeValue<uint32_t>(out, levelCount);
+        writeValue<uint32_t>(out, 0); // supercompressionScheme
+        writeValue<uint32_t>(out, dfdByteOffset);
+        writeValue<uint32_t>(out, dfdByteLength);
+        writeValue<uint32_t>(out, 0); // kvdByteOffset
+        writeValue<uint32_t>(out, 0); // kvdByteLength
+        writeValue<uint64_t>(out, 0); // sgdByteOffset
+        writeValue<uint64_t>(out, 0); // sgdByteLength
+        for (uint32_t level = 0; level < levelCount; ++level)
+        {
+            writeValue<uint64_t>(out, levelOffsets[level]);
+            writeValue<uint64_t>(out, levels[level].size());
+            writeValue<uint64_t>(out, levels[level].size());
+        }
+
+        writeValue<uint32_t>(out, dfdByteLength);
+        writeValue<uint32_t>(out, 0);                                // vendorId, descriptorType
+        writeValue<uint32_t>(out, 2 | (basicBlockSize << 16));       // versionNumber, descriptorBlockSize
+        writeValue<uint32_t>(out, colorModel | (1u << 8) | (1u << 16)); // BT709 primaries, linear transfer
+        writeValue<uint32_t>(out, 3 | (3u << 8));                    // 4x4 texel blocks
+        writeValue<uint32_t>(out, blockSize(format));                // bytesPlane0
+        writeValue<uint32_t>(out, 0);
+        for (const auto& sample : samples)
+        {
+            for (auto word : sample) writeValue<uint32_t>(out, word);
+        }
+
+        for (uint32_t level = levelCount; level-- > 0;)
+        {
+            std::fill_n(std::ostreambuf_iterator<char>(out), levelOffsets[level] - static_cast<uint64_t>(out.tellp()), '\0');
+            out.write(reinterpret_cast<const char*>(levels[level].data()), levels[level].size());
+        }
+        return static_cast<bool>(out);
+    }
+
+    vsg::ref_ptr<vsg::Data> readCached(const fs::path& path, bool alphaMask, vsg::ref_ptr<const vsg::Options> options)
+    {
+        auto data = vsg::read_cast<vsg::Data>(path.string(), options);
+        if (data) data->setValue("alpha_mask", alphaMask);
+        return data;
+    }
+} // namespace
+
+vsg::ref_ptr<vsg::Data> vsgXchange::ingestTexture(const vsg::Path& filename, TextureUsage usage, const vsg::Path& cacheDirectory,
+                                                  vsg::ref_ptr<const vsg::Options> options)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) return {};
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // the cache entry is addressed by the file content, the usage and the encoder version
+    uint64_t hash = 14695981039346656037ull;
+    hash = hashBytes(hash, content.data(), content.size());
+    hash = hashBytes(hash, &usage, sizeof(usage));
+    hash = hashBytes(hash, &kIngestVersion, sizeof(kIngestVersion));
+    std::stringstream name;
+    name << std::hex << hash;
+
+    // the alpha mask flag is encoded in the file name as it can not be recovered from the compressed data
+    const fs::path cachePath = fs::path(cacheDirectory) / (name.str() + ".ktx2");
+    const fs::path cachePathAlpha = fs::path(cacheDirectory) / (name.str() + "_alpha.ktx2");
+    if (fs::exists(cachePath)) return readCached(cachePath, false, options);
+    if (fs::exists(cachePathAlpha)) return readCached(cachePathAlpha, true, options);
+
+    auto sourceOptions = vsg::Options::create(*options);
+    // the readers register lower case extensions, .JPG or .PNG would not be decoded
+    sourceOptions->extensionHint = vsg::lowerCaseFileExtension(filename);
+    auto source = vsg::read_cast<vsg::ubvec4Array2D>(reinterpret_cast<const uint8_t*>(content.data()), content.size(), sourceOptions);
+    if (!source || !isPowerOfTwo(source->width()) || !isPowerOfTwo(source->height()) || source->width() < 4 || source->height() < 4)
+    {
+        return {};
+    }
+
+    Image image;
+    image.width = source->width();
+    image.height = source->height();
+    image.texels.assign(source->begin(), source->end());
+
+    bool alphaMask = false;
+    if (usage == TextureUsage::Color)
+    {
+        alphaMask = std::any_of(image.texels.begin(), image.texels.end(),
+                                [](const vsg::ubvec4& texel) { return texel.a < kAlphaMaskThreshold; });
+    }
+
+    std::vector<std::vector<uint8_t>> levels;
+    levels.push_back(encodeLevel(image, usage));
+    while (image.width > 1 || image.height > 1)
+    {
+        image = downsample(image, usage);
+        levels.push_back(encodeLevel(image, usage));
+    }
+
+    // write to a temporary file first so that concurrent runs never see partially written entries
+    std::error_code error;
+    fs::create_directories(cacheDirectory, error);
+    const fs::path& targetPath = alphaMask ? cachePathAlpha : cachePath;
+    // thread ids repeat across processes, so the temporary name is random
+    std::random_device random;
+    const std::string tempName = targetPath.filename().string() + "." + std::to_string(random()) + ".tmp";
+    const fs::path tempPath = fs::path(cacheDirectory) / tempName;
+    if (!writeKtx2(tempPath, formatForUsage(usage), source->width(), source->height(), levels))
+    {
+        std::cerr << "Failed to write texture cache entry " << tempPath.string() << std::endl;
+        fs::remove(tempPath, error);
+        return {};
+    }
+    fs::rename(tempPath, targetPath, error);
+    if (error)
+    {
+        fs::remove(tempPath, error);
+    }
+    return readCached(targetPath, alphaMask, options);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <vsg/core/Data.h>
+#include <vsg/io/Options.h>
+
+namespace vsgXchange
+{
+    enum class TextureUsage
+    {
+        Color,     // sRGB diffuse and emissive maps, filtered in linear space -> BC7
+        Normal,    // tangent space normal maps, only x and y are kept -> BC5
+        Occlusion, // single channel maps like ambient occlusion and light maps -> BC4
+        Data       // linear material parameters like metallic/roughness, specular and opacity maps -> BC7
+    };
+
+    /*
+     * Offline texture ingest.
+     *
+     * Decodes the texture file, generates a full mip chain and encodes it to a block compressed format depending
+     * on the usage. The result is stored as KTX2 in cacheDirectory under a name derived from the file content, so
+     * later runs load it through the ktx reader without touching the source image.
+     *
+     * Returns an empty ref_ptr if the texture can not be ingested (e.g. non power of two dimensions), in which case
+     * the caller should fall back to the source image.
+     * Color textures get the value "alpha_mask" set to whether any texel is (nearly) transparent, as the
+     * compressed data can not be inspected for it after loading.
+     */
+    vsg::ref_ptr<vsg::Data> ingestTexture(const vsg::Path& filename, TextureUsage usage, const vsg::Path& cacheDirectory,
+                                          vsg::ref_ptr<const vsg::Options> options);
+} // namespace vsgXchange
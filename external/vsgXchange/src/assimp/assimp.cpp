@@ -11,6 +11,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 </editor-fold> */
 
 #include "3DFrontImporter.h"
+#include "TextureIngest.h"
 
 #include <vsgXchange/models.h>
 
@@ -18,9 +19,18 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "assimp_phong.h"
 #include "assimp_vertex.h"
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <filesystem>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <map>
 #include <sstream>
 #include <stack>
+#include <thread>
 
 #include <vsg/all.h>
 
@@ -50,8 +60,63 @@ namespace
     {
         vsg::ref_ptr<vsg::Sampler> sampler;
         vsg::ref_ptr<vsg::Data> data;
+        vsg::ref_ptr<vsg::ImageView> imageView;
     };
 
+    // decoded texture file together with the image view that represents it on the GPU,
+    // materials referencing the same file share both
+    struct TextureImage : public vsg::Inherit<vsg::Object, TextureImage>
+    {
+        vsg::ref_ptr<vsg::Data> data;
+        vsg::ref_ptr<vsg::ImageView> imageView;
+    };
+    using TextureImages = std::map<std::string, vsg::ref_ptr<TextureImage>>;
+
+    // process-wide cache of decoded texture files, keyed by canonical path
+    vsg::ObjectCache& textureImageCache()
+    {
+        static auto cache = vsg::ObjectCache::create();
+        return *cache;
+    }
+
+    const std::array<aiTextureType, 7> kMaterialTextureTypes{
+        aiTextureType_DIFFUSE, aiTextureType_EMISSIVE, aiTextureType_LIGHTMAP, aiTextureType_AMBIENT,
+        aiTextureType_NORMALS, aiTextureType_UNKNOWN, aiTextureType_SPECULAR};
+
+    vsgXchange::TextureUsage getTextureUsage(aiTextureType type)
+    {
+        switch (type)
+        {
+        case aiTextureType_NORMALS: return vsgXchange::TextureUsage::Normal;
+        case aiTextureType_AMBIENT:
+        case aiTextureType_LIGHTMAP: return vsgXchange::TextureUsage::Occlusion;
+        // metallic/roughness is stored as aiTextureType_UNKNOWN, its mips must not be averaged in sRGB
+        case aiTextureType_UNKNOWN:
+        case aiTextureType_SPECULAR:
+        case aiTextureType_SHININESS:
+        case aiTextureType_OPACITY: return vsgXchange::TextureUsage::Data;
+        default: return vsgXchange::TextureUsage::Color;
+        }
+    }
+
+    // runs func(i) for i in [0, count) on up to hardware_concurrency tasks
+    template<typename F>
+    void parallelFor(unsigned int count, F func)
+    {
+        std::atomic<unsigned int> next{0};
+        auto worker = [&]() {
+            for (unsigned int i = next++; i < count; i = next++)
+                func(i);
+        };
+        const unsigned int numTasks = std::min(std::max(std::thread::hardware_concurrency(), 1u), count);
+        std::vector<std::future<void>> tasks;
+        for (unsigned int t = 1; t < numTasks; ++t)
+            tasks.push_back(std::async(std::launch::async, worker));
+        worker();
+        for (auto& task : tasks)
+            task.get();
+    }
+
     const std::string kDiffuseMapKey("VSG_DIFFUSE_MAP");
     const std::string kSpecularMapKey("VSG_SPECULAR_MAP");
     const std::string kAmbientMapKey("VSG_AMBIENT_MAP");
@@ -119,6 +184,183 @@ namespace
     static auto kBlackData = createTexture(kBlackColor);
     static auto kNormalData = createTexture(kNormalColor);
 
+    struct MeshData
+    {
+        vsg::ref_ptr<vsg::vec3Array> vertices;
+        vsg::ref_ptr<vsg::vec3Array> normals;
+        vsg::ref_ptr<vsg::vec2Array> texcoords;
+        vsg::ref_ptr<vsg::Data> indices;
+        uint32_t indexCount{0};
+    };
+
+    // timings and sizes of one import, attached to the returned scene graph as "import.*" double values
+    struct ImportStatistics
+    {
+        double materialMs = 0.0;
+        double textureDecodeMs = 0.0;
+        double texturesDecoded = 0.0;
+        double textureBytes = 0.0;
+        double meshConvertMs = 0.0;
+        double meshCount = 0.0;
+        double vertexBytes = 0.0;
+
+        void assignTo(vsg::Object& object) const
+        {
+            object.setValue("import.material_ms", materialMs);
+            object.setValue("import.texture_decode_ms", textureDecodeMs);
+            object.setValue("import.textures_decoded", texturesDecoded);
+            object.setValue("import.texture_bytes", textureBytes);
+            object.setValue("import.mesh_convert_ms", meshConvertMs);
+            object.setValue("import.mesh_count", meshCount);
+            object.setValue("import.vertex_bytes", vertexBytes);
+        }
+    };
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    inline uint32_t hashFloats(uint32_t hash, const float* values, unsigned int count)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &values[i], sizeof(uint32_t));
+            hash = (hash ^ bits) * 16777619u;
+        }
+        return hash;
+    }
+
+    template<typename T>
+    void copyIndices(const aiMesh* mesh, const std::vector<uint32_t>& remap, T* indices)
+    {
+        for (unsigned int j = 0; j < mesh->mNumFaces; ++j)
+        {
+            const auto& face = mesh->mFaces[j];
+            for (unsigned int k = 0; k < face.mNumIndices; ++k)
+                *(indices++) = static_cast<T>(remap[face.mIndices[k]]);
+        }
+    }
+
+    // converts a mesh into vsg arrays, vertices which are identical in position, normal and texcoord are welded.
+    // Meshes without normals are not welded, so they keep their faceted shading
+    MeshData convertMesh(const aiMesh* mesh)
+    {
+        const unsigned int numVertices = mesh->mNumVertices;
+        const aiVector3D* positions = mesh->mVertices;
+        const aiVector3D* normals = mesh->mNormals;
+        const aiVector3D* texcoords = mesh->mTextureCoords[0];
+
+        // weld vertices with an open addressing hash table that stores indices of unique vertices
+        std::vector<uint32_t> remap(numVertices);
+        std::vector<uint32_t> uniqueToSource;
+        uniqueToSource.reserve(numVertices);
+
+        if (!normals)
+        {
+            // the normals are generated over the shared vertices later, welding would turn faceted meshes smooth
+            for (unsigned int j = 0; j < numVertices; ++j)
+            {
+                remap[j] = j;
+                uniqueToSource.push_back(j);
+            }
+        }
+        else
+        {
+            uint32_t tableSize = 1;
+            while (tableSize < numVertices * 2) tableSize <<= 1;
+            const uint32_t tableMask = tableSize - 1;
+            const uint32_t emptySlot = std::numeric_limits<uint32_t>::max();
+            std::vector<uint32_t> table(tableSize, emptySlot);
+
+            auto equalVertex = [&](unsigned int a, unsigned int b) {
+                if (positions[a] != positions[b] || normals[a] != normals[b]) return false;
+                if (texcoords && (texcoords[a].x != texcoords[b].x || texcoords[a].y != texcoords[b].y)) return false;
+                return true;
+            };
+
+            for (unsigned int j = 0; j < numVertices; ++j)
+            {
+                uint32_t hash = hashFloats(2166136261u, &positions[j].x, 3);
+                hash = hashFloats(hash, &normals[j].x, 3);
+                if (texcoords) hash = hashFloats(hash, &texcoords[j].x, 2);
+
+                uint32_t slot = hash & tableMask;
+                while (table[slot] != emptySlot && !equalVertex(uniqueToSource[table[slot]], j))
+                    slot = (slot + 1) & tableMask;
+
+                if (table[slot] == emptySlot)
+                {
+                    table[slot] = static_cast<uint32_t>(uniqueToSource.size());
+                    uniqueToSource.push_back(j);
+                }
+                remap[j] = table[slot];
+            }
+        }
+
+        const auto numUnique = static_cast<uint32_t>(uniqueToSource.size());
+
+        MeshData meshData;
+        meshData.vertices = vsg::vec3Array::create(numUnique);
+        meshData.normals = vsg::vec3Array::create(numUnique);
+        meshData.texcoords = vsg::vec2Array::create(numUnique);
+
+        auto vertexPtr = meshData.vertices->data();
+        for (uint32_t u = 0; u < numUnique; ++u)
+        {
+            const auto& v = positions[uniqueToSource[u]];
+            vertexPtr[u].set(v.x, v.y, v.z);
+        }
+
+        auto normalPtr = meshData.normals->data();
+        if (normals)
+        {
+            for (uint32_t u = 0; u < numUnique; ++u)
+            {
+                const auto& n = normals[uniqueToSource[u]];
+                normalPtr[u].set(n.x, n.y, n.z);
+            }
+        }
+        else
+        {
+            std::fill(normalPtr, normalPtr + numUnique, vsg::vec3(0.0f, 0.0f, 0.0f));
+        }
+
+        auto texcoordPtr = meshData.texcoords->data();
+        if (texcoords)
+        {
+            for (uint32_t u = 0; u < numUnique; ++u)
+            {
+                const auto& t = texcoords[uniqueToSource[u]];
+                texcoordPtr[u].set(t.x, t.y);
+            }
+        }
+        else
+        {
+            std::fill(texcoordPtr, texcoordPtr + numUnique, vsg::vec2(0.0f, 0.0f));
+        }
+
+        for (unsigned int j = 0; j < mesh->mNumFaces; ++j)
+            meshData.indexCount += mesh->mFaces[j].mNumIndices;
+
+        // the index width only depends on the largest index that can be referenced
+        if (numUnique <= std::numeric_limits<uint16_t>::max())
+        {
+            auto indices = vsg::ushortArray::create(meshData.indexCount);
+            copyIndices(mesh, remap, indices->data());
+            meshData.indices = indices;
+        }
+        else
+        {
+            auto indices = vsg::uintArray::create(meshData.indexCount);
+            copyIndices(mesh, remap, indices->data());
+            meshData.indices = indices;
+        }
+
+        return meshData;
+    }
+
 } // namespace
 
 using namespace vsgXchange;
@@ -140,7 +382,7 @@ private:
     vsg::ref_ptr<vsg::GraphicsPipeline> createPipeline(vsg::ref_ptr<vsg::ShaderStage> vs, vsg::ref_ptr<vsg::ShaderStage> fs, vsg::ref_ptr<vsg::DescriptorSetLayout> descriptorSetLayout, bool doubleSided = false, bool enableBlend = false) const;
     void createDefaultPipelineAndState();
     vsg::ref_ptr<vsg::Object> processScene(const aiScene* scene, vsg::ref_ptr<const vsg::Options> options, const vsg::Path& ext) const;
-    BindState processMaterials(const aiScene* scene, vsg::ref_ptr<const vsg::Options> options) const;
+    BindState processMaterials(const aiScene* scene, vsg::ref_ptr<const vsg::Options> options, ImportStatistics& statistics) const;
 
     VkSamplerAddressMode getWrapMode(aiTextureMapMode mode) const
     {
@@ -155,7 +397,19 @@ private:
         return VK_SAMPLER_ADDRESS_MODE_REPEAT;
     }
 
-    SamplerData getTexture(const aiScene* scene, vsg::ref_ptr<const vsg::Options> options, aiMaterial& material, aiTextureType type, std::vector<std::string>& defines) const
+    TextureImages loadTextureImages(const aiScene* scene, vsg::ref_ptr<const vsg::Options> options, ImportStatistics& statistics) const;
+
+    vsg::ref_ptr<vsg::DescriptorImage> createDescriptorImage(const SamplerData& samplerImage, uint32_t binding) const
+    {
+        if (samplerImage.imageView)
+        {
+            auto imageInfo = vsg::ImageInfo::create(samplerImage.sampler, samplerImage.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            return vsg::DescriptorImage::create(imageInfo, binding, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        }
+        return vsg::DescriptorImage::create(samplerImage.sampler, samplerImage.data, binding, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+    }
+
+    SamplerData getTexture(const aiScene* scene, vsg::ref_ptr<const vsg::Options> options, const TextureImages& textureImages, aiMaterial& material, aiTextureType type, std::vector<std::string>& defines) const
     {
         aiString texPath;
         std::array<aiTextureMapMode, 3> wrapMode{{aiTextureMapMode_Wrap, aiTextureMapMode_Wrap, aiTextureMapMode_Wrap}};
@@ -181,13 +435,13 @@ private:
             }
             else
             {
-                const std::string filename = vsg::findFile(texPath.C_Str(), options);
-
-                if (samplerImage.data = vsg::read_cast<vsg::Data>(filename, options); !samplerImage.data.valid())
-                {
-                    std::cerr << "Failed to load texture: " << filename << " texPath = " << texPath.C_Str() << std::endl;
+                // texture files were already decoded by loadTextureImages, failures have been reported there
+                auto itr = textureImages.find(texPath.C_Str());
+                if (itr == textureImages.end() || !itr->second)
                     return {};
-                }
+
+                samplerImage.data = itr->second->data;
+                samplerImage.imageView = itr->second->imageView;
             }
 
             switch (type)
@@ -294,6 +548,7 @@ bool assimp::getFeatures(Features& features) const
     features.optionNameTypeMap[assimp::generate_sharp_normals] = vsg::type_name<bool>();
     features.optionNameTypeMap[assimp::crease_angle] = vsg::type_name<float>();
     features.optionNameTypeMap[assimp::two_sided] = vsg::type_name<bool>();
+    features.optionNameTypeMap[assimp::texture_cache] = vsg::type_name<std::string>();
 
     return true;
 }
@@ -304,6 +559,7 @@ bool assimp::readOptions(vsg::Options& options, vsg::CommandLine& arguments) con
     result = arguments.readAndAssign<void>(assimp::generate_sharp_normals, &options) || result;
     result = arguments.readAndAssign<float>(assimp::crease_angle, &options) || result;
     result = arguments.readAndAssign<void>(assimp::two_sided, &options) || result;
+    result = arguments.readAndAssign<std::string>(assimp::texture_cache, &options) || result;
     return result;
 }
 
@@ -377,10 +633,27 @@ vsg::ref_ptr<vsg::Object> assimp::Implementation::processScene(const aiScene* sc
 {
     bool useVertexIndexDraw = true;
 
+    ImportStatistics statistics;
+
     // Process materials
     //auto pipelineLayout = _defaultPipeline->layout;
-    auto stateSets = processMaterials(scene, options);
-
+    auto startTime = std::chrono::steady_clock::now();
+    auto stateSets = processMaterials(scene, options, statistics);
+    statistics.materialMs = millisecondsSince(startTime);
+
+    // convert the meshes up front and in parallel, meshes referenced by several nodes share their arrays
+    startTime = std::chrono::steady_clock::now();
+    std::vector<MeshData> meshDataList(scene->mNumMeshes);
+    parallelFor(scene->mNumMeshes, [&](unsigned int i) { meshDataList[i] = convertMesh(scene->mMeshes[i]); });
+    statistics.meshConvertMs = millisecondsSince(startTime);
+    statistics.meshCount = scene->mNumMeshes;
+    for (const auto& meshData : meshDataList)
+    {
+        for (auto& data : vsg::DataList{meshData.vertices, meshData.normals, meshData.texcoords, meshData.indices})
+        {
+            if (data) statistics.vertexBytes += data->dataSize();
+        }
+    }
 
     auto scenegraph = vsg::StateGroup::create();
     scenegraph->add(vsg::BindGraphicsPipeline::create(_defaultPipeline));
@@ -405,56 +678,11 @@ vsg::ref_ptr<vsg::Object> assimp::Implementation::processScene(const aiScene* sc
             for (unsigned int i = 0; i < node->mNumMeshes; ++i)
             {
                 auto mesh = scene->mMeshes[node->mMeshes[i]];
-                auto vertices = vsg::vec3Array::create(mesh->mNumVertices);
-                auto normals = vsg::vec3Array::create(mesh->mNumVertices);
-                auto texcoords = vsg::vec2Array::create(mesh->mNumVertices);
-                std::vector<unsigned int> indices;
-
-                for (unsigned int j = 0; j < mesh->mNumVertices; ++j)
-                {
-                    vertices->at(j) = vsg::vec3(mesh->mVertices[j].x, mesh->mVertices[j].y, mesh->mVertices[j].z);
-
-                    if (mesh->mNormals)
-                    {
-                        normals->at(j) = vsg::vec3(mesh->mNormals[j].x, mesh->mNormals[j].y, mesh->mNormals[j].z);
-                    }
-                    else
-                    {
-                        normals->at(j) = vsg::vec3(0, 0, 0);
-                    }
-
-                    if (mesh->mTextureCoords[0])
-                    {
-                        texcoords->at(j) = vsg::vec2(mesh->mTextureCoords[0][j].x, mesh->mTextureCoords[0][j].y);
-                    }
-                    else
-                    {
-                        texcoords->at(j) = vsg::vec2(0, 0);
-                    }
-                }
-
-                for (unsigned int j = 0; j < mesh->mNumFaces; ++j)
-                {
-                    const auto& face = mesh->mFaces[j];
-
-                    for (unsigned int k = 0; k < face.mNumIndices; ++k)
-                        indices.push_back(face.mIndices[k]);
-                }
-
-                vsg::ref_ptr<vsg::Data> vsg_indices;
-
-                if (indices.size() < std::numeric_limits<uint16_t>::max())
-                {
-                    auto myindices = vsg::ushortArray::create(static_cast<uint16_t>(indices.size()));
-                    std::copy(indices.begin(), indices.end(), myindices->data());
-                    vsg_indices = myindices;
-                }
-                else
-                {
-                    auto myindices = vsg::uintArray::create(static_cast<uint32_t>(indices.size()));
-                    std::copy(indices.begin(), indices.end(), myindices->data());
-                    vsg_indices = myindices;
-                }
+                const auto& meshData = meshDataList[node->mMeshes[i]];
+                auto vertices = meshData.vertices;
+                auto normals = meshData.normals;
+                auto texcoords = meshData.texcoords;
+                auto vsg_indices = meshData.indices;
 
                 auto stategroup = vsg::StateGroup::create();
                 xform->addChild(stategroup);
@@ -473,7 +701,7 @@ vsg::ref_ptr<vsg::Object> assimp::Implementation::processScene(const aiScene* sc
                     auto vid = vsg::VertexIndexDraw::create();
                     vid->assignArrays(vsg::DataList{vertices, normals, texcoords});
                     vid->assignIndices(vsg_indices);
-                    vid->indexCount = indices.size();
+                    vid->indexCount = meshData.indexCount;
                     vid->instanceCount = 1;
                     stategroup->addChild(vid);
                 }
@@ -481,7 +709,7 @@ vsg::ref_ptr<vsg::Object> assimp::Implementation::processScene(const aiScene* sc
                 {
                     stategroup->addChild(vsg::BindVertexBuffers::create(0, vsg::DataList{vertices, normals, texcoords}));
                     stategroup->addChild(vsg::BindIndexBuffer::create(vsg_indices));
-                    stategroup->addChild(vsg::DrawIndexed::create(static_cast<uint32_t>(indices.size()), 1, 0, 0, 0));
+                    stategroup->addChild(vsg::DrawIndexed::create(meshData.indexCount, 1, 0, 0, 0));
                 }
             }
 
@@ -515,26 +743,123 @@ vsg::ref_ptr<vsg::Object> assimp::Implementation::processScene(const aiScene* sc
         }
     }
 
+    vsg::ref_ptr<vsg::Object> result = scenegraph;
     vsg::dmat4 matrix;
     if (vsg::transform(source_coordianteConvention, options->sceneCoordinateConvention, matrix))
     {
         auto root = vsg::MatrixTransform::create(matrix);
         root->addChild(scenegraph);
 
-        return root;
+        result = root;
+    }
+
+    statistics.assignTo(*result);
+    return result;
+}
+
+assimp::Implementation::TextureImages assimp::Implementation::loadTextureImages(const aiScene* scene, vsg::ref_ptr<const vsg::Options> options, ImportStatistics& statistics) const
+{
+    // gather all texture files referenced by the materials, embedded textures are handled by getTexture
+    TextureImages textureImages;
+    std::map<std::string, TextureUsage> textureUsages;
+    unsigned int numReferences = 0;
+    for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
+    {
+        for (auto type : kMaterialTextureTypes)
+        {
+            aiString texPath;
+            if (scene->mMaterials[i]->GetTexture(type, 0, &texPath) == AI_SUCCESS && texPath.data[0] != '*')
+            {
+                textureImages[texPath.C_Str()];
+                textureUsages.emplace(texPath.C_Str(), getTextureUsage(type));
+                ++numReferences;
+            }
+        }
+    }
+
+    // map the texture paths to canonical file paths so that every file is decoded once
+    std::map<std::string, std::vector<std::string>> canonicalToTexPaths;
+    for (auto& [texPath, textureImage] : textureImages)
+    {
+        const std::string filename = vsg::findFile(texPath, options);
+        if (filename.empty())
+        {
+            std::cerr << "Failed to find texture: " << texPath << std::endl;
+            continue;
+        }
+        std::error_code error;
+        auto canonicalPath = std::filesystem::weakly_canonical(std::filesystem::path(filename), error);
+        canonicalToTexPaths[error ? filename : canonicalPath.string()].push_back(texPath);
+    }
+
+    auto& cache = textureImageCache();
+    std::vector<std::pair<std::string, vsg::ref_ptr<TextureImage>>> toDecode;
+    const auto textureCacheDirectory = vsg::value<std::string>({}, assimp::texture_cache, options);
+    unsigned int numCacheHits = 0;
+    for (auto& [canonicalPath, texPaths] : canonicalToTexPaths)
+    {
+        if (auto cached = cache.get(canonicalPath).cast<TextureImage>())
+        {
+            for (auto& texPath : texPaths) textureImages[texPath] = cached;
+            ++numCacheHits;
+        }
+        else
+        {
+            toDecode.emplace_back(canonicalPath, vsg::ref_ptr<TextureImage>{});
+        }
     }
-    else
+
+    auto startTime = std::chrono::steady_clock::now();
+    parallelFor(static_cast<unsigned int>(toDecode.size()), [&](unsigned int i) {
+        auto& [canonicalPath, textureImage] = toDecode[i];
+        vsg::ref_ptr<vsg::Data> data;
+        if (!textureCacheDirectory.empty())
+        {
+            // files shared between usages are ingested with the usage of the first reference
+            auto usage = textureUsages[canonicalToTexPaths[canonicalPath].front()];
+            data = ingestTexture(canonicalPath, usage, textureCacheDirectory, options);
+        }
+        if (!data) data = vsg::read_cast<vsg::Data>(canonicalPath, options);
+        if (!data)
+        {
+            std::cerr << "Failed to load texture: " << canonicalPath << std::endl;
+            return;
+        }
+        auto image = vsg::Image::create(data);
+        image->usage |= (VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+        textureImage = TextureImage::create();
+        textureImage->data = data;
+        textureImage->imageView = vsg::ImageView::create(image);
+    });
+    auto decodeTime = millisecondsSince(startTime);
+    statistics.textureDecodeMs = decodeTime;
+
+    for (auto& [canonicalPath, textureImage] : toDecode)
     {
-        return scenegraph;
+        if (!textureImage) continue;
+        statistics.texturesDecoded += 1.0;
+        statistics.textureBytes += textureImage->data->dataSize();
+        cache.add(textureImage, canonicalPath);
+        for (auto& texPath : canonicalToTexPaths[canonicalPath]) textureImages[texPath] = textureImage;
     }
 
+    if (numReferences > 0)
+    {
+        std::cout << "Decoded " << toDecode.size() << " textures in " << decodeTime << " ms, "
+                  << numReferences - toDecode.size() << " duplicate texture references avoided ("
+                  << numCacheHits << " from the image cache)" << std::endl;
+    }
+
+    return textureImages;
 }
 
-assimp::Implementation::BindState assimp::Implementation::processMaterials(const aiScene* scene, vsg::ref_ptr<const vsg::Options> options) const
+assimp::Implementation::BindState assimp::Implementation::processMaterials(const aiScene* scene, vsg::ref_ptr<const vsg::Options> options, ImportStatistics& statistics) const
 {
     BindState bindDescriptorSets;
     bindDescriptorSets.reserve(scene->mNumMaterials);
 
+    auto textureImages = loadTextureImages(scene, options, statistics);
+
     for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
     {
         const auto material = scene->mMaterials[i];
@@ -589,44 +914,44 @@ assimp::Implementation::BindState assimp::Implementation::processMaterials(const
             descList.push_back(buffer);
 
             SamplerData samplerImage;
-            if (samplerImage = getTexture(scene, options, *material, aiTextureType_DIFFUSE, defines); samplerImage.data.valid())
+            if (samplerImage = getTexture(scene, options, textureImages, *material, aiTextureType_DIFFUSE, defines); samplerImage.data.valid())
             {
-                auto diffuseTexture = vsg::DescriptorImage::create(samplerImage.sampler, samplerImage.data, 0, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+                auto diffuseTexture = createDescriptorImage(samplerImage, 0);
                 descList.push_back(diffuseTexture);
                 descriptorBindings.push_back({0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr});
             }
 
-            if (samplerImage = getTexture(scene, options, *material, aiTextureType_EMISSIVE, defines); samplerImage.data.valid())
+            if (samplerImage = getTexture(scene, options, textureImages, *material, aiTextureType_EMISSIVE, defines); samplerImage.data.valid())
             {
-                auto emissiveTexture = vsg::DescriptorImage::create(samplerImage.sampler, samplerImage.data, 4, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+                auto emissiveTexture = createDescriptorImage(samplerImage, 4);
                 descList.push_back(emissiveTexture);
                 descriptorBindings.push_back({4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr});
             }
 
-            if (samplerImage = getTexture(scene, options, *material, aiTextureType_LIGHTMAP, defines); samplerImage.data.valid())
+            if (samplerImage = getTexture(scene, options, textureImages, *material, aiTextureType_LIGHTMAP, defines); samplerImage.data.valid())
             {
-                auto aoTexture = vsg::DescriptorImage::create(samplerImage.sampler, samplerImage.data, 3, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+                auto aoTexture = createDescriptorImage(samplerImage, 3);
                 descList.push_back(aoTexture);
                 descriptorBindings.push_back({3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr});
             }
 
-            if (samplerImage = getTexture(scene, options, *material, aiTextureType_NORMALS, defines); samplerImage.data.valid())
+            if (samplerImage = getTexture(scene, options, textureImages, *material, aiTextureType_NORMALS, defines); samplerImage.data.valid())
             {
-                auto normalTexture = vsg::DescriptorImage::create(samplerImage.sampler, samplerImage.data, 2, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+                auto normalTexture = createDescriptorImage(samplerImage, 2);
                 descList.push_back(normalTexture);
                 descriptorBindings.push_back({2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr});
             }
 
-            if (samplerImage = getTexture(scene, options, *material, aiTextureType_UNKNOWN, defines); samplerImage.data.valid())
+            if (samplerImage = getTexture(scene, options, textureImages, *material, aiTextureType_UNKNOWN, defines); samplerImage.data.valid())
             {
-                auto mrTexture = vsg::DescriptorImage::create(samplerImage.sampler, samplerImage.data, 1, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+                auto mrTexture = createDescriptorImage(samplerImage, 1);
                 descList.push_back(mrTexture);
                 descriptorBindings.push_back({1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr});
             }
 
-            if (samplerImage = getTexture(scene, options, *material, aiTextureType_SPECULAR, defines); samplerImage.data.valid())
+            if (samplerImage = getTexture(scene, options, textureImages, *material, aiTextureType_SPECULAR, defines); samplerImage.data.valid())
             {
-                auto texture = vsg::DescriptorImage::create(samplerImage.sampler, samplerImage.data, 5, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+                auto texture = createDescriptorImage(samplerImage, 5);
                 descList.push_back(texture);
                 descriptorBindings.push_back({5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr});
             }
@@ -694,9 +1019,9 @@ assimp::Implementation::BindState assimp::Implementation::processMaterials(const
             vsg::Descriptors descList;
 
             SamplerData samplerImage;
-            if (samplerImage = getTexture(scene, options, *material, aiTextureType_DIFFUSE, defines); samplerImage.data.valid())
+            if (samplerImage = getTexture(scene, options, textureImages, *material, aiTextureType_DIFFUSE, defines); samplerImage.data.valid())
             {
-                auto diffuseTexture = vsg::DescriptorImage::create(samplerImage.sampler, samplerImage.data, 0, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+                auto diffuseTexture = createDescriptorImage(samplerImage, 0);
                 descList.push_back(diffuseTexture);
                 descriptorBindings.push_back({0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr});
 
@@ -704,9 +1029,9 @@ assimp::Implementation::BindState assimp::Implementation::processMaterials(const
                     mat.diffuse.set(1.0f, 1.0f, 1.0f, 1.0f);
             }
 
-            if (samplerImage = getTexture(scene, options, *material, aiTextureType_EMISSIVE, defines); samplerImage.data.valid())
+            if (samplerImage = getTexture(scene, options, textureImages, *material, aiTextureType_EMISSIVE, defines); samplerImage.data.valid())
             {
-                auto emissiveTexture = vsg::DescriptorImage::create(samplerImage.sampler, samplerImage.data, 4, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+                auto emissiveTexture = createDescriptorImage(samplerImage, 4);
                 descList.push_back(emissiveTexture);
                 descriptorBindings.push_back({4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr});
 
@@ -714,29 +1039,29 @@ assimp::Implementation::BindState assimp::Implementation::processMaterials(const
                     mat.emissive.set(1.0f, 1.0f, 1.0f, 1.0f);
             }
 
-            if (samplerImage = getTexture(scene, options, *material, aiTextureType_LIGHTMAP, defines); samplerImage.data.valid())
+            if (samplerImage = getTexture(scene, options, textureImages, *material, aiTextureType_LIGHTMAP, defines); samplerImage.data.valid())
             {
-                auto aoTexture = vsg::DescriptorImage::create(samplerImage.sampler, samplerImage.data, 3, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+                auto aoTexture = createDescriptorImage(samplerImage, 3);
                 descList.push_back(aoTexture);
                 descriptorBindings.push_back({3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr});
             }
-            else if (samplerImage = getTexture(scene, options, *material, aiTextureType_AMBIENT, defines); samplerImage.data.valid())
+            else if (samplerImage = getTexture(scene, options, textureImages, *material, aiTextureType_AMBIENT, defines); samplerImage.data.valid())
             {
-                auto texture = vsg::DescriptorImage::create(samplerImage.sampler, samplerImage.data, 3, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+                auto texture = createDescriptorImage(samplerImage, 3);
                 descList.push_back(texture);
                 descriptorBindings.push_back({3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr});
             }
 
-            if (samplerImage = getTexture(scene, options, *material, aiTextureType_NORMALS, defines); samplerImage.data.valid())
+            if (samplerImage = getTexture(scene, options, textureImages, *material, aiTextureType_NORMALS, defines); samplerImage.data.valid())
             {
-                auto normalTexture = vsg::DescriptorImage::create(samplerImage.sampler, samplerImage.data, 2, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+                auto normalTexture = createDescriptorImage(samplerImage, 2);
                 descList.push_back(normalTexture);
                 descriptorBindings.push_back({2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr});
             }
 
-            if (samplerImage = getTexture(scene, options, *material, aiTextureType_SPECULAR, defines); samplerImage.data.valid())
+            if (samplerImage = getTexture(scene, options, textureImages, *material, aiTextureType_SPECULAR, defines); samplerImage.data.valid())
             {
-                auto texture = vsg::DescriptorImage::create(samplerImage.sampler, samplerImage.data, 5, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+                auto texture = createDescriptorImage(samplerImage, 5);
                 descList.push_back(texture);
                 descriptorBindings.push_back({5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr});
 
@@ -785,12 +1110,16 @@ vsg::ref_ptr<vsg::Object> assimp::Implementation::read(const vsg::Path& filename
             flags |= aiProcess_GenNormals;
         }
 
+        auto startTime = std::chrono::steady_clock::now();
         if (auto scene = importer.ReadFile(filenameToUse, flags); scene)
         {
+            auto readTime = millisecondsSince(startTime);
             auto opt = vsg::Options::create(*options);
             opt->paths.insert(opt->paths.begin(), vsg::filePath(filenameToUse));
 
-            return processScene(scene, opt, ext);
+            auto result = processScene(scene, opt, ext);
+            if (result) result->setValue("import.read_ms", readTime);
+            return result;
         }
         else
         {
@@ -24,9 +24,11 @@ if (${vsgXchange_assimp})
     set(SOURCES ${SOURCES}
         assimp/assimp.cpp
         assimp/3DFrontImporter.cpp
+        assimp/TextureIngest.cpp
     )
     set(HEADERS ${HEADERS}
         ${CMAKE_CURRENT_SOURCE_DIR}/assimp/3DFrontImporter.h
+        ${CMAKE_CURRENT_SOURCE_DIR}/assimp/TextureIngest.h
     )
     message(${HEADERS})
     set(EXTRA_INCLUDES ${EXTRA_INCLUDES} ${assimp_INCLUDE_DIRS})
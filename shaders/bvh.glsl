@@ -0,0 +1,95 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "layoutPTBVH.glsl"
+
+// stackless traversal is not worth the extra node data, the cpu build limits the depth to this size
+const uint c_BVHStackSize = 64;
+const float c_BVHMiss = 1e30;
+
+// entry distance of the ray into the box, c_BVHMiss if it is missed within [rayTmin, rayTmax]
+float intersectAABB(vec3 aabbMin, vec3 aabbMax, vec3 origin, vec3 invDir, float rayTmin, float rayTmax){
+  vec3 t0 = (aabbMin - origin) * invDir;
+  vec3 t1 = (aabbMax - origin) * invDir;
+  vec3 tNear = min(t0, t1);
+  vec3 tFar = max(t0, t1);
+  float enter = max(max(tNear.x, tNear.y), max(tNear.z, rayTmin));
+  float exit = min(min(tFar.x, tFar.y), min(tFar.z, rayTmax));
+  return enter <= exit ? enter : c_BVHMiss;
+}
+
+// moeller trumbore, attribs are the barycentrics of v1 and v2 like the hit attributes of the ray tracing pipeline
+bool intersectTriangle(BVHTriangle triangle, vec3 origin, vec3 direction, float rayTmin, float rayTmax, out float t, out vec2 attribs){
+  vec3 p = cross(direction, triangle.edge2);
+  float det = dot(triangle.edge1, p);
+  // both sides are hit, there is no culling in the hardware backends either
+  if(abs(det) < 1e-12) return false;
+  float invDet = 1.0 / det;
+  vec3 s = origin - triangle.v0;
+  attribs.x = dot(s, p) * invDet;
+  vec3 q = cross(s, triangle.edge1);
+  attribs.y = dot(direction, q) * invDet;
+  t = dot(triangle.edge2, q) * invDet;
+  return attribs.x >= 0 && attribs.y >= 0 && attribs.x + attribs.y <= 1 && t > rayTmin && t < rayTmax;
+}
+
+// closest triangle along the ray accepted by acceptCandidate() (see trace.glsl), with firstHit the traversal ends at
+// the first accepted triangle. Returns false if nothing is hit.
+bool traverseBVH(vec3 origin, vec3 direction, float rayTmin, float rayTmax, bool firstHit, out uint hitTriangle, out vec2 hitAttribs, out float hitT){
+  hitT = rayTmax;
+  bool hit = false;
+  // axis parallel rays get a large instead of an infinite inverse, so no nan appears in the slab test
+  vec3 invDir = 1.0 / (direction + vec3(equal(direction, vec3(0))) * 1e-20);
+  if(intersectAABB(bvhNodes.nodes[0].aabbMin, bvhNodes.nodes[0].aabbMax, origin, invDir, rayTmin, hitT) == c_BVHMiss) return false;
+  // pushed nodes with the entry distance of the ray into their box
+  uint stack[c_BVHStackSize];
+  float stackT[c_BVHStackSize];
+  uint stackSize = 0;
+  uint nodeIndex = 0;
+  while(true){
+    BVHNode node = bvhNodes.nodes[nodeIndex];
+    if(node.triangleCount > 0){
+      for(uint i = node.leftFirst; i < node.leftFirst + node.triangleCount; ++i){
+        BVHTriangle triangle = bvhTriangles.triangles[i];
+        float t;
+        vec2 attribs;
+        if(!intersectTriangle(triangle, origin, direction, rayTmin, hitT, t, attribs)) continue;
+        if(!acceptCandidate(triangle.shaderOffset, triangle.instanceIndex, triangle.primitiveID, attribs)) continue;
+        hit = true;
+        hitT = t;
+        hitTriangle = i;
+        hitAttribs = attribs;
+        if(firstHit) return true;
+      }
+    }
+    else{
+      // the nearer child first, the other one is visited later if it is still in front of the closest hit
+      uint nearChild = node.leftFirst, farChild = node.leftFirst + 1;
+      float nearT = intersectAABB(bvhNodes.nodes[nearChild].aabbMin, bvhNodes.nodes[nearChild].aabbMax, origin, invDir, rayTmin, hitT);
+      float farT = intersectAABB(bvhNodes.nodes[farChild].aabbMin, bvhNodes.nodes[farChild].aabbMax, origin, invDir, rayTmin, hitT);
+      if(nearT > farT){
+        uint tmpChild = nearChild;
+        nearChild = farChild;
+        farChild = tmpChild;
+        float tmpT = nearT;
+        nearT = farT;
+        farT = tmpT;
+      }
+      if(nearT != c_BVHMiss){
+        if(farT != c_BVHMiss){
+          stack[stackSize] = farChild;
+          stackT[stackSize++] = farT;
+        }
+        nodeIndex = nearChild;
+        continue;
+      }
+    }
+    // pushed boxes which are entered behind the closest hit found since are skipped
+    do{
+      if(stackSize == 0) return hit;
+      nodeIndex = stack[--stackSize];
+    } while(stackT[stackSize] >= hitT);
+  }
+}
+
+#endif //BVH_H
@@ -6,7 +6,7 @@
 void createRay(uvec2 pixelPos, uvec2 imSize, bool antiAlias,inout RandomEngine re, out vec4 pos, out vec4 dir){
     vec2 pixelCenter = vec2(pixelPos.xy) + vec2(.5);
     if(antiAlias)
-        pixelCenter += randomVec2(re) - .5;	//can not be done when reprojecting
+        pixelCenter += sample2D(re, c_DimCamera) - .5;	//can not be done when reprojecting
     const vec2 normalisedPixelCoord = pixelCenter/vec2(imSize.xy);
     vec2 clipSpaceCoord = normalisedPixelCoord * 2.0 - 1.0;
 
@@ -15,4 +15,11 @@ void createRay(uvec2 pixelPos, uvec2 imSize, bool antiAlias,inout RandomEngine r
     dir = camParams.inverseViewMatrix * vec4(normalize(dir.xyz), 0) ;
 }
 
+// angle between the rays through two vertically adjacent pixel centers, initial spread of the ray cone
+float pixelSpreadAngle(uvec2 imSize){
+    vec3 d0 = normalize((camParams.inverseProjectionMatrix * vec4(0, 0, 1, 1)).xyz);
+    vec3 d1 = normalize((camParams.inverseProjectionMatrix * vec4(0, 2.0 / float(imSize.y), 1, 1)).xyz);
+    return acos(clamp(dot(d0, d1), -1.0, 1.0));
+}
+
 #endif //CAMEAR_H
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef GBUFFER_ENCODING_H
+#define GBUFFER_ENCODING_H
+
+// storage of the g-buffer attribute images, shared by the path tracer that writes them and every consumer. The image
+// formats of GBufferEncoding (source/buffers/GBufferEncoding.hpp) have to match the layout qualifiers below, the cpu
+// side of the encoders is GBufferEncoder, used by GBufferIO.
+// Without GBUFFER_COMPACT: float depth, spherical float normals and rgba8 material (16 bytes per pixel).
+// With GBUFFER_COMPACT: half depth, octahedral snorm16 normals and r8 material (7 bytes per pixel).
+
+#ifdef GBUFFER_COMPACT
+#define GBUFFER_DEPTH_FORMAT r16f
+#define GBUFFER_NORMAL_FORMAT rg16_snorm
+#define GBUFFER_MATERIAL_FORMAT r8
+#else
+#define GBUFFER_DEPTH_FORMAT r32f
+#define GBUFFER_NORMAL_FORMAT rg32f
+#define GBUFFER_MATERIAL_FORMAT rgba8
+#endif
+
+const float c_MaxHalf = 65504.0;
+
+#ifdef GBUFFER_COMPACT
+// octahedral mapping, the lower hemisphere is folded over the diagonals of the upper one
+vec2 octahedralWrap(vec2 v){
+    return (1.0 - abs(v.yx)) * mix(vec2(-1.0), vec2(1.0), greaterThanEqual(v, vec2(0.0)));
+}
+#endif
+
+vec2 encodeNormal(vec3 n){
+#ifdef GBUFFER_COMPACT
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    return n.z >= 0.0 ? n.xy : octahedralWrap(n.xy);
+#else
+    return vec2(acos(n.z), atan(n.y, n.x));
+#endif
+}
+
+vec3 decodeNormal(vec2 e){
+#ifdef GBUFFER_COMPACT
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+#else
+    return vec3(sin(e.x) * cos(e.y), sin(e.x) * sin(e.y), cos(e.x));
+#endif
+}
+
+// misses are stored at the largest half depth instead of overflowing to infinity
+float encodeDepth(float depth){
+#ifdef GBUFFER_COMPACT
+    return min(depth, c_MaxHalf);
+#else
+    return depth;
+#endif
+}
+
+#endif //GBUFFER_ENCODING_H
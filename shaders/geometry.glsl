@@ -7,7 +7,7 @@ uvec3 unpackIndex(uint objId, uint primitiveID, uint indexStride){
         index = ivec3(ind[nonuniformEXT(objId)].i[3 * primitiveID], ind[nonuniformEXT(objId)].i[3 * primitiveID + 1], ind[nonuniformEXT(objId)].i[3 * primitiveID + 2]);
     else                  //only ushorts are in the indexbuffer
     {
-        int full = 3 * gl_PrimitiveID;
+        uint full = 3 * primitiveID;
         uint p = uint(full * .5f);
         if(bool(full & 1)){   //not dividable by 2, second half of p + both places of p + 1
             index.x = ind[nonuniformEXT(objId)].i[p] >> 16;
@@ -81,12 +81,33 @@ mat3 gramSchmidt(vec3 T, vec3 B, vec3 N){
     return mat3(normalize(t), normalize(b), N);
 }
 
-vec3 getNormal(mat3 TBN, sampler2D normalMap, vec2 uv)
+// Ray cone texture lod, see "Texture Level of Detail Strategies for Real-Time Ray Tracing" (Ray Tracing Gems, ch. 20)
+// returns the lod without the texture size term, add textureSizeLod() for the sampled texture
+float rayConeLod(vec3 p0, vec3 p1, vec3 p2, vec2 uv0, vec2 uv1, vec2 uv2, float coneWidth, vec3 rayDir)
+{
+    vec3 worldCross = cross(p1 - p0, p2 - p0);
+    vec2 uvE1 = uv1 - uv0, uvE2 = uv2 - uv0;
+    float worldArea = max(length(worldCross), 1e-12);
+    float uvArea = max(abs(uvE1.x * uvE2.y - uvE2.x * uvE1.y), 1e-12);
+    float cosTheta = max(abs(dot(worldCross / worldArea, rayDir)), 1e-3);
+    return 0.5 * log2(uvArea / worldArea) + log2(max(coneWidth, 1e-12)) - log2(cosTheta);
+}
+
+float textureSizeLod(sampler2D tex)
+{
+    ivec2 size = textureSize(tex, 0);
+    return 0.5 * log2(float(size.x * size.y));
+}
+
+vec3 getNormal(mat3 TBN, sampler2D normalMap, vec2 uv, float lod)
 {
     if(textureSize(normalMap, 0) == ivec2(1,1)) 
         return TBN[2];
     // Perturb normal, see http://www.thetenthplanet.de/archives/1180
-    vec3 tangentNormal = texture(normalMap, uv).xyz * 2.0 - 1.0;
+    // z is reconstructed so that two channel (BC5) normal maps work as well
+    vec3 tangentNormal;
+    tangentNormal.xy = textureLod(normalMap, uv, lod + textureSizeLod(normalMap)).xy * 2.0 - 1.0;
+    tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
   
     return normalize(TBN * tangentNormal);
 }
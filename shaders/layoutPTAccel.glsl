@@ -1,6 +1,11 @@
 #ifndef LAYOUTPTACCEL_H
 #define LAYOUTPTACCEL_H
 
+#ifdef SOFTWARE_BVH
+// the software backend traverses a bvh built on the cpu instead of the acceleration structure
+#include "layoutPTBVH.glsl"
+#else
 layout(binding = 0, set = 0) uniform accelerationStructureEXT tlas;
+#endif
 
 #endif //LAYOUTPTACCEL_H
\ No newline at end of file
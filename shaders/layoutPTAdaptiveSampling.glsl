@@ -0,0 +1,41 @@
+#ifndef LAYOUTPTADAPTIVESAMPLING_H
+#define LAYOUTPTADAPTIVESAMPLING_H
+
+#ifdef ADAPTIVE_SAMPLING
+// x sample count, y mean luminance, z sum of squared differences to the mean luminance (welford)
+layout(binding = 30, rgba32f) uniform image2D sampleStatistics;
+// not yet converged pixels packed as x | y << 16, written by adaptiveSampling.comp
+layout(binding = 31) readonly buffer ActivePixels{
+  uint activePixels[];
+};
+#endif
+
+#ifdef COMPUTE_LAUNCH
+// the compute backends are dispatched in whole workgroups, so the image size is given separately
+layout(constant_id = 2) const uint launchWidth = 1;
+layout(constant_id = 3) const uint launchHeight = 1;
+#endif
+
+// with adaptive sampling the launch is one dimensional over the active pixels
+ivec2 launchPixel(){
+#if defined COMPUTE_LAUNCH
+  return ivec2(gl_GlobalInvocationID.xy);
+#elif defined ADAPTIVE_SAMPLING
+  uint packedPixel = activePixels[gl_LaunchIDEXT.x];
+  return ivec2(packedPixel & 0xffff, packedPixel >> 16);
+#else
+  return ivec2(gl_LaunchIDEXT.xy);
+#endif
+}
+
+uvec2 launchImageSize(){
+#if defined COMPUTE_LAUNCH
+  return uvec2(launchWidth, launchHeight);
+#elif defined ADAPTIVE_SAMPLING
+  return uvec2(imageSize(sampleStatistics));
+#else
+  return gl_LaunchSizeEXT.xy;
+#endif
+}
+
+#endif //LAYOUTPTADAPTIVESAMPLING_H
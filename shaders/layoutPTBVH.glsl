@@ -0,0 +1,27 @@
+#ifndef LAYOUTPTBVH_H
+#define LAYOUTPTBVH_H
+
+// bvh of the software backend, built by SoftwareBVH on the cpu (std430 layouts of SoftwareBVH::Node and Triangle)
+// leaves hold triangleCount triangles starting at leftFirst, inner nodes have their children at leftFirst and
+// leftFirst + 1. Node 0 is the root.
+struct BVHNode{
+  vec3 aabbMin;
+  uint leftFirst;
+  vec3 aabbMax;
+  uint triangleCount;
+};
+
+// world space triangle with the instance and primitive it belongs to, shaderOffset 1 marks alpha tested instances
+struct BVHTriangle{
+  vec3 v0;
+  int instanceIndex;
+  vec3 edge1;           // v1 - v0
+  int primitiveID;
+  vec3 edge2;           // v2 - v0
+  uint shaderOffset;
+};
+
+layout(binding = 49) readonly buffer BVHNodes{ BVHNode nodes[]; } bvhNodes;
+layout(binding = 50) readonly buffer BVHTriangles{ BVHTriangle triangles[]; } bvhTriangles;
+
+#endif //LAYOUTPTBVH_H
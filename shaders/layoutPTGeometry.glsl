@@ -2,12 +2,18 @@
 #define LAYOUTPTGEOMETRY_H
 #include "ptStructures.glsl"
 
-layout(binding = 2) buffer Pos {float p[]; }     pos[];  //non interleaved positions, normals and texture arrays
-layout(binding = 3) buffer Nor {float n[]; }     nor[];
-layout(binding = 4) buffer Tex {float t[]; }     tex[];
-layout(binding = 5) buffer Ind {uint i[]; }  ind[];
+// the path tracer has the geometry in its only set, the consumers of the visibility g-buffer bind it as set 1 next to
+// their own images (see GBuffer::bind_scene_geometry())
+#ifndef GEOMETRY_SET
+#define GEOMETRY_SET 0
+#endif
 
-layout(binding = 13) buffer Materials{WaveFrontMaterialPacked m[]; } materials;
-layout(binding = 14) buffer Instances{ObjectInstance i[]; } instances;
+layout(set = GEOMETRY_SET, binding = 2) buffer Pos {float p[]; }     pos[];  //non interleaved positions, normals and texture arrays
+layout(set = GEOMETRY_SET, binding = 3) buffer Nor {float n[]; }     nor[];
+layout(set = GEOMETRY_SET, binding = 4) buffer Tex {float t[]; }     tex[];
+layout(set = GEOMETRY_SET, binding = 5) buffer Ind {uint i[]; }  ind[];
+
+layout(set = GEOMETRY_SET, binding = 13) buffer Materials{WaveFrontMaterialPacked m[]; } materials;
+layout(set = GEOMETRY_SET, binding = 14) buffer Instances{ObjectInstance i[]; } instances;
 
 #endif //LAYOUTPTGEOMETRY_H
\ No newline at end of file
@@ -6,9 +6,15 @@ layout(binding = 1, rgba32f) uniform image2D outputImage;
 #endif
 
 #ifdef GBUFFER
-layout(binding = 15, r32f) uniform image2D depthImage;
-layout(binding = 16, rg32f) uniform image2D normalImage;
-layout(binding = 17, rgba8) uniform image2D materialImage;
+#ifdef VISIBILITY_BUFFER
+// instance index and primitive id of the primary hit, the consumers reconstruct the surface (see visibility.glsl)
+layout(binding = 52, rg32ui) uniform uimage2D visibilityImage;
+#else
+#include "gbufferEncoding.glsl"
+layout(binding = 15, GBUFFER_DEPTH_FORMAT) uniform image2D depthImage;
+layout(binding = 16, GBUFFER_NORMAL_FORMAT) uniform image2D normalImage;
+layout(binding = 17, GBUFFER_MATERIAL_FORMAT) uniform image2D materialImage;
+#endif
 layout(binding = 18, rgba8) uniform image2D albedoImage;
 #endif
 
@@ -16,4 +22,15 @@ layout(binding = 18, rgba8) uniform image2D albedoImage;
 layout(binding = 25, rgba32f) uniform image2D illumination;
 #endif
 
+#ifdef RAY_ORIGIN_GBUFFER
+// primary hits of the GBufferRasterizer: instance index, primitive index and barycentrics as float bits
+layout(binding = 51, rgba32ui) uniform readonly uimage2D primaryHitImage;
+#endif
+
+#ifdef COST_HEATMAP
+// x shader time in realtime clock ticks, y bounce rays, z shadow rays, w any hit invocations
+layout(binding = 28, rgba32f) uniform image2D costImage;
+layout(binding = 29, r32ui) uniform coherent uimage2D anyHitCountImage;
+#endif
+
 #endif //LAYOUTPTIMAGES_H
\ No newline at end of file
@@ -0,0 +1,19 @@
+#ifndef LAYOUTPTRADIANCECACHE_H
+#define LAYOUTPTRADIANCECACHE_H
+
+#ifdef RADIANCE_CACHE
+struct RadianceCacheEntry{
+  uint checksum;      // 0 for empty slots, 1 for evicted slots
+  uint age;           // frames since the last sample
+  uint sampleCount;   // samples accumulated in the current frame
+  uint historyLength; // samples the resolved radiance is averaged over
+  uvec4 accumulated;  // rgb radiance of the current frame in fixed point (c_RadianceCacheScale)
+  vec4 radiance;      // resolved rgb radiance, written by radianceCache.comp
+};
+// hash grid of the outgoing radiance at path vertices (see RadianceCacheBuffer.hpp), the length is a power of two
+layout(binding = 42) buffer RadianceCache{
+  RadianceCacheEntry entries[];
+} radianceCache;
+#endif
+
+#endif //LAYOUTPTRADIANCECACHE_H
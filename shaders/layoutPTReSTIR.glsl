@@ -0,0 +1,29 @@
+#ifndef LAYOUTPTRESTIR_H
+#define LAYOUTPTRESTIR_H
+
+#if defined RESTIR_DI || defined RESTIR_GI
+// x direct lighting candidate count M, y primary hit distance, zw compressed primary hit normal
+layout(binding = 32, rgba32f) uniform image2D reservoirSurfaces;
+// surfaces of the previous frame, the prev images are copied after every trace rays (see ReservoirBuffer.hpp)
+layout(binding = 33, rgba32f) uniform readonly image2D prevReservoirSurfaces;
+#endif
+
+#ifdef RESTIR_DI
+// x light index, yz light sample, w reservoir weight W
+layout(binding = 34, rgba32f) uniform image2D reservoirs;
+layout(binding = 35, rgba32f) uniform readonly image2D prevReservoirs;
+#endif
+
+#ifdef RESTIR_GI
+// xyz secondary hit position, w reservoir weight W
+layout(binding = 36, rgba32f) uniform image2D giSamples;
+// xyz outgoing radiance of the secondary hit towards the primary hit, w candidate count M
+layout(binding = 37, rgba32f) uniform image2D giRadiance;
+// xy compressed secondary hit normal
+layout(binding = 38, rg32f) uniform image2D giNormals;
+layout(binding = 39, rgba32f) uniform readonly image2D prevGISamples;
+layout(binding = 40, rgba32f) uniform readonly image2D prevGIRadiance;
+layout(binding = 41, rg32f) uniform readonly image2D prevGINormals;
+#endif
+
+#endif //LAYOUTPTRESTIR_H
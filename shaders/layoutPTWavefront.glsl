@@ -0,0 +1,134 @@
+#ifndef LAYOUTPTWAVEFRONT_H
+#define LAYOUTPTWAVEFRONT_H
+
+// Work queues of the wavefront path tracer (see WavefrontBuffer.hpp). Every path of a launch owns the slot of its
+// pixel in the path states and hit records, the queues hold path slots.
+
+// material classes, every class is shaded by its own dispatch so the invocations of a dispatch take the same branches
+const uint mc_opaque = 0;
+const uint mc_transmissive = 1;
+const uint c_MaterialClassCount = 2;
+
+struct PathState{
+  vec4 origin;          // xyz origin of the next ray, w ray cone width at the origin
+  vec4 direction;       // xyz direction of the next ray, w ray cone spread angle
+  vec4 throughput;
+  vec4 radiance;        // radiance of the hit surfaces, written by the trace stage for extension rays
+  vec4 shadowRadiance;  // radiance of the unoccluded shadow rays, written by the trace stage for shadow rays
+  uvec4 rngState;       // RandomEngine.state
+  uvec4 rngSample;      // x pixel packed into 16 bit each, y pixel seed, z sample index, w vertex
+  uvec4 info;           // x bounces, y transmissions, z termination (see rayStatistics.glsl), w shadow rays
+};
+
+// surface at the end of the last extension ray of a path, a packed SurfaceInfo
+struct HitRecord{
+  vec4 positionIor;           // xyz hit position, w index of refraction
+  vec4 normalRoughness;       // xyz shading normal, w perceptual roughness
+  vec4 basis0Metalness;
+  vec4 basis1AlphaRoughness;
+  vec4 basis2Illumination;    // w illumination type
+  vec4 diffuseColor;
+  vec4 specularColor;
+  vec4 reflectance0;
+  vec4 reflectance90;
+  vec4 transmissiveColor;
+};
+
+struct ShadowRay{
+  vec4 originTmax;            // xyz origin, w length of the ray
+  vec4 directionSlot;         // xyz direction, w path slot as uint bits
+  vec4 contribution;          // radiance added to the path if the light is visible
+};
+
+// the counters are cleared and launchSample is set before every sample (see WavefrontPathTracer.cpp)
+layout(binding = 43) buffer WavefrontQueues{
+  uvec4 traceRays;                            // xyz VkTraceRaysIndirectCommandKHR of the trace stage
+  uvec4 shadeDispatch[c_MaterialClassCount];  // xyz VkDispatchIndirectCommand of the shading stages
+  uint launchSample;
+  uint traceExtensionCount;                   // extension rays of the trace stage, they precede the shadow rays
+  uint extensionCount;
+  uint shadowCount;
+  uint shadeCount[c_MaterialClassCount];
+} wfQueues;
+
+layout(binding = 44) buffer PathStates{ PathState paths[]; } wfPaths;
+layout(binding = 45) buffer HitRecords{ HitRecord hits[]; } wfHits;
+layout(binding = 46) buffer ExtensionQueue{ uint extensionRays[]; } wfExtensionQueue;
+layout(binding = 47) buffer ShadowQueue{ ShadowRay shadowRays[]; } wfShadowQueue;
+// path slots sorted by material class, class c occupies [c * path count, (c + 1) * path count)
+layout(binding = 48) buffer ShadeQueues{ uint shadeRays[]; } wfShadeQueues;
+
+uint wfPathCount(){
+  return uint(wfPaths.paths.length());
+}
+
+void wfPushExtensionRay(uint slot){
+  wfExtensionQueue.extensionRays[atomicAdd(wfQueues.extensionCount, 1)] = slot;
+}
+
+void wfPushShadowRay(uint slot, vec3 origin, vec3 direction, float tmax, vec3 contribution){
+  uint index = atomicAdd(wfQueues.shadowCount, 1);
+  wfShadowQueue.shadowRays[index].originTmax = vec4(origin, tmax);
+  wfShadowQueue.shadowRays[index].directionSlot = vec4(direction, uintBitsToFloat(slot));
+  wfShadowQueue.shadowRays[index].contribution = vec4(contribution, 0);
+}
+
+void wfPushShadeRay(uint slot, uint materialClass){
+  uint index = atomicAdd(wfQueues.shadeCount[materialClass], 1);
+  wfShadeQueues.shadeRays[materialClass * wfPathCount() + index] = slot;
+}
+
+#ifdef PTSTRUCTURES_H
+void wfStoreHit(uint slot, vec3 position, SurfaceInfo s){
+  wfHits.hits[slot].positionIor = vec4(position, s.indexOfRefraction);
+  wfHits.hits[slot].normalRoughness = vec4(s.normal, s.perceptualRoughness);
+  wfHits.hits[slot].basis0Metalness = vec4(s.basis[0], s.metalness);
+  wfHits.hits[slot].basis1AlphaRoughness = vec4(s.basis[1], s.alphaRoughness);
+  wfHits.hits[slot].basis2Illumination = vec4(s.basis[2], float(s.illuminationType));
+  wfHits.hits[slot].diffuseColor = vec4(s.diffuseColor, 0);
+  wfHits.hits[slot].specularColor = vec4(s.specularColor, 0);
+  wfHits.hits[slot].reflectance0 = vec4(s.reflectance0, 0);
+  wfHits.hits[slot].reflectance90 = vec4(s.reflectance90, 0);
+  wfHits.hits[slot].transmissiveColor = vec4(s.transmissiveColor, 0);
+}
+
+SurfaceInfo wfLoadHit(uint slot, out vec3 position){
+  HitRecord h = wfHits.hits[slot];
+  SurfaceInfo s;
+  position = h.positionIor.xyz;
+  s.indexOfRefraction = h.positionIor.w;
+  s.normal = h.normalRoughness.xyz;
+  s.perceptualRoughness = h.normalRoughness.w;
+  s.basis = mat3(h.basis0Metalness.xyz, h.basis1AlphaRoughness.xyz, h.basis2Illumination.xyz);
+  s.metalness = h.basis0Metalness.w;
+  s.alphaRoughness = h.basis1AlphaRoughness.w;
+  s.illuminationType = int(h.basis2Illumination.w);
+  s.diffuseColor = h.diffuseColor.xyz;
+  s.specularColor = h.specularColor.xyz;
+  s.reflectance0 = h.reflectance0.xyz;
+  s.reflectance90 = h.reflectance90.xyz;
+  s.transmissiveColor = h.transmissiveColor.xyz;
+  s.emissiveColor = vec3(0);   // added by the trace stage
+  return s;
+}
+#endif
+
+#ifdef RANDOM_H
+void wfStoreRandomEngine(uint slot, RandomEngine re){
+  wfPaths.paths[slot].rngState = re.state;
+  wfPaths.paths[slot].rngSample = uvec4(re.pixel.x | (re.pixel.y << 16), re.pixelSeed, re.sampleIndex, re.vertex);
+}
+
+RandomEngine wfLoadRandomEngine(uint slot){
+  uvec4 rngSample = wfPaths.paths[slot].rngSample;
+  RandomEngine re;
+  re.state = wfPaths.paths[slot].rngState;
+  re.pixel = uvec2(rngSample.x & 0xffff, rngSample.x >> 16);
+  re.pixelSeed = rngSample.y;
+  re.sampleIndex = rngSample.z;
+  re.vertex = rngSample.w;
+  return re;
+}
+#endif
+
+#endif //LAYOUTPTWAVEFRONT_H
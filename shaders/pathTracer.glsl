@@ -0,0 +1,263 @@
+#ifndef PATHTRACER_H
+#define PATHTRACER_H
+
+// megakernel path tracer, every invocation traces all samples of its pixel. Included by ptRaygen.rgen for the ray
+// tracing pipeline and by the compute backends ptRayQuery.comp and ptSoftwareBVH.comp, which define COMPUTE_LAUNCH.
+
+#include "ptStructures.glsl"
+#include "layoutPTAccel.glsl"
+#include "layoutPTImages.glsl"
+#include "layoutPTLights.glsl"
+#include "layoutPTUniform.glsl"
+#include "layoutPTPushConstants.glsl"
+#include "layoutPTAdaptiveSampling.glsl"
+#include "layoutPTReSTIR.glsl"
+#include "layoutPTRadianceCache.glsl"
+#include "rayStatistics.glsl"
+
+#ifdef COMPUTE_LAUNCH
+// the rays are traced inline, see trace.glsl
+RayPayload rayPayload;
+#else
+layout(location = 0) rayPayloadEXT bool shadowed;
+layout(location = 1) rayPayloadEXT RayPayload rayPayload;
+uint rayFlags = gl_RayFlagsNoOpaqueEXT | gl_RayFlagsOpaqueEXT;
+#endif
+uint cullMask = 0xff;
+float tmin = 0.001;
+float tmax = 10000.0;
+// rays traced by this invocation, only written to the statistics buffer with RAY_STATISTICS
+uint bounceRayCount = 0;
+uint shadowRayCount = 0;
+bool pathTerminated = false;
+uint pathTermination = pt_maxDepth;
+
+#ifdef RADIANCE_CACHE
+#include "radianceCache.glsl"
+#endif
+#include "camera.glsl"
+#include "trace.glsl"
+#include "lighting.glsl"
+#if defined RESTIR_DI || defined RESTIR_GI
+#include "restir.glsl"
+#endif
+
+// samples traced one after another by every invocation, camParams.sampleNumber counts launches
+layout(constant_id = 0) const uint samplesPerLaunch = 1;
+
+void main(){
+	ivec2 pixel = launchPixel();
+	uvec2 imSize = launchImageSize();
+#ifdef COMPUTE_LAUNCH
+	// the workgroups cover the image in tiles
+	if(any(greaterThanEqual(uvec2(pixel), imSize))) return;
+#endif
+#ifdef COST_HEATMAP
+	uvec2 startClock = clockRealtime2x32EXT();
+	imageStore(anyHitCountImage, pixel, uvec4(0));
+#endif
+	// the white noise continues over the samples of a launch, but every launch of a frame needs its own seed. Seeded
+	// by the frame alone, the launches would repeat the same samples and adaptive sampling would see no variance
+	RandomEngine re = rEInit(uvec2(pixel), wangHash(camParams.frameNumber) ^ camParams.sampleNumber);
+	uint prevSampleCount = camParams.sampleNumber * samplesPerLaunch;
+#ifdef ADAPTIVE_SAMPLING
+	// converged pixels are not traced anymore, so every pixel has its own sample count
+	vec4 statistics = camParams.sampleNumber > 0 ? imageLoad(sampleStatistics, pixel) : vec4(0);
+	prevSampleCount = uint(statistics.x);
+#endif
+	vec3 colorSum = vec3(0);
+#ifdef RESTIR_DI
+	Reservoir pixelReservoir = emptyReservoir();
+#endif
+#ifdef RESTIR_GI
+	GIReservoir giReservoir = emptyGIReservoir();
+	vec3 giReservoirPos = vec3(0);
+#endif
+#if defined DEMOD_ILLUMINATION_FLOAT
+	vec3 demodulatedSum = vec3(0);
+#endif
+	for(uint launchSample = 0; launchSample < samplesPerLaunch; ++launchSample){
+		// --------------------------------------------------------------------
+		// ray generation (including first hit infos and first hit direct lighting)
+		// --------------------------------------------------------------------
+		vec3 throughput = vec3(1);
+		vec4 worldSpacePos, worldSpaceDir;
+		bool antiAlias = false;
+		#if defined FINAL_IMAGE && !defined RAY_ORIGIN_GBUFFER
+		#ifndef DEMOD_ILLUMINATION
+		#ifndef DEMOD_ILLUMINATION_SQUARED
+		if(prevSampleCount + launchSample > 0)
+			antiAlias = true;	//can not be done when reprojecting, never is done for first sample
+		#endif
+		#endif
+		#endif
+		// the blue noise sampler rescrambles the sequence for every block of 2^blueNoiseLog2Samples samples
+		rESetSample(re, prevSampleCount + launchSample);
+		pathTerminated = false;
+		pathTermination = pt_maxDepth;
+#ifdef RADIANCE_CACHE
+		radianceCacheBeginPath(pixel, camParams.frameNumber * samplesPerLaunch + launchSample);
+#endif
+		uint prevBounceRayCount = bounceRayCount;
+		createRay(uvec2(pixel), imSize, antiAlias, re, worldSpacePos, worldSpaceDir);
+		rayPayload.cone = vec2(0, pixelSpreadAngle(imSize));
+#ifdef RAY_ORIGIN_GBUFFER
+		// the primary hit of the pixel center is rasterized, all samples start from it
+		loadPrimaryHit(pixel, worldSpacePos.xyz, worldSpaceDir.xyz);
+#else
+		traceSurface(worldSpacePos.xyz, worldSpaceDir.xyz);
+#endif
+		vec3 finalColor = vec3(0);
+#ifdef RESTIR_DI
+		if(rayPayload.si.normal != vec3(1)){
+			finalColor += restirDirectLighting(pixel, imSize, rayPayload.position, -normalize(worldSpaceDir.xyz), rayPayload.si, launchSample == 0, pixelReservoir, re);
+		}
+		else{
+			finalColor += nextEventEsitmation(rayPayload.position, -normalize(worldSpaceDir.xyz), rayPayload.si, throughput, re);
+			pixelReservoir = emptyReservoir();
+		}
+#else
+		finalColor += nextEventEsitmation(rayPayload.position, -normalize(worldSpaceDir.xyz), rayPayload.si, throughput, re);
+#endif
+		finalColor += rayPayload.si.emissiveColor;
+		// --------------------------------------------------------------------
+		// storing GBuffer information, the primary hit is the same for all samples without anti aliasing
+		// --------------------------------------------------------------------
+		vec3 curAlbedo = (rayPayload.si.diffuseColor + rayPayload.si.specularColor).xyz;
+		float depth = distance(rayPayload.position, worldSpacePos.xyz);
+		vec3 curNorm = rayPayload.si.normal;
+#ifdef GBUFFER
+		if(launchSample == 0){
+#ifdef VISIBILITY_BUFFER
+			imageStore(visibilityImage, pixel, uvec4(rayPayload.instanceIndex, rayPayload.primitiveID, 0, 0));
+#else
+			imageStore(depthImage, pixel, vec4(encodeDepth(depth)));
+			imageStore(normalImage, pixel, vec4(encodeNormal(rayPayload.si.normal), 1, 1));
+			float category_id = float(rayPayload.category_id) / 255.0;
+			imageStore(materialImage, pixel, vec4(category_id, 0, 0, 0));
+#endif
+			imageStore(albedoImage, pixel, vec4(curAlbedo, 1));
+		}
+#endif
+
+		// --------------------------------------------------------------------
+		//depth recursion
+		// --------------------------------------------------------------------
+#if defined FINAL_IMAGE || defined DEMOD_ILLUMINATION || defined DEMOD_ILLUMINATION_SQUARED || defined DEMOD_ILLUMINATION_FLOAT
+#ifdef RESTIR_GI
+		// the first bounce of opaque primary hits is resampled, transmissive ones are path traced as usual
+		bool reuseFirstBounce = rayPayload.si.normal != vec3(1) && rayPayload.si.illuminationType != 7;
+		if(!reuseFirstBounce) giReservoir = emptyGIReservoir();
+		if(reuseFirstBounce){
+			finalColor += restirIndirectLighting(pixel, imSize, rayPayload.position, -normalize(worldSpaceDir.xyz), rayPayload.si, launchSample == 0, giReservoir, giReservoirPos, re);
+		}
+		else
+#endif
+		if(rayPayload.si.normal != vec3(1)){
+			int transDepth = 0;
+			for(int i = 0; i < infos.maxRecursionDepth && transDepth < 10; ++i){
+				if(rayPayload.si.illuminationType == 7) --i, ++transDepth;
+				vec3 v = normalize(worldSpacePos.xyz - rayPayload.position);
+				worldSpacePos = vec4(rayPayload.position, 1);
+				vec3 indir = indirectLighting(worldSpacePos.xyz, v, rayPayload.si, i, throughput, re);
+				finalColor += indir;
+				if(pathTerminated) break;
+				if(rayPayload.si.normal == vec3(1)){
+					pathTerminated = true;
+					pathTermination = pt_escaped;
+					break;
+				}
+			}
+			if(!pathTerminated && transDepth >= 10) pathTermination = pt_maxTransmissionDepth;
+		}
+		else{
+			pathTermination = pt_escaped;
+		}
+#endif
+#ifdef RADIANCE_CACHE
+		radianceCacheEndPath();
+#endif
+#if defined RESTIR_DI || defined RESTIR_GI
+		// the reservoirs of the last sample of the launch are reused in the next frame
+		if(launchSample == samplesPerLaunch - 1){
+			float directLightingCount = 0;
+#ifdef RESTIR_DI
+			storeReservoir(pixel, pixelReservoir);
+			directLightingCount = pixelReservoir.M;
+#endif
+#ifdef RESTIR_GI
+			storeGIReservoir(pixel, giReservoir);
+#endif
+			bool primaryHit = curNorm != vec3(1);
+			storeReservoirSurface(pixel, directLightingCount, primaryHit ? depth : 0, primaryHit ? curNorm : vec3(0, 0, 1));
+		}
+#endif
+
+		finalColor = clamp(finalColor, vec3(0), vec3(c_MaxRadiance));
+		colorSum += finalColor;
+#if defined DEMOD_ILLUMINATION_FLOAT
+		vec3 demodulated = finalColor;
+		if(!isinf(rayPayload.position.x)){
+			demodulated = min(finalColor / (curAlbedo + vec3(EPSILON)), vec3(1e3));
+		}
+		demodulatedSum += demodulated;
+#endif
+#ifdef ADAPTIVE_SAMPLING
+		float sampleLuminance = luminance(finalColor);
+		statistics.x += 1;
+		float delta = sampleLuminance - statistics.y;
+		statistics.y += delta / statistics.x;
+		statistics.z += delta * (sampleLuminance - statistics.y);
+#endif
+#ifdef RAY_STATISTICS
+		atomicAdd(rayStatistics.terminations[pathTermination], 1);
+		atomicAdd(rayStatistics.pathLengths[min(1 + bounceRayCount - prevBounceRayCount, c_MaxStatisticsPathLength)], 1);
+#endif
+	}
+
+    // --------------------------------------------------------------------
+	// final color calculations
+	// --------------------------------------------------------------------
+	vec3 finalColor = colorSum / samplesPerLaunch;
+
+#if defined DEMOD_ILLUMINATION_FLOAT
+	imageStore(illumination, pixel, vec4(demodulatedSum / samplesPerLaunch, 1));
+#endif
+
+#ifdef FINAL_IMAGE
+#ifdef ADAPTIVE_SAMPLING
+	imageStore(sampleStatistics, pixel, statistics);
+#endif
+	if(prevSampleCount > 0){
+		vec3 prevFrameColor = imageLoad(outputImage, pixel).xyz;
+		float alpha = float(samplesPerLaunch) / (prevSampleCount + samplesPerLaunch);
+		finalColor = mix(SRGBtoLINEAR(vec4(prevFrameColor,1)).xyz, finalColor, alpha);
+	}
+
+	finalColor = LINEARtoSRGB(vec4(finalColor, 1)).xyz;
+	finalColor = clamp(finalColor, vec3(0), vec3(1));
+
+	imageStore(outputImage, pixel, vec4(finalColor, 1));
+#endif
+
+#ifdef COST_HEATMAP
+	uvec2 endClock = clockRealtime2x32EXT();
+	// the difference is taken in integers with a borrow, a float has no tick precision near 2^32
+	uint timeLow = endClock.x - startClock.x;
+	uint timeHigh = endClock.y - startClock.y - (endClock.x < startClock.x ? 1u : 0u);
+	float shaderTime = float(timeHigh) * 4294967296.0 + float(timeLow);
+	uint anyHitCount = imageLoad(anyHitCountImage, pixel).x;
+	imageStore(costImage, pixel, vec4(shaderTime, bounceRayCount, shadowRayCount, anyHitCount));
+#endif
+
+#ifdef RAY_STATISTICS
+	// the ray counts are accumulated locally over all samples of the launch
+#ifndef RAY_ORIGIN_GBUFFER
+	atomicAdd(rayStatistics.primaryRays, samplesPerLaunch);
+#endif
+	atomicAdd(rayStatistics.bounceRays, bounceRayCount);
+	atomicAdd(rayStatistics.shadowRays, shadowRayCount);
+#endif
+}
+
+#endif //PATHTRACER_H
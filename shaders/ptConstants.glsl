@@ -9,5 +9,7 @@ const float BLEND_ALPHA = .2f;
 const float c_MinRoughness = 0.04;
 const float c_MaxRadiance = 1e1;
 const float c_MinTermination = 0.05;
+const float c_ConeRoughnessSpread = 0.5;    // additional ray cone spread angle per unit of alpha roughness at a bounce
+const uint c_NoPrimaryHit = 0xffffffff;     // instance index of misses in RayPayload and the primary hit images
 
 #endif //PTCONSTANTS_H
\ No newline at end of file
@@ -96,6 +96,9 @@ struct RayPayload {
 	vec3 position;
     SurfaceInfo si;
     uint category_id;
+    vec2 cone;          // ray cone for texture lod: x = width at the ray origin (updated to the width at the hit), y = spread angle
+    uint instanceIndex; // custom index of the hit instance, c_NoPrimaryHit for a miss
+    uint primitiveID;
 };
 
 #endif //PTSTRUCTURES_H
\ No newline at end of file
@@ -0,0 +1,114 @@
+#ifndef RADIANCECACHE_H
+#define RADIANCECACHE_H
+
+#include "ptConstants.glsl"
+#include "random.glsl"
+
+// World space radiance cache. The cells of a hash grid whose size grows with the distance to the camera store the
+// outgoing radiance of the path vertices in them, separated by the dominant axis of the normal. A small part of the
+// paths is traced to full length and adds the radiance of all its vertices to the cache, every other path ends at
+// the first hit after a rough bounce if the cell of that hit has enough samples.
+
+const float c_RadianceCacheCellSize = .05;       // cell size at distance 1 to the camera, doubles every octave
+const uint c_RadianceCacheProbes = 8;            // slots searched for a cell with linear probing
+const float c_RadianceCacheScale = 1024;         // fixed point scale of the accumulated radiance
+const uint c_RadianceCacheMinSamples = 16;       // samples a cell needs before paths end in it
+const float c_RadianceCacheMinRoughness = .25;   // alpha roughness of a surface whose bounce may end in the cache
+const uint c_RadianceCacheTrainingRatio = 16;    // one in this many paths updates the cache
+const uint c_RadianceCacheMaxVertices = 8;       // vertices of a training path added to the cache
+// checksums of free slots. Evicted slots are tombstones, lookups continue past them so the probe chains of the cells
+// behind them stay intact, and inserts reuse them
+const uint c_RadianceCacheEmpty = 0;
+const uint c_RadianceCacheTombstone = 1;
+
+// vertices of the current training path, every contribution of the path is added to the radiance of all vertices
+// before it, the outgoing radiance of a vertex is its radiance divided by its throughput
+bool radianceCacheTraining = false;
+uint radianceCacheVertexCount = 0;
+vec3 radianceCachePositions[c_RadianceCacheMaxVertices];
+vec3 radianceCacheNormals[c_RadianceCacheMaxVertices];
+vec3 radianceCacheThroughputs[c_RadianceCacheMaxVertices];
+vec3 radianceCacheRadiance[c_RadianceCacheMaxVertices];
+
+//key of the cell containing pos
+uint radianceCacheKey(vec3 pos, vec3 normal){
+  float level = clamp(floor(log2(max(distance(pos, camParams.inverseViewMatrix[3].xyz), 1))), 0, 15);
+  ivec3 cell = ivec3(floor(pos / (c_RadianceCacheCellSize * exp2(level))));
+  vec3 a = abs(normal);
+  uint axis = a.x > a.y ? (a.x > a.z ? 0 : 2) : (a.y > a.z ? 1 : 2);
+  uint normalBucket = axis * 2 + (normal[axis] < 0 ? 1 : 0);
+  uint key = wangHash(uint(cell.x) ^ wangHash(uint(cell.y) ^ wangHash(uint(cell.z) ^ wangHash(uint(level) << 3 | normalBucket))));
+  return max(key, 1);
+}
+
+//slot of the cell with the given key, -1 if the cell is not in the cache and could not be inserted
+int radianceCacheFind(uint key, bool insert){
+  uint count = uint(radianceCache.entries.length());
+  uint checksum = max(wangHash(key ^ 0x9e3779b9), c_RadianceCacheTombstone + 1);
+  int tombstone = -1;
+  for(uint p = 0; p < c_RadianceCacheProbes; ++p){
+    uint slot = (key + p) & (count - 1);
+    uint stored = radianceCache.entries[slot].checksum;
+    if(stored == checksum) return int(slot);
+    if(stored == c_RadianceCacheTombstone && tombstone < 0) tombstone = int(slot);
+    if(stored != c_RadianceCacheEmpty) continue;
+    if(!insert) return -1;
+    // the cell is not further down the chain, so the first evicted slot before the empty one is reused
+    if(tombstone >= 0){
+      stored = atomicCompSwap(radianceCache.entries[tombstone].checksum, c_RadianceCacheTombstone, checksum);
+      if(stored == c_RadianceCacheTombstone || stored == checksum) return tombstone;
+    }
+    stored = atomicCompSwap(radianceCache.entries[slot].checksum, c_RadianceCacheEmpty, checksum);
+    if(stored == c_RadianceCacheEmpty || stored == checksum) return int(slot);
+  }
+  if(insert && tombstone >= 0){
+    uint stored = atomicCompSwap(radianceCache.entries[tombstone].checksum, c_RadianceCacheTombstone, checksum);
+    if(stored == c_RadianceCacheTombstone || stored == checksum) return tombstone;
+  }
+  return -1;
+}
+
+bool radianceCacheLookup(vec3 pos, vec3 normal, out vec3 radiance){
+  radiance = vec3(0);
+  int slot = radianceCacheFind(radianceCacheKey(pos, normal), false);
+  if(slot < 0 || radianceCache.entries[slot].historyLength < c_RadianceCacheMinSamples) return false;
+  radiance = radianceCache.entries[slot].radiance.rgb;
+  return true;
+}
+
+void radianceCacheAdd(vec3 pos, vec3 normal, vec3 radiance){
+  int slot = radianceCacheFind(radianceCacheKey(pos, normal), true);
+  if(slot < 0) return;
+  uvec3 fixedPoint = uvec3(clamp(radiance, vec3(0), vec3(c_MaxRadiance)) * c_RadianceCacheScale);
+  atomicAdd(radianceCache.entries[slot].sampleCount, 1);
+  atomicAdd(radianceCache.entries[slot].accumulated.r, fixedPoint.r);
+  atomicAdd(radianceCache.entries[slot].accumulated.g, fixedPoint.g);
+  atomicAdd(radianceCache.entries[slot].accumulated.b, fixedPoint.b);
+}
+
+//selects the paths which update the cache, the selection changes every sample
+void radianceCacheBeginPath(ivec2 pixel, uint sampleIndex){
+  radianceCacheVertexCount = 0;
+  radianceCacheTraining = wangHash(wangHash(uint(pixel.x) ^ wangHash(uint(pixel.y))) ^ sampleIndex) % c_RadianceCacheTrainingRatio == 0;
+}
+
+//contribution of the path vertex at pos which was reached with throughput, escaped paths add no vertex
+void radianceCacheRecordVertex(vec3 pos, vec3 normal, vec3 throughput, vec3 contribution){
+  if(!radianceCacheTraining) return;
+  for(uint i = 0; i < radianceCacheVertexCount; ++i)
+    radianceCacheRadiance[i] += contribution;
+  if(normal == vec3(1) || radianceCacheVertexCount == c_RadianceCacheMaxVertices) return;
+  radianceCachePositions[radianceCacheVertexCount] = pos;
+  radianceCacheNormals[radianceCacheVertexCount] = normal;
+  radianceCacheThroughputs[radianceCacheVertexCount] = throughput;
+  radianceCacheRadiance[radianceCacheVertexCount] = contribution;
+  ++radianceCacheVertexCount;
+}
+
+void radianceCacheEndPath(){
+  if(!radianceCacheTraining) return;
+  for(uint i = 0; i < radianceCacheVertexCount; ++i)
+    radianceCacheAdd(radianceCachePositions[i], radianceCacheNormals[i], radianceCacheRadiance[i] / max(radianceCacheThroughputs[i], vec3(EPSILON)));
+}
+
+#endif //RADIANCECACHE_H
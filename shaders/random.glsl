@@ -8,6 +8,11 @@
 //};
 struct RandomEngine{
     uvec4 state;
+    // low discrepancy sampler state, see sampler.glsl
+    uvec2 pixel;
+    uint pixelSeed;
+    uint sampleIndex;
+    uint vertex;
 };
 
 uint rotl(uint x, uint k){
@@ -92,6 +97,10 @@ RandomEngine rEInit(uvec2 id, uint frameIndex){
     re.state.y = wangHash(s1);
     re.state.z = wangHash(s2);
     re.state.w = wangHash(s3);
+    re.pixel = id;
+    re.pixelSeed = wangHash(id.x ^ wangHash(id.y));  // independent of the frame, sequences are deterministic per pixel
+    re.sampleIndex = 0;
+    re.vertex = 0;
     return re;
 }
 
@@ -0,0 +1,27 @@
+#version 460
+#extension GL_EXT_nonuniform_qualifier : enable
+#extension GL_GOOGLE_include_directive : enable
+
+#pragma import_defines (ALPHA_TEST)
+
+// writes the primary hit of the pixel center like a closest hit, the path tracer reconstructs the surface from it
+// (RAY_ORIGIN_GBUFFER in pathTracer.glsl). Only the alpha tested instances are drawn with ALPHA_TEST, so the opaque
+// ones keep the early depth test.
+
+#include "surfaceHit.glsl"
+// not read here, the scene descriptors shared with the path tracer bind the lights as well
+#include "layoutPTLights.glsl"
+
+layout(location = 0) in vec2 barycentrics;
+layout(location = 1) flat in int instanceIndex;
+layout(location = 2) flat in int primitiveID;
+
+// instance index, primitive index and the barycentrics as float bits, cleared to c_NoPrimaryHit
+layout(location = 0) out uvec4 primaryHit;
+
+void main(){
+#ifdef ALPHA_TEST
+  if(!alphaTest(instanceIndex, primitiveID, barycentrics)) discard;
+#endif
+  primaryHit = uvec4(instanceIndex, primitiveID, floatBitsToUint(barycentrics));
+}
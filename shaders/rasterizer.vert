@@ -0,0 +1,34 @@
+#version 460
+#extension GL_EXT_nonuniform_qualifier : enable
+#extension GL_GOOGLE_include_directive : enable
+
+// primary visibility of the GBufferRasterizer. The vertices are pulled from the scene descriptors of the path tracer,
+// every instance is drawn with 3 vertices per triangle and its instance index as first instance.
+
+#include "ptStructures.glsl"
+#include "layoutPTGeometry.glsl"
+#include "geometry.glsl"
+
+layout(push_constant) uniform RasterConstants{
+  mat4 viewProjection;
+} raster;
+
+layout(location = 0) out vec2 barycentrics;
+layout(location = 1) flat out int instanceIndex;
+layout(location = 2) flat out int primitiveID;
+
+void main(){
+  ObjectInstance instance = instances.i[gl_InstanceIndex];
+  uint objId = uint(instance.meshId);
+  uint corner = gl_VertexIndex % 3;
+  uvec3 index = unpackIndex(objId, gl_VertexIndex / 3, instance.indexStride);
+  uint vertexIndex = corner == 0 ? index.x : corner == 1 ? index.y : index.z;
+  vec3 position = unpackVertex(vertexIndex, objId).pos;
+
+  // the barycentrics of the second and third corner, like the hit attributes of a triangle hit
+  barycentrics = vec2(corner == 1, corner == 2);
+  instanceIndex = gl_InstanceIndex;
+  // the draws are not indexed, so every primitive has its own three vertices
+  primitiveID = gl_VertexIndex / 3;
+  gl_Position = raster.viewProjection * instance.objectMat * vec4(position, 1);
+}
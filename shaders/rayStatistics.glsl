@@ -0,0 +1,26 @@
+#ifndef RAYSTATISTICS_H
+#define RAYSTATISTICS_H
+
+// reasons for the end of a path, index into RayStatistics.terminations
+const uint pt_escaped = 0;              // the path left the scene
+const uint pt_russianRoulette = 1;
+const uint pt_absorbed = 2;             // the brdf sample carries no energy
+const uint pt_maxDepth = 3;
+const uint pt_maxTransmissionDepth = 4;
+const uint pt_radianceCache = 5;        // the rest of the path was taken from the radiance cache
+const uint c_PathTerminationCount = 6;
+const uint c_MaxStatisticsPathLength = 16;  // longer paths are counted in the last histogram bucket
+
+// per frame counters, cleared before and read back after every trace rays (see RayStatisticsBuffer.hpp)
+#ifdef RAY_STATISTICS
+layout(binding = 27) buffer RayStatistics{
+  uint primaryRays;
+  uint bounceRays;
+  uint shadowRays;
+  uint anyHitInvocations;
+  uint terminations[c_PathTerminationCount];
+  uint pathLengths[c_MaxStatisticsPathLength + 1];  // number of traced segments including the camera ray
+} rayStatistics;
+#endif
+
+#endif //RAYSTATISTICS_H
@@ -0,0 +1,392 @@
+#ifndef RESTIR_H
+#define RESTIR_H
+
+#include "lighting.glsl"
+
+// Reservoir based spatiotemporal resampling at the primary hit. Every pixel merges the reservoirs of the previous frame
+// at the reprojected pixel and at random pixels around it, so temporal and spatial reuse happen in the same pass.
+// RESTIR_DI (Bitterli et al. 2020) resamples c_ReSTIRCandidates light samples with their unshadowed contribution as
+// target function. A single shadow ray is traced for the selected sample, occluded samples keep their candidate count
+// but lose their weight, which reuses the visibility as well.
+// The candidates are drawn proportional to the light strength with LIGHT_SAMPLE_LIGHT_STRENGTH, uniformly otherwise.
+// RESTIR_GI (Ouyang et al. 2021) resamples the secondary hit of the first bounce together with the radiance its path
+// brought back. Reused secondary hits are weighted with the jacobian of the change of the solid angle between the
+// primary hits and checked for visibility with a single shadow ray.
+
+const uint c_ReSTIRCandidates = 16;
+const uint c_ReSTIRSpatialNeighbours = 4;
+const float c_ReSTIRSpatialRadius = 16;         // in pixels
+const float c_ReSTIRMaxHistory = 20;            // cap of a reused candidate count in multiples of c_ReSTIRCandidates
+const float c_ReSTIRMaxDepthDifference = .1;    // relative to the distance to the camera
+const float c_ReSTIRMinNormalSimilarity = .9;
+const float c_ReSTIRGIMaxHistory = 30;          // cap of a reused secondary hit candidate count
+const float c_ReSTIRGIMaxJacobian = 10;         // reused secondary hits with a larger change of solid angle are skipped
+
+vec2 compressNormal(vec3 n){
+  return vec2(acos(n.z), atan(n.y, n.x));
+}
+
+vec3 decompressNormal(vec2 c){
+  return vec3(sin(c.x) * cos(c.y), sin(c.x) * sin(c.y), cos(c.x));
+}
+
+//m is the candidate count of the direct lighting reservoir
+void storeReservoirSurface(ivec2 pixel, float m, float depth, vec3 normal){
+  imageStore(reservoirSurfaces, pixel, vec4(m, depth, compressNormal(normal)));
+}
+
+//pixel of pos in the previous frame and its distance to the previous camera, the reprojection of accumulator.comp
+bool reprojectToPreviousFrame(vec3 pos, uvec2 imSize, out ivec2 prevPixel, out float prevDepth){
+  vec4 prevClip = inverse(camParams.inverseProjectionMatrix) * camParams.prevView * vec4(pos, 1);
+  prevPixel = ivec2(-1);
+  prevDepth = distance(pos, inverse(camParams.prevView)[3].xyz);
+  if(prevClip.w <= 0) return false;
+  vec2 uv = prevClip.xy / prevClip.w * .5 + .5;
+  prevPixel = ivec2(uv * vec2(imSize));
+  return all(greaterThanEqual(uv, vec2(0))) && all(lessThan(uv, vec2(1)));
+}
+
+//the reprojected pixel for n = 0, a random pixel around it otherwise
+ivec2 reuseCandidatePixel(ivec2 prevPixel, uint n, inout RandomEngine re){
+  if(n == 0) return prevPixel;
+  return prevPixel + ivec2((randomVec2(re) * 2 - 1) * c_ReSTIRSpatialRadius);
+}
+
+//false if the previous frame surface at the pixel does not belong to the current one, m is its direct lighting count
+bool loadMatchingPrevSurface(ivec2 pixel, uvec2 imSize, float prevDepth, vec3 normal, out float m, out float depth){
+  m = 0;
+  depth = 0;
+  if(any(lessThan(pixel, ivec2(0))) || any(greaterThanEqual(pixel, ivec2(imSize)))) return false;
+  vec4 surface = imageLoad(prevReservoirSurfaces, pixel);
+  m = surface.x;
+  depth = surface.y;
+  if(abs(depth - prevDepth) > c_ReSTIRMaxDepthDifference * prevDepth) return false;
+  return dot(decompressNormal(surface.zw), normal) >= c_ReSTIRMinNormalSimilarity;
+}
+
+#ifdef RESTIR_DI
+struct Reservoir{
+  int light;
+  vec2 u;           // light sample, barycentrics for area lights
+  float targetPdf;  // target function of the selected sample at the current surface
+  float wSum;
+  float M;
+  float W;
+};
+
+Reservoir emptyReservoir(){
+  return Reservoir(-1, vec2(0), 0, 0, 0, 0);
+}
+
+//unshadowed light contribution of a light sample in area measure, point and directional lights have no area
+vec3 lightSampleRadiance(vec3 pos, vec3 n, int i, vec2 u, out vec3 l, out float lightTmax){
+  vec3 radiance = lights.l[i].colAmbient.xyz + lights.l[i].colDiffuse.xyz + lights.l[i].colSpecular.xyz;
+  float d = 0, attenuation = 0;
+  lightTmax = 1000.0;
+  l = vec3(0);
+  switch(int(lights.l[i].v0Type.w)){
+    case lst_directional:
+      d = distance(pos, lights.l[i].v0Type.xyz);
+      attenuation = 1.0f / (lights.l[i].strengths.x + lights.l[i].strengths.y * d + lights.l[i].strengths.z * d * d);
+      l = normalize(-lights.l[i].dirAngle2.xyz);
+      return radiance * max(dot(n, l), 0) * attenuation;
+    case lst_point:
+      d = distance(pos, lights.l[i].v0Type.xyz);
+      attenuation = 1.0f / (lights.l[i].strengths.x + lights.l[i].strengths.y * d + lights.l[i].strengths.z * d * d);
+      l = normalize(lights.l[i].v0Type.xyz - pos);
+      lightTmax = d - tmin;
+      return radiance * max(dot(n, l), 0) * attenuation;
+    case lst_area:
+      vec2 barycentrics = sampleTriangle(u);
+      vec3 p1 = lights.l[i].v0Type.xyz;
+      vec3 p2 = lights.l[i].v1Strength.xyz;
+      vec3 p3 = lights.l[i].v2Angle.xyz;
+      vec3 lightDir = blerp(barycentrics, p1, p2, p3) - pos;
+      vec3 lightNormal = normalize(cross(p2 - p1, p3 - p1));
+      d = length(lightDir);
+      l = lightDir / d;
+      attenuation = 1.0f / (lights.l[i].strengths.x + lights.l[i].strengths.y * d + lights.l[i].strengths.z * d * d);
+      lightTmax = d - tmin;
+      return radiance * max(dot(n, l), 0) * max(dot(-l, lightNormal), 0) * attenuation;
+  }
+  return vec3(0);
+}
+
+//probability density of a candidate, in area measure for area lights
+float lightSourcePdf(int i){
+#ifdef LIGHT_SAMPLE_LIGHT_STRENGTH
+  float pdf = singleLightStrength(i) / infos.lightStrengthSum;
+#else
+  float pdf = 1.0 / float(infos.lightCount);
+#endif
+  if(int(lights.l[i].v0Type.w) == lst_area){
+    vec3 p1 = lights.l[i].v0Type.xyz;
+    vec3 p2 = lights.l[i].v1Strength.xyz;
+    vec3 p3 = lights.l[i].v2Angle.xyz;
+    pdf /= .5 * length(cross(p2 - p1, p3 - p1));
+  }
+  return pdf;
+}
+
+int pickLight(float rand){
+#ifdef LIGHT_SAMPLE_LIGHT_STRENGTH
+  return pickLightByStrength(rand);
+#else
+  return min(int(rand * infos.lightCount), int(infos.lightCount) - 1);
+#endif
+}
+
+//luminance of the unshadowed contribution, contribution already contains the brdf and the cosine
+float targetPdf(vec3 pos, vec3 o, SurfaceInfo s, int light, vec2 u, out vec3 contribution, out vec3 l, out float lightTmax){
+  contribution = lightSampleRadiance(pos, s.normal, light, u, l, lightTmax);
+  if(contribution == vec3(0)) return 0;
+  contribution *= BRDF(o, l, normalize(l + o), s);
+  return luminance(contribution);
+}
+
+//p is the target function of the sample, w its resampling weight
+void updateReservoir(inout Reservoir r, int light, vec2 u, float p, float w, float M, inout RandomEngine re){
+  r.wSum += w;
+  r.M += M;
+  if(w > 0 && randomFloat(re) * r.wSum < w){
+    r.light = light;
+    r.u = u;
+    r.targetPdf = p;
+  }
+}
+
+//resamples the sample of q with its target function at the current surface
+void mergeReservoir(inout Reservoir r, Reservoir q, vec3 pos, vec3 o, SurfaceInfo s, inout RandomEngine re){
+  if(q.M <= 0 || q.light < 0 || q.light >= int(infos.lightCount)) return;
+  q.M = min(q.M, c_ReSTIRMaxHistory * c_ReSTIRCandidates);
+  vec3 contribution, l;
+  float lightTmax;
+  float p = targetPdf(pos, o, s, q.light, q.u, contribution, l, lightTmax);
+  updateReservoir(r, q.light, q.u, p, p * q.W * q.M, q.M, re);
+}
+
+void storeReservoir(ivec2 pixel, Reservoir r){
+  imageStore(reservoirs, pixel, vec4(float(r.light), r.u, r.W));
+}
+
+Reservoir loadPrevReservoir(ivec2 pixel, float m){
+  vec4 lightSample = imageLoad(prevReservoirs, pixel);
+  Reservoir r = emptyReservoir();
+  r.light = int(lightSample.x);
+  r.u = lightSample.yz;
+  r.W = lightSample.w;
+  r.M = m;
+  return r;
+}
+
+//direct lighting at the primary hit, pixelReservoir carries the reservoir from one sample of a launch to the next
+vec3 restirDirectLighting(ivec2 pixel, uvec2 imSize, vec3 pos, vec3 o, SurfaceInfo s, bool firstLaunchSample,
+                          inout Reservoir pixelReservoir, inout RandomEngine re){
+  vec3 contribution, l;
+  float lightTmax;
+  Reservoir r = emptyReservoir();
+  for(uint c = 0; c < c_ReSTIRCandidates; ++c){
+    int light = pickLight(randomFloat(re));
+    vec2 u = randomVec2(re);
+    float p = targetPdf(pos, o, s, light, u, contribution, l, lightTmax);
+    updateReservoir(r, light, u, p, p / lightSourcePdf(light), 1, re);
+  }
+
+  if(!firstLaunchSample){
+    mergeReservoir(r, pixelReservoir, pos, o, s, re);
+  }
+  else if(camParams.frameNumber > 0){
+    ivec2 prevPixel;
+    float prevDepth;
+    if(reprojectToPreviousFrame(pos, imSize, prevPixel, prevDepth)){
+      for(uint n = 0; n <= c_ReSTIRSpatialNeighbours; ++n){
+        ivec2 neighbour = reuseCandidatePixel(prevPixel, n, re);
+        float m, neighbourDepth;
+        if(!loadMatchingPrevSurface(neighbour, imSize, prevDepth, s.normal, m, neighbourDepth)) continue;
+        mergeReservoir(r, loadPrevReservoir(neighbour, m), pos, o, s, re);
+      }
+    }
+  }
+
+  r.W = r.targetPdf > 0 ? r.wSum / (r.M * r.targetPdf) : 0;
+  vec3 radiance = vec3(0);
+  if(r.W > 0){
+    targetPdf(pos, o, s, r.light, r.u, contribution, l, lightTmax);
+    ++shadowRayCount;
+    if(traceOcclusion(pos, l, lightTmax)) r.W = 0;
+    else radiance = contribution * r.W;
+  }
+  pixelReservoir = r;
+  return min(radiance, vec3(c_MaxRadiance));
+}
+#endif //RESTIR_DI
+
+#ifdef RESTIR_GI
+struct GIReservoir{
+  vec3 position;    // secondary hit
+  vec3 normal;
+  vec3 radiance;    // outgoing radiance of the secondary hit towards the primary hit it was traced from
+  float targetPdf;  // target function of the selected sample at the current surface
+  float wSum;
+  float M;
+  float W;
+};
+
+GIReservoir emptyGIReservoir(){
+  return GIReservoir(vec3(0), vec3(0, 0, 1), vec3(0), 0, 0, 0, 0);
+}
+
+//luminance of the contribution of the secondary hit of r at pos, contribution contains the brdf and the cosine
+float giTargetPdf(vec3 pos, vec3 o, SurfaceInfo s, GIReservoir r, out vec3 contribution){
+  contribution = vec3(0);
+  vec3 l = normalize(r.position - pos);
+  float cosTheta = dot(l, s.normal);
+  if(cosTheta <= 0 || r.radiance == vec3(0)) return 0;
+  contribution = r.radiance * BRDF(o, l, normalize(l + o), s) * cosTheta;
+  return luminance(contribution);
+}
+
+//p is the target function of the sample, w its resampling weight
+void updateGIReservoir(inout GIReservoir r, GIReservoir lightSample, float p, float w, float M, inout RandomEngine re){
+  r.wSum += w;
+  r.M += M;
+  if(w > 0 && randomFloat(re) * r.wSum < w){
+    r.position = lightSample.position;
+    r.normal = lightSample.normal;
+    r.radiance = lightSample.radiance;
+    r.targetPdf = p;
+  }
+}
+
+//ratio of the solid angle densities of the secondary hit of q seen from qPos and from pos
+float giJacobian(vec3 pos, vec3 qPos, GIReservoir q){
+  vec3 toPos = pos - q.position;
+  vec3 toQPos = qPos - q.position;
+  float cosPos = abs(dot(normalize(toPos), q.normal));
+  float cosQPos = abs(dot(normalize(toQPos), q.normal));
+  return cosPos * dot(toQPos, toQPos) / max(cosQPos * dot(toPos, toPos), EPSILON);
+}
+
+//resamples the secondary hit of q that was traced from the primary hit qPos at the current surface
+void mergeGIReservoir(inout GIReservoir r, GIReservoir q, vec3 qPos, vec3 pos, vec3 o, SurfaceInfo s, inout RandomEngine re){
+  if(q.M <= 0) return;
+  float jacobian = giJacobian(pos, qPos, q);
+  if(isnan(jacobian) || jacobian > c_ReSTIRGIMaxJacobian || jacobian < 1 / c_ReSTIRGIMaxJacobian) return;
+  q.M = min(q.M, c_ReSTIRGIMaxHistory);
+  vec3 contribution;
+  float p = giTargetPdf(pos, o, s, q, contribution);
+  updateGIReservoir(r, q, p, p * q.W * q.M * jacobian, q.M, re);
+}
+
+void storeGIReservoir(ivec2 pixel, GIReservoir r){
+  imageStore(giSamples, pixel, vec4(r.position, r.W));
+  imageStore(giRadiance, pixel, vec4(r.radiance, r.M));
+  imageStore(giNormals, pixel, vec4(compressNormal(r.normal), 0, 0));
+}
+
+GIReservoir loadPrevGIReservoir(ivec2 pixel){
+  vec4 position = imageLoad(prevGISamples, pixel);
+  vec4 radiance = imageLoad(prevGIRadiance, pixel);
+  GIReservoir r = emptyGIReservoir();
+  r.position = position.xyz;
+  r.W = position.w;
+  r.radiance = radiance.xyz;
+  r.M = radiance.w;
+  r.normal = decompressNormal(imageLoad(prevGINormals, pixel).xy);
+  return r;
+}
+
+//primary hit of a pixel in the previous frame reconstructed from its distance to the previous camera
+vec3 prevPrimaryHit(ivec2 pixel, uvec2 imSize, float depth){
+  mat4 prevInverseView = inverse(camParams.prevView);
+  vec2 clipSpaceCoord = (vec2(pixel) + .5) / vec2(imSize) * 2 - 1;
+  vec3 dir = (camParams.inverseProjectionMatrix * vec4(clipSpaceCoord, 1, 1)).xyz;
+  dir = (prevInverseView * vec4(normalize(dir), 0)).xyz;
+  return prevInverseView[3].xyz + dir * depth;
+}
+
+//outgoing radiance of the secondary hit in rayPayload that was traced from prevPos in direction l, continues the path
+//with a throughput of one
+vec3 secondaryHitRadiance(vec3 prevPos, vec3 l, inout RandomEngine re){
+  vec3 throughput = vec3(1);
+  vec3 radiance = nextEventEsitmation(rayPayload.position, -l, rayPayload.si, throughput, re) + rayPayload.si.emissiveColor;
+  int transDepth = 0;
+  for(int i = 1; i < infos.maxRecursionDepth && transDepth < 10; ++i){
+    if(rayPayload.si.normal == vec3(1)) break;
+    if(rayPayload.si.illuminationType == 7) --i, ++transDepth;
+    vec3 v = normalize(prevPos - rayPayload.position);
+    prevPos = rayPayload.position;
+    radiance += indirectLighting(prevPos, v, rayPayload.si, i, throughput, re);
+    if(pathTerminated) break;
+  }
+  if(!pathTerminated){
+    if(rayPayload.si.normal == vec3(1)){
+      pathTerminated = true;
+      pathTermination = pt_escaped;
+    }
+    else if(transDepth >= 10) pathTermination = pt_maxTransmissionDepth;
+  }
+  return radiance;
+}
+
+//indirect lighting at the primary hit pos, traces the path of a new secondary hit and resamples it together with the
+//secondary hits of the previous frame, pixelReservoir and pixelReservoirPos carry the reservoir and the primary hit it
+//belongs to from one sample of a launch to the next
+vec3 restirIndirectLighting(ivec2 pixel, uvec2 imSize, vec3 pos, vec3 o, SurfaceInfo s, bool firstLaunchSample,
+                            inout GIReservoir pixelReservoir, inout vec3 pixelReservoirPos, inout RandomEngine re){
+  // new secondary hit, traced the same way as the first bounce of indirectLighting() but without russian roulette
+  GIReservoir candidate = emptyGIReservoir();
+  vec3 contribution, l;
+  float pdf;
+  vec3 brdf = sampleBRDF(s, re, o, l, pdf);
+  if(brdf != vec3(0) && pdf >= EPSILON && dot(l, s.normal) > 0){
+    rayPayload.cone.y += c_ConeRoughnessSpread * s.alphaRoughness;
+    ++bounceRayCount;
+    traceSurface(pos, l);
+    ++re.vertex;
+    bool escaped = rayPayload.si.normal == vec3(1);
+    candidate.position = escaped ? pos + l * tmax : rayPayload.position;
+    candidate.normal = escaped ? -l : rayPayload.si.normal;
+    candidate.radiance = secondaryHitRadiance(pos, l, re);
+  }
+  else{
+    pathTerminated = true;
+    pathTermination = pt_absorbed;
+  }
+  GIReservoir r = emptyGIReservoir();
+  float p = giTargetPdf(pos, o, s, candidate, contribution);
+  updateGIReservoir(r, candidate, p, pdf >= EPSILON ? p / pdf : 0, 1, re);
+  GIReservoir initial = r;
+
+  if(!firstLaunchSample){
+    mergeGIReservoir(r, pixelReservoir, pixelReservoirPos, pos, o, s, re);
+  }
+  else if(camParams.frameNumber > 0){
+    ivec2 prevPixel;
+    float prevDepth;
+    if(reprojectToPreviousFrame(pos, imSize, prevPixel, prevDepth)){
+      for(uint n = 0; n <= c_ReSTIRSpatialNeighbours; ++n){
+        ivec2 neighbour = reuseCandidatePixel(prevPixel, n, re);
+        float m, neighbourDepth;
+        if(!loadMatchingPrevSurface(neighbour, imSize, prevDepth, s.normal, m, neighbourDepth)) continue;
+        vec3 neighbourPos = prevPrimaryHit(neighbour, imSize, neighbourDepth);
+        mergeGIReservoir(r, loadPrevGIReservoir(neighbour), neighbourPos, pos, o, s, re);
+      }
+    }
+  }
+
+  // a reused secondary hit has to be visible from the current primary hit, the new one is used otherwise
+  if(r.position != initial.position && r.targetPdf > 0){
+    vec3 toSample = r.position - pos;
+    ++shadowRayCount;
+    if(traceOcclusion(pos, normalize(toSample), length(toSample) - 2 * tmin)) r = initial;
+  }
+  r.W = r.targetPdf > 0 ? r.wSum / (r.M * r.targetPdf) : 0;
+  giTargetPdf(pos, o, s, r, contribution);
+  pixelReservoir = r;
+  pixelReservoirPos = pos;
+  return min(contribution * r.W, vec3(c_MaxRadiance));
+}
+#endif //RESTIR_GI
+
+#endif //RESTIR_H
@@ -0,0 +1,158 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include "random.glsl"
+
+// Low discrepancy samples for the path tracer. SAMPLER_SOBOL selects owen scrambled sobol points, SAMPLER_BLUE_NOISE
+// the rank ordered (z-order) sobol variant which distributes the error as blue noise over the screen, without either
+// the white noise of random.glsl is used.
+// Every decision of a path reads a fixed dimension, so the dimensions stay aligned between samples no matter which
+// branches were taken: two camera dimensions followed by c_VertexDimensions for every path vertex.
+// The streaming light selection in LIGHT_SAMPLE_SURFACE_STRENGTH draws a varying count of numbers and stays white noise.
+
+const uint c_DimCamera = 0;             // 2D, pixel jitter
+const uint c_CameraDimensions = 4;
+const uint c_DimLightPick = 0;
+const uint c_DimLightPosition = 1;      // 2D
+const uint c_DimRussianRoulette = 3;
+const uint c_DimBSDFLobe = 4;
+const uint c_DimBSDFDirection = 5;      // 2D
+const uint c_DimRefraction = 7;
+const uint c_VertexDimensions = 8;      // two sets of four, 2D samples never cross a set
+
+// log2 of the samples of a pixel before the blue noise pattern is rescrambled, even and at most 4. Set to the samples
+// per frame, the blue noise only forms over a complete block of samples.
+layout(constant_id = 1) const uint blueNoiseLog2Samples = 4;
+
+// direction numbers of the first four sobol dimensions (Joe and Kuo), 32 per dimension
+const uint c_SobolDirections[128] = uint[](
+    0x80000000u, 0x40000000u, 0x20000000u, 0x10000000u, 0x08000000u, 0x04000000u, 0x02000000u, 0x01000000u,
+    0x00800000u, 0x00400000u, 0x00200000u, 0x00100000u, 0x00080000u, 0x00040000u, 0x00020000u, 0x00010000u,
+    0x00008000u, 0x00004000u, 0x00002000u, 0x00001000u, 0x00000800u, 0x00000400u, 0x00000200u, 0x00000100u,
+    0x00000080u, 0x00000040u, 0x00000020u, 0x00000010u, 0x00000008u, 0x00000004u, 0x00000002u, 0x00000001u,
+    0x80000000u, 0xc0000000u, 0xa0000000u, 0xf0000000u, 0x88000000u, 0xcc000000u, 0xaa000000u, 0xff000000u,
+    0x80800000u, 0xc0c00000u, 0xa0a00000u, 0xf0f00000u, 0x88880000u, 0xcccc0000u, 0xaaaa0000u, 0xffff0000u,
+    0x80008000u, 0xc000c000u, 0xa000a000u, 0xf000f000u, 0x88008800u, 0xcc00cc00u, 0xaa00aa00u, 0xff00ff00u,
+    0x80808080u, 0xc0c0c0c0u, 0xa0a0a0a0u, 0xf0f0f0f0u, 0x88888888u, 0xccccccccu, 0xaaaaaaaau, 0xffffffffu,
+    0x80000000u, 0xc0000000u, 0x60000000u, 0x90000000u, 0xe8000000u, 0x5c000000u, 0x8e000000u, 0xc5000000u,
+    0x68800000u, 0x9cc00000u, 0xee600000u, 0x55900000u, 0x80680000u, 0xc09c0000u, 0x60ee0000u, 0x90550000u,
+    0xe8808000u, 0x5cc0c000u, 0x8e606000u, 0xc5909000u, 0x6868e800u, 0x9c9c5c00u, 0xeeee8e00u, 0x5555c500u,
+    0x8000e880u, 0xc0005cc0u, 0x60008e60u, 0x9000c590u, 0xe8006868u, 0x5c009c9cu, 0x8e00eeeeu, 0xc5005555u,
+    0x80000000u, 0xc0000000u, 0x20000000u, 0x50000000u, 0xf8000000u, 0x74000000u, 0xa2000000u, 0x93000000u,
+    0xd8800000u, 0x25400000u, 0x59e00000u, 0xe6d00000u, 0x78080000u, 0xb40c0000u, 0x82020000u, 0xc3050000u,
+    0x208f8000u, 0x51474000u, 0xfbea2000u, 0x75d93000u, 0xa0858800u, 0x914e5400u, 0xdbe79e00u, 0x25db6d00u,
+    0x58800080u, 0xe54000c0u, 0x79e00020u, 0xb6d00050u, 0x800800f8u, 0xc00c0074u, 0x200200a2u, 0x50050093u
+);
+
+// all permutations of four base 4 digits, 2 bits per entry
+const uint c_DigitPermutations[24] = uint[](
+    0xe4u, 0xb4u, 0xd8u, 0x78u, 0x9cu, 0x6cu, 0xe1u, 0xb1u, 0xc9u, 0x39u, 0x8du, 0x2du,
+    0xd2u, 0x72u, 0xc6u, 0x36u, 0x4eu, 0x1eu, 0x93u, 0x63u, 0x87u, 0x27u, 0x4bu, 0x1bu
+);
+
+uint sobol(uint index, uint dimension){
+    uint result = 0;
+    for(uint bit = 0; index != 0; index >>= 1, ++bit){
+        if((index & 1) != 0) result ^= c_SobolDirections[dimension * 32 + bit];
+    }
+    return result;
+}
+
+// hash based permutation in which every bit only depends on the bits below it (Laine and Karras)
+uint laineKarrasPermutation(uint x, uint seed){
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+// owen scrambling of a 32 bit fixed point number (Burley 2020, Practical Hash-based Owen Scrambling)
+uint nestedUniformScramble(uint x, uint seed){
+    return bitfieldReverse(laineKarrasPermutation(bitfieldReverse(x), seed));
+}
+
+uint hashCombine(uint seed, uint v){
+    return seed ^ (wangHash(v) + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+}
+
+float fixedPointToFloat(uint x){
+    return float(x >> 8) * (1.0 / 16777216.0);
+}
+
+// interleaves the lower 16 bits of x and y
+uint morton2(uvec2 p){
+    uvec2 v = p & 0xffffu;
+    v = (v | (v << 8)) & 0x00ff00ffu;
+    v = (v | (v << 4)) & 0x0f0f0f0fu;
+    v = (v | (v << 2)) & 0x33333333u;
+    v = (v | (v << 1)) & 0x55555555u;
+    return v.x | (v.y << 1);
+}
+
+// padded sobol: the four dimensions of a set share a shuffled sample index, so they are stratified together, different
+// sets use independent shuffles. The shuffle keeps every block of 2^k consecutive indices together, so progressive
+// sample counts stay stratified.
+float sobolSample(RandomEngine re, uint dimension){
+    uint setSeed = hashCombine(re.pixelSeed, dimension / 4);
+    uint index = nestedUniformScramble(re.sampleIndex, setSeed);
+    uint component = dimension % 4;
+    return fixedPointToFloat(nestedUniformScramble(sobol(index, component), hashCombine(setSeed, component + 1)));
+}
+
+// sample index of the z-order sampler (Ahmed and Wonka 2020): the samples of all pixels are one sobol sequence ordered
+// by the morton code of the pixel, with randomly permuted base 4 digits per dimension. Neighbouring pixels get
+// neighbouring blocks of the sequence, which are well stratified together.
+uint zSobolIndex(RandomEngine re, uint dimension, uint seed){
+    const uint sampleMask = (1u << blueNoiseLog2Samples) - 1;
+    uint mortonIndex = (morton2(re.pixel) << blueNoiseLog2Samples) | (re.sampleIndex & sampleMask);
+    uint index = 0;
+    // 12 bits per pixel coordinate and blueNoiseLog2Samples bits fill up to 14 base 4 digits
+    for(int digitShift = 22 + int(blueNoiseLog2Samples); digitShift >= 0; digitShift -= 2){
+        uint digit = (mortonIndex >> digitShift) & 3;
+        uint higherDigits = mortonIndex >> (digitShift + 2);
+        uint permutation = c_DigitPermutations[wangHash(higherDigits ^ seed ^ (0x55555555u * dimension)) % 24];
+        index |= ((permutation >> (2 * digit)) & 3) << digitShift;
+    }
+    return index;
+}
+
+// dimension of a decision at the current path vertex
+uint vertexDimension(RandomEngine re, uint slot){
+    return c_CameraDimensions + re.vertex * c_VertexDimensions + slot;
+}
+
+// starts the next sample of the pixel, the index selects the point of the sequence
+void rESetSample(inout RandomEngine re, uint sampleIndex){
+    re.sampleIndex = sampleIndex;
+    re.vertex = 0;
+}
+
+float sample1D(inout RandomEngine re, uint dimension){
+#if defined SAMPLER_SOBOL
+    return sobolSample(re, dimension);
+#elif defined SAMPLER_BLUE_NOISE
+    uint seed = wangHash(re.sampleIndex >> blueNoiseLog2Samples);
+    uint index = zSobolIndex(re, dimension, seed);
+    return fixedPointToFloat(nestedUniformScramble(sobol(index, 0), hashCombine(seed, dimension)));
+#else
+    return randomFloat(re);
+#endif
+}
+
+vec2 sample2D(inout RandomEngine re, uint dimension){
+#if defined SAMPLER_SOBOL
+    return vec2(sobolSample(re, dimension), sobolSample(re, dimension + 1));
+#elif defined SAMPLER_BLUE_NOISE
+    uint seed = wangHash(re.sampleIndex >> blueNoiseLog2Samples);
+    uint index = zSobolIndex(re, dimension, seed);
+    uint scrambleSeed = hashCombine(seed, dimension);
+    return vec2(fixedPointToFloat(nestedUniformScramble(sobol(index, 0), scrambleSeed)),
+        fixedPointToFloat(nestedUniformScramble(sobol(index, 1), hashCombine(scrambleSeed, 1))));
+#else
+    return randomVec2(re);
+#endif
+}
+
+#endif //SAMPLER_H
@@ -3,7 +3,7 @@
 
 #include "ptConstants.glsl"
 #include "math.glsl"
-#include "random.glsl"
+#include "sampler.glsl"
 #include "color.glsl"
 #include "brdf.glsl"
 
@@ -26,9 +26,9 @@ vec2 sampleTriangle(vec2 u){
     return vec2(1.0f - uxsqrt, u.y * uxsqrt);
 }
 
-vec3 sampleBRDF(SurfaceInfo s, RandomEngine re, vec3 v,out vec3 l,out float pdf){
+vec3 sampleBRDF(SurfaceInfo s, inout RandomEngine re, vec3 v,out vec3 l,out float pdf){
     vec3 h;
-    vec3 u = randomVec3(re);
+    vec3 u = vec3(sample2D(re, vertexDimension(re, c_DimBSDFDirection)), sample1D(re, vertexDimension(re, c_DimBSDFLobe)));
     float specularSW = specularSampleWeight(s);
     mat3 basis = s.basis;
     bool entering = dot(v, s.normal) >= 0;
@@ -51,7 +51,7 @@ vec3 sampleBRDF(SurfaceInfo s, RandomEngine re, vec3 v,out vec3 l,out float pdf)
     //decide if material should refract
     if(s.illuminationType == 7){
         float f = specularReflection(vec3(1), vec3(0), dot(v, h)).x;    //fresnel term
-        if(randomFloat(re) < f || !entering){    //refracting
+        if(sample1D(re, vertexDimension(re, c_DimRefraction)) < f || !entering){    //refracting
             float t = !entering ? s.indexOfRefraction : 1 / s.indexOfRefraction; // it is assumed that only air is anohter medium that is participating
             //refraction calculation adopted from https://graphics.stanford.edu/courses/cs148-10-summer/docs/2006--degreve--reflection_refraction.pdf
             //in particular we use the light vector instead of the incident vector and have to adjust it in order to get a corret vector for the formula
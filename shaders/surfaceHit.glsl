@@ -0,0 +1,157 @@
+#ifndef SURFACEHIT_H
+#define SURFACEHIT_H
+
+#include "ptStructures.glsl"
+#include "layoutPTGeometry.glsl"
+#include "layoutPTGeometryImages.glsl"
+#include "ptConstants.glsl"
+#include "geometry.glsl"
+#include "color.glsl"
+
+// surface of a ray hit and of a miss, used by the hit shaders of the ray tracing pipeline and by the ray queries of
+// the compute backend (see trace.glsl). instanceIndex is the custom index of the hit instance.
+
+// fills the payload with the surface info at the hit, the cone width of the payload is updated to the hit distance
+void surfaceHit(int instanceIndex, int primitiveID, vec2 attribs, float hitT, vec3 rayDirection, inout RayPayload payload)
+{
+    const float epsilon = 1e-6;
+    ObjectInstance instance = instances.i[instanceIndex];
+    uint objId = int(instance.meshId);
+    uint indexStride = int(instances.i[instanceIndex].indexStride);
+    uvec3 index = unpackIndex(objId, primitiveID, indexStride);
+
+    Vertex v0 = unpackVertex(index.x, objId);
+	Vertex v1 = unpackVertex(index.y, objId);
+	Vertex v2 = unpackVertex(index.z, objId);
+
+    const vec3 bar = vec3(1.0f - attribs.x - attribs.y, attribs.x, attribs.y);
+    vec2 texCoord = v0.uv * bar.x + v1.uv * bar.y + v2.uv * bar.z;
+
+    // texture footprint of the ray cone at the hit, the cone width is handed on to the next bounce
+    float coneWidth = payload.cone.x + payload.cone.y * hitT;
+    payload.cone.x = coneWidth;
+    vec3 p0 = (instance.objectMat * vec4(v0.pos, 1)).xyz;
+    vec3 p1 = (instance.objectMat * vec4(v1.pos, 1)).xyz;
+    vec3 p2 = (instance.objectMat * vec4(v2.pos, 1)).xyz;
+    float lod = rayConeLod(p0, p1, p2, v0.uv, v1.uv, v2.uv, coneWidth, rayDirection);
+
+    vec4 diffuse = SRGBtoLINEAR(textureLod(diffuseMap[nonuniformEXT(objId)], texCoord, lod + textureSizeLod(diffuseMap[nonuniformEXT(objId)])));
+    diffuse.rgb *= diffuse.a;
+    vec3 position = v0.pos * bar.x + v1.pos * bar.y + v2.pos * bar.z;
+    position = (instance.objectMat * vec4(position, 1)).xyz;
+    vec3 normal = normalize(v0.normal * bar.x + v1.normal * bar.y + v2.normal * bar.z).xyz;//.xzy;
+    if(isinf(normal.x) || isnan(normal.x)) normal = vec3(0,1,0);
+    mat4 normalObj = transpose(inverse(instance.objectMat));
+    normal = normalize((normalObj * vec4(normal, 0)).xyz);
+    if(v0.uv == v1.uv) v1.uv += vec2(epsilon,0);
+    if(v0.uv == v2.uv) v2.uv += vec2(0,epsilon);
+    if(v1.uv == v2.uv) v2.uv += vec2(epsilon);
+    vec3 T = (normalObj * vec4(getTangent(v0.pos, v1.pos, v2.pos, v0.uv, v1.uv, v2.uv).xyz, 0)).xyz;
+    //T = (instance.objectMat * vec4(T, 0)).xyz;
+    vec3 B = (normalObj * vec4(getBitangent(v0.pos, v1.pos, v2.pos, v0.uv, v1.uv, v2.uv).xyz, 0)).xyz;
+    //B = (instance.objectMat * vec4(B, 0)).xyz;
+    mat3 TBN = gramSchmidt(T, B, normal);
+    normal = getNormal(TBN, normalMap[nonuniformEXT(objId)], texCoord, lod);
+
+    WaveFrontMaterial mat = unpackMaterial(materials.m[objId]);
+    diffuse.rgb *= mat.diffuse.rgb;
+    float perceptualRoughness = 0;
+
+    const vec3 f0 = vec3(.04);
+
+    vec4 specular;
+    if(textureSize(specularMap[nonuniformEXT(objId)], 0) == ivec2(1,1))
+        specular = vec4(mat.specular, mat.roughness);
+    else
+        specular = SRGBtoLINEAR(textureLod(specularMap[nonuniformEXT(objId)], texCoord, lod + textureSizeLod(specularMap[nonuniformEXT(objId)])));
+    perceptualRoughness = specular.a;
+
+    float maxSpecular = max(max(specular.r, specular.g), specular.b);
+
+    float metallic = convertMetallic(diffuse.rgb, specular.rgb, maxSpecular);
+
+    vec3 baseColorDiffusePart = diffuse.rgb * ((1.0 - maxSpecular) / (1 - c_MinRoughness) / max(1 - metallic, epsilon));
+    vec3 baseColorSpecularPart = specular.rgb - (vec3(c_MinRoughness) * (1 - metallic) * (1 / max(metallic, epsilon)));
+    vec4 baseColor = vec4(mix(baseColorDiffusePart, baseColorSpecularPart, metallic * metallic), diffuse.a);
+
+    vec3 diffuseColor = baseColor.rgb * (vec3(1.0) - f0);
+    diffuseColor *= 1.0 - metallic;
+
+    float alphaRoughness = perceptualRoughness * perceptualRoughness;
+    vec3 specularColor = mix(f0, baseColor.rgb, metallic);
+
+    float reflectance = max(max(specularColor.r, specularColor.g), specularColor.b);
+
+    float reflectance90 = clamp(reflectance * 25, 0, 1);
+    vec3 specularEnvironmentR0 = specularColor.rgb;
+    vec3 specularEnvironmentR90 = vec3(1) * reflectance90;
+    vec3 v = normalize(-rayDirection);
+    //surface emission
+    vec3 emissiveColor = mat.emission * SRGBtoLINEAR(textureLod(emissiveMap[nonuniformEXT(objId)], texCoord, lod + textureSizeLod(emissiveMap[nonuniformEXT(objId)]))).rgb;
+    if(dot(v, normal) < 0) emissiveColor = vec3(0);
+
+    payload.si = SurfaceInfo(perceptualRoughness, metallic, alphaRoughness, mat.illum, specularEnvironmentR0, specularEnvironmentR90, diffuseColor, specularColor, emissiveColor, mat.transmittance, normal, TBN, mat.ior);
+
+    payload.position = position;
+	
+	payload.category_id = mat.category_id;
+    payload.instanceIndex = uint(instanceIndex);
+    payload.primitiveID = uint(primitiveID);
+}
+
+// world space position of the hit point given by the barycentrics of the second and third corner
+vec3 hitPosition(int instanceIndex, int primitiveID, vec2 attribs)
+{
+    ObjectInstance instance = instances.i[instanceIndex];
+    uint objId = int(instance.meshId);
+    uvec3 index = unpackIndex(objId, primitiveID, instance.indexStride);
+    const vec3 bar = vec3(1.0f - attribs.x - attribs.y, attribs.x, attribs.y);
+    vec3 position = unpackVertex(index.x, objId).pos * bar.x + unpackVertex(index.y, objId).pos * bar.y + unpackVertex(index.z, objId).pos * bar.z;
+    return (instance.objectMat * vec4(position, 1)).xyz;
+}
+
+// a normal of (1, 1, 1) marks a ray which left the scene
+void surfaceMiss(inout RayPayload payload)
+{
+    payload.position = vec3(1.0e10);
+    payload.category_id = uint(-1);
+    payload.instanceIndex = c_NoPrimaryHit;
+    payload.si.normal = vec3(1);
+    payload.si.emissiveColor = vec3(0);
+    payload.si.diffuseColor = vec3(0);
+    payload.si.specularColor = vec3(0);
+    payload.si.perceptualRoughness = 0;
+    payload.si.metalness = 0;
+    payload.si.alphaRoughness = 0;
+    payload.si.illuminationType = 0;
+    payload.si.reflectance0 = vec3(0);
+    payload.si.reflectance90 = vec3(0);
+    payload.si.transmissiveColor = vec3(0);
+    payload.si.basis = mat3(0);
+    payload.si.indexOfRefraction = 1;
+}
+
+// alpha threshold used to reject intersection
+const float alphaThresh = .01f;
+
+// checks if alpha is higher than a threshold, surface points with too low alpha are no intersection
+bool alphaTest(int instanceIndex, int primitiveID, vec2 attribs)
+{
+    ObjectInstance instance = instances.i[instanceIndex];
+    uint objId = int(instance.meshId);
+    uvec3 index = unpackIndex(objId, primitiveID, instance.indexStride);
+
+    vec2 uv0, uv1, uv2;
+    uv0.x = tex[nonuniformEXT(objId)].t[2 * index.x];
+    uv0.y = tex[nonuniformEXT(objId)].t[2 * index.x + 1];
+    uv1.x = tex[nonuniformEXT(objId)].t[2 * index.y];
+    uv1.y = tex[nonuniformEXT(objId)].t[2 * index.y + 1];
+    uv2.x = tex[nonuniformEXT(objId)].t[2 * index.z];
+    uv2.y = tex[nonuniformEXT(objId)].t[2 * index.z + 1];
+    const vec3 bar = vec3(1.0f - attribs.x - attribs.y, attribs.x, attribs.y);
+    vec2 texCoord = uv0 * bar.x + uv1 * bar.y + uv2 * bar.z;
+    vec4 diffuse = textureLod(diffuseMap[nonuniformEXT(objId)], texCoord, 0);
+    return diffuse.a >= alphaThresh;
+}
+
+#endif //SURFACEHIT_H
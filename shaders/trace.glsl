@@ -0,0 +1,112 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// path and shadow rays of the path tracer. With RAY_QUERY they are traced inline (compute backend), with SOFTWARE_BVH
+// through the bvh of bvh.glsl (compute backend without ray tracing support), else through the shader binding table of
+// the ray tracing pipeline. Expects rayPayload, cullMask, tmin, tmax and, except for SOFTWARE_BVH, tlas to be declared
+// by the including shader, the ray tracing pipeline additionally needs rayFlags and the shadowed payload.
+// With RAY_ORIGIN_GBUFFER the primary hits are read from the GBufferRasterizer instead (loadPrimaryHit()).
+
+#if defined RAY_QUERY || defined SOFTWARE_BVH
+#include "surfaceHit.glsl"
+
+// any hit of the inline traversals, instances with shader offset 1 are alpha tested (see PBRTPipeline::set_tlas())
+bool acceptCandidate(uint shaderOffset, int instanceIndex, int primitiveID, vec2 attribs){
+  if(shaderOffset == 0) return true;
+#ifdef RAY_STATISTICS
+  atomicAdd(rayStatistics.anyHitInvocations, 1);
+#endif
+#ifdef COST_HEATMAP
+  imageAtomicAdd(anyHitCountImage, launchPixel(), 1);
+#endif
+  return alphaTest(instanceIndex, primitiveID, attribs);
+}
+#endif
+
+#ifdef SOFTWARE_BVH
+#include "bvh.glsl"
+#endif
+
+#ifdef RAY_ORIGIN_GBUFFER
+#include "surfaceHit.glsl"
+
+// primary hit of the pixel center rasterized by the GBufferRasterizer instead of a traced primary ray, the surface is
+// written to rayPayload like with traceSurface(). direction is set to the one from origin to the hit.
+void loadPrimaryHit(ivec2 pixel, vec3 origin, inout vec3 direction){
+  uvec4 hit = imageLoad(primaryHitImage, pixel);
+  if(hit.x == c_NoPrimaryHit){
+    surfaceMiss(rayPayload);
+    return;
+  }
+  int instanceIndex = int(hit.x);
+  int primitiveID = int(hit.y);
+  vec2 attribs = uintBitsToFloat(hit.zw);
+  vec3 position = hitPosition(instanceIndex, primitiveID, attribs);
+  float hitT = distance(origin, position);
+  direction = (position - origin) / hitT;
+  surfaceHit(instanceIndex, primitiveID, attribs, hitT, direction, rayPayload);
+}
+#endif
+
+// closest hit along the ray, the surface is written to rayPayload
+void traceSurface(vec3 origin, vec3 direction){
+#ifdef RAY_QUERY
+  rayQueryEXT rayQuery;
+  rayQueryInitializeEXT(rayQuery, tlas, gl_RayFlagsNoOpaqueEXT, cullMask, origin, tmin, direction, tmax);
+  while(rayQueryProceedEXT(rayQuery)){
+    if(acceptCandidate(rayQueryGetIntersectionInstanceShaderBindingTableRecordOffsetEXT(rayQuery, false),
+                       rayQueryGetIntersectionInstanceCustomIndexEXT(rayQuery, false),
+                       rayQueryGetIntersectionPrimitiveIndexEXT(rayQuery, false),
+                       rayQueryGetIntersectionBarycentricsEXT(rayQuery, false)))
+      rayQueryConfirmIntersectionEXT(rayQuery);
+  }
+  if(rayQueryGetIntersectionTypeEXT(rayQuery, true) == gl_RayQueryCommittedIntersectionNoneEXT){
+    surfaceMiss(rayPayload);
+    return;
+  }
+  surfaceHit(rayQueryGetIntersectionInstanceCustomIndexEXT(rayQuery, true),
+             rayQueryGetIntersectionPrimitiveIndexEXT(rayQuery, true),
+             rayQueryGetIntersectionBarycentricsEXT(rayQuery, true), rayQueryGetIntersectionTEXT(rayQuery, true),
+             direction, rayPayload);
+#elif defined SOFTWARE_BVH
+  // the bvh holds no instance masks, cullMask is ignored
+  uint hitTriangle;
+  vec2 attribs;
+  float hitT;
+  if(!traverseBVH(origin, direction, tmin, tmax, false, hitTriangle, attribs, hitT)){
+    surfaceMiss(rayPayload);
+    return;
+  }
+  BVHTriangle triangle = bvhTriangles.triangles[hitTriangle];
+  surfaceHit(triangle.instanceIndex, triangle.primitiveID, attribs, hitT, direction, rayPayload);
+#else
+  traceRayEXT(tlas, rayFlags, cullMask, 0, 0, 0, origin, tmin, direction, tmax, 1);
+#endif
+}
+
+// true if anything is hit between origin and rayTmax, the traversal ends at the first hit
+bool traceOcclusion(vec3 origin, vec3 direction, float rayTmax){
+#ifdef RAY_QUERY
+  rayQueryEXT rayQuery;
+  rayQueryInitializeEXT(rayQuery, tlas, gl_RayFlagsTerminateOnFirstHitEXT | gl_RayFlagsNoOpaqueEXT, 0xFF, origin, tmin, direction, rayTmax);
+  while(rayQueryProceedEXT(rayQuery)){
+    if(acceptCandidate(rayQueryGetIntersectionInstanceShaderBindingTableRecordOffsetEXT(rayQuery, false),
+                       rayQueryGetIntersectionInstanceCustomIndexEXT(rayQuery, false),
+                       rayQueryGetIntersectionPrimitiveIndexEXT(rayQuery, false),
+                       rayQueryGetIntersectionBarycentricsEXT(rayQuery, false)))
+      rayQueryConfirmIntersectionEXT(rayQuery);
+  }
+  return rayQueryGetIntersectionTypeEXT(rayQuery, true) != gl_RayQueryCommittedIntersectionNoneEXT;
+#elif defined SOFTWARE_BVH
+  uint hitTriangle;
+  vec2 attribs;
+  float hitT;
+  return traverseBVH(origin, direction, tmin, rayTmax, true, hitTriangle, attribs, hitT);
+#else
+  shadowed = true;
+  traceRayEXT(tlas, gl_RayFlagsTerminateOnFirstHitEXT | gl_RayFlagsOpaqueEXT | gl_RayFlagsSkipClosestHitShaderEXT | gl_RayFlagsNoOpaqueEXT, 0xFF, 0, 0, 1, origin, tmin, direction, rayTmax, 0);
+  return shadowed;
+#endif
+}
+
+#endif //TRACE_H
@@ -0,0 +1,92 @@
+#ifndef VISIBILITY_H
+#define VISIBILITY_H
+
+// visibility g-buffer: per pixel only the instance index and the primitive id of the primary hit are stored (written by
+// pathTracer.glsl with VISIBILITY_BUFFER). The consumers reconstruct depth and normal from the scene geometry by
+// intersecting the ray through the pixel center with the stored triangle, only the position, normal and index buffers
+// of that triangle are read. Expects the including shader to enable GL_EXT_nonuniform_qualifier, the geometry is
+// declared in set GEOMETRY_SET (1 if not defined).
+// ptConstants.glsl is not included as its constants clash with the ones of the denoisers.
+
+#ifndef GEOMETRY_SET
+#define GEOMETRY_SET 1
+#endif
+#include "ptStructures.glsl"
+#include "layoutPTGeometry.glsl"
+#include "geometry.glsl"
+
+const uint c_VisibilityMiss = 0xffffffff;   // instance index of pixels without a hit, c_NoPrimaryHit of ptConstants.glsl
+const float c_VisibilityMissDepth = 1e10;   // depth of pixels without a hit, the position of a miss is at 1e10
+
+struct VisibilitySurface{
+    float depth;    // distance from the ray origin along the normalized ray direction
+    vec3 normal;    // interpolated world space shading normal without the normal map
+};
+
+vec3 visibilityPosition(uint index, uint objId){
+    return vec3(pos[nonuniformEXT(objId)].p[3 * index], pos[nonuniformEXT(objId)].p[3 * index + 1], pos[nonuniformEXT(objId)].p[3 * index + 2]);
+}
+
+vec3 visibilityVertexNormal(uint index, uint objId){
+    return vec3(nor[nonuniformEXT(objId)].n[3 * index], nor[nonuniformEXT(objId)].n[3 * index + 1], nor[nonuniformEXT(objId)].n[3 * index + 2]);
+}
+
+// intersects the ray with the plane of the triangle of the record, bar holds the barycentrics of the second and third
+// corner. Returns false for misses and rays parallel to the triangle
+bool visibilityIntersect(uvec2 record, vec3 origin, vec3 dir, out ObjectInstance instance, out uvec3 index, out vec2 bar, out float t){
+    if(record.x == c_VisibilityMiss) return false;
+    instance = instances.i[record.x];
+    uint objId = uint(instance.meshId);
+    index = unpackIndex(objId, record.y, instance.indexStride);
+    vec3 p0 = (instance.objectMat * vec4(visibilityPosition(index.x, objId), 1)).xyz;
+    vec3 e1 = (instance.objectMat * vec4(visibilityPosition(index.y, objId), 1)).xyz - p0;
+    vec3 e2 = (instance.objectMat * vec4(visibilityPosition(index.z, objId), 1)).xyz - p0;
+    vec3 h = cross(dir, e2);
+    float det = dot(e1, h);
+    if(abs(det) < 1e-12) return false;
+    vec3 s = origin - p0;
+    vec3 q = cross(s, e1);
+    bar = vec2(dot(s, h), dot(dir, q)) / det;
+    t = dot(e2, q) / det;
+    return true;
+}
+
+// depth of the surface of the record seen along the ray, the plane of the triangle is intersected
+float visibilityDepth(uvec2 record, vec3 origin, vec3 dir){
+    ObjectInstance instance;
+    uvec3 index;
+    vec2 bar;
+    float t;
+    return visibilityIntersect(record, origin, dir, instance, index, bar, t) ? t : c_VisibilityMissDepth;
+}
+
+// depth and normal of the surface of the record seen along the ray, a miss has the normal the fat g-buffer decodes to
+VisibilitySurface visibilitySurface(uvec2 record, vec3 origin, vec3 dir){
+    VisibilitySurface surface = VisibilitySurface(c_VisibilityMissDepth, vec3(0, 0, 1));
+    ObjectInstance instance;
+    uvec3 index;
+    vec2 bar;
+    float t;
+    if(!visibilityIntersect(record, origin, dir, instance, index, bar, t)) return surface;
+    // the record belongs to the first sample of the pixel, which is jittered with anti aliasing, so the pixel center
+    // can lie just outside of the triangle. The normal is interpolated at a point inside then
+    bar = clamp(bar, vec2(0), vec2(1));
+    bar /= max(1.0, bar.x + bar.y);
+    uint objId = uint(instance.meshId);
+    vec3 normal = visibilityVertexNormal(index.x, objId) * (1 - bar.x - bar.y) + visibilityVertexNormal(index.y, objId) * bar.x + visibilityVertexNormal(index.z, objId) * bar.y;
+    normal = normalize((transpose(inverse(instance.objectMat)) * vec4(normal, 0)).xyz);
+    if(isinf(normal.x) || isnan(normal.x)) normal = vec3(0, 1, 0);
+    surface.depth = t;
+    surface.normal = normal;
+    return surface;
+}
+
+// ray through the center of the pixel with the inverse camera matrices of the ray tracing push constants
+void visibilityCameraRay(ivec2 pixel, ivec2 size, mat4 inverseView, mat4 inverseProjection, out vec3 origin, out vec3 dir){
+    vec2 clipSpaceCoord = (vec2(pixel) + vec2(.5)) / vec2(size) * 2.0 - 1.0;
+    vec4 viewSpaceDir = inverseProjection * vec4(clipSpaceCoord, 1, 1);
+    origin = (inverseView * vec4(0, 0, 0, 1)).xyz;
+    dir = (inverseView * vec4(normalize(viewSpaceDir.xyz), 0)).xyz;
+}
+
+#endif //VISIBILITY_H
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <buffers/RayStatisticsBuffer.hpp>
+
 #include <vsg/all.h>
 #include <vsgImGui/imgui.h>
 #include <vsgImGui/RenderImGui.h>
@@ -17,10 +19,17 @@ public:
         float test_color[4];
         char test_text_input[200];
         int triangle_count;
-        int rays_per_pixel;
+        // one path segment and one shadow ray per bounce, only shown without measured ray statistics
+        int estimated_rays_per_pixel;
         int width;
         int height;
         uint32_t sample_number;
+        // measured counts of the last finished frame, only available with --rayStatistics
+        bool has_ray_statistics = false;
+        RayStatistics ray_statistics{};
+        // channel of the cost heatmap, only used with --costHeatmap
+        bool has_cost_heatmap = false;
+        int cost_heatmap_channel = 0;
     };
 
     explicit Gui(vsg::ref_ptr<Values> values) : _values(values), _state({true}) {}
@@ -38,10 +47,41 @@ public:
         ImGui::InputText("testTextInput", _values->test_text_input, 200);
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS) for %d triangles", 1000.0F / ImGui::GetIO().Framerate,
             ImGui::GetIO().Framerate, _values->triangle_count);
-        ImGui::Text("Render size is %d by %d with %d rays/pixel resulting in %.3f mRays/second", _values->width,
-            _values->height, _values->rays_per_pixel,
-            ImGui::GetIO().Framerate * _values->rays_per_pixel * _values->width * _values->height / 1.0e6);
+        ImGui::Text("Render size is %d by %d", _values->width, _values->height);
+        if (!_values->has_ray_statistics)
+        {
+            ImGui::Text("Estimated %d rays/pixel resulting in %.3f mRays/second", _values->estimated_rays_per_pixel,
+                ImGui::GetIO().Framerate * _values->estimated_rays_per_pixel * _values->width * _values->height
+                    / 1.0e6);
+        }
         ImGui::Text("Samples per pixel: %d", _values->sample_number);
+        if (_values->has_cost_heatmap)
+        {
+            const char* channels[] = {"Shader time", "Bounce rays", "Shadow rays", "Any hit invocations"};
+            ImGui::Combo("Cost heatmap", &_values->cost_heatmap_channel, channels, IM_ARRAYSIZE(channels));
+        }
+        if (_values->has_ray_statistics)
+        {
+            const auto& statistics = _values->ray_statistics;
+            ImGui::Text("Measured %.2f rays/pixel resulting in %.3f mRays/second",
+                static_cast<double>(statistics.total_rays()) / (_values->width * _values->height),
+                ImGui::GetIO().Framerate * statistics.total_rays() / 1.0e6);
+            ImGui::Text("Rays: %u primary, %u bounce, %u shadow, %u any hit invocations", statistics.primary_rays,
+                statistics.bounce_rays, statistics.shadow_rays, statistics.any_hit_invocations);
+            for (size_t i = 0; i < RayStatistics::termination_count; ++i)
+            {
+                ImGui::Text("Paths terminated by %s: %u", RayStatistics::termination_names[i],
+                    statistics.terminations[i]);
+            }
+            // bucket 0 is unused, paths have at least the camera ray
+            float path_lengths[RayStatistics::max_path_length];
+            for (size_t i = 0; i < RayStatistics::max_path_length; ++i)
+            {
+                path_lengths[i] = static_cast<float>(statistics.path_lengths[i + 1]);
+            }
+            ImGui::PlotHistogram("Path lengths", path_lengths, RayStatistics::max_path_length, 0, nullptr, 0.0F,
+                FLT_MAX, ImVec2(0, 80));
+        }
 
         ImGui::End();
         return _state.active;
@@ -8,9 +8,17 @@
 #include "renderModules/Accumulator.hpp"
 #include "renderModules/FormatConverter.hpp"
 #include "renderModules/Taa.hpp"
+#include "renderModules/CostHeatmap.hpp"
+#include "renderModules/AdaptiveSampler.hpp"
+#include "renderModules/RadianceCache.hpp"
 #include "io/RenderIO.hpp"
 #include <util/VsgUtils.hpp>
 #include <util/DenoiserUtils.hpp>
+#include <util/GpuTimer.hpp>
+#include <util/Instrumentation.hpp>
+#include <util/PipelineCache.hpp>
+#include <util/ShaderCache.hpp>
+#include <util/TaskGraph.hpp>
 #include "Gui.hpp"
 
 #include <vsg/all.h>
@@ -19,6 +27,8 @@
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <deque>
 #include <iostream>
 
 #include "../external/vsgXchange/src/assimp/3DFrontImporter.h"
@@ -109,11 +119,46 @@ int main(int argc, char** argv)
         auto export_material_path = arguments.value(std::string(), "--exportMaterial");
         auto illumination_path = arguments.value(std::string(), "--illuminations");
         auto export_illumination_path = arguments.value(std::string(), "--exportIllumination");
+        auto export_cost_path = arguments.value(std::string(), "--exportCost");
         auto matrices_path = arguments.value(std::string(), "--matrices");
+        auto camera_path_path = arguments.value(std::string(), "--cameraPath");
         auto export_matrices_path = arguments.value(std::string(), "--exportMatrices");
         auto scene_filename = arguments.value(std::string(), "-i");
+        auto texture_cache_path = arguments.value(std::string(), "--textureCache");
+        auto shader_cache_path = arguments.value(std::string("shader_cache"), "--shaderCache");
+        auto pipeline_cache_path = arguments.value(std::string("pipeline_cache.bin"), "--pipelineCache");
+        bool use_pipeline_cache = !arguments.read("--noPipelineCache");
+        auto& instrumentation = vkpbrt::Instrumentation::instance();
+        if (auto trace_path = arguments.value(std::string(), "--trace"); !trace_path.empty())
+        {
+            // startup phases, io and per frame timings as chrome trace plus counters and frame time percentiles
+            instrumentation.enable(trace_path);
+        }
+        if (!arguments.read("--noShaderCache"))
+        {
+            vkpbrt::ShaderCache::global = vkpbrt::ShaderCache::create(shader_cache_path);
+        }
+        if (arguments.read("--precompileShaders"))
+        {
+            // fill the shader cache with all runtime compiled shader permutations, e.g. as a build step
+            if (!vkpbrt::ShaderCache::global)
+            {
+                std::cout << "--precompileShaders requires the shader cache to be enabled." << std::endl;
+                return 1;
+            }
+            PBRTPipeline::precompile_shaders();
+            Accumulator::load_shader(false);
+            Accumulator::load_shader(true);
+            Accumulator::load_shader(true, true);
+            Accumulator::load_shader(false, false, true);
+            Accumulator::load_shader(true, false, true);
+            FormatConverter::load_shader(VK_FORMAT_B8G8R8A8_UNORM);
+            vkpbrt::ShaderCache::global->print_statistics();
+            return 0;
+        }
         bool use_external_buffers = !normal_path.empty();
         bool export_illumination = !export_illumination_path.empty();
+        bool export_cost = !export_cost_path.empty();
         bool export_g_buffer = !export_normal_path.empty() || !export_depth_path.empty()
                                || !export_position_path.empty() || !export_albedo_path.empty()
                                || !export_material_path.empty();
@@ -156,8 +201,159 @@ int main(int argc, char** argv)
                 std::cout << "Unknown denoising type: " << denoising_type_str << std::endl;
             }
         }
+        std::string denoising_block_size_str;
+        if (arguments.read("--denoiserBlockSize", denoising_block_size_str))
+        {
+            if (denoising_block_size_str == "8")
+            {
+                denoising_block_size = DenoisingBlockSize::X8;
+            }
+            else if (denoising_block_size_str == "16")
+            {
+                denoising_block_size = DenoisingBlockSize::X16;
+            }
+            else if (denoising_block_size_str == "32")
+            {
+                denoising_block_size = DenoisingBlockSize::X32;
+            }
+            else if (denoising_block_size_str == "64")
+            {
+                denoising_block_size = DenoisingBlockSize::X64;
+            }
+            else if (denoising_block_size_str == "8-16-32")
+            {
+                denoising_block_size = DenoisingBlockSize::X8X16X32;
+            }
+            else
+            {
+                std::cout << "Unknown denoising block size: " << denoising_block_size_str << std::endl;
+            }
+        }
+        SamplerType sampler_type = SamplerType::RANDOM;
+        std::string sampler_type_str;
+        if (arguments.read("--sampler", sampler_type_str))
+        {
+            if (sampler_type_str == "sobol")
+            {
+                sampler_type = SamplerType::SOBOL;
+            }
+            else if (sampler_type_str == "bluenoise")
+            {
+                sampler_type = SamplerType::BLUE_NOISE;
+            }
+            else if (sampler_type_str == "random")
+            {
+            }
+            else
+            {
+                std::cout << "Unknown sampler type: " << sampler_type_str << std::endl;
+            }
+        }
         bool use_taa = arguments.read("--taa");
         bool use_fly_navigation = arguments.read("--fly");
+        // measured ray counts and path statistics in the gui and the trace, costs a few atomics per pixel
+        bool use_ray_statistics = arguments.read("--rayStatistics");
+        // per pixel shader time, bounce and any hit counts shown as false colour image instead of the final image
+        bool show_cost_heatmap = arguments.read("--costHeatmap");
+        bool use_cost_buffer = (show_cost_heatmap || export_cost) && normal_path.empty();
+        // a frame is finished as soon as the mean relative error of its pixels is below the target, --spp is the
+        // upper bound of the samples per frame then
+        auto target_error = arguments.value(0.f, "--targetError");
+        // only pixels whose relative standard error is above the given value are traced, 0 traces every pixel
+        auto adaptive_max_error = arguments.value(target_error, "--adaptiveSampling");
+        auto adaptive_min_samples = arguments.value(16, "--adaptiveMinSpp");
+        bool use_adaptive_sampling = adaptive_max_error > 0 && !use_external_buffers;
+        if (use_adaptive_sampling && denoising_type != DenoisingType::NONE)
+        {
+            // the denoisers expect a new sample for every pixel each frame
+            std::cout << "Adaptive sampling is only available without denoiser, ignoring --adaptiveSampling and "
+                         "--targetError"
+                      << std::endl;
+            use_adaptive_sampling = false;
+        }
+        bool use_convergence_termination = use_adaptive_sampling && target_error > 0;
+        // resampled direct lighting at the primary hits that reuses the light samples of the last frame and of the
+        // neighbouring pixels, meant for real time rendering with a denoiser
+        bool use_restir = arguments.read("--restir") && !use_external_buffers;
+        // resampled first bounce of the indirect lighting, reuses the secondary hits of the last frame and neighbours
+        bool use_restir_gi = arguments.read("--restirGI") && !use_external_buffers;
+        // paths end in a world space cache of the radiance after a rough bounce
+        bool use_radiance_cache = arguments.read("--radianceCache") && !use_external_buffers;
+        // every bounce of all paths runs as separate trace and shading stages sorted by material, writes the final
+        // image only
+        bool use_wavefront = arguments.read("--wavefront") && !use_external_buffers;
+        if (use_wavefront
+            && (denoising_type != DenoisingType::NONE || export_illumination || export_g_buffer || use_cost_buffer
+                || use_adaptive_sampling || use_restir || use_restir_gi || use_radiance_cache))
+        {
+            std::cout << "The wavefront path tracer is only available without denoiser, adaptive sampling, ReSTIR, "
+                         "radiance cache and g-buffer or cost exports, ignoring --wavefront"
+                      << std::endl;
+            use_wavefront = false;
+        }
+        // the paths are traced with inline ray queries from a compute shader instead of the ray tracing pipeline
+        bool use_ray_query = arguments.read("--rayQuery");
+        if (use_ray_query && (use_adaptive_sampling || use_wavefront))
+        {
+            std::cout << "The ray query backend is not available with adaptive sampling and the wavefront path tracer, "
+                         "ignoring --rayQuery"
+                      << std::endl;
+            use_ray_query = false;
+        }
+        // the paths are traced through a bvh built on the cpu, runs on devices without ray tracing support
+        bool use_software_bvh = arguments.read("--softwareBVH") && !use_external_buffers;
+        if (use_software_bvh && (use_adaptive_sampling || use_wavefront || use_ray_query))
+        {
+            std::cout << "The software bvh backend is not available with adaptive sampling, the wavefront path tracer "
+                         "and the ray query backend, ignoring --softwareBVH"
+                      << std::endl;
+            use_software_bvh = false;
+        }
+        // the primary hits are rasterized instead of traced, the paths start from them
+        bool use_raster_primary = arguments.read("--rasterPrimary") && !use_external_buffers;
+        if (use_raster_primary && use_wavefront)
+        {
+            std::cout << "The wavefront path tracer traces its primary rays, ignoring --rasterPrimary" << std::endl;
+            use_raster_primary = false;
+        }
+        // the g-buffer for the denoisers only stores the primary triangle of each pixel, depth and normal are
+        // reconstructed from the scene geometry by the accumulator and the denoisers
+        bool use_visibility_buffer = arguments.read("--visibilityBuffer") && !use_external_buffers;
+        if (use_visibility_buffer && (denoising_type == DenoisingType::NONE || export_g_buffer))
+        {
+            std::cout << "The visibility buffer is only used by the denoisers and can not be exported, ignoring "
+                         "--visibilityBuffer"
+                      << std::endl;
+            use_visibility_buffer = false;
+        }
+        auto g_buffer_layout = use_visibility_buffer ? GBufferLayout::VISIBILITY : GBufferLayout::ATTRIBUTES;
+        // half depth, octahedral normals and single channel material, imported g-buffers are converted after loading
+        // and exported ones decoded before writing
+        bool use_compact_g_buffer = arguments.read("--compactGBuffer");
+        if (use_compact_g_buffer && use_visibility_buffer)
+        {
+            std::cout << "The visibility buffer stores no depth and normals, ignoring --compactGBuffer" << std::endl;
+            use_compact_g_buffer = false;
+        }
+        auto g_buffer_encoding = use_compact_g_buffer ? GBufferEncoding::COMPACT : GBufferEncoding::FULL;
+        auto ray_origin = use_raster_primary ? RayTracingRayOrigin::GBUFFER : RayTracingRayOrigin::CAMERA;
+        auto tracing_backend = use_ray_query ? TracingBackend::RAY_QUERY : TracingBackend::RAY_TRACING_PIPELINE;
+        if (use_software_bvh)
+        {
+            tracing_backend = TracingBackend::SOFTWARE_BVH;
+        }
+        // bounces of a path after the primary hit
+        auto max_depth = std::max(arguments.value(2, "--maxDepth"), 1);
+        // samples traced by a single trace rays, accumulation and denoising then only run once per launch
+        // batch renders trace all samples of a frame at once unless the frame can finish early
+        int default_samples_per_dispatch = num_frames > 0 && !use_convergence_termination ? samples_per_pixel : 1;
+        auto samples_per_dispatch = std::max(arguments.value(default_samples_per_dispatch, "--samplesPerDispatch"), 1);
+        if (samples_per_pixel % samples_per_dispatch != 0)
+        {
+            samples_per_pixel += samples_per_dispatch - samples_per_pixel % samples_per_dispatch;
+            std::cout << "--spp is rounded up to a multiple of --samplesPerDispatch: " << samples_per_pixel
+                      << std::endl;
+        }
 #ifdef _DEBUG
         // overwriting command line options for debug
         window_traits->debugLayer = true;
@@ -169,19 +365,53 @@ int main(int argc, char** argv)
         window_traits->swapchainPreferences.imageUsage
             = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
         window_traits->deviceExtensionNames
-            = {VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME, VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
-                VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME, VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,
-                VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
-                VK_KHR_SPIRV_1_4_EXTENSION_NAME, VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME};
+            = {VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME, VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,
+                VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, VK_KHR_SPIRV_1_4_EXTENSION_NAME,
+                VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME};
+        if (!use_software_bvh)
+        {
+            window_traits->deviceExtensionNames.insert(window_traits->deviceExtensionNames.end(),
+                {VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME, VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
+                    VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME});
+            auto& enabled_acceleration_structure_features
+                = window_traits->deviceFeatures->get<VkPhysicalDeviceAccelerationStructureFeaturesKHR,
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR>();
+            auto& enabled_ray_tracing_pipeline_features
+                = window_traits->deviceFeatures->get<VkPhysicalDeviceRayTracingPipelineFeaturesKHR,
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR>();
+            enabled_acceleration_structure_features.accelerationStructure = VK_TRUE;
+            enabled_ray_tracing_pipeline_features.rayTracingPipeline = VK_TRUE;
+            enabled_ray_tracing_pipeline_features.rayTracingPipelineTraceRaysIndirect
+                = use_adaptive_sampling || use_wavefront;
+        }
+        if (use_cost_buffer)
+        {
+            window_traits->deviceExtensionNames.push_back(VK_KHR_SHADER_CLOCK_EXTENSION_NAME);
+            auto& enabled_shader_clock_features
+                = window_traits->deviceFeatures->get<VkPhysicalDeviceShaderClockFeaturesKHR,
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_CLOCK_FEATURES_KHR>();
+            enabled_shader_clock_features.shaderDeviceClock = VK_TRUE;
+        }
+        if (use_ray_query)
+        {
+            window_traits->deviceExtensionNames.push_back(VK_KHR_RAY_QUERY_EXTENSION_NAME);
+            auto& enabled_ray_query_features
+                = window_traits->deviceFeatures->get<VkPhysicalDeviceRayQueryFeaturesKHR,
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR>();
+            enabled_ray_query_features.rayQuery = VK_TRUE;
+        }
+        if (use_raster_primary)
+        {
+            // the rasterizer reads the vertices from the storage buffers of the scene
+            window_traits->deviceFeatures->get().vertexPipelineStoresAndAtomics = VK_TRUE;
+            window_traits->deviceFeatures->get().fragmentStoresAndAtomics = VK_TRUE;
+        }
+        if (use_compact_g_buffer)
+        {
+            // r16f, rg16_snorm and r8 storage images
+            window_traits->deviceFeatures->get().shaderStorageImageExtendedFormats = VK_TRUE;
+        }
         window_traits->vulkanVersion = VK_API_VERSION_1_2;
-        auto& enabled_acceleration_structure_features
-            = window_traits->deviceFeatures->get<VkPhysicalDeviceAccelerationStructureFeaturesKHR,
-                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR>();
-        auto& enabled_ray_tracing_pipeline_features
-            = window_traits->deviceFeatures->get<VkPhysicalDeviceRayTracingPipelineFeaturesKHR,
-                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR>();
-        enabled_acceleration_structure_features.accelerationStructure = VK_TRUE;
-        enabled_ray_tracing_pipeline_features.rayTracingPipeline = VK_TRUE;
         auto& enabled_physical_device_vk12_feature
             = window_traits->deviceFeatures
                   ->get<VkPhysicalDeviceVulkan12Features, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES>();
@@ -191,44 +421,82 @@ int main(int argc, char** argv)
         enabled_physical_device_vk12_feature.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
         enabled_physical_device_vk12_feature.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
 
-        // load scene or images
+        // -------------------------------------------------------------------------------------
+        // startup phases, independent phases run concurrently
+        // -------------------------------------------------------------------------------------
         vsg::ref_ptr<vsg::Node> loaded_scene;
         std::vector<vsg::ref_ptr<OfflineGBuffer>> offline_g_buffers;
         std::vector<vsg::ref_ptr<OfflineIllumination>> offline_illuminations;
+        std::vector<vsg::ref_ptr<OfflineIllumination>> offline_costs;
         std::vector<CameraMatrices> camera_matrices;
-        if (!use_external_buffers)
+        vsg::ref_ptr<vsg::Window> window;
+        vsg::ref_ptr<vsg::Viewer> viewer;
+        vsg::ref_ptr<vsg::Device> device;
+        vsg::ref_ptr<vkpbrt::PipelineCache> pipeline_cache;
+        vsg::ref_ptr<GBuffer> g_buffer;
+        vsg::ref_ptr<IlluminationBuffer> illumination_buffer;
+        vsg::ref_ptr<AccumulationBuffer> accumulation_buffer;
+        bool write_g_buffer = false;
+        uint32_t max_recursion_depth = max_depth;
+        vsg::ref_ptr<PBRTPipeline> pbrt_pipeline;
+        vsg::ref_ptr<RayStatisticsBuffer> ray_statistics_buffer;
+        if (use_ray_statistics && !use_external_buffers)
         {
-            AI3DFrontImporter::ReadConfig(config_json);
-            auto options = vsg::Options::create(vsgXchange::assimp::create(), vsgXchange::dds::create(),
-                vsgXchange::stbi::create());  // using the assimp loader
-            loaded_scene = vsg::read_cast<vsg::Node>(scene_filename, options);
-            if (!loaded_scene)
+            ray_statistics_buffer = RayStatisticsBuffer::create();
+        }
+        vsg::ref_ptr<CostBuffer> cost_buffer;
+        vsg::ref_ptr<AdaptiveSamplingBuffer> adaptive_sampling_buffer;
+        vsg::ref_ptr<ReservoirBuffer> reservoir_buffer;
+        vsg::ref_ptr<RadianceCacheBuffer> radiance_cache_buffer;
+        vsg::ref_ptr<WavefrontBuffer> wavefront_buffer;
+        vsg::ref_ptr<vsg::TopLevelAccelerationStructure> tlas;
+        CountTrianglesVisitor counter;
+
+        vkpbrt::TaskGraph startup;
+        // load scene or images
+        auto load_task = startup.add("load", [&]() {
+            if (!use_external_buffers)
             {
-                std::cout << "Scene not found: " << scene_filename << std::endl;
-                return 1;
+                AI3DFrontImporter::ReadConfig(config_json);
+                auto options = vsg::Options::create(vsgXchange::assimp::create(), vsgXchange::dds::create(),
+                    vsgXchange::stbi::create(), vsgXchange::ktx::create());  // using the assimp loader
+                if (!texture_cache_path.empty())
+                {
+                    // block compressed textures are generated on the first run and read from the cache afterwards
+                    options->setValue(vsgXchange::assimp::texture_cache, texture_cache_path);
+                }
+                loaded_scene = vsg::read_cast<vsg::Node>(scene_filename, options);
+                if (!loaded_scene)
+                {
+                    throw std::runtime_error("Scene not found: " + scene_filename);
+                }
+                if (auto auxiliary = loaded_scene->getAuxiliary(); auxiliary && instrumentation.enabled())
+                {
+                    // the importer attaches its timings and sizes as "import.*" values
+                    for (const auto& [key, object] : auxiliary->getObjectMap())
+                    {
+                        if (auto value = dynamic_cast<const vsg::doubleValue*>(object.get()))
+                        {
+                            instrumentation.add_counter(key, value->value());
+                        }
+                    }
+                }
+                return;
             }
-        }
-        else
-        {
             if (num_frames <= 0)
             {
-                std::cout << "No number of frames given. For usage of external GBuffer and Illumination information "
-                             "use \"-f\" to inform about the number of frames."
-                          << std::endl;
-                return 1;
+                throw std::runtime_error("No number of frames given. For usage of external GBuffer and "
+                                         "Illumination information use \"-f\" to inform about the number of frames.");
             }
             if (matrices_path.empty())
             {
-                std::cout << "Camera matrices are missing. Insert location of file with camera information via "
-                             "\"--matrices\"."
-                          << std::endl;
-                return 1;
+                throw std::runtime_error("Camera matrices are missing. Insert location of file with camera "
+                                         "information via \"--matrices\".");
             }
             camera_matrices = MatrixIO::import_matrices(matrices_path);
             if (camera_matrices.empty())
             {
-                std::cout << "Camera matrices could not be loaded" << std::endl;
-                return 1;
+                throw std::runtime_error("Camera matrices could not be loaded");
             }
             if (static_cast<unsigned int>(!position_path.empty()) != 0U)
             {
@@ -240,80 +508,242 @@ int main(int argc, char** argv)
                 offline_g_buffers
                     = GBufferIO::import_g_buffer_depth(depth_path, normal_path, material_path, albedo_path, num_frames);
             }
+            for (auto& offline_g_buffer : offline_g_buffers)
+            {
+                offline_g_buffer = offline_g_buffer->converted(g_buffer_encoding);
+            }
             offline_illuminations = IlluminationBufferIO::import_illumination(illumination_path, num_frames);
             window_traits->width = offline_g_buffers[0]->depth->width();
             window_traits->height = offline_g_buffers[0]->depth->height();
-        }
-        if (export_illumination)
+        });
+        // the image size is only known before loading when rendering a scene
+        std::vector<vkpbrt::TaskGraph::TaskId> size_dependencies;
+        if (use_external_buffers)
         {
-            if (num_frames <= 0)
-            {
-                std::cout << "No number of frames given. For usage of Illumination export use \"-f\" to inform about "
-                             "the number of frames."
-                          << std::endl;
-                return 1;
-            }
-            if (offline_illuminations.empty())
-            {
-                offline_illuminations.resize(num_frames);
-                for (auto& i : offline_illuminations)
+            size_dependencies.push_back(load_task);
+        }
+
+        // window and device creation have to stay on the main thread
+        auto window_task = startup.add(
+            "window and device",
+            [&]() {
+                window = vsg::Window::create(window_traits);
+                if (!window)
                 {
-                    i = OfflineIllumination::create();
-                    i->noisy = vsg::vec4Array2D::create(window_traits->width, window_traits->height);
+                    throw std::runtime_error("Could not create windows.");
                 }
-            }
-        }
-        if (export_g_buffer)
-        {
-            if (num_frames <= 0)
-            {
-                std::cout << "No number of frames given. For usage of GBuffer export use \"-f\" to inform about the "
-                             "number of frames."
-                          << std::endl;
-                return 1;
-            }
-            if (offline_g_buffers.empty())
-            {
-                offline_g_buffers.resize(num_frames);
-                for (auto& i : offline_g_buffers)
+                viewer = vsg::Viewer::create();
+                viewer->addWindow(window);
+
+                device = window->getOrCreateDevice();
+
+                // all pipelines are compiled through one pipeline cache which persists across runs
+                if (use_pipeline_cache)
                 {
-                    i = OfflineGBuffer::create();
-                    i->depth = vsg::floatArray2D::create(window_traits->width, window_traits->height);
-                    i->normal = vsg::vec2Array2D::create(window_traits->width, window_traits->height);
-                    i->albedo = vsg::ubvec4Array2D::create(window_traits->width, window_traits->height);
-                    i->material = vsg::ubvec4Array2D::create(window_traits->width, window_traits->height);
+                    pipeline_cache = vkpbrt::PipelineCache::create(device, pipeline_cache_path);
                 }
-            }
+
+                // setting a custom render pass for imgui non clear rendering
+                window->setRenderPass(vkpbrt::create_non_clear_render_pass(
+                    window->surfaceFormat().format, window->depthFormat(), device));
+            },
+            size_dependencies, true);
+
+        auto buffers_task = startup.add(
+            "buffers",
+            [&]() {
+                if (export_illumination)
+                {
+                    if (num_frames <= 0)
+                    {
+                        throw std::runtime_error("No number of frames given. For usage of Illumination export use "
+                                                 "\"-f\" to inform about the number of frames.");
+                    }
+                    if (offline_illuminations.empty())
+                    {
+                        offline_illuminations.resize(num_frames);
+                        for (auto& i : offline_illuminations)
+                        {
+                            i = OfflineIllumination::create();
+                            i->noisy = vsg::vec4Array2D::create(window_traits->width, window_traits->height);
+                        }
+                    }
+                }
+                if (export_cost)
+                {
+                    if (num_frames <= 0)
+                    {
+                        throw std::runtime_error("No number of frames given. For usage of cost export use \"-f\" to "
+                                                 "inform about the number of frames.");
+                    }
+                    offline_costs.resize(num_frames);
+                    for (auto& i : offline_costs)
+                    {
+                        i = OfflineIllumination::create();
+                        i->noisy = vsg::vec4Array2D::create(window_traits->width, window_traits->height);
+                    }
+                }
+                if (use_cost_buffer)
+                {
+                    cost_buffer = CostBuffer::create(window_traits->width, window_traits->height);
+                }
+                if (use_adaptive_sampling)
+                {
+                    adaptive_sampling_buffer
+                        = AdaptiveSamplingBuffer::create(window_traits->width, window_traits->height);
+                }
+                if (use_restir || use_restir_gi)
+                {
+                    reservoir_buffer = ReservoirBuffer::create(
+                        window_traits->width, window_traits->height, use_restir, use_restir_gi);
+                }
+                if (use_radiance_cache)
+                {
+                    radiance_cache_buffer = RadianceCacheBuffer::create();
+                }
+                if (use_wavefront)
+                {
+                    wavefront_buffer = WavefrontBuffer::create(window_traits->width, window_traits->height);
+                }
+                if (export_g_buffer)
+                {
+                    if (num_frames <= 0)
+                    {
+                        throw std::runtime_error("No number of frames given. For usage of GBuffer export use \"-f\" "
+                                                 "to inform about the number of frames.");
+                    }
+                    if (offline_g_buffers.empty())
+                    {
+                        offline_g_buffers.resize(num_frames);
+                        for (auto& i : offline_g_buffers)
+                        {
+                            i = OfflineGBuffer::create(window_traits->width, window_traits->height, g_buffer_encoding);
+                        }
+                    }
+                }
+                if (store_matrices)
+                {
+                    camera_matrices.resize(num_frames);
+                    for (auto& matrix : camera_matrices)
+                    {
+                        matrix.proj = vsg::mat4();
+                        matrix.inv_proj = vsg::mat4();
+                    }
+                }
+
+                if (denoising_type != DenoisingType::NONE)
+                {
+                    write_g_buffer = true;
+                    g_buffer = GBuffer::create(
+                        window_traits->width, window_traits->height, g_buffer_layout, g_buffer_encoding);
+                    illumination_buffer
+                        = IlluminationBufferDemodulatedFloat::create(window_traits->width, window_traits->height);
+                }
+                else
+                {
+                    write_g_buffer = false;
+                    illumination_buffer
+                        = IlluminationBufferFinalFloat::create(window_traits->width, window_traits->height);
+                }
+                if (export_illumination && !g_buffer)
+                {
+                    write_g_buffer = true;
+                    g_buffer = GBuffer::create(
+                        window_traits->width, window_traits->height, GBufferLayout::ATTRIBUTES, g_buffer_encoding);
+                }
+                if (use_taa && !accumulation_buffer)
+                {
+                    // TODO: need the velocity buffer
+                }
+            },
+            size_dependencies);
+
+        // with a shader cache the runtime compiled shaders can be built while the scene is still loading, the
+        // modules then read them from the cache
+        std::vector<vkpbrt::TaskGraph::TaskId> pipeline_dependencies{load_task, buffers_task};
+        if (vkpbrt::ShaderCache::global)
+        {
+            pipeline_dependencies.push_back(startup.add(
+                "shader compilation",
+                [&]() {
+                    if (!use_external_buffers)
+                    {
+                        PBRTPipeline::prepare_raygen_shader(
+                            illumination_buffer, g_buffer, sampler_type, tracing_backend, ray_origin);
+                    }
+                    if (denoising_type != DenoisingType::NONE)
+                    {
+                        Accumulator::load_shader(!use_external_buffers, use_visibility_buffer, use_compact_g_buffer);
+                    }
+                    FormatConverter::load_shader(VK_FORMAT_B8G8R8A8_UNORM);
+                },
+                {buffers_task}));
         }
-        if (store_matrices)
+
+        if (!use_external_buffers)
         {
-            camera_matrices.resize(num_frames);
-            for (auto& matrix : camera_matrices)
+            // raytracing pipeline setup
+            auto pipeline_task = startup.add(
+                "raytracing pipeline",
+                [&]() {
+                    pbrt_pipeline = PBRTPipeline::create(loaded_scene, g_buffer, illumination_buffer, write_g_buffer,
+                        ray_origin, ray_statistics_buffer, cost_buffer, adaptive_sampling_buffer,
+                        sampler_type, reservoir_buffer, radiance_cache_buffer, wavefront_buffer, tracing_backend);
+                    pbrt_pipeline->set_samples_per_launch(samples_per_dispatch);
+                    pbrt_pipeline->set_samples_per_frame(samples_per_pixel);
+                    pbrt_pipeline->set_max_recursion_depth(max_recursion_depth);
+                },
+                pipeline_dependencies);
+            // the software bvh is built with the pipeline
+            if (!use_software_bvh)
             {
-                matrix.proj = vsg::mat4();
-                matrix.inv_proj = vsg::mat4();
+                auto acceleration_structure_task = startup.add(
+                    "acceleration structures",
+                    [&]() {
+                        vsg::BuildAccelerationStructureTraversal build_accel_struct(device);
+                        loaded_scene->accept(build_accel_struct);
+                        tlas = build_accel_struct.tlas;
+                        instrumentation.add_counter(
+                            "scene.tlas_instances", static_cast<double>(tlas->geometryInstances.size()));
+                    },
+                    {load_task, window_task});
+                startup.add("setup tlas", [&]() { pbrt_pipeline->set_tlas(tlas); },
+                    {pipeline_task, acceleration_structure_task});
             }
+            startup.add(
+                "count triangles",
+                [&]() {
+                    loaded_scene->accept(counter);
+                    instrumentation.add_counter("scene.triangles", counter.triangle_count);
+                },
+                {load_task});
         }
-
-        auto window = vsg::Window::create(window_traits);
-        if (!window)
+        try
         {
-            std::cout << "Could not create windows." << std::endl;
+            startup.run();
+        }
+        catch (const std::runtime_error& e)
+        {
+            // a phase could not continue with the given arguments
+            std::cout << e.what() << std::endl;
             return 1;
         }
-        auto viewer = vsg::Viewer::create();
-        viewer->addWindow(window);
-
-        vsg::ref_ptr<vsg::Device> device(window->getOrCreateDevice());
-
-        // setting a custom render pass for imgui non clear rendering
-        window->setRenderPass(
-            vkpbrt::create_non_clear_render_pass(window->surfaceFormat().format, window->depthFormat(), device));
 
         // create camera matrices
         auto perspective = vsg::Perspective::create(
             60, static_cast<double>(window_traits->width) / static_cast<double>(window_traits->height), .1, 1000);
         auto look_at = vsg::LookAt::create(vsg::dvec3(0.0, -3, 1), vsg::dvec3(0.0, 0.0, 1), vsg::dvec3(0.0, 0.0, 1.0));
+        // fixed camera per frame, e.g. for reproducible benchmarks
+        CameraMatricesVec camera_path;
+        if (!camera_path_path.empty() && !use_external_buffers)
+        {
+            camera_path = MatrixIO::import_matrices(camera_path_path);
+            if (camera_path.empty())
+            {
+                std::cout << "Camera path could not be loaded" << std::endl;
+                return 1;
+            }
+        }
 
         // create push constants
         auto ray_tracing_push_constants_value = RayTracingPushConstantsValue::create();
@@ -327,50 +757,12 @@ int main(int argc, char** argv)
         auto compute_constants
             = vsg::PushConstants::create(VK_SHADER_STAGE_COMPUTE_BIT, 0, ray_tracing_push_constants_value);
 
-        vsg::ref_ptr<GBuffer> g_buffer;
-        vsg::ref_ptr<IlluminationBuffer> illumination_buffer;
-        vsg::ref_ptr<AccumulationBuffer> accumulation_buffer;
-        bool write_g_buffer;
-        if (denoising_type != DenoisingType::NONE)
-        {
-            write_g_buffer = true;
-            g_buffer = GBuffer::create(window_traits->width, window_traits->height);
-            illumination_buffer
-                = IlluminationBufferDemodulatedFloat::create(window_traits->width, window_traits->height);
-        }
-        else
-        {
-            write_g_buffer = false;
-            illumination_buffer = IlluminationBufferFinalFloat::create(window_traits->width, window_traits->height);
-        }
-        if (export_illumination && !g_buffer)
-        {
-            write_g_buffer = true;
-            g_buffer = GBuffer::create(window_traits->width, window_traits->height);
-        }
-        if (use_taa && !accumulation_buffer)
-        {
-            // TODO: need the velocity buffer
-        }
-
-        // raytracing pipeline setup
-        uint32_t max_recursion_depth = 2;
-        vsg::ref_ptr<PBRTPipeline> pbrt_pipeline;
-        if (!use_external_buffers)
-        {
-            pbrt_pipeline = PBRTPipeline::create(
-                loaded_scene, g_buffer, illumination_buffer, write_g_buffer, RayTracingRayOrigin::CAMERA);
-
-            // setup tlas
-            vsg::BuildAccelerationStructureTraversal build_accel_struct(device);
-            loaded_scene->accept(build_accel_struct);
-            pbrt_pipeline->set_tlas(build_accel_struct.tlas);
-        }
-        else
+        if (use_external_buffers)
         {
             if (!g_buffer)
             {
-                g_buffer = GBuffer::create(offline_g_buffers[0]->depth->width(), offline_g_buffers[0]->depth->height());
+                g_buffer = GBuffer::create(offline_g_buffers[0]->depth->width(), offline_g_buffers[0]->depth->height(),
+                    GBufferLayout::ATTRIBUTES, g_buffer_encoding);
             }
             switch (offline_illuminations[0]->noisy->getLayout().format)
             {
@@ -394,18 +786,39 @@ int main(int argc, char** argv)
         auto commands = vsg::Commands::create();
         auto offline_g_buffer_stager = OfflineGBuffer::create();
         auto offline_illumination_buffer_stager = OfflineIllumination::create();
-        vsg::ref_ptr<vsg::QueryPool> query_pool;
+        auto offline_cost_stager = OfflineIllumination::create();
+        // gpu time per render module, only recorded with --trace
+        vsg::ref_ptr<vkpbrt::GpuTimer> gpu_timer;
+        if (instrumentation.enabled())
+        {
+            gpu_timer = vkpbrt::GpuTimer::create(
+                device, device->getPhysicalDevice()->getQueueFamily(window_traits->queueFlags));
+            gpu_timer->add_begin_to_command_graph(commands);
+        }
+        auto add_gpu_timestamp = [&](const char* name)
+        {
+            if (gpu_timer)
+            {
+                gpu_timer->add_timestamp_to_command_graph(commands, name);
+            }
+        };
         if (pbrt_pipeline)
         {
-            query_pool = vsg::QueryPool::create();  // standard init has 1 timestamp place
-            query_pool->queryCount = 2;
-            auto reset_query = vsg::ResetQueryPool::create(query_pool);
-            auto write1 = vsg::WriteTimestamp::create(query_pool, 0, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR);
-            auto write2 = vsg::WriteTimestamp::create(query_pool, 1, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR);
-            commands->addChild(reset_query);
-            commands->addChild(write1);
+            if (adaptive_sampling_buffer)
+            {
+                auto adaptive_sampler
+                    = AdaptiveSampler::create(adaptive_sampling_buffer, adaptive_max_error, adaptive_min_samples);
+                adaptive_sampler->add_dispatch_to_command_graph(commands, compute_constants);
+                add_gpu_timestamp("adaptive sampling");
+            }
             pbrt_pipeline->add_trace_rays_to_command_graph(commands, push_constants);
-            commands->addChild(write2);
+            add_gpu_timestamp("raytrace");
+            if (radiance_cache_buffer)
+            {
+                auto radiance_cache = RadianceCache::create(radiance_cache_buffer);
+                radiance_cache->add_dispatch_to_command_graph(commands);
+                add_gpu_timestamp("radiance cache");
+            }
             illumination_buffer = pbrt_pipeline->get_illumination_buffer();
         }
         else
@@ -418,6 +831,7 @@ int main(int argc, char** argv)
             offline_g_buffer_stager->upload_to_g_buffer_command(g_buffer, commands, image_layout_compile.context);
             offline_illumination_buffer_stager->upload_to_illumination_buffer_command(
                 illumination_buffer, commands, image_layout_compile.context);
+            add_gpu_timestamp("upload");
         }
 
         vsg::ref_ptr<Accumulator> accumulator;
@@ -425,6 +839,7 @@ int main(int argc, char** argv)
         {
             accumulator = Accumulator::create(g_buffer, illumination_buffer, !use_external_buffers);
             accumulator->add_dispatch_to_command_graph(commands);
+            add_gpu_timestamp("accumulate");
             accumulation_buffer = accumulator->accumulation_buffer;
             illumination_buffer->compile(image_layout_compile.context);
             illumination_buffer->update_image_layouts(image_layout_compile.context);
@@ -443,6 +858,7 @@ int main(int argc, char** argv)
             vkpbrt::add_denoiser_to_commands(denoising_type, denoising_block_size, commands, image_layout_compile,
                 window_traits->width, window_traits->height, compute_constants, g_buffer, illumination_buffer,
                 accumulation_buffer, final_descriptor_image);
+            add_gpu_timestamp("denoise");
         }
 
         if (use_taa && accumulation_buffer)
@@ -452,6 +868,7 @@ int main(int argc, char** argv)
             taa->compile(image_layout_compile.context);
             taa->update_image_layouts(image_layout_compile.context);
             taa->add_dispatch_to_command_graph(commands);
+            add_gpu_timestamp("taa");
             final_descriptor_image = taa->get_final_descriptor_image();
         }
         if (export_g_buffer)
@@ -473,6 +890,26 @@ int main(int argc, char** argv)
             offline_illumination_buffer_stager->download_from_illumination_buffer_command(
                 illumination_buffer, commands, image_layout_compile.context);
         }
+        if (export_cost)
+        {
+            vsg::ref_ptr<IlluminationBuffer> cost_illumination = cost_buffer;
+            offline_cost_stager->download_from_illumination_buffer_command(
+                cost_illumination, commands, image_layout_compile.context);
+        }
+        if (export_g_buffer || export_illumination || export_cost)
+        {
+            add_gpu_timestamp("download");
+        }
+        vsg::ref_ptr<CostHeatmap> cost_heatmap;
+        if (show_cost_heatmap && cost_buffer)
+        {
+            cost_heatmap = CostHeatmap::create(cost_buffer);
+            cost_heatmap->compile_images(image_layout_compile.context);
+            cost_heatmap->update_image_layouts(image_layout_compile.context);
+            cost_heatmap->add_dispatch_to_command_graph(commands);
+            add_gpu_timestamp("cost heatmap");
+            final_descriptor_image = cost_heatmap->final_image;
+        }
         if (final_descriptor_image->imageInfoList[0]->imageView->image->format != VK_FORMAT_B8G8R8A8_UNORM)
         {
             auto converter = FormatConverter::create(
@@ -480,6 +917,7 @@ int main(int argc, char** argv)
             converter->compile_images(image_layout_compile.context);
             converter->update_image_layouts(image_layout_compile.context);
             converter->add_dispatch_to_command_graph(commands);
+            add_gpu_timestamp("format conversion");
             final_descriptor_image = converter->final_image;
         }
         if (g_buffer)
@@ -497,25 +935,65 @@ int main(int argc, char** argv)
             illumination_buffer->compile(image_layout_compile.context);
             illumination_buffer->update_image_layouts(image_layout_compile.context);
         }
+        if (ray_statistics_buffer)
+        {
+            ray_statistics_buffer->compile(image_layout_compile.context);
+        }
+        if (cost_buffer)
+        {
+            cost_buffer->compile(image_layout_compile.context);
+            cost_buffer->update_image_layouts(image_layout_compile.context);
+        }
+        if (adaptive_sampling_buffer)
+        {
+            adaptive_sampling_buffer->compile(image_layout_compile.context);
+            adaptive_sampling_buffer->update_image_layouts(image_layout_compile.context);
+        }
+        if (reservoir_buffer)
+        {
+            reservoir_buffer->compile(image_layout_compile.context);
+            reservoir_buffer->update_image_layouts(image_layout_compile.context);
+        }
+        if (radiance_cache_buffer)
+        {
+            radiance_cache_buffer->compile(image_layout_compile.context);
+        }
+        if (wavefront_buffer)
+        {
+            wavefront_buffer->compile(image_layout_compile.context);
+        }
         image_layout_compile.context.record();
 
         if (accumulation_buffer)
         {
             accumulation_buffer->copy_to_back_images(commands, g_buffer, illumination_buffer);
         }
+        if (reservoir_buffer)
+        {
+            reservoir_buffer->copy_to_back_images(commands);
+        }
 
         // set GUI values
         auto gui_values = Gui::Values::create();
         gui_values->width = window_traits->width;
         gui_values->height = window_traits->height;
-        CountTrianglesVisitor counter;
-        if (loaded_scene)
-        {
-            loaded_scene->accept(counter);
-        }
         gui_values->triangle_count = counter.triangle_count;
-        gui_values->rays_per_pixel
+        gui_values->estimated_rays_per_pixel
             = max_recursion_depth * 2;  // for each depth recursion one next event estimate is done
+        gui_values->has_cost_heatmap = cost_heatmap.valid();
+        instrumentation.add_counter("render.width", window_traits->width);
+        instrumentation.add_counter("render.height", window_traits->height);
+        if (g_buffer)
+        {
+            instrumentation.add_counter("gbuffer.bytes_per_pixel", g_buffer->bytes_per_pixel());
+        }
+        instrumentation.add_counter("render.samples_per_pixel", samples_per_pixel);
+        instrumentation.add_counter("render.samples_per_dispatch", samples_per_dispatch);
+        if (!ray_statistics_buffer)
+        {
+            // kept apart from the measured rays.* counters, so runs are not compared on the estimate
+            instrumentation.add_counter("render.estimated_rays_per_pixel", gui_values->estimated_rays_per_pixel);
+        }
 
         auto viewport = vsg::ViewportState::create(0, 0, window_traits->width, window_traits->height);
         auto camera = vsg::Camera::create(perspective, look_at, viewport);
@@ -541,16 +1019,112 @@ int main(int argc, char** argv)
             viewer->addEventHandler(vsg::Trackball::create(camera));
         }
         viewer->assignRecordAndSubmitTaskAndPresentation({command_graph});
-        viewer->compile();
+        {
+            // pipeline creation, acceleration structure builds and resource uploads
+            vkpbrt::ScopedTimer timer("viewer compile", "startup");
+            viewer->compile();
+        }
+        if (vkpbrt::ShaderCache::global)
+        {
+            vkpbrt::ShaderCache::global->print_statistics();
+        }
 
         // waiting for image layout transitions
         image_layout_compile.context.waitForCompletion();
 
         int frame_index = 0;
         int sample_index = 0;
+
+        // the convergence is read back without waiting for the gpu, so the results arrive a few dispatches late and
+        // are matched to the frame the dispatch was traced for. A frame keeps the samples that are in flight when its
+        // error falls below the target
+        struct ConvergenceDispatch
+        {
+            uint64_t dispatch;
+            int frame, sample;
+        };
+        std::deque<ConvergenceDispatch> unread_dispatches;
+        uint64_t recorded_dispatches = 0;  // one adaptive sampling dispatch is recorded per submitted frame
+        int counted_frame = -1;  // the frame the results are currently summed up for
+        uint64_t traced_pixels = 0;  // since the last accumulation restart, for the achieved samples per pixel
+        double relative_error = 1.;
+        auto report_convergence = [&]() {
+            if (counted_frame < 0)
+            {
+                return;
+            }
+            double achieved_samples
+                = static_cast<double>(traced_pixels) / (window_traits->width * window_traits->height);
+            std::cout << "Frame " << counted_frame << ": " << achieved_samples << " spp, relative error "
+                      << relative_error << std::endl;
+            instrumentation.add_frame_value("convergence.spp", achieved_samples);
+            instrumentation.add_frame_value("convergence.relative_error", relative_error);
+        };
+        // returns true if the current frame has converged
+        auto read_convergence = [&]() {
+            bool converged = false;
+            AdaptiveSamplingResult result;
+            while (adaptive_sampling_buffer->read(result))
+            {
+                // results overwritten in the ring are lost
+                while (!unread_dispatches.empty() && unread_dispatches.front().dispatch < result.dispatch)
+                {
+                    unread_dispatches.pop_front();
+                }
+                if (unread_dispatches.empty())
+                {
+                    break;
+                }
+                auto dispatch = unread_dispatches.front();
+                unread_dispatches.pop_front();
+                // all dispatches of the counted frame have been read once a dispatch of the next frame arrives
+                if (dispatch.frame != counted_frame)
+                {
+                    report_convergence();
+                    counted_frame = dispatch.frame;
+                    traced_pixels = 0;
+                }
+                if (dispatch.sample == 0)
+                {
+                    traced_pixels = 0;
+                }
+                traced_pixels += static_cast<uint64_t>(result.active_pixels) * samples_per_dispatch;
+                relative_error = result.mean_relative_error;
+                // the error is counted by the adaptive sampling pass before the trace of the sample, so the frame
+                // might get one sample more than needed
+                converged = converged
+                            || (dispatch.frame == frame_index
+                                && (dispatch.sample + 1) * samples_per_dispatch >= adaptive_min_samples
+                                && relative_error <= target_error);
+            }
+            return converged;
+        };
+
+        auto frame_start = vkpbrt::Instrumentation::Clock::now();
         while (viewer->advanceToNextFrame() && (num_frames < 0 || frame_index < num_frames))
         {
+            if (instrumentation.enabled())
+            {
+                auto now = vkpbrt::Instrumentation::Clock::now();
+                if (frame_index > 0 || sample_index > 0)
+                {
+                    instrumentation.add_event("frame", "frame", frame_start, now);
+                    instrumentation.add_frame_time(std::chrono::duration<double, std::milli>(now - frame_start).count());
+                    if (gpu_timer)
+                    {
+                        for (const auto& [name, milliseconds] : gpu_timer->read_results())
+                        {
+                            instrumentation.add_gpu_time(name, milliseconds);
+                        }
+                    }
+                }
+                frame_start = now;
+            }
             viewer->handleEvents();
+            if (!camera_path.empty())
+            {
+                look_at->set(vsg::dmat4(camera_path[frame_index % camera_path.size()].inv_view));
+            }
             if (static_cast<vsg::mat4>(lookAt(look_at->eye, look_at->center, look_at->up))
                 != ray_tracing_push_constants_value->value().prev_view)
             {
@@ -561,7 +1135,11 @@ int main(int argc, char** argv)
             ray_tracing_push_constants_value->value().view_inverse = look_at->inverse();
             ray_tracing_push_constants_value->value().frame_number = frame_index;
             ray_tracing_push_constants_value->value().sample_number = sample_index;
-            gui_values->sample_number = sample_index;
+            gui_values->sample_number = sample_index * samples_per_dispatch;
+            if (cost_heatmap)
+            {
+                cost_heatmap->set_channel(static_cast<CostHeatmap::Channel>(gui_values->cost_heatmap_channel));
+            }
 
             if (use_external_buffers)
             {
@@ -590,11 +1168,42 @@ int main(int argc, char** argv)
 
             ray_tracing_push_constants_value->value().prev_view = look_at->transform();
 
-            if (sample_index + 1 >= samples_per_pixel)
+            if (ray_statistics_buffer && ray_statistics_buffer->read(gui_values->ray_statistics))
             {
-                if (export_g_buffer || export_illumination)
+                gui_values->has_ray_statistics = true;
+                const auto& statistics = gui_values->ray_statistics;
+                instrumentation.add_counter("rays.frames", 1);
+                instrumentation.add_counter("rays.primary", statistics.primary_rays);
+                instrumentation.add_counter("rays.bounce", statistics.bounce_rays);
+                instrumentation.add_counter("rays.shadow", statistics.shadow_rays);
+                instrumentation.add_counter("rays.any_hit", statistics.any_hit_invocations);
+                for (size_t i = 0; i < RayStatistics::termination_count; ++i)
+                {
+                    instrumentation.add_counter(std::string("paths.terminated.") + RayStatistics::termination_names[i],
+                        statistics.terminations[i]);
+                }
+                for (size_t i = 1; i < statistics.path_lengths.size(); ++i)
+                {
+                    instrumentation.add_counter("paths.length." + std::to_string(i), statistics.path_lengths[i]);
+                }
+            }
+
+            int traced_samples = (sample_index + 1) * samples_per_dispatch;
+            bool frame_finished = traced_samples >= samples_per_pixel;
+            if (use_convergence_termination)
+            {
+                unread_dispatches.push_back({++recorded_dispatches, frame_index, sample_index});
+                frame_finished = read_convergence() || frame_finished;
+            }
+            if (frame_finished)
+            {
+                if (export_g_buffer || export_illumination || export_cost)
                 {
                     viewer->deviceWaitIdle();
+                    if (export_cost)
+                    {
+                        offline_cost_stager->transfer_staging_data_to(offline_costs[frame_index]);
+                    }
                     if (export_illumination)
                     {
                         offline_illumination_buffer_stager->transfer_staging_data_to(
@@ -616,6 +1225,17 @@ int main(int argc, char** argv)
             }
             sample_index++;
         }
+        if (use_convergence_termination)
+        {
+            // the last frames are still in flight
+            viewer->deviceWaitIdle();
+            read_convergence();
+            report_convergence();
+        }
+        if (pipeline_cache)
+        {
+            pipeline_cache->save();
+        }
 
         // exporting all images
         if (export_g_buffer)
@@ -627,10 +1247,15 @@ int main(int argc, char** argv)
         {
             IlluminationBufferIO::export_illumination(export_illumination_path, num_frames, offline_illuminations);
         }
+        if (export_cost)
+        {
+            IlluminationBufferIO::export_illumination(export_cost_path, num_frames, offline_costs);
+        }
         if (!export_matrices_path.empty())
         {
             MatrixIO::export_matrices(export_matrices_path, camera_matrices);
         }
+        instrumentation.write();
     }
     catch (const vsg::Exception& e)
     {
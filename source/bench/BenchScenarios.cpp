@@ -0,0 +1,530 @@
+#include <bench/BenchScenarios.hpp>
+#include <bench/LowDiscrepancy.hpp>
+#include <io/RenderIO.hpp>
+#include <util/Instrumentation.hpp>
+
+#include <vsg/all.h>
+#include <vsgXchange/images.h>
+#include <vsgXchange/models.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+namespace vkpbrt
+{
+namespace
+{
+const int gbuffer_frames = 8;
+const uint32_t gbuffer_width = 1280;
+const uint32_t gbuffer_height = 720;
+
+void write_checker_texture(const std::string& path, int size, int seed)
+{
+    // binary ppm, readable by the stbi loader without an image writer dependency
+    std::ofstream file(path, std::ios::binary);
+    file << "P6\n" << size << " " << size << "\n255\n";
+    std::mt19937 random(seed);
+    unsigned char a[3] = {static_cast<unsigned char>(random() % 256), static_cast<unsigned char>(random() % 256),
+        static_cast<unsigned char>(random() % 256)};
+    unsigned char b[3] = {255, 255, 255};
+    int cell = std::max(size / 16, 1);
+    std::vector<unsigned char> row(size * 3);
+    for (int y = 0; y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            const unsigned char* color = ((x / cell + y / cell) % 2) != 0 ? a : b;
+            std::copy(color, color + 3, row.begin() + x * 3);
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+    if (!file)
+    {
+        throw std::runtime_error("Failed to write texture " + path);
+    }
+}
+void add_import_counters(const vsg::Node& scene)
+{
+    if (auto auxiliary = scene.getAuxiliary())
+    {
+        for (const auto& [key, object] : auxiliary->getObjectMap())
+        {
+            if (auto value = dynamic_cast<const vsg::doubleValue*>(object.get()))
+            {
+                Instrumentation::instance().add_counter(key, value->value());
+            }
+        }
+    }
+}
+void run_import(const std::string& scene_file)
+{
+    auto options = vsg::Options::create(vsgXchange::assimp::create(), vsgXchange::dds::create(),
+        vsgXchange::stbi::create(), vsgXchange::ktx::create());
+    vsg::ref_ptr<vsg::Node> scene;
+    {
+        ScopedTimer timer("import", "bench");
+        scene = vsg::read_cast<vsg::Node>(scene_file, options);
+    }
+    if (!scene)
+    {
+        throw std::runtime_error("Scene not found: " + scene_file);
+    }
+    add_import_counters(*scene);
+}
+void run_g_buffer_round_trip(const std::string& work_directory)
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    OfflineGBuffers g_buffers(gbuffer_frames);
+    for (auto& g_buffer : g_buffers)
+    {
+        auto depth = vsg::floatArray2D::create(gbuffer_width, gbuffer_height, vsg::Data::Layout{VK_FORMAT_R32_SFLOAT});
+        auto normal
+            = vsg::vec2Array2D::create(gbuffer_width, gbuffer_height, vsg::Data::Layout{VK_FORMAT_R32G32_SFLOAT});
+        auto material
+            = vsg::ubvec4Array2D::create(gbuffer_width, gbuffer_height, vsg::Data::Layout{VK_FORMAT_R8G8B8A8_UNORM});
+        auto albedo
+            = vsg::ubvec4Array2D::create(gbuffer_width, gbuffer_height, vsg::Data::Layout{VK_FORMAT_R8G8B8A8_UNORM});
+        for (uint32_t i = 0; i < depth->valueCount(); ++i)
+        {
+            depth->data()[i] = 1.f + 10.f * uniform(random);
+            normal->data()[i] = vsg::vec2(uniform(random) * 3.14159f, uniform(random) * 6.28318f);
+            auto value = static_cast<uint8_t>(i % 256);
+            material->data()[i] = vsg::ubvec4(value, 255 - value, 128, 255);
+            albedo->data()[i] = vsg::ubvec4(255 - value, value, 64, 255);
+        }
+        g_buffer = OfflineGBuffer::create();
+        g_buffer->depth = depth;
+        g_buffer->normal = normal;
+        g_buffer->material = material;
+        g_buffer->albedo = albedo;
+    }
+
+    auto directory = std::filesystem::path(work_directory) / "gbuffer";
+    std::filesystem::create_directories(directory);
+    auto format = [&](const char* name) { return (directory / (std::string(name) + "_%d.exr")).string(); };
+    bool exported;
+    {
+        ScopedTimer timer("export", "bench");
+        exported = GBufferIO::export_g_buffer({}, format("depth"), format("normal"), format("material"),
+            format("albedo"), gbuffer_frames, g_buffers, {}, 0);
+    }
+    if (!exported)
+    {
+        throw std::runtime_error("GBuffer export failed");
+    }
+    ScopedTimer timer("import", "bench");
+    GBufferIO::import_g_buffer_depth(
+        format("depth"), format("normal"), format("material"), format("albedo"), gbuffer_frames, 0);
+}
+// conversion of a full g-buffer to the compact encoding and back, with the precision lost by it
+void run_g_buffer_compact(const std::string&)
+{
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+    auto g_buffer = OfflineGBuffer::create(gbuffer_width, gbuffer_height, GBufferEncoding::FULL);
+    auto depth = g_buffer->depth.cast<vsg::floatArray2D>();
+    auto normal = g_buffer->normal.cast<vsg::vec2Array2D>();
+    std::vector<vsg::vec3> normals(normal->valueCount());
+    for (uint32_t i = 0; i < depth->valueCount(); ++i)
+    {
+        depth->data()[i] = std::pow(10.f, 2.f + 2.f * uniform(random));
+        vsg::vec3 n;
+        do
+        {
+            n = vsg::vec3(uniform(random), uniform(random), uniform(random));
+        } while (vsg::length(n) < 1e-3f || vsg::length(n) > 1.f);
+        normals[i] = vsg::normalize(n);
+        normal->data()[i] = GBufferEncoder::encode_spherical(normals[i]);
+    }
+
+    vsg::ref_ptr<OfflineGBuffer> compact, decoded;
+    {
+        ScopedTimer timer("encode", "bench");
+        compact = g_buffer->converted(GBufferEncoding::COMPACT);
+    }
+    {
+        ScopedTimer timer("decode", "bench");
+        decoded = compact->converted(GBufferEncoding::FULL);
+    }
+    auto decoded_depth = decoded->depth.cast<vsg::floatArray2D>();
+    auto decoded_normal = decoded->normal.cast<vsg::vec2Array2D>();
+    double angle_sum = 0;
+    double angle_max = 0;
+    double depth_error_max = 0;
+    for (uint32_t i = 0; i < depth->valueCount(); ++i)
+    {
+        auto cos_angle = vsg::dot(normals[i], GBufferEncoder::decode_spherical(decoded_normal->data()[i]));
+        double angle = std::acos(std::clamp(static_cast<double>(cos_angle), -1., 1.)) * 180. / vsg::PI;
+        angle_sum += angle;
+        angle_max = std::max(angle_max, angle);
+        depth_error_max = std::max(depth_error_max,
+            static_cast<double>(std::abs(decoded_depth->data()[i] - depth->data()[i]) / depth->data()[i]));
+    }
+    auto& instrumentation = Instrumentation::instance();
+    instrumentation.add_counter(
+        "gbuffer.full_bytes_per_pixel", g_buffer_formats(GBufferEncoding::FULL).bytes_per_pixel());
+    instrumentation.add_counter(
+        "gbuffer.compact_bytes_per_pixel", g_buffer_formats(GBufferEncoding::COMPACT).bytes_per_pixel());
+    instrumentation.add_counter("gbuffer.normal_error_mean_deg", angle_sum / depth->valueCount());
+    instrumentation.add_counter("gbuffer.normal_error_max_deg", angle_max);
+    instrumentation.add_counter("gbuffer.depth_relative_error_max", depth_error_max);
+}
+void run_illumination_round_trip(const std::string& work_directory)
+{
+    std::mt19937 random(2);
+    std::uniform_real_distribution<float> uniform(0.f, 4.f);
+    OfflineIlluminations illuminations(gbuffer_frames);
+    for (auto& illumination : illuminations)
+    {
+        auto noisy = vsg::vec4Array2D::create(
+            gbuffer_width, gbuffer_height, vsg::Data::Layout{VK_FORMAT_R32G32B32A32_SFLOAT});
+        for (auto& value : *noisy)
+        {
+            value = vsg::vec4(uniform(random), uniform(random), uniform(random), 1.f);
+        }
+        illumination = OfflineIllumination::create();
+        illumination->noisy = noisy;
+    }
+
+    auto directory = std::filesystem::path(work_directory) / "illumination";
+    std::filesystem::create_directories(directory);
+    auto format = (directory / "illumination_%d.exr").string();
+    bool exported;
+    {
+        ScopedTimer timer("export", "bench");
+        exported = IlluminationBufferIO::export_illumination(format, gbuffer_frames, illuminations, 0);
+    }
+    if (!exported)
+    {
+        throw std::runtime_error("Illumination export failed");
+    }
+    ScopedTimer timer("import", "bench");
+    IlluminationBufferIO::import_illumination(format, gbuffer_frames, 0);
+}
+
+enum class SamplerPattern
+{
+    RANDOM,
+    SOBOL,
+    BLUE_NOISE
+};
+using Sample2D = std::array<float, 2>;
+
+// the first n values of sample2D(re, dimension) of a pixel, the white noise is drawn in sequence like in the shader.
+// The blue noise pattern is set up for the given samples per frame.
+std::vector<Sample2D> pixel_samples(
+    SamplerPattern pattern, uint32_t x, uint32_t y, uint32_t n, uint32_t dimension, uint32_t samples_per_frame)
+{
+    auto log2_samples = low_discrepancy::blue_noise_log2_samples(samples_per_frame);
+    std::vector<Sample2D> samples(n);
+    low_discrepancy::RandomEngine random(x, y, dimension);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        switch (pattern)
+        {
+        case SamplerPattern::RANDOM:
+            samples[i] = {random.next(), random.next()};
+            break;
+        case SamplerPattern::SOBOL:
+        {
+            auto seed = low_discrepancy::pixel_seed(x, y);
+            samples[i] = {low_discrepancy::sobol_sample(seed, i, dimension),
+                low_discrepancy::sobol_sample(seed, i, dimension + 1)};
+            break;
+        }
+        case SamplerPattern::BLUE_NOISE:
+            samples[i] = {low_discrepancy::z_sobol_sample(x, y, i, dimension, 0, log2_samples),
+                low_discrepancy::z_sobol_sample(x, y, i, dimension, 1, log2_samples)};
+            break;
+        }
+    }
+    return samples;
+}
+// L2 star discrepancy of a 2D point set (Warnock's formula)
+double l2_star_discrepancy(const std::vector<Sample2D>& samples)
+{
+    double n = static_cast<double>(samples.size());
+    double single_sum = 0;
+    double pair_sum = 0;
+    for (const auto& a : samples)
+    {
+        single_sum += (1. - a[0] * a[0]) * (1. - a[1] * a[1]);
+        for (const auto& b : samples)
+        {
+            pair_sum += (1. - std::max(a[0], b[0])) * (1. - std::max(a[1], b[1]));
+        }
+    }
+    return std::sqrt(std::max(1. / 9. - single_sum / (2. * n) + pair_sum / (n * n), 0.));
+}
+// quarter disk, the discontinuity is what the light and bsdf samples of the path tracer usually see
+double disk_integrand(const Sample2D& s)
+{
+    return s[0] * s[0] + s[1] * s[1] < 1.f ? 1. : 0.;
+}
+double smooth_integrand(const Sample2D& s)
+{
+    return std::exp(-static_cast<double>(s[0]) - s[1]);
+}
+void run_sampler(SamplerPattern pattern)
+{
+    // pixel jitter and bsdf direction of the second path vertex, the latter is in a later set of the padded sobol
+    const std::array<uint32_t, 2> dimensions{
+        0, low_discrepancy::camera_dimensions + low_discrepancy::vertex_dimensions + 5};
+    const std::array<const char*, 2> dimension_names{"camera", "bsdf"};
+    const std::array<uint32_t, 4> sample_counts{16, 64, 256, 1024};
+    const uint32_t pixels = 8;
+    const double disk_reference = vsg::PI / 4.;
+    const double smooth_reference = (1. - std::exp(-1.)) * (1. - std::exp(-1.));
+
+    std::vector<std::vector<Sample2D>> samples(dimensions.size() * pixels * pixels);
+    {
+        ScopedTimer timer("sample", "bench");
+        for (size_t d = 0; d < dimensions.size(); ++d)
+        {
+            for (uint32_t p = 0; p < pixels * pixels; ++p)
+            {
+                samples[d * pixels * pixels + p]
+                    = pixel_samples(pattern, p % pixels, p / pixels, sample_counts.back(), dimensions[d], 16);
+            }
+        }
+    }
+    // the prefixes of a pixel sequence are the progressive sample counts
+    for (auto n : sample_counts)
+    {
+        auto suffix = ".spp" + std::to_string(n);
+        for (size_t d = 0; d < dimensions.size(); ++d)
+        {
+            double discrepancy = 0;
+            double disk_error = 0;
+            double smooth_error = 0;
+            for (uint32_t p = 0; p < pixels * pixels; ++p)
+            {
+                const auto& pixel = samples[d * pixels * pixels + p];
+                std::vector<Sample2D> prefix(pixel.begin(), pixel.begin() + n);
+                discrepancy += l2_star_discrepancy(prefix);
+                double disk = 0;
+                double smooth = 0;
+                for (const auto& s : prefix)
+                {
+                    disk += disk_integrand(s);
+                    smooth += smooth_integrand(s);
+                }
+                disk_error += std::pow(disk / n - disk_reference, 2.);
+                smooth_error += std::pow(smooth / n - smooth_reference, 2.);
+            }
+            auto prefix = std::string("sampler.") + dimension_names[d];
+            Instrumentation::instance().add_counter(
+                prefix + ".l2_discrepancy" + suffix, discrepancy / (pixels * pixels));
+            Instrumentation::instance().add_counter(
+                prefix + ".rmse_disk" + suffix, std::sqrt(disk_error / (pixels * pixels)));
+            Instrumentation::instance().add_counter(
+                prefix + ".rmse_smooth" + suffix, std::sqrt(smooth_error / (pixels * pixels)));
+        }
+    }
+
+    // spatial error distribution at 4 spp: a 3x3 box filter removes most of a blue noise error, white noise keeps a
+    // third of its rms error
+    const uint32_t image_size = 64;
+    const uint32_t image_samples = 4;
+    std::vector<double> error(image_size * image_size);
+    for (uint32_t y = 0; y < image_size; ++y)
+    {
+        for (uint32_t x = 0; x < image_size; ++x)
+        {
+            double disk = 0;
+            for (const auto& s : pixel_samples(pattern, x, y, image_samples, 0, image_samples))
+            {
+                disk += disk_integrand(s);
+            }
+            error[y * image_size + x] = disk / image_samples - disk_reference;
+        }
+    }
+    double error_sum = 0;
+    double filtered_error_sum = 0;
+    for (uint32_t y = 1; y + 1 < image_size; ++y)
+    {
+        for (uint32_t x = 1; x + 1 < image_size; ++x)
+        {
+            double filtered = 0;
+            for (uint32_t j = y - 1; j <= y + 1; ++j)
+            {
+                for (uint32_t i = x - 1; i <= x + 1; ++i)
+                {
+                    filtered += error[j * image_size + i] / 9.;
+                }
+            }
+            error_sum += std::pow(error[y * image_size + x], 2.);
+            filtered_error_sum += filtered * filtered;
+        }
+    }
+    Instrumentation::instance().add_counter("sampler.filtered_error_ratio", std::sqrt(filtered_error_sum / error_sum));
+}
+}  // namespace
+
+const std::vector<ProceduralScene>& procedural_scenes()
+{
+    static const std::vector<ProceduralScene> scenes{
+        {"cornell", 1, 64, 0, 0},
+        {"spheres_128k", 8, 32, 4, 256},
+        {"spheres_1m", 16, 48, 16, 1024},
+    };
+    return scenes;
+}
+std::string write_procedural_scene(const ProceduralScene& scene, const std::string& directory)
+{
+    auto scene_directory = std::filesystem::path(directory) / scene.name;
+    auto obj_path = scene_directory / (scene.name + ".obj");
+    if (std::filesystem::exists(obj_path))
+    {
+        return obj_path.string();
+    }
+    std::filesystem::create_directories(scene_directory);
+
+    std::ofstream mtl(scene_directory / (scene.name + ".mtl"));
+    mtl << "newmtl white\nKd 0.8 0.8 0.8\n\n";
+    mtl << "newmtl red\nKd 0.8 0.1 0.1\n\n";
+    mtl << "newmtl green\nKd 0.1 0.8 0.1\n\n";
+    mtl << "newmtl light\nKd 0 0 0\nKe 15 15 15\n\n";
+    for (int t = 0; t < scene.texture_count; ++t)
+    {
+        auto texture = "texture_" + std::to_string(t) + ".ppm";
+        write_checker_texture((scene_directory / texture).string(), scene.texture_size, t);
+        mtl << "newmtl textured_" << t << "\nKd 1 1 1\nmap_Kd " << texture << "\n\n";
+    }
+
+    // the box spans [-1, 1] x [0, 2] x [-1, 1] with y up and is open towards +z
+    std::ofstream obj(obj_path);
+    obj << "mtllib " << scene.name << ".mtl\n";
+    uint32_t vertex_count = 0;
+    auto quad = [&](const char* material, vsg::vec3 o, vsg::vec3 u, vsg::vec3 v) {
+        auto n = vsg::normalize(vsg::cross(u, v));
+        for (auto p : {o, o + u, o + u + v, o + v})
+        {
+            obj << "v " << p.x << " " << p.y << " " << p.z << "\n";
+        }
+        obj << "vn " << n.x << " " << n.y << " " << n.z << "\n";
+        obj << "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n";
+        obj << "usemtl " << material << "\nf";
+        for (uint32_t i = 1; i <= 4; ++i)
+        {
+            auto index = vertex_count + i;
+            obj << " " << index << "/" << index << "/" << (vertex_count / 4 + 1);
+        }
+        obj << "\n";
+        vertex_count += 4;
+    };
+    // normals are face normals, so the vn index of a quad is the running quad index
+    quad("white", {-1, 0, 1}, {2, 0, 0}, {0, 0, -2});
+    quad("white", {-1, 2, -1}, {2, 0, 0}, {0, 0, 2});
+    quad("white", {-1, 0, -1}, {2, 0, 0}, {0, 2, 0});
+    quad("red", {-1, 0, 1}, {0, 0, -2}, {0, 2, 0});
+    quad("green", {1, 0, -1}, {0, 0, 2}, {0, 2, 0});
+    quad("light", {-.25f, 1.99f, -.25f}, {.5f, 0, 0}, {0, 0, .5f});
+    uint32_t normal_count = vertex_count / 4;
+
+    const int rings = scene.sphere_segments / 2;
+    const float spacing = 1.6f / static_cast<float>(scene.spheres_per_axis);
+    const float radius = .35f * spacing;
+    const float pi = 3.14159265f;
+    int sphere_index = 0;
+    for (int sx = 0; sx < scene.spheres_per_axis; ++sx)
+    {
+        for (int sz = 0; sz < scene.spheres_per_axis; ++sz, ++sphere_index)
+        {
+            vsg::vec3 center(-.8f + spacing * (static_cast<float>(sx) + .5f), radius,
+                -.8f + spacing * (static_cast<float>(sz) + .5f));
+            uint32_t first = vertex_count + 1;
+            for (int r = 0; r <= rings; ++r)
+            {
+                float theta = pi * static_cast<float>(r) / static_cast<float>(rings);
+                for (int s = 0; s <= scene.sphere_segments; ++s)
+                {
+                    float phi = 2.f * pi * static_cast<float>(s) / static_cast<float>(scene.sphere_segments);
+                    vsg::vec3 n(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+                    auto p = center + n * radius;
+                    obj << "v " << p.x << " " << p.y << " " << p.z << "\n";
+                    obj << "vn " << n.x << " " << n.y << " " << n.z << "\n";
+                    obj << "vt " << static_cast<float>(s) / static_cast<float>(scene.sphere_segments) << " "
+                        << static_cast<float>(r) / static_cast<float>(rings) << "\n";
+                }
+            }
+            if (scene.texture_count > 0)
+            {
+                obj << "usemtl textured_" << sphere_index % scene.texture_count << "\n";
+            }
+            else
+            {
+                obj << "usemtl white\n";
+            }
+            // texcoords were written per vertex for the quads as well, so position and texcoord indices match
+            uint32_t first_normal = normal_count + 1;
+            auto corner = [&](int r, int s) {
+                auto offset = static_cast<uint32_t>(r * (scene.sphere_segments + 1) + s);
+                return std::to_string(first + offset) + "/" + std::to_string(first + offset) + "/"
+                       + std::to_string(first_normal + offset);
+            };
+            for (int r = 0; r < rings; ++r)
+            {
+                for (int s = 0; s < scene.sphere_segments; ++s)
+                {
+                    obj << "f " << corner(r, s) << " " << corner(r + 1, s) << " " << corner(r + 1, s + 1) << "\n";
+                    obj << "f " << corner(r, s) << " " << corner(r + 1, s + 1) << " " << corner(r, s + 1) << "\n";
+                }
+            }
+            auto sphere_vertices = static_cast<uint32_t>((rings + 1) * (scene.sphere_segments + 1));
+            vertex_count += sphere_vertices;
+            normal_count += sphere_vertices;
+        }
+    }
+    if (!obj || !mtl)
+    {
+        throw std::runtime_error("Failed to write scene " + obj_path.string());
+    }
+    return obj_path.string();
+}
+void write_camera_path(const std::string& path, int num_frames)
+{
+    // the box is converted to z up on import, the open side faces -y
+    CameraMatricesVec matrices(num_frames);
+    for (int f = 0; f < num_frames; ++f)
+    {
+        double angle = .3 * std::sin(2. * vsg::PI * f / std::max(num_frames, 1));
+        vsg::dvec3 eye(3. * std::sin(angle), -3. * std::cos(angle), 1.);
+        auto view = vsg::lookAt(eye, vsg::dvec3(0., 0., 1.), vsg::dvec3(0., 0., 1.));
+        matrices[f].view = vsg::mat4(view);
+        matrices[f].inv_view = vsg::mat4(vsg::inverse(view));
+    }
+    if (!MatrixIO::export_matrices(path, matrices))
+    {
+        throw std::runtime_error("Failed to write camera path " + path);
+    }
+}
+std::vector<CpuScenario> cpu_scenarios(const std::vector<std::string>& scene_files)
+{
+    std::vector<CpuScenario> scenarios;
+    for (const auto& scene : procedural_scenes())
+    {
+        scenarios.push_back({"import/" + scene.name, [scene](const std::string& work_directory) {
+                                 run_import(write_procedural_scene(scene, work_directory));
+                             }});
+    }
+    for (const auto& scene_file : scene_files)
+    {
+        scenarios.push_back({"import/" + std::filesystem::path(scene_file).stem().string(),
+            [scene_file](const std::string&) { run_import(scene_file); }});
+    }
+    scenarios.push_back({"renderio/gbuffer", run_g_buffer_round_trip});
+    scenarios.push_back({"renderio/gbuffer_compact", run_g_buffer_compact});
+    scenarios.push_back({"renderio/illumination", run_illumination_round_trip});
+    scenarios.push_back({"sampler/random", [](const std::string&) { run_sampler(SamplerPattern::RANDOM); }});
+    scenarios.push_back({"sampler/sobol", [](const std::string&) { run_sampler(SamplerPattern::SOBOL); }});
+    scenarios.push_back({"sampler/bluenoise", [](const std::string&) { run_sampler(SamplerPattern::BLUE_NOISE); }});
+    return scenarios;
+}
+}  // namespace vkpbrt
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace vkpbrt
+{
+// Canned scene written as obj/mtl with generated textures: an open box with an area light and a grid of spheres.
+// The geometry only depends on the parameters, so results of different runs are comparable.
+struct ProceduralScene
+{
+    std::string name;
+    int spheres_per_axis;
+    int sphere_segments;  // longitude segments, half as many latitude rings
+    int texture_count;    // checker textures shared round robin by the spheres, 0 for untextured spheres
+    int texture_size;
+};
+
+const std::vector<ProceduralScene>& procedural_scenes();
+// writes <name>.obj, <name>.mtl and the textures into directory if they do not exist yet, returns the obj path
+std::string write_procedural_scene(const ProceduralScene& scene, const std::string& directory);
+// small orbit in front of the open side of the procedural box, loadable with --cameraPath
+void write_camera_path(const std::string& path, int num_frames);
+
+// Scenario without a Vulkan device, executed in a child process of the bench. Timings are recorded with
+// ScopedTimer in the "bench" category, sizes with Instrumentation counters.
+struct CpuScenario
+{
+    std::string name;
+    std::function<void(const std::string& work_directory)> run;
+};
+
+// import of every procedural and given scene plus RenderIO export/import round trips
+std::vector<CpuScenario> cpu_scenarios(const std::vector<std::string>& scene_files);
+}  // namespace vkpbrt
@@ -0,0 +1,195 @@
+#include <bench/LowDiscrepancy.hpp>
+
+#include <algorithm>
+#include <array>
+
+namespace vkpbrt
+{
+namespace low_discrepancy
+{
+namespace
+{
+// the table c_SobolDirections of sampler.glsl, built from the Joe and Kuo primitive polynomials
+std::array<uint32_t, 128> sobol_directions()
+{
+    struct Polynomial
+    {
+        uint32_t degree, coefficients;
+        std::array<uint32_t, 3> initial;
+    };
+    const std::array<Polynomial, 3> polynomials{{{1, 0, {1}}, {2, 1, {1, 3}}, {3, 1, {1, 3, 1}}}};
+    std::array<uint32_t, 128> directions{};
+    for (uint32_t bit = 0; bit < 32; ++bit)
+    {
+        directions[bit] = 1u << (31 - bit);
+    }
+    for (uint32_t d = 0; d < polynomials.size(); ++d)
+    {
+        const auto& p = polynomials[d];
+        std::array<uint32_t, 32> m{};
+        std::copy(p.initial.begin(), p.initial.begin() + p.degree, m.begin());
+        for (uint32_t i = p.degree; i < 32; ++i)
+        {
+            m[i] = m[i - p.degree] ^ (m[i - p.degree] << p.degree);
+            for (uint32_t k = 1; k < p.degree; ++k)
+            {
+                m[i] ^= ((p.coefficients >> (p.degree - 1 - k)) & 1) * (m[i - k] << k);
+            }
+        }
+        for (uint32_t bit = 0; bit < 32; ++bit)
+        {
+            directions[(d + 1) * 32 + bit] = m[bit] << (31 - bit);
+        }
+    }
+    return directions;
+}
+// the table c_DigitPermutations of sampler.glsl, all permutations of four base 4 digits in lexicographic order
+std::array<uint32_t, 24> digit_permutations()
+{
+    std::array<uint32_t, 24> permutations{};
+    std::array<uint32_t, 4> digits{0, 1, 2, 3};
+    for (auto& permutation : permutations)
+    {
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            permutation |= digits[i] << (2 * i);
+        }
+        std::next_permutation(digits.begin(), digits.end());
+    }
+    return permutations;
+}
+uint32_t sobol(uint32_t index, uint32_t dimension)
+{
+    static const auto directions = sobol_directions();
+    uint32_t result = 0;
+    for (uint32_t bit = 0; index != 0; index >>= 1, ++bit)
+    {
+        if (index & 1)
+        {
+            result ^= directions[dimension * 32 + bit];
+        }
+    }
+    return result;
+}
+uint32_t reverse_bits(uint32_t x)
+{
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+    x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+    x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+    x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+    return x;
+}
+uint32_t laine_karras_permutation(uint32_t x, uint32_t seed)
+{
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+uint32_t nested_uniform_scramble(uint32_t x, uint32_t seed)
+{
+    return reverse_bits(laine_karras_permutation(reverse_bits(x), seed));
+}
+uint32_t hash_combine(uint32_t seed, uint32_t v)
+{
+    return seed ^ (wang_hash(v) + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+}
+float fixed_point_to_float(uint32_t x)
+{
+    return static_cast<float>(x >> 8) * (1.f / 16777216.f);
+}
+uint32_t morton2(uint32_t x, uint32_t y)
+{
+    auto spread = [](uint32_t v) {
+        v &= 0xffffu;
+        v = (v | (v << 8)) & 0x00ff00ffu;
+        v = (v | (v << 4)) & 0x0f0f0f0fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        v = (v | (v << 1)) & 0x55555555u;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+uint32_t z_sobol_index(
+    uint32_t x, uint32_t y, uint32_t sample_index, uint32_t dimension, uint32_t seed, uint32_t log2_samples)
+{
+    static const auto permutations = digit_permutations();
+    const uint32_t sample_mask = (1u << log2_samples) - 1;
+    uint32_t morton_index = (morton2(x, y) << log2_samples) | (sample_index & sample_mask);
+    uint32_t index = 0;
+    for (int digit_shift = 22 + static_cast<int>(log2_samples); digit_shift >= 0; digit_shift -= 2)
+    {
+        uint32_t digit = (morton_index >> digit_shift) & 3;
+        uint32_t higher_digits = morton_index >> (digit_shift + 2);
+        uint32_t permutation = permutations[wang_hash(higher_digits ^ seed ^ (0x55555555u * dimension)) % 24];
+        index |= ((permutation >> (2 * digit)) & 3) << digit_shift;
+    }
+    return index;
+}
+uint32_t taus_step(uint32_t z, int s1, int s2, int s3, uint32_t m)
+{
+    uint32_t b = ((z << s1) ^ z) >> s2;
+    return ((z & m) << s3) ^ b;
+}
+}  // namespace
+
+uint32_t wang_hash(uint32_t seed)
+{
+    seed = (seed ^ 61) ^ (seed >> 16);
+    seed *= 9;
+    seed = seed ^ (seed >> 4);
+    seed *= 0x27d4eb2d;
+    seed = seed ^ (seed >> 15);
+    return seed;
+}
+uint32_t pixel_seed(uint32_t x, uint32_t y)
+{
+    return wang_hash(x ^ wang_hash(y));
+}
+RandomEngine::RandomEngine(uint32_t x, uint32_t y, uint32_t frame_index)
+    : _state{wang_hash(x), wang_hash(y), wang_hash(frame_index), wang_hash((x + y) * frame_index)}
+{
+}
+float RandomEngine::next()
+{
+    _state[0] = taus_step(_state[0], 13, 19, 12, 4294967294u);
+    _state[1] = taus_step(_state[1], 2, 25, 4, 4294967288u);
+    _state[2] = taus_step(_state[2], 3, 11, 17, 4294967280u);
+    _state[3] = 1664525u * _state[3] + 1013904223u;
+    return 2.3283064365387e-10f * static_cast<float>(_state[0] ^ _state[1] ^ _state[2] ^ _state[3]);
+}
+float sobol_sample(uint32_t pixel_seed, uint32_t sample_index, uint32_t dimension)
+{
+    uint32_t set_seed = hash_combine(pixel_seed, dimension / 4);
+    uint32_t index = nested_uniform_scramble(sample_index, set_seed);
+    uint32_t component = dimension % 4;
+    return fixed_point_to_float(
+        nested_uniform_scramble(sobol(index, component), hash_combine(set_seed, component + 1)));
+}
+float z_sobol_sample(uint32_t x, uint32_t y, uint32_t sample_index, uint32_t dimension, uint32_t component,
+    uint32_t log2_samples)
+{
+    uint32_t seed = wang_hash(sample_index >> log2_samples);
+    uint32_t index = z_sobol_index(x, y, sample_index, dimension, seed, log2_samples);
+    uint32_t scramble_seed = hash_combine(seed, dimension);
+    if (component == 1)
+    {
+        scramble_seed = hash_combine(scramble_seed, 1);
+    }
+    return fixed_point_to_float(nested_uniform_scramble(sobol(index, component), scramble_seed));
+}
+uint32_t blue_noise_log2_samples(uint32_t samples)
+{
+    // odd exponents would pair sample bits with pixel bits in a base 4 digit
+    uint32_t log2_samples = 0;
+    while (log2_samples < 4 && (1u << log2_samples) < samples)
+    {
+        log2_samples += 2;
+    }
+    return log2_samples;
+}
+}  // namespace low_discrepancy
+}  // namespace vkpbrt
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+namespace vkpbrt
+{
+// CPU copy of the samplers in shaders/random.glsl and shaders/sampler.glsl, used by the bench to measure the
+// discrepancy and convergence of the sample patterns the path tracer sees. Has to be kept in sync with the shaders.
+namespace low_discrepancy
+{
+constexpr uint32_t camera_dimensions = 4;
+constexpr uint32_t vertex_dimensions = 8;
+
+uint32_t wang_hash(uint32_t seed);
+// seed of rEInit(), independent of the frame
+uint32_t pixel_seed(uint32_t x, uint32_t y);
+
+// white noise generator of random.glsl, initialized like rEInit()
+class RandomEngine
+{
+public:
+    RandomEngine(uint32_t x, uint32_t y, uint32_t frame_index);
+    float next();
+
+private:
+    uint32_t _state[4];
+};
+
+// owen scrambled padded sobol sample, SAMPLER_SOBOL
+float sobol_sample(uint32_t pixel_seed, uint32_t sample_index, uint32_t dimension);
+// z-order sobol sample, SAMPLER_BLUE_NOISE, component selects the first or second value of sample2D()
+float z_sobol_sample(uint32_t x, uint32_t y, uint32_t sample_index, uint32_t dimension, uint32_t component,
+    uint32_t log2_samples);
+// blueNoiseLog2Samples for the given samples per frame
+uint32_t blue_noise_log2_samples(uint32_t samples);
+}  // namespace low_discrepancy
+}  // namespace vkpbrt
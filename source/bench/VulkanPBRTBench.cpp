@@ -0,0 +1,392 @@
+// Benchmark suite for VulkanPBRT.
+// Every scenario runs in its own process with --trace, the metrics are derived from the written trace files:
+// cpu scenarios (scene import, RenderIO round trips) are run by this executable and need no Vulkan device, render
+// scenarios start the VulkanPBRT executable with a canned scene, a fixed camera path and fixed sample counts.
+// The results are written as JSON and can be compared against a stored baseline with relative tolerances.
+#include <bench/BenchScenarios.hpp>
+#include <util/Instrumentation.hpp>
+
+#include <vsg/all.h>
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#ifndef VULKANPBRT_EXECUTABLE
+#define VULKANPBRT_EXECUTABLE "VulkanPBRT"
+#endif
+
+namespace
+{
+struct RenderConfig
+{
+    std::string name;
+    std::vector<std::string> arguments;
+};
+
+// every denoiser with each of its block sizes, svgf is not implemented yet
+std::vector<RenderConfig> render_configs()
+{
+    std::vector<RenderConfig> configs{{"none", {"--denoiser", "none"}}};
+    for (const char* denoiser : {"bfr", "bmfr"})
+    {
+        for (const char* block_size : {"8", "16", "32", "8-16-32"})
+        {
+            configs.push_back({std::string(denoiser) + "_" + block_size,
+                {"--denoiser", denoiser, "--denoiserBlockSize", block_size}});
+        }
+    }
+    configs.push_back({"wavefront", {"--denoiser", "none", "--wavefront"}});
+    // same paths as "none" traced with inline ray queries
+    configs.push_back({"ray_query", {"--denoiser", "none", "--rayQuery"}});
+    // same paths traced through the bvh of the software backend
+    configs.push_back({"software_bvh", {"--denoiser", "none", "--softwareBVH"}});
+    // primary hits rasterized instead of traced
+    configs.push_back({"raster_primary", {"--denoiser", "none", "--rasterPrimary"}});
+    // bmfr_16 with depth and normals reconstructed from a visibility g-buffer
+    configs.push_back(
+        {"bmfr_16_visibility", {"--denoiser", "bmfr", "--denoiserBlockSize", "16", "--visibilityBuffer"}});
+    // bmfr_16 with the compact g-buffer encoding
+    configs.push_back({"bmfr_16_compact", {"--denoiser", "bmfr", "--denoiserBlockSize", "16", "--compactGBuffer"}});
+    return configs;
+}
+std::string quote(const std::string& argument)
+{
+    return "\"" + argument + "\"";
+}
+bool run_process(const std::string& executable, const std::vector<std::string>& arguments, const std::string& log)
+{
+    std::string command = quote(executable);
+    for (const auto& argument : arguments)
+    {
+        command += " " + quote(argument);
+    }
+    command += " > " + quote(log) + " 2>&1";
+#ifdef _WIN32
+    command = "\"" + command + "\"";  // cmd strips the outer quotes
+#endif
+    return std::system(command.c_str()) == 0;
+}
+std::string metric_name(std::string name)
+{
+    for (auto& c : name)
+    {
+        c = std::isalnum(static_cast<unsigned char>(c)) != 0 ? static_cast<char>(std::tolower(c)) : '_';
+    }
+    return name;
+}
+// "_ms" and "_mb" metrics are better when lower, "_per_s" metrics when higher, all others are informational
+int metric_direction(const std::string& name)
+{
+    auto ends_with = [&](const std::string& suffix) {
+        return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    if (ends_with("_ms") || ends_with("_mb"))
+    {
+        return -1;
+    }
+    if (ends_with("_per_s"))
+    {
+        return 1;
+    }
+    return 0;
+}
+nlohmann::json metrics_from_trace(const std::string& trace_path)
+{
+    std::ifstream file(trace_path);
+    if (!file)
+    {
+        return {};
+    }
+    nlohmann::json trace = nlohmann::json::parse(file, nullptr, false);
+    if (trace.is_discarded())
+    {
+        return {};
+    }
+
+    nlohmann::json metrics = nlohmann::json::object();
+    double read_ms = 0.;
+    double write_ms = 0.;
+    for (const auto& event : trace["traceEvents"])
+    {
+        std::string category = event["cat"];
+        std::string name = event["name"];
+        double ms = event["dur"].get<double>() * 1e-3;
+        if (category == "bench" || category == "startup")
+        {
+            auto key = (category == "startup" ? "startup_" : "") + metric_name(name) + "_ms";
+            metrics[key] = metrics.value(key, 0.) + ms;
+        }
+        else if (category == "io" && (name == "gbuffer import" || name == "illumination import"))
+        {
+            read_ms += ms;
+        }
+        else if (category == "io" && (name == "gbuffer export" || name == "illumination export"))
+        {
+            write_ms += ms;
+        }
+    }
+    auto counters = trace.value("counters", nlohmann::json::object());
+    for (const auto& [name, value] : counters.items())
+    {
+        metrics["counter." + name] = value;
+    }
+    if (read_ms > 0.)
+    {
+        metrics["read_mb_per_s"] = counters.value("io.bytes_read", 0.) / 1e6 / (read_ms * 1e-3);
+    }
+    if (write_ms > 0.)
+    {
+        metrics["write_mb_per_s"] = counters.value("io.bytes_written", 0.) / 1e6 / (write_ms * 1e-3);
+    }
+    if (trace.contains("frameTimes"))
+    {
+        metrics["frame_mean_ms"] = trace["frameTimes"]["mean"];
+        metrics["frame_p95_ms"] = trace["frameTimes"]["p95"];
+    }
+    for (const auto& [module, times] : trace.value("gpuTimes", nlohmann::json::object()).items())
+    {
+        metrics["gpu_" + metric_name(module) + "_ms"] = times["mean"];
+    }
+    if (metrics.contains("gpu_raytrace_ms") && metrics["gpu_raytrace_ms"].get<double>() > 0.)
+    {
+        double seconds = metrics["gpu_raytrace_ms"].get<double>() * 1e-3;
+        if (counters.value("rays.frames", 0.) > 0.)
+        {
+            // rays counted by the shaders with --rayStatistics
+            double rays = (counters.value("rays.primary", 0.) + counters.value("rays.bounce", 0.)
+                              + counters.value("rays.shadow", 0.))
+                          / counters["rays.frames"].get<double>();
+            metrics["mrays_per_s"] = rays / seconds / 1e6;
+        }
+        else
+        {
+            // the estimate also shown in the gui: one path segment and one shadow ray per bounce. It is a separate
+            // metric, so it is never compared to a measured baseline
+            double rays = counters.value("render.width", 0.) * counters.value("render.height", 0.)
+                          * counters.value("render.estimated_rays_per_pixel", 0.);
+            metrics["estimated_mrays_per_s"] = rays / seconds / 1e6;
+        }
+    }
+    metrics["peak_memory_mb"] = trace.value("peakMemoryMB", 0.);
+    return metrics;
+}
+// prints every compared metric, returns the number of regressions
+int compare_to_baseline(const nlohmann::json& results, const nlohmann::json& baseline, double default_tolerance)
+{
+    auto tolerances = baseline.value("tolerances", nlohmann::json::object());
+    int regressions = 0;
+    std::cout << std::left << std::setw(48) << "scenario/metric" << std::right << std::setw(14) << "baseline"
+              << std::setw(14) << "current" << std::setw(10) << "change" << std::endl;
+    for (const auto& [scenario, baseline_metrics] : baseline["scenarios"].items())
+    {
+        if (!results["scenarios"].contains(scenario))
+        {
+            if (std::find(results["failed"].begin(), results["failed"].end(), scenario) != results["failed"].end())
+            {
+                std::cout << scenario << ": FAILED" << std::endl;
+                ++regressions;
+            }
+            continue;  // not selected in this run, e.g. --cpuOnly
+        }
+        const auto& current_metrics = results["scenarios"][scenario];
+        for (const auto& [name, baseline_value] : baseline_metrics.items())
+        {
+            int direction = metric_direction(name);
+            if (direction == 0 || !current_metrics.contains(name))
+            {
+                continue;
+            }
+            double base = baseline_value;
+            double current = current_metrics[name];
+            double change = base != 0. ? (current - base) / base : 0.;
+            // a tolerance for "scenario:metric" overrides the one for "metric"
+            double tolerance = tolerances.value(scenario + ":" + name, tolerances.value(name, default_tolerance));
+            bool regression = direction * change < -tolerance;
+            regressions += regression ? 1 : 0;
+            std::cout << std::left << std::setw(48) << scenario + "/" + name << std::right << std::fixed
+                      << std::setprecision(3) << std::setw(14) << base << std::setw(14) << current << std::setw(9)
+                      << std::setprecision(1) << change * 100. << "%" << (regression ? "  REGRESSION" : "")
+                      << std::endl;
+        }
+    }
+    return regressions;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        vsg::CommandLine arguments(&argc, argv);
+        auto renderer = arguments.value(std::string(VULKANPBRT_EXECUTABLE), "--renderer");
+        auto work_directory = arguments.value(std::string("bench_work"), "--workDir");
+        auto output_path = arguments.value(std::string("bench_results.json"), "--output");
+        auto baseline_path = arguments.value(std::string(), "--baseline");
+        auto tolerance = arguments.value(0.1, "--tolerance");
+        auto filter = arguments.value(std::string(), "--filter");
+        auto num_frames = arguments.value(64, "-f");
+        auto samples_per_pixel = arguments.value(1, "--spp");
+        bool cpu_only = arguments.read("--cpuOnly");
+        // the shader counters cost a few atomics per pixel, without them only estimated_mrays_per_s is reported
+        bool ray_statistics = !arguments.read("--noRayStatistics");
+        std::vector<std::string> scene_files;
+        std::string scene_file;
+        while (arguments.read("--scene", scene_file))
+        {
+            scene_files.push_back(scene_file);
+        }
+        // internal: executes a single cpu scenario, used for the child processes
+        auto run_scenario = arguments.value(std::string(), "--runScenario");
+        auto trace_path = arguments.value(std::string(), "--trace");
+        if (arguments.errors())
+        {
+            return arguments.writeErrorMessages(std::cerr);
+        }
+        std::filesystem::create_directories(work_directory);
+
+        auto cpu_scenarios = vkpbrt::cpu_scenarios(scene_files);
+        if (!run_scenario.empty())
+        {
+            auto scenario = std::find_if(cpu_scenarios.begin(), cpu_scenarios.end(),
+                [&](const vkpbrt::CpuScenario& s) { return s.name == run_scenario; });
+            if (scenario == cpu_scenarios.end())
+            {
+                std::cerr << "Unknown scenario " << run_scenario << std::endl;
+                return 1;
+            }
+            vkpbrt::Instrumentation::instance().enable(trace_path);
+            scenario->run(work_directory);
+            vkpbrt::Instrumentation::instance().write();
+            return 0;
+        }
+
+        nlohmann::json results;
+        results["scenarios"] = nlohmann::json::object();
+        results["failed"] = nlohmann::json::array();
+        auto selected = [&](const std::string& name) { return filter.empty() || name.find(filter) != std::string::npos; };
+        auto run = [&](const std::string& name, const std::string& executable, std::vector<std::string> run_arguments) {
+            auto file_name = metric_name(name);
+            auto trace = (std::filesystem::path(work_directory) / (file_name + ".trace.json")).string();
+            auto log = (std::filesystem::path(work_directory) / (file_name + ".log")).string();
+            std::filesystem::remove(trace);
+            run_arguments.insert(run_arguments.end(), {"--trace", trace});
+            std::cout << name << " ... " << std::flush;
+            nlohmann::json metrics;
+            if (!run_process(executable, run_arguments, log) || (metrics = metrics_from_trace(trace)).empty())
+            {
+                std::cout << "failed, see " << log << std::endl;
+                results["failed"].push_back(name);
+                return;
+            }
+            results["scenarios"][name] = metrics;
+            std::cout << "done" << std::endl;
+        };
+
+        for (const auto& scenario : cpu_scenarios)
+        {
+            if (!selected(scenario.name))
+            {
+                continue;
+            }
+            std::vector<std::string> child_arguments{"--runScenario", scenario.name, "--workDir", work_directory};
+            for (const auto& file : scene_files)
+            {
+                child_arguments.insert(child_arguments.end(), {"--scene", file});
+            }
+            run(scenario.name, argv[0], child_arguments);
+        }
+
+        if (!cpu_only)
+        {
+            auto camera_path = (std::filesystem::path(work_directory) / "camera_path.json").string();
+            vkpbrt::write_camera_path(camera_path, num_frames);
+            auto shader_cache = (std::filesystem::path(work_directory) / "shader_cache").string();
+            // shaders are compiled once up front, so startup times do not depend on the scenario order
+            run_process(renderer, {"--precompileShaders", "--shaderCache", shader_cache},
+                (std::filesystem::path(work_directory) / "precompile.log").string());
+
+            std::vector<std::pair<std::string, std::vector<std::string>>> scenes;
+            for (const auto& scene : vkpbrt::procedural_scenes())
+            {
+                scenes.push_back({scene.name, {"-i", vkpbrt::write_procedural_scene(scene, work_directory),
+                                                  "--cameraPath", camera_path}});
+            }
+            for (const auto& file : scene_files)
+            {
+                scenes.push_back({std::filesystem::path(file).stem().string(), {"-i", file}});
+            }
+            for (const auto& [scene_name, scene_arguments] : scenes)
+            {
+                std::vector<std::string> common = scene_arguments;
+                common.insert(common.end(), {"-f", std::to_string(num_frames), "--spp",
+                                                std::to_string(samples_per_pixel), "--shaderCache", shader_cache,
+                                                "--noPipelineCache"});
+                for (const auto& config : render_configs())
+                {
+                    auto name = "render/" + scene_name + "/" + config.name;
+                    if (!selected(name))
+                    {
+                        continue;
+                    }
+                    auto render_arguments = common;
+                    render_arguments.insert(render_arguments.end(), config.arguments.begin(), config.arguments.end());
+                    if (ray_statistics)
+                    {
+                        render_arguments.emplace_back("--rayStatistics");
+                    }
+                    run(name, renderer, render_arguments);
+                }
+                // gbuffer and illumination export, the throughput is part of the metrics
+                auto name = "export/" + scene_name;
+                if (selected(name))
+                {
+                    auto export_directory = std::filesystem::path(work_directory) / metric_name(name);
+                    std::filesystem::create_directories(export_directory);
+                    auto format = [&](const char* image) {
+                        return (export_directory / (std::string(image) + "_%d.exr")).string();
+                    };
+                    auto export_arguments = common;
+                    export_arguments.insert(export_arguments.end(),
+                        {"--exportDepth", format("depth"), "--exportNormal", format("normal"), "--exportAlbedo",
+                            format("albedo"), "--exportMaterial", format("material"), "--exportIllumination",
+                            format("illumination")});
+                    run(name, renderer, export_arguments);
+                }
+            }
+        }
+
+        std::ofstream output(output_path);
+        output << results.dump(2);
+        std::cout << "Results written to " << output_path << std::endl;
+
+        int regressions = 0;
+        if (!baseline_path.empty())
+        {
+            std::ifstream baseline_file(baseline_path);
+            if (!baseline_file)
+            {
+                std::cerr << "Baseline " << baseline_path << " not found." << std::endl;
+                return 1;
+            }
+            regressions = compare_to_baseline(results, nlohmann::json::parse(baseline_file), tolerance);
+            std::cout << regressions << " regressions" << std::endl;
+        }
+        return regressions > 0 || !results["failed"].empty() ? 1 : 0;
+    }
+    catch (const vsg::Exception& e)
+    {
+        std::cerr << e.message << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
+    return 1;
+}
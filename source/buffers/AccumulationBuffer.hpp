@@ -7,12 +7,16 @@
 
 // class to holding buffer needed for accumulation. These are:
 // prevIllu, prevDepth, prevNormal, spp, prevSpp, motion
+// With a visibility g-buffer prevVisibility replaces prevDepth and prevNormal (which stay null then), else the two have
+// the formats of the g-buffer encoding
 class AccumulationBuffer : public vsg::Inherit<vsg::Object, AccumulationBuffer>
 {
 public:
-    AccumulationBuffer(uint32_t width, uint32_t height);
+    AccumulationBuffer(uint32_t width, uint32_t height, GBufferLayout g_buffer_layout = GBufferLayout::ATTRIBUTES,
+        GBufferEncoding g_buffer_encoding = GBufferEncoding::FULL);
 
-    vsg::ref_ptr<vsg::DescriptorImage> prev_illu, prev_illu_squared, prev_depth, prev_normal, spp, prev_spp, motion;
+    vsg::ref_ptr<vsg::DescriptorImage> prev_illu, prev_illu_squared, prev_depth, prev_normal, prev_visibility, spp,
+        prev_spp, motion;
 
     void update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const;
 
@@ -25,6 +29,8 @@ public:
 
 protected:
     uint32_t _width, _height;
+    GBufferLayout _g_buffer_layout;
+    GBufferEncoding _g_buffer_encoding;
 
     void setup_images();
 };
@@ -0,0 +1,167 @@
+#include <buffers/AdaptiveSamplingBuffer.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+class AdaptiveSamplingBuffer::Readback : public vsg::Inherit<vsg::Command, Readback>
+{
+public:
+    Readback(vsg::ref_ptr<vsg::Buffer> trace_rays_command, vsg::ref_ptr<vsg::Buffer> readback, uint32_t slots)
+        : trace_rays_command(trace_rays_command), readback(readback), slots(slots)
+    {
+    }
+    vsg::ref_ptr<vsg::Buffer> trace_rays_command, readback;
+    uint32_t slots;
+    // dispatch n is copied to slot (n - 1) % slots and stamped with n
+    mutable uint64_t recorded_dispatches = 0;
+
+    void record(vsg::CommandBuffer& command_buffer) const override
+    {
+        VkDeviceSize slot_offset = (recorded_dispatches % slots) * _slot_stride;
+        uint64_t stamp = ++recorded_dispatches;
+
+        VkMemoryBarrier barrier{
+            VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT};
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            1, &barrier, 0, nullptr, 0, nullptr);
+        VkBufferCopy region{0, slot_offset, sizeof(AdaptiveSamplingCommand)};
+        vkCmdCopyBuffer(command_buffer, trace_rays_command->vk(command_buffer.deviceID),
+            readback->vk(command_buffer.deviceID), 1, &region);
+        // the stamp is only written after the command, so a matching stamp means the slot is complete
+        barrier = {
+            VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_WRITE_BIT};
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1,
+            &barrier, 0, nullptr, 0, nullptr);
+        vkCmdUpdateBuffer(command_buffer, readback->vk(command_buffer.deviceID), slot_offset + _stamp_offset,
+            sizeof(stamp), &stamp);
+        barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT};
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1,
+            &barrier, 0, nullptr, 0, nullptr);
+    }
+};
+
+AdaptiveSamplingBuffer::AdaptiveSamplingBuffer(uint32_t width, uint32_t height, uint32_t readback_slots)
+    : width(width), height(height), _readback_slots(readback_slots)
+{
+    setup_images();
+    _readback_command = Readback::create(trace_rays_command, _readback, _readback_slots);
+}
+void AdaptiveSamplingBuffer::update_descriptor(
+    vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const
+{
+    int statistics_ind = vsg::ShaderStage::getSetBindingIndex(binding_map, "sampleStatistics").second;
+    auto statistics_bind = vsg::DescriptorImage::create(
+        sample_statistics->imageInfoList, statistics_ind, 0, sample_statistics->descriptorType);
+    int active_pixels_ind = vsg::ShaderStage::getSetBindingIndex(binding_map, "ActivePixels").second;
+    auto active_pixels_bind = vsg::DescriptorBuffer::create(
+        vsg::BufferInfoList{vsg::BufferInfo::create(active_pixels, 0, active_pixels->size)}, active_pixels_ind, 0,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+    desc_set->descriptorSet->descriptors.push_back(statistics_bind);
+    desc_set->descriptorSet->descriptors.push_back(active_pixels_bind);
+}
+void AdaptiveSamplingBuffer::update_image_layouts(vsg::Context& context) const
+{
+    VkImageSubresourceRange resource_range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    auto statistics_layout
+        = vsg::ImageMemoryBarrier::create(VK_ACCESS_NONE_KHR, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_GENERAL, 0, 0, sample_statistics->imageInfoList[0]->imageView->image, resource_range);
+    auto pipeline_barrier = vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_DEPENDENCY_BY_REGION_BIT, statistics_layout);
+    context.commands.emplace_back(pipeline_barrier);
+}
+void AdaptiveSamplingBuffer::compile(vsg::Context& context)
+{
+    sample_statistics->compile(context);
+    for (const auto& buffer : {active_pixels, trace_rays_command})
+    {
+        if (!buffer->compile(context.device))
+        {
+            continue;
+        }
+        // the indirect trace rays command is referenced by its device address
+        VkMemoryAllocateFlagsInfo allocate_flags_info{};
+        allocate_flags_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+        allocate_flags_info.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+        auto memory = vsg::DeviceMemory::create(context.device, buffer->getMemoryRequirements(context.deviceID),
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &allocate_flags_info);
+        buffer->bind(memory, 0);
+    }
+    if (!_readback->compile(context.device))
+    {
+        return;
+    }
+    auto memory = vsg::DeviceMemory::create(context.device, _readback->getMemoryRequirements(context.deviceID),
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    _readback->bind(memory, 0);
+    void* data = nullptr;
+    if (VkResult result = memory->map(0, _readback->size, 0, &data); result != VK_SUCCESS)
+    {
+        throw vsg::Exception{"Error: AdaptiveSamplingBuffer::compile(...) failed to map the readback buffer.", result};
+    }
+    // slots which were never written have stamp 0
+    std::memset(data, 0, _readback->size);
+    _readback_data = static_cast<const uint8_t*>(data);
+}
+void AdaptiveSamplingBuffer::add_readback_to_command_graph(vsg::ref_ptr<vsg::Commands> commands) const
+{
+    commands->addChild(_readback_command);
+}
+bool AdaptiveSamplingBuffer::read(AdaptiveSamplingResult& result)
+{
+    if (!_readback_data)
+    {
+        return false;
+    }
+    // dispatches older than the ring size may already be overwritten by newer dispatches in flight
+    uint64_t recorded = _readback_command->recorded_dispatches;
+    uint64_t dispatch = std::max(_last_read_dispatch, recorded > _readback_slots ? recorded - _readback_slots : 0) + 1;
+    if (dispatch > recorded)
+    {
+        return false;
+    }
+    const uint8_t* slot = _readback_data + ((dispatch - 1) % _readback_slots) * _slot_stride;
+    uint64_t stamp;
+    std::memcpy(&stamp, slot + _stamp_offset, sizeof(stamp));
+    if (stamp != dispatch)
+    {
+        return false;
+    }
+    AdaptiveSamplingCommand command;
+    std::memcpy(&command, slot, sizeof(command));
+    result.dispatch = dispatch;
+    result.active_pixels = command.width;
+    result.mean_relative_error = static_cast<double>(command.relative_error_sum())
+                                 / AdaptiveSamplingCommand::error_scale / (static_cast<double>(width) * height);
+    _last_read_dispatch = dispatch;
+    return true;
+}
+void AdaptiveSamplingBuffer::setup_images()
+{
+    auto image = vsg::Image::create();
+    image->imageType = VK_IMAGE_TYPE_2D;
+    image->format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    image->extent.width = width;
+    image->extent.height = height;
+    image->extent.depth = 1;
+    image->mipLevels = 1;
+    image->arrayLayers = 1;
+    image->samples = VK_SAMPLE_COUNT_1_BIT;
+    image->tiling = VK_IMAGE_TILING_OPTIMAL;
+    image->usage = VK_IMAGE_USAGE_STORAGE_BIT;
+    image->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image->sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    auto image_view = vsg::ImageView::create(image, VK_IMAGE_ASPECT_COLOR_BIT);
+    auto image_info = vsg::ImageInfo::create(vsg::ref_ptr<vsg::Sampler>{}, image_view, VK_IMAGE_LAYOUT_GENERAL);
+    sample_statistics = vsg::DescriptorImage::create(image_info, 0, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+
+    // one packed uint per pixel
+    active_pixels = vsg::Buffer::create(sizeof(uint32_t) * width * height, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_SHARING_MODE_EXCLUSIVE);
+    trace_rays_command = vsg::Buffer::create(sizeof(AdaptiveSamplingCommand),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+            | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VK_SHARING_MODE_EXCLUSIVE);
+    _readback = vsg::Buffer::create(
+        _slot_stride * _readback_slots, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE);
+}
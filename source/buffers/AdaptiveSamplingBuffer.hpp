@@ -0,0 +1,74 @@
+#pragma once
+#include <vsg/all.h>
+
+#include <cstdint>
+
+// host copy of the TraceRaysCommand buffer in shaders/adaptiveSampling.comp
+struct AdaptiveSamplingCommand
+{
+    static constexpr double error_scale = 1024.;
+
+    uint32_t width;  // number of active pixels
+    uint32_t height;
+    uint32_t depth;
+    // 64 bit sum split into two words, the buffer has no 8 byte alignment
+    uint32_t relative_error_sum_low;
+    uint32_t relative_error_sum_high;
+
+    uint64_t relative_error_sum() const
+    {
+        return static_cast<uint64_t>(relative_error_sum_high) << 32 | relative_error_sum_low;
+    }
+};
+static_assert(
+    sizeof(AdaptiveSamplingCommand) == 5 * sizeof(uint32_t), "AdaptiveSamplingCommand has to match the shader layout");
+
+// convergence of the image as counted by one adaptive sampling dispatch
+struct AdaptiveSamplingResult
+{
+    uint64_t dispatch;  // number of the dispatch, counted from 1 in the order they were recorded
+    uint32_t active_pixels;  // pixels traced by the dispatch
+    double mean_relative_error;  // of all pixels before the dispatch
+};
+
+// per pixel sample statistics and the list of not yet converged pixels for adaptive sampling
+// the list is filled by the AdaptiveSampler every frame, trace_rays_command holds the VkTraceRaysIndirectCommandKHR
+// the raygen shader is launched with (see layoutPTAdaptiveSampling.glsl). The command is copied into a ring of host
+// visible slots after every dispatch, so the convergence can be read without waiting for the gpu
+class AdaptiveSamplingBuffer : public vsg::Inherit<vsg::Object, AdaptiveSamplingBuffer>
+{
+public:
+    AdaptiveSamplingBuffer(uint32_t width, uint32_t height, uint32_t readback_slots = 8);
+
+    uint32_t width, height;
+    vsg::ref_ptr<vsg::DescriptorImage> sample_statistics;
+    vsg::ref_ptr<vsg::Buffer> active_pixels, trace_rays_command;
+
+    void update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const;
+
+    void update_image_layouts(vsg::Context& context) const;
+
+    // the buffers have to be compiled before any descriptor set using them, else they end up in host memory
+    void compile(vsg::Context& context);
+
+    // has to be added after the adaptive sampling dispatch
+    void add_readback_to_command_graph(vsg::ref_ptr<vsg::Commands> commands) const;
+
+    // copies the result of the oldest finished dispatch which was not read yet, returns false if the next dispatch has
+    // not finished. Results which were overwritten in the ring before they were read are skipped
+    bool read(AdaptiveSamplingResult& result);
+
+protected:
+    class Readback;
+
+    void setup_images();
+
+    static constexpr VkDeviceSize _slot_stride = 32;  // command followed by the 64 bit dispatch stamp
+    static constexpr VkDeviceSize _stamp_offset = 24;
+
+    uint32_t _readback_slots;
+    vsg::ref_ptr<vsg::Buffer> _readback;
+    vsg::ref_ptr<Readback> _readback_command;
+    const uint8_t* _readback_data = nullptr;
+    uint64_t _last_read_dispatch = 0;
+};
@@ -0,0 +1,18 @@
+#pragma once
+#include <buffers/IlluminationBuffer.hpp>
+
+#include <vsg/all.h>
+
+#include <cstdint>
+
+// per pixel cost of the path tracer, written by the raygen shader if it is compiled with COST_HEATMAP
+// costImage: x shader time in realtime clock ticks, y bounce rays, z shadow rays, w any hit invocations
+// anyHitCountImage is only a scratch counter for the any hit shader
+// derived from IlluminationBuffer so the cost image can be exported with OfflineIllumination and IlluminationBufferIO
+class CostBuffer : public vsg::Inherit<IlluminationBuffer, CostBuffer>
+{
+public:
+    CostBuffer(uint32_t width, uint32_t height);
+
+    void fill_images();
+};
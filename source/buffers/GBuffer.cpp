@@ -1,125 +1,148 @@
 #include <buffers/GBuffer.hpp>
 
-GBuffer::GBuffer(uint32_t width, uint32_t height) : width(width), height(height)
+namespace
+{
+// storage image in general layout, bound initially to set 0 binding 0. Correct binding number is set in
+// update_descriptor()
+vsg::ref_ptr<vsg::DescriptorImage> create_g_buffer_image(uint32_t width, uint32_t height, VkFormat format)
+{
+    auto image = vsg::Image::create();
+    image->imageType = VK_IMAGE_TYPE_2D;
+    image->format = format;
+    image->extent.width = width;
+    image->extent.height = height;
+    image->extent.depth = 1;
+    image->mipLevels = 1;
+    image->arrayLayers = 1;
+    image->samples = VK_SAMPLE_COUNT_1_BIT;
+    image->tiling = VK_IMAGE_TILING_OPTIMAL;
+    image->usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    image->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image->sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    auto image_view = vsg::ImageView::create(image, VK_IMAGE_ASPECT_COLOR_BIT);
+    auto image_info = vsg::ImageInfo::create(vsg::ref_ptr<vsg::Sampler>{}, image_view, VK_IMAGE_LAYOUT_GENERAL);
+    return vsg::DescriptorImage::create(image_info, 0, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+}
+}  // namespace
+
+GBuffer::GBuffer(uint32_t width, uint32_t height, GBufferLayout layout, GBufferEncoding encoding)
+    : width(width), height(height), layout(layout), encoding(encoding)
 {
     setup_images();
 }
 void GBuffer::update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const
 {
-    vsg::DescriptorSetLayoutBindings& bindings = desc_set->descriptorSet->setLayout->bindings;
-    int depth_ind = vsg::ShaderStage::getSetBindingIndex(binding_map, "depthImage").second;
-    auto depth_bind = vsg::DescriptorImage::create(depth->imageInfoList, depth_ind, 0, depth->descriptorType);
-    int normal_ind = vsg::ShaderStage::getSetBindingIndex(binding_map, "normalImage").second;
-    auto normal_bind = vsg::DescriptorImage::create(normal->imageInfoList, normal_ind, 0, normal->descriptorType);
-    int material_ind = vsg::ShaderStage::getSetBindingIndex(binding_map, "materialImage").second;
-    auto material_bind
-        = vsg::DescriptorImage::create(material->imageInfoList, material_ind, 0, material->descriptorType);
-    int albedo_ind = vsg::ShaderStage::getSetBindingIndex(binding_map, "albedoImage").second;
-    auto albedo_bind = vsg::DescriptorImage::create(albedo->imageInfoList, albedo_ind, 0, albedo->descriptorType);
-
-    desc_set->descriptorSet->descriptors.push_back(depth_bind);
-    desc_set->descriptorSet->descriptors.push_back(normal_bind);
-    desc_set->descriptorSet->descriptors.push_back(material_bind);
-    desc_set->descriptorSet->descriptors.push_back(albedo_bind);
+    auto bind_image = [&](const vsg::ref_ptr<vsg::DescriptorImage>& image, const char* name) {
+        int ind = vsg::ShaderStage::getSetBindingIndex(binding_map, name).second;
+        desc_set->descriptorSet->descriptors.push_back(
+            vsg::DescriptorImage::create(image->imageInfoList, ind, 0, image->descriptorType));
+    };
+    if (layout == GBufferLayout::VISIBILITY)
+    {
+        bind_image(visibility, "visibilityImage");
+    }
+    else
+    {
+        bind_image(depth, "depthImage");
+        bind_image(normal, "normalImage");
+        bind_image(material, "materialImage");
+    }
+    bind_image(albedo, "albedoImage");
 }
 void GBuffer::update_image_layouts(vsg::Context& context) const
 {
     VkImageSubresourceRange resource_range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
-    auto depth_layout
-        = vsg::ImageMemoryBarrier::create(VK_ACCESS_NONE_KHR, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_GENERAL, 0, 0, depth->imageInfoList[0]->imageView->image, resource_range);
-    auto normal_layout
-        = vsg::ImageMemoryBarrier::create(VK_ACCESS_NONE_KHR, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_GENERAL, 0, 0, normal->imageInfoList[0]->imageView->image, resource_range);
-    auto material_layout
-        = vsg::ImageMemoryBarrier::create(VK_ACCESS_NONE_KHR, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_GENERAL, 0, 0, material->imageInfoList[0]->imageView->image, resource_range);
-    auto albedo_layout
-        = vsg::ImageMemoryBarrier::create(VK_ACCESS_NONE_KHR, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_GENERAL, 0, 0, albedo->imageInfoList[0]->imageView->image, resource_range);
-
     auto pipeline_barrier = vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
-        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_DEPENDENCY_BY_REGION_BIT, depth_layout, normal_layout,
-        material_layout, albedo_layout);
+        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_DEPENDENCY_BY_REGION_BIT);
+    for (const auto& image : images())
+    {
+        pipeline_barrier->add(
+            vsg::ImageMemoryBarrier::create(VK_ACCESS_NONE_KHR, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_GENERAL, 0, 0, image->imageInfoList[0]->imageView->image, resource_range));
+    }
     context.commands.emplace_back(pipeline_barrier);
 }
 void GBuffer::compile(vsg::Context& context) const
 {
-    depth->compile(context);
-    normal->compile(context);
-    material->compile(context);
-    albedo->compile(context);
+    for (const auto& image : images())
+    {
+        image->compile(context);
+    }
+}
+uint32_t GBuffer::bytes_per_pixel() const
+{
+    auto formats = g_buffer_formats(encoding);
+    if (layout == GBufferLayout::VISIBILITY)
+    {
+        return 8 + formats.albedo_size;
+    }
+    return formats.bytes_per_pixel();
+}
+std::string GBuffer::shader_variant() const
+{
+    if (layout == GBufferLayout::VISIBILITY)
+    {
+        return ".visibility";
+    }
+    return encoding == GBufferEncoding::COMPACT ? ".compact" : "";
+}
+void GBuffer::set_scene_geometry(const vsg::Descriptors& scene_descriptors, const vsg::BindingMap& binding_map)
+{
+    // the consumers declare the buffers with the binding numbers of the path tracer (see GEOMETRY_SET)
+    vsg::DescriptorSetLayoutBindings bindings;
+    vsg::Descriptors descriptors;
+    for (const char* name : {"Pos", "Nor", "Tex", "Ind", "Materials", "Instances"})
+    {
+        uint32_t binding = vsg::ShaderStage::getSetBindingIndex(binding_map, name).second;
+        uint32_t count = 0;
+        for (const auto& descriptor : scene_descriptors)
+        {
+            if (descriptor->dstBinding == binding)
+            {
+                descriptors.push_back(descriptor);
+                ++count;
+            }
+        }
+        if (count > 0)
+        {
+            bindings.push_back(
+                {binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, count, VK_SHADER_STAGE_COMPUTE_BIT, nullptr});
+        }
+    }
+    scene_geometry = vsg::DescriptorSet::create(vsg::DescriptorSetLayout::create(bindings), descriptors);
+}
+vsg::ref_ptr<vsg::BindDescriptorSet> GBuffer::bind_scene_geometry(
+    vsg::ref_ptr<vsg::PipelineLayout> pipeline_layout) const
+{
+    if (!scene_geometry)
+    {
+        throw vsg::Exception{"Error: GBuffer::bind_scene_geometry(...) The scene geometry has not been set."};
+    }
+    return vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 1, scene_geometry);
 }
 void GBuffer::setup_images()
 {
     _sampler = vsg::Sampler::create();
+    auto formats = g_buffer_formats(encoding);
 
-    // all images are bound initially to set 0 binding 0. Correct binding number is set in updateDescriptor()
-    auto image = vsg::Image::create();
-    image->imageType = VK_IMAGE_TYPE_2D;
-    image->format = VK_FORMAT_R32_SFLOAT;
-    image->extent.width = width;
-    image->extent.height = height;
-    image->extent.depth = 1;
-    image->mipLevels = 1;
-    image->arrayLayers = 1;
-    image->samples = VK_SAMPLE_COUNT_1_BIT;
-    image->tiling = VK_IMAGE_TILING_OPTIMAL;
-    image->usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
-    image->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    image->sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    auto image_view = vsg::ImageView::create(image, VK_IMAGE_ASPECT_COLOR_BIT);
-    auto image_info = vsg::ImageInfo::create(vsg::ref_ptr<vsg::Sampler>{}, image_view, VK_IMAGE_LAYOUT_GENERAL);
-    depth = vsg::DescriptorImage::create(image_info, 0, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
-
-    image = vsg::Image::create();
-    image->imageType = VK_IMAGE_TYPE_2D;
-    image->format = VK_FORMAT_R32G32_SFLOAT;
-    image->extent.width = width;
-    image->extent.height = height;
-    image->extent.depth = 1;
-    image->mipLevels = 1;
-    image->arrayLayers = 1;
-    image->samples = VK_SAMPLE_COUNT_1_BIT;
-    image->tiling = VK_IMAGE_TILING_OPTIMAL;
-    image->usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
-    image->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    image->sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    image_view = vsg::ImageView::create(image, VK_IMAGE_ASPECT_COLOR_BIT);
-    image_info = vsg::ImageInfo::create(vsg::ref_ptr<vsg::Sampler>{}, image_view, VK_IMAGE_LAYOUT_GENERAL);
-    normal = vsg::DescriptorImage::create(image_info, 0, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
-
-    image = vsg::Image::create();
-    image->imageType = VK_IMAGE_TYPE_2D;
-    image->format = VK_FORMAT_R8G8B8A8_UNORM;
-    image->extent.width = width;
-    image->extent.height = height;
-    image->extent.depth = 1;
-    image->mipLevels = 1;
-    image->arrayLayers = 1;
-    image->samples = VK_SAMPLE_COUNT_1_BIT;
-    image->tiling = VK_IMAGE_TILING_OPTIMAL;
-    image->usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
-    image->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    image->sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    image_view = vsg::ImageView::create(image, VK_IMAGE_ASPECT_COLOR_BIT);
-    image_info = vsg::ImageInfo::create(vsg::ref_ptr<vsg::Sampler>{}, image_view, VK_IMAGE_LAYOUT_GENERAL);
-    material = vsg::DescriptorImage::create(image_info, 0, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
-
-    image = vsg::Image::create();
-    image->imageType = VK_IMAGE_TYPE_2D;
-    image->format = VK_FORMAT_R8G8B8A8_UNORM;
-    image->extent.width = width;
-    image->extent.height = height;
-    image->extent.depth = 1;
-    image->mipLevels = 1;
-    image->arrayLayers = 1;
-    image->samples = VK_SAMPLE_COUNT_1_BIT;
-    image->tiling = VK_IMAGE_TILING_OPTIMAL;
-    image->usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
-    image->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    image->sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    image_view = vsg::ImageView::create(image, VK_IMAGE_ASPECT_COLOR_BIT);
-    image_info = vsg::ImageInfo::create(vsg::ref_ptr<vsg::Sampler>{}, image_view, VK_IMAGE_LAYOUT_GENERAL);
-    albedo = vsg::DescriptorImage::create(image_info, 0, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+    if (layout == GBufferLayout::VISIBILITY)
+    {
+        // 8 bytes per pixel instead of the 16 of depth, normal and material
+        visibility = create_g_buffer_image(width, height, VK_FORMAT_R32G32_UINT);
+    }
+    else
+    {
+        depth = create_g_buffer_image(width, height, formats.depth);
+        normal = create_g_buffer_image(width, height, formats.normal);
+        material = create_g_buffer_image(width, height, formats.material);
+    }
+    albedo = create_g_buffer_image(width, height, formats.albedo);
+}
+std::vector<vsg::ref_ptr<vsg::DescriptorImage>> GBuffer::images() const
+{
+    if (layout == GBufferLayout::VISIBILITY)
+    {
+        return {visibility, albedo};
+    }
+    return {depth, normal, material, albedo};
 }
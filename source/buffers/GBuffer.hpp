@@ -1,7 +1,17 @@
 #pragma once
+#include <buffers/GBufferEncoding.hpp>
 #include <vsg/all.h>
 
 #include <cstdint>
+#include <string>
+#include <vector>
+
+// what the gbuffer stores per pixel
+enum class GBufferLayout
+{
+    ATTRIBUTES,  // depth, normal, material and albedo of the primary hit
+    VISIBILITY,  // instance index and primitive id of the primary hit and the albedo, see shaders/visibility.glsl
+};
 
 // class holding all references for the gbuffer
 // supports automatically updating the ray tracing descriptor set
@@ -9,10 +19,18 @@
 class GBuffer : public vsg::Inherit<vsg::Object, GBuffer>
 {
 public:
-    GBuffer(uint32_t width, uint32_t height);
+    GBuffer(uint32_t width, uint32_t height, GBufferLayout layout = GBufferLayout::ATTRIBUTES,
+        GBufferEncoding encoding = GBufferEncoding::FULL);
 
     uint32_t width, height;
-    vsg::ref_ptr<vsg::DescriptorImage> depth, normal, material, albedo;
+    const GBufferLayout layout;
+    // storage of depth, normal and material, without effect for the visibility layout
+    const GBufferEncoding encoding;
+    // depth, normal and material are only set for GBufferLayout::ATTRIBUTES, visibility only for VISIBILITY
+    vsg::ref_ptr<vsg::DescriptorImage> depth, normal, material, albedo, visibility;
+    // position, normal, texture coordinate and index buffers, materials and instances of the scene, the consumers of
+    // the visibility layout reconstruct the surfaces from them. Set by set_scene_geometry()
+    vsg::ref_ptr<vsg::DescriptorSet> scene_geometry;
 
     void update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const;
 
@@ -20,7 +38,20 @@ public:
 
     void compile(vsg::Context& context) const;
 
+    // size of all images of the layout per pixel, written by the path tracer and read by every consumer
+    uint32_t bytes_per_pixel() const;
+    // ".visibility", ".compact" or "", the precompiled denoiser shaders reading this g-buffer are
+    // shaders/<shader>.comp<variant>.spv (see GBUFFER_VARIANT_SHADERS in CMakeLists.txt)
+    std::string shader_variant() const;
+
+    // takes the geometry buffers of shaders/layoutPTGeometry.glsl out of the scene descriptors of the path tracer
+    void set_scene_geometry(const vsg::Descriptors& scene_descriptors, const vsg::BindingMap& binding_map);
+    // binds scene_geometry as set 1 of a compute pipeline, the pipeline layout needs its layout as second set layout
+    vsg::ref_ptr<vsg::BindDescriptorSet> bind_scene_geometry(vsg::ref_ptr<vsg::PipelineLayout> pipeline_layout) const;
+
 protected:
     vsg::ref_ptr<vsg::Sampler> _sampler;
     void setup_images();
+    // all allocated images of the layout
+    std::vector<vsg::ref_ptr<vsg::DescriptorImage>> images() const;
 };
@@ -0,0 +1,91 @@
+#include <buffers/GBufferEncoding.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+GBufferFormats g_buffer_formats(GBufferEncoding encoding)
+{
+    // albedo is rgba8 in both encodings, it is needed with 8 bit per channel for the demodulation
+    if (encoding == GBufferEncoding::COMPACT)
+    {
+        return {
+            VK_FORMAT_R16_SFLOAT, VK_FORMAT_R16G16_SNORM, VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, 2, 4, 1, 4};
+    }
+    return {
+        VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, 4, 8, 4, 4};
+}
+vsg::vec2 GBufferEncoder::encode_spherical(const vsg::vec3& normal)
+{
+    return {std::acos(normal.z), std::atan2(normal.y, normal.x)};
+}
+vsg::vec3 GBufferEncoder::decode_spherical(const vsg::vec2& angles)
+{
+    return {std::cos(angles.y) * std::sin(angles.x), std::sin(angles.y) * std::sin(angles.x), std::cos(angles.x)};
+}
+vsg::svec2 GBufferEncoder::encode_octahedral(const vsg::vec3& normal)
+{
+    auto sign = [](float v) { return v >= 0.F ? 1.F : -1.F; };
+    vsg::vec3 n = normal / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+    vsg::vec2 e(n.x, n.y);
+    if (n.z < 0.F)
+    {
+        e = vsg::vec2((1.F - std::abs(n.y)) * sign(n.x), (1.F - std::abs(n.x)) * sign(n.y));
+    }
+    auto to_snorm = [](float v) { return static_cast<int16_t>(std::lround(std::clamp(v, -1.F, 1.F) * 32767.F)); };
+    return {to_snorm(e.x), to_snorm(e.y)};
+}
+vsg::vec3 GBufferEncoder::decode_octahedral(const vsg::svec2& encoded)
+{
+    auto from_snorm = [](int16_t v) { return std::max(static_cast<float>(v) / 32767.F, -1.F); };
+    vsg::vec3 n(from_snorm(encoded.x), from_snorm(encoded.y), 0.F);
+    n.z = 1.F - std::abs(n.x) - std::abs(n.y);
+    float t = std::max(-n.z, 0.F);
+    n.x += n.x >= 0.F ? -t : t;
+    n.y += n.y >= 0.F ? -t : t;
+    return vsg::normalize(n);
+}
+uint16_t GBufferEncoder::encode_half(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    if (std::isnan(value))
+    {
+        return sign | 0x7e00;
+    }
+    float magnitude = std::min(std::abs(value), max_half);
+    std::memcpy(&bits, &magnitude, sizeof(bits));
+    int32_t exponent = static_cast<int32_t>(bits >> 23) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+    if (exponent <= 0)
+    {
+        // denormal half, values below half of the smallest denormal round to zero
+        if (exponent < -10)
+        {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        uint32_t shift = 14 - exponent;
+        return sign | static_cast<uint16_t>((mantissa + (1U << (shift - 1))) >> shift);
+    }
+    // rounding can carry into the exponent, which is the correctly rounded result. max_half does not round up
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10 | mantissa >> 13) + (mantissa >> 12 & 1);
+    return sign | static_cast<uint16_t>(half);
+}
+float GBufferEncoder::decode_half(uint16_t half)
+{
+    float sign = (half & 0x8000) != 0 ? -1.F : 1.F;
+    int exponent = half >> 10 & 0x1f;
+    int mantissa = half & 0x3ff;
+    if (exponent == 0)
+    {
+        return sign * std::ldexp(static_cast<float>(mantissa), -24);
+    }
+    if (exponent == 31)
+    {
+        return mantissa != 0 ? std::numeric_limits<float>::quiet_NaN() : sign * std::numeric_limits<float>::infinity();
+    }
+    return sign * std::ldexp(static_cast<float>(mantissa | 0x400), exponent - 25);
+}
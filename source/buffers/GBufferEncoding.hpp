@@ -0,0 +1,40 @@
+#pragma once
+#include <vsg/all.h>
+
+#include <cstdint>
+
+// how the depth, normal and material images of the GBufferLayout::ATTRIBUTES layout are stored. The formats have to
+// match the layout qualifiers of shaders/gbufferEncoding.glsl, which is compiled with GBUFFER_COMPACT for COMPACT
+enum class GBufferEncoding
+{
+    FULL,     // float depth, spherical float normals and rgba8 material
+    COMPACT,  // half depth, octahedral snorm16 normals and r8 material
+};
+
+// image formats and texel sizes in bytes of the g-buffer images
+struct GBufferFormats
+{
+    VkFormat depth, normal, material, albedo;
+    uint32_t depth_size, normal_size, material_size, albedo_size;
+
+    uint32_t bytes_per_pixel() const { return depth_size + normal_size + material_size + albedo_size; }
+};
+
+GBufferFormats g_buffer_formats(GBufferEncoding encoding);
+
+// cpu side of the encodings of shaders/gbufferEncoding.glsl, used to convert offline g-buffers between the encodings
+class GBufferEncoder
+{
+public:
+    // polar and azimuthal angle of a normalized normal
+    static vsg::vec2 encode_spherical(const vsg::vec3& normal);
+    static vsg::vec3 decode_spherical(const vsg::vec2& angles);
+    // octahedral mapping to the unit square stored as snorm16
+    static vsg::svec2 encode_octahedral(const vsg::vec3& normal);
+    static vsg::vec3 decode_octahedral(const vsg::svec2& encoded);
+    // half float bits, values above the largest half are clamped to it like encodeDepth() does
+    static uint16_t encode_half(float value);
+    static float decode_half(uint16_t half);
+
+    static constexpr float max_half = 65504.F;
+};
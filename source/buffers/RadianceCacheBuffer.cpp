@@ -0,0 +1,46 @@
+#include <buffers/RadianceCacheBuffer.hpp>
+
+#include <cassert>
+
+class RadianceCacheBuffer::Clear : public vsg::Inherit<vsg::Command, Clear>
+{
+public:
+    explicit Clear(vsg::ref_ptr<vsg::Buffer> entries) : entries(entries) {}
+    vsg::ref_ptr<vsg::Buffer> entries;
+
+    void record(vsg::CommandBuffer& command_buffer) const override
+    {
+        vkCmdFillBuffer(command_buffer, entries->vk(command_buffer.deviceID), 0, VK_WHOLE_SIZE, 0);
+        VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+            nullptr, 0, nullptr);
+    }
+};
+
+RadianceCacheBuffer::RadianceCacheBuffer(uint32_t entry_count) : entry_count(entry_count)
+{
+    assert((entry_count & (entry_count - 1)) == 0);
+    entries = vsg::Buffer::create(sizeof(RadianceCacheEntry) * entry_count,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE);
+}
+void RadianceCacheBuffer::update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const
+{
+    int cache_ind = vsg::ShaderStage::getSetBindingIndex(binding_map, "RadianceCache").second;
+    auto cache_bind = vsg::DescriptorBuffer::create(
+        vsg::BufferInfoList{vsg::BufferInfo::create(entries, 0, entries->size)}, cache_ind, 0,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    desc_set->descriptorSet->descriptors.push_back(cache_bind);
+}
+void RadianceCacheBuffer::compile(vsg::Context& context)
+{
+    if (!entries->compile(context.device))
+    {
+        return;
+    }
+    auto memory_requirements = entries->getMemoryRequirements(context.deviceID);
+    auto memory = vsg::DeviceMemory::create(context.device, memory_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    entries->bind(memory, 0);
+    context.commands.emplace_back(Clear::create(entries));
+}
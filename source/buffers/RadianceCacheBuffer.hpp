@@ -0,0 +1,41 @@
+#pragma once
+#include <vsg/all.h>
+
+#include <array>
+#include <cstdint>
+
+// host copy of a RadianceCacheEntry in shaders/layoutPTRadianceCache.glsl (std430 layout)
+struct RadianceCacheEntry
+{
+    static constexpr double radiance_scale = 1024.;
+
+    uint32_t checksum;        // 0 for empty slots, 1 for evicted slots
+    uint32_t age;             // frames since the last sample
+    uint32_t sample_count;    // samples accumulated in the current frame
+    uint32_t history_length;  // samples the resolved radiance is averaged over
+    std::array<uint32_t, 4> accumulated;  // rgb radiance of the current frame in fixed point with radiance_scale
+    std::array<float, 4> radiance;        // resolved rgb radiance
+};
+static_assert(sizeof(RadianceCacheEntry) == 12 * sizeof(uint32_t), "RadianceCacheEntry has to match the shader layout");
+
+// world space hash grid of the outgoing radiance at path vertices, written and read by the raygen shader if it is
+// compiled with RADIANCE_CACHE and resolved, aged and evicted by the RadianceCache module after every trace rays
+// the table has a fixed number of entries, cells are hashed into it with linear probing
+class RadianceCacheBuffer : public vsg::Inherit<vsg::Object, RadianceCacheBuffer>
+{
+public:
+    // entry_count has to be a power of two
+    explicit RadianceCacheBuffer(uint32_t entry_count = 1u << 20);
+
+    const uint32_t entry_count;
+    vsg::ref_ptr<vsg::Buffer> entries;
+
+    void update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const;
+
+    // has to be called before the ray tracing descriptor set is compiled, else the table ends up in host memory
+    // the table is cleared with the commands of the context
+    void compile(vsg::Context& context);
+
+private:
+    class Clear;
+};
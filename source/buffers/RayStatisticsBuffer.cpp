@@ -0,0 +1,132 @@
+#include <buffers/RayStatisticsBuffer.hpp>
+
+#include <cstring>
+
+class RayStatisticsBuffer::Reset : public vsg::Inherit<vsg::Command, Reset>
+{
+public:
+    explicit Reset(vsg::ref_ptr<vsg::Buffer> counters) : counters(counters) {}
+    vsg::ref_ptr<vsg::Buffer> counters;
+
+    void record(vsg::CommandBuffer& command_buffer) const override
+    {
+        vkCmdFillBuffer(command_buffer, counters->vk(command_buffer.deviceID), 0, sizeof(RayStatistics), 0);
+        VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+            nullptr, 0, nullptr);
+    }
+};
+class RayStatisticsBuffer::Readback : public vsg::Inherit<vsg::Command, Readback>
+{
+public:
+    Readback(vsg::ref_ptr<vsg::Buffer> counters, vsg::ref_ptr<vsg::Buffer> readback, uint32_t slots)
+        : counters(counters), readback(readback), slots(slots)
+    {
+    }
+    vsg::ref_ptr<vsg::Buffer> counters, readback;
+    uint32_t slots;
+    // every record is one frame, frame n is copied to slot n % slots and stamped with n + 1
+    mutable uint64_t recorded_frames = 0;
+
+    void record(vsg::CommandBuffer& command_buffer) const override
+    {
+        VkDeviceSize slot_offset = (recorded_frames % slots) * _slot_stride;
+        uint64_t stamp = ++recorded_frames;
+
+        VkMemoryBarrier barrier{
+            VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT};
+        vkCmdPipelineBarrier(command_buffer,
+            VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        VkBufferCopy region{0, slot_offset, sizeof(RayStatistics)};
+        vkCmdCopyBuffer(command_buffer, counters->vk(command_buffer.deviceID), readback->vk(command_buffer.deviceID),
+            1, &region);
+        // the stamp is only written after the counters, so a matching stamp means the slot is complete
+        barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_TRANSFER_WRITE_BIT};
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1,
+            &barrier, 0, nullptr, 0, nullptr);
+        vkCmdUpdateBuffer(command_buffer, readback->vk(command_buffer.deviceID), slot_offset + _stamp_offset,
+            sizeof(stamp), &stamp);
+        barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT};
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1,
+            &barrier, 0, nullptr, 0, nullptr);
+    }
+};
+
+RayStatisticsBuffer::RayStatisticsBuffer(uint32_t readback_slots) : _readback_slots(readback_slots)
+{
+    _counters = vsg::Buffer::create(sizeof(RayStatistics),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_SHARING_MODE_EXCLUSIVE);
+    _readback = vsg::Buffer::create(
+        _slot_stride * _readback_slots, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE);
+    _reset = Reset::create(_counters);
+    _readback_command = Readback::create(_counters, _readback, _readback_slots);
+}
+void RayStatisticsBuffer::update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const
+{
+    int statistics_ind = vsg::ShaderStage::getSetBindingIndex(binding_map, "RayStatistics").second;
+    auto buffer_info = vsg::BufferInfo::create(_counters, 0, sizeof(RayStatistics));
+    auto statistics_bind = vsg::DescriptorBuffer::create(
+        vsg::BufferInfoList{buffer_info}, statistics_ind, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    desc_set->descriptorSet->descriptors.push_back(statistics_bind);
+}
+void RayStatisticsBuffer::compile(vsg::Context& context)
+{
+    if (_counters->compile(context.device))
+    {
+        auto memory_requirements = _counters->getMemoryRequirements(context.deviceID);
+        auto memory
+            = vsg::DeviceMemory::create(context.device, memory_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        _counters->bind(memory, 0);
+    }
+    if (!_readback->compile(context.device))
+    {
+        return;
+    }
+    auto memory_requirements = _readback->getMemoryRequirements(context.deviceID);
+    auto memory = vsg::DeviceMemory::create(context.device, memory_requirements,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    _readback->bind(memory, 0);
+    void* data = nullptr;
+    if (VkResult result = memory->map(0, _readback->size, 0, &data); result != VK_SUCCESS)
+    {
+        throw vsg::Exception{"Error: RayStatisticsBuffer::compile(...) failed to map the readback buffer.", result};
+    }
+    // slots which were never written have stamp 0
+    std::memset(data, 0, _readback->size);
+    _readback_data = static_cast<const uint8_t*>(data);
+}
+void RayStatisticsBuffer::add_reset_to_command_graph(vsg::ref_ptr<vsg::Commands> commands) const
+{
+    commands->addChild(_reset);
+}
+void RayStatisticsBuffer::add_readback_to_command_graph(vsg::ref_ptr<vsg::Commands> commands) const
+{
+    commands->addChild(_readback_command);
+}
+bool RayStatisticsBuffer::read(RayStatistics& statistics)
+{
+    if (!_readback_data)
+    {
+        return false;
+    }
+    // frames older than the ring size may already be overwritten by newer frames in flight
+    uint64_t recorded = _readback_command->recorded_frames;
+    for (uint64_t frame = recorded; frame > _last_read_frame && recorded - frame < _readback_slots; --frame)
+    {
+        const uint8_t* slot = _readback_data + ((frame - 1) % _readback_slots) * _slot_stride;
+        uint64_t stamp;
+        std::memcpy(&stamp, slot + _stamp_offset, sizeof(stamp));
+        if (stamp == frame)
+        {
+            std::memcpy(&statistics, slot, sizeof(RayStatistics));
+            _last_read_frame = frame;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <vsg/all.h>
+
+#include <array>
+#include <cstdint>
+
+// host copy of the RayStatistics storage buffer in shaders/rayStatistics.glsl (std430 layout)
+struct RayStatistics
+{
+    static constexpr size_t termination_count = 6;
+    static constexpr size_t max_path_length = 16;
+    // names of the path termination reasons in the order of the pt_* constants in the shader
+    static constexpr std::array<const char*, termination_count> termination_names{
+        "escaped", "russian_roulette", "absorbed", "max_depth", "max_transmission_depth",
+        "radiance_cache"};
+
+    uint32_t primary_rays;
+    uint32_t bounce_rays;
+    uint32_t shadow_rays;
+    uint32_t any_hit_invocations;
+    std::array<uint32_t, termination_count> terminations;
+    std::array<uint32_t, max_path_length + 1> path_lengths;  // the last entry counts all longer paths
+
+    uint64_t total_rays() const
+    {
+        return static_cast<uint64_t>(primary_rays) + bounce_rays + shadow_rays;
+    }
+};
+static_assert(sizeof(RayStatistics) == 27 * sizeof(uint32_t), "RayStatistics has to match the shader layout");
+
+// counters written by the raygen and any hit shaders if they are compiled with RAY_STATISTICS
+// the counters are cleared before every trace rays and copied into a ring of host visible slots afterwards, so the
+// results can be read without waiting for the gpu
+class RayStatisticsBuffer : public vsg::Inherit<vsg::Object, RayStatisticsBuffer>
+{
+public:
+    explicit RayStatisticsBuffer(uint32_t readback_slots = 8);
+
+    void update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const;
+
+    // has to be called before the ray tracing descriptor set is compiled, else the counters end up in host memory
+    void compile(vsg::Context& context);
+
+    // the reset has to be added before and the readback after the trace rays command
+
+    void add_reset_to_command_graph(vsg::ref_ptr<vsg::Commands> commands) const;
+    void add_readback_to_command_graph(vsg::ref_ptr<vsg::Commands> commands) const;
+
+    // copies the statistics of the newest finished frame, returns false if no new frame has finished since the last
+    // call
+    bool read(RayStatistics& statistics);
+
+protected:
+    class Reset;
+    class Readback;
+
+    static constexpr VkDeviceSize _slot_stride = 128;  // counters followed by the 64 bit frame stamp
+    static constexpr VkDeviceSize _stamp_offset = sizeof(RayStatistics);
+
+    uint32_t _readback_slots;
+    vsg::ref_ptr<vsg::Buffer> _counters;
+    vsg::ref_ptr<vsg::Buffer> _readback;
+    vsg::ref_ptr<Reset> _reset;
+    vsg::ref_ptr<Readback> _readback_command;
+    const uint8_t* _readback_data = nullptr;
+    uint64_t _last_read_frame = 0;
+};
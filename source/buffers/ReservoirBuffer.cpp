@@ -0,0 +1,136 @@
+#include <buffers/ReservoirBuffer.hpp>
+
+ReservoirBuffer::ReservoirBuffer(uint32_t width, uint32_t height, bool direct_lighting, bool global_illumination)
+    : direct_lighting(direct_lighting), global_illumination(global_illumination), _width(width), _height(height)
+{
+    setup_images();
+}
+void ReservoirBuffer::update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const
+{
+    for (const auto& [name, image] : images())
+    {
+        image->dstBinding = vsg::ShaderStage::getSetBindingIndex(binding_map, name).second;
+        desc_set->descriptorSet->descriptors.push_back(image);
+    }
+}
+void ReservoirBuffer::update_image_layouts(vsg::Context& context) const
+{
+    VkImageSubresourceRange resource_range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    auto pipeline_barrier = vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_DEPENDENCY_BY_REGION_BIT);
+    for (const auto& [name, image] : images())
+    {
+        pipeline_barrier->add(vsg::ImageMemoryBarrier::create(VK_ACCESS_NONE_KHR, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0, 0, image->imageInfoList[0]->imageView->image,
+            resource_range));
+    }
+    context.commands.emplace_back(pipeline_barrier);
+}
+void ReservoirBuffer::compile(vsg::Context& context) const
+{
+    for (const auto& [name, image] : images())
+    {
+        image->compile(context);
+    }
+}
+void ReservoirBuffer::copy_to_back_images(vsg::ref_ptr<vsg::Commands> commands) const
+{
+    using DescriptorImage = vsg::ref_ptr<vsg::DescriptorImage>;
+    auto copy_to_back = [&](const DescriptorImage& src, const DescriptorImage& dst) {
+        copy_image(commands, src->imageInfoList[0]->imageView->image, dst->imageInfoList[0]->imageView->image);
+    };
+    copy_to_back(reservoir_surfaces, prev_reservoir_surfaces);
+    if (direct_lighting)
+    {
+        copy_to_back(reservoirs, prev_reservoirs);
+    }
+    if (global_illumination)
+    {
+        copy_to_back(gi_samples, prev_gi_samples);
+        copy_to_back(gi_radiance, prev_gi_radiance);
+        copy_to_back(gi_normals, prev_gi_normals);
+    }
+}
+std::vector<std::pair<const char*, vsg::ref_ptr<vsg::DescriptorImage>>> ReservoirBuffer::images() const
+{
+    std::vector<std::pair<const char*, vsg::ref_ptr<vsg::DescriptorImage>>> images{
+        {"reservoirSurfaces", reservoir_surfaces}, {"prevReservoirSurfaces", prev_reservoir_surfaces}};
+    if (direct_lighting)
+    {
+        images.insert(images.end(), {{"reservoirs", reservoirs}, {"prevReservoirs", prev_reservoirs}});
+    }
+    if (global_illumination)
+    {
+        images.insert(images.end(),
+            {{"giSamples", gi_samples}, {"giRadiance", gi_radiance}, {"giNormals", gi_normals},
+                {"prevGISamples", prev_gi_samples}, {"prevGIRadiance", prev_gi_radiance},
+                {"prevGINormals", prev_gi_normals}});
+    }
+    return images;
+}
+void ReservoirBuffer::copy_image(
+    vsg::ref_ptr<vsg::Commands> commands, vsg::ref_ptr<vsg::Image> src_image, vsg::ref_ptr<vsg::Image> dst_image) const
+{
+    VkImageSubresourceRange resource_range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    auto src_barrier = vsg::ImageMemoryBarrier::create(VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+        VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, 0, src_image, resource_range);
+    auto dst_barrier = vsg::ImageMemoryBarrier::create(VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, 0, dst_image, resource_range);
+    commands->addChild(vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_DEPENDENCY_BY_REGION_BIT, src_barrier, dst_barrier));
+
+    VkImageCopy copy_region{};
+    copy_region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    copy_region.srcOffset = {0, 0, 0};
+    copy_region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    copy_region.dstOffset = {0, 0, 0};
+    copy_region.extent = {_width, _height, 1};
+
+    auto copy = vsg::CopyImage::create();
+    copy->srcImage = src_image;
+    copy->srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    copy->dstImage = dst_image;
+    copy->dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    copy->regions.emplace_back(copy_region);
+    commands->addChild(copy);
+
+    src_barrier = vsg::ImageMemoryBarrier::create(VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, 0, 0, src_image, resource_range);
+    dst_barrier = vsg::ImageMemoryBarrier::create(VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, 0, 0, dst_image, resource_range);
+    commands->addChild(vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_DEPENDENCY_BY_REGION_BIT, src_barrier, dst_barrier));
+}
+void ReservoirBuffer::setup_images()
+{
+    auto create_image = [&](VkFormat format, VkImageUsageFlags usage) {
+        auto image = vsg::Image::create();
+        image->imageType = VK_IMAGE_TYPE_2D;
+        image->format = format;
+        image->extent.width = _width;
+        image->extent.height = _height;
+        image->extent.depth = 1;
+        image->mipLevels = 1;
+        image->arrayLayers = 1;
+        image->usage = VK_IMAGE_USAGE_STORAGE_BIT | usage;
+        auto image_view = vsg::ImageView::create(image, VK_IMAGE_ASPECT_COLOR_BIT);
+        auto image_info = vsg::ImageInfo::create(vsg::ref_ptr<vsg::Sampler>{}, image_view, VK_IMAGE_LAYOUT_GENERAL);
+        return vsg::DescriptorImage::create(image_info, 0, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+    };
+    reservoir_surfaces = create_image(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+    prev_reservoir_surfaces = create_image(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+    if (direct_lighting)
+    {
+        reservoirs = create_image(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+        prev_reservoirs = create_image(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+    }
+    if (global_illumination)
+    {
+        gi_samples = create_image(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+        gi_radiance = create_image(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+        gi_normals = create_image(VK_FORMAT_R32G32_SFLOAT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+        prev_gi_samples = create_image(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+        prev_gi_radiance = create_image(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+        prev_gi_normals = create_image(VK_FORMAT_R32G32_SFLOAT, VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+    }
+}
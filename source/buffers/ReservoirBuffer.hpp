@@ -0,0 +1,43 @@
+#pragma once
+#include <vsg/all.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// ReSTIR reservoirs of the primary hits, written by the raygen shader if it is compiled with RESTIR_DI or RESTIR_GI
+// reservoir_surfaces: x direct lighting candidate count, y primary hit distance, zw compressed primary hit normal
+// reservoirs (RESTIR_DI): x light index, yz light sample, w reservoir weight
+// gi_samples (RESTIR_GI): xyz secondary hit position, w reservoir weight
+// gi_radiance (RESTIR_GI): xyz outgoing radiance of the secondary hit, w candidate count
+// gi_normals (RESTIR_GI): xy compressed secondary hit normal
+// the prev_ images hold the reservoirs of the last frame for the temporal and spatial reuse (see layoutPTReSTIR.glsl)
+class ReservoirBuffer : public vsg::Inherit<vsg::Object, ReservoirBuffer>
+{
+public:
+    ReservoirBuffer(uint32_t width, uint32_t height, bool direct_lighting = true, bool global_illumination = false);
+
+    const bool direct_lighting, global_illumination;
+    vsg::ref_ptr<vsg::DescriptorImage> reservoir_surfaces, prev_reservoir_surfaces;
+    vsg::ref_ptr<vsg::DescriptorImage> reservoirs, prev_reservoirs;
+    vsg::ref_ptr<vsg::DescriptorImage> gi_samples, gi_radiance, gi_normals, prev_gi_samples, prev_gi_radiance,
+        prev_gi_normals;
+
+    void update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const;
+
+    void update_image_layouts(vsg::Context& context) const;
+
+    void compile(vsg::Context& context) const;
+
+    // copies the reservoirs of the current frame to the prev_ images, has to be recorded after the trace rays
+    void copy_to_back_images(vsg::ref_ptr<vsg::Commands> commands) const;
+
+protected:
+    uint32_t _width, _height;
+
+    void setup_images();
+    // all images of the enabled reservoirs with their names in layoutPTReSTIR.glsl
+    std::vector<std::pair<const char*, vsg::ref_ptr<vsg::DescriptorImage>>> images() const;
+    void copy_image(vsg::ref_ptr<vsg::Commands> commands, vsg::ref_ptr<vsg::Image> src_image,
+        vsg::ref_ptr<vsg::Image> dst_image) const;
+};
@@ -0,0 +1,62 @@
+#include <buffers/WavefrontBuffer.hpp>
+
+namespace
+{
+// sizes of the std430 structs in shaders/layoutPTWavefront.glsl
+constexpr VkDeviceSize path_state_size = 8 * 4 * sizeof(float);
+constexpr VkDeviceSize hit_record_size = 10 * 4 * sizeof(float);
+constexpr VkDeviceSize shadow_ray_size = 3 * 4 * sizeof(float);
+}  // namespace
+
+WavefrontBuffer::WavefrontBuffer(uint32_t width, uint32_t height) : width(width), height(height)
+{
+    setup_buffers();
+}
+void WavefrontBuffer::update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const
+{
+    for (const auto& [name, buffer] : buffers())
+    {
+        auto descriptor
+            = vsg::DescriptorBuffer::create(vsg::BufferInfoList{vsg::BufferInfo::create(buffer, 0, buffer->size)},
+                vsg::ShaderStage::getSetBindingIndex(binding_map, name).second, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        desc_set->descriptorSet->descriptors.push_back(descriptor);
+    }
+}
+void WavefrontBuffer::compile(vsg::Context& context)
+{
+    for (const auto& [name, buffer] : buffers())
+    {
+        if (!buffer->compile(context.device))
+        {
+            continue;
+        }
+        // the indirect trace rays command is referenced by its device address
+        VkMemoryAllocateFlagsInfo allocate_flags_info{};
+        allocate_flags_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+        allocate_flags_info.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+        bool device_address = buffer == queue_counters;
+        auto memory = vsg::DeviceMemory::create(context.device, buffer->getMemoryRequirements(context.deviceID),
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, device_address ? &allocate_flags_info : nullptr);
+        buffer->bind(memory, 0);
+    }
+}
+void WavefrontBuffer::setup_buffers()
+{
+    auto create_buffer = [](VkDeviceSize size, VkBufferUsageFlags usage) {
+        return vsg::Buffer::create(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | usage, VK_SHARING_MODE_EXCLUSIVE);
+    };
+    VkDeviceSize path_count = static_cast<VkDeviceSize>(width) * height;
+    queue_counters = create_buffer(sizeof(WavefrontQueueCounters),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+            | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT);
+    path_states = create_buffer(path_state_size * path_count, 0);
+    hit_records = create_buffer(hit_record_size * path_count, 0);
+    extension_queue = create_buffer(sizeof(uint32_t) * path_count, 0);
+    shadow_queue = create_buffer(shadow_ray_size * path_count, 0);
+    shade_queues = create_buffer(sizeof(uint32_t) * path_count * WavefrontQueueCounters::material_class_count, 0);
+}
+std::vector<std::pair<const char*, vsg::ref_ptr<vsg::Buffer>>> WavefrontBuffer::buffers() const
+{
+    return {{"WavefrontQueues", queue_counters}, {"PathStates", path_states}, {"HitRecords", hit_records},
+        {"ExtensionQueue", extension_queue}, {"ShadowQueue", shadow_queue}, {"ShadeQueues", shade_queues}};
+}
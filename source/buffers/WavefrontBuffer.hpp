@@ -0,0 +1,46 @@
+#pragma once
+#include <vsg/all.h>
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// host copy of the WavefrontQueues buffer in shaders/layoutPTWavefront.glsl (std430 layout)
+struct WavefrontQueueCounters
+{
+    static constexpr uint32_t material_class_count = 2;
+
+    std::array<uint32_t, 4> trace_rays;  // VkTraceRaysIndirectCommandKHR of the trace stage
+    std::array<std::array<uint32_t, 4>, material_class_count> shade_dispatch;  // VkDispatchIndirectCommand per class
+    uint32_t launch_sample;
+    uint32_t trace_extension_count;
+    uint32_t extension_count;
+    uint32_t shadow_count;
+    std::array<uint32_t, material_class_count> shade_count;
+};
+static_assert(sizeof(WavefrontQueueCounters) == 18 * sizeof(uint32_t),
+    "WavefrontQueueCounters has to match the shader layout");
+
+// path states, hit records and work queues of the wavefront path tracer (see WavefrontPathTracer.hpp)
+// every pixel owns one path slot, the queues hold the slots of the paths waiting for a stage:
+// extension_queue and shadow_queue for the trace stage, shade_queues for the shading stage of every material class
+// queue_counters holds the queue lengths and the indirect launch sizes of the stages
+class WavefrontBuffer : public vsg::Inherit<vsg::Object, WavefrontBuffer>
+{
+public:
+    WavefrontBuffer(uint32_t width, uint32_t height);
+
+    const uint32_t width, height;
+    vsg::ref_ptr<vsg::Buffer> queue_counters, path_states, hit_records, extension_queue, shadow_queue, shade_queues;
+
+    void update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const;
+
+    // the buffers have to be compiled before any descriptor set using them, else they end up in host memory
+    void compile(vsg::Context& context);
+
+protected:
+    void setup_buffers();
+    // all buffers with their names in layoutPTWavefront.glsl
+    std::vector<std::pair<const char*, vsg::ref_ptr<vsg::Buffer>>> buffers() const;
+};
@@ -1,12 +1,43 @@
 #include <io/RenderIO.hpp>
+#include <util/Instrumentation.hpp>
+#include <algorithm>
 #include <future>
 #include <cctype>
 #include <nlohmann/json.hpp>
 
+namespace
+{
+double data_bytes(const vsg::ref_ptr<vsg::Data>& data)
+{
+    return data ? static_cast<double>(data->dataSize()) : 0.;
+}
+// converts every value of an image of type In to an image of type Out with the given format, missing images stay null
+template<typename Out, typename In, typename F>
+vsg::ref_ptr<vsg::Data> convert_image(const vsg::ref_ptr<vsg::Data>& data, VkFormat format, F convert)
+{
+    if (!data)
+    {
+        return {};
+    }
+    auto in = data.cast<In>();
+    if (!in)
+    {
+        throw vsg::Exception{"Error: OfflineGBuffer::converted(...) Unexpected image format."};
+    }
+    auto out = Out::create(in->width(), in->height(), vsg::Data::Layout{format});
+    for (uint32_t i = 0; i < in->valueCount(); ++i)
+    {
+        out->data()[i] = convert(in->data()[i]);
+    }
+    return out;
+}
+}  // namespace
+
 std::vector<vsg::ref_ptr<OfflineGBuffer>> GBufferIO::import_g_buffer_depth(const std::string& depth_format,
     const std::string& normal_format, const std::string& material_format, const std::string& albedo_format,
     int num_frames, int verbosity)
 {
+    vkpbrt::ScopedTimer timer("gbuffer import", "io");
     if (verbosity > 0)
     {
         std::cout << "Start loading GBuffer" << std::endl;
@@ -15,6 +46,7 @@ std::vector<vsg::ref_ptr<OfflineGBuffer>> GBufferIO::import_g_buffer_depth(const
     auto options = vsg::Options::create(vsgXchange::openexr::create());
     auto exec_load = [&](int f)
     {
+        vkpbrt::ScopedTimer frame_timer("gbuffer import frame " + std::to_string(f), "io");
         if (verbosity > 1)
         {
             std::cout << "GBuffer: Loading frame " << f << std::endl << std::flush;
@@ -51,6 +83,8 @@ std::vector<vsg::ref_ptr<OfflineGBuffer>> GBufferIO::import_g_buffer_depth(const
             return;
         }
         g_buffers[f]->albedo = compress_albedo(g_buffers[f]->albedo);
+        vkpbrt::Instrumentation::instance().add_counter("io.bytes_read", data_bytes(g_buffers[f]->depth) +
+            data_bytes(g_buffers[f]->normal) + data_bytes(g_buffers[f]->material) + data_bytes(g_buffers[f]->albedo));
         if (verbosity > 1)
         {
             std::cout << "GBuffer: Loaded frame " << f << std::endl << std::flush;
@@ -74,6 +108,7 @@ std::vector<vsg::ref_ptr<OfflineGBuffer>> GBufferIO::import_g_buffer_position(co
     const std::string& normal_format, const std::string& material_format, const std::string& albedo_format,
     const std::vector<CameraMatrices>& matrices, int num_frames, int verbosity)
 {
+    vkpbrt::ScopedTimer timer("gbuffer import", "io");
     if (verbosity > 0)
     {
         std::cout << "Start loading GBuffer" << std::endl;
@@ -82,6 +117,7 @@ std::vector<vsg::ref_ptr<OfflineGBuffer>> GBufferIO::import_g_buffer_position(co
     std::vector<vsg::ref_ptr<OfflineGBuffer>> g_buffers(num_frames);
     auto exec_load = [&](int f)
     {
+        vkpbrt::ScopedTimer frame_timer("gbuffer import frame " + std::to_string(f), "io");
         if (verbosity > 1)
         {
             std::cout << "GBuffer: Loading frame " << f << std::endl << std::flush;
@@ -138,6 +174,8 @@ std::vector<vsg::ref_ptr<OfflineGBuffer>> GBufferIO::import_g_buffer_position(co
             return;
         }
         g_buffers[f]->albedo = compress_albedo(g_buffers[f]->albedo);
+        vkpbrt::Instrumentation::instance().add_counter("io.bytes_read", data_bytes(g_buffers[f]->depth) +
+            data_bytes(g_buffers[f]->normal) + data_bytes(g_buffers[f]->material) + data_bytes(g_buffers[f]->albedo));
         if (verbosity > 1)
         {
             std::cout << "GBuffer: Loaded frame " << f << std::endl << std::flush;
@@ -170,8 +208,7 @@ vsg::ref_ptr<vsg::Data> GBufferIO::convert_normal_to_spherical(vsg::ref_ptr<vsg:
         // the normals are generally stored in correct full format
         // curNormal *= 2;
         // curNormal -= vsg::vec4(1, 1, 1, 0);
-        res[i].x = acos(cur_normal.z);
-        res[i].y = atan2(cur_normal.y, cur_normal.x);
+        res[i] = GBufferEncoder::encode_spherical(vsg::vec3(cur_normal.x, cur_normal.y, cur_normal.z));
     }
     return vsg::vec2Array2D::create(
         normals->width(), normals->height(), res, vsg::Data::Layout{VK_FORMAT_R32G32_SFLOAT});
@@ -196,11 +233,7 @@ vsg::ref_ptr<vsg::Data> GBufferIO::compress_albedo(vsg::ref_ptr<vsg::Data> in)
     }
     else if (vsg::ref_ptr<vsg::usvec4Array2D> large_albedo = in.cast<vsg::usvec4Array2D>())
     {
-        auto to_float = [](uint16_t h)
-        {
-            uint32_t t = ((h & 0x8000) << 16) | (((h & 0x7c00) + 0x1C000) << 13) | ((h & 0x03FF) << 13);
-            return *reinterpret_cast<float*>(&t);
-        };
+        auto to_float = [](uint16_t h) { return GBufferEncoder::decode_half(h); };
         for (uint32_t i = 0; i < in->valueCount(); ++i)
         {
             vsg::usvec4& cur = large_albedo->data()[i];
@@ -214,6 +247,7 @@ bool GBufferIO::export_g_buffer(const std::string& position_format, const std::s
     const std::string& normal_format, const std::string& material_format, const std::string& albedo_format,
     int num_frames, const OfflineGBuffers& g_buffers, const CameraMatricesVec& matrices, int verbosity)
 {
+    vkpbrt::ScopedTimer timer("gbuffer export", "io");
     if (verbosity > 0)
     {
         std::cout << "Start exporting GBuffer" << std::endl;
@@ -222,10 +256,13 @@ bool GBufferIO::export_g_buffer(const std::string& position_format, const std::s
     bool fine = true;
     auto exec_store = [&](int f)
     {
+        vkpbrt::ScopedTimer frame_timer("gbuffer export frame " + std::to_string(f), "io");
         if (verbosity > 1)
         {
             std::cout << "GBuffer: Storing frame " << f << std::endl << std::flush;
         }
+        // the files always hold the full encoding
+        auto g_buffer = g_buffers[f]->converted(GBufferEncoding::FULL);
         char buff[200];
         std::string filename;
         // depth images
@@ -233,7 +270,7 @@ bool GBufferIO::export_g_buffer(const std::string& position_format, const std::s
         {
             snprintf(buff, sizeof(buff), depth_format.c_str(), f);
             filename = buff;
-            if (!write(g_buffers[f]->depth, filename, options))
+            if (!write(g_buffer->depth, filename, options))
             {
                 std::cerr << "Failed to store image: " << filename << std::endl;
                 fine = false;
@@ -245,7 +282,7 @@ bool GBufferIO::export_g_buffer(const std::string& position_format, const std::s
         {
             snprintf(buff, sizeof(buff), position_format.c_str(), f);
             vsg::ref_ptr<vsg::Data> position
-                = depth_to_position(g_buffers[f]->depth.cast<vsg::floatArray2D>(), matrices[f]);
+                = depth_to_position(g_buffer->depth.cast<vsg::floatArray2D>(), matrices[f]);
             filename = buff;
             if (!write(position, filename, options))
             {
@@ -259,7 +296,7 @@ bool GBufferIO::export_g_buffer(const std::string& position_format, const std::s
         {
             snprintf(buff, sizeof(buff), normal_format.c_str(), f);
             filename = buff;
-            if (!write(spherical_to_cartesian(g_buffers[f]->normal.cast<vsg::vec2Array2D>()), filename, options))
+            if (!write(spherical_to_cartesian(g_buffer->normal.cast<vsg::vec2Array2D>()), filename, options))
             {
                 std::cerr << "Failed to store image: " << filename << std::endl;
                 fine = false;
@@ -271,7 +308,7 @@ bool GBufferIO::export_g_buffer(const std::string& position_format, const std::s
         {
             snprintf(buff, sizeof(buff), material_format.c_str(), f);
             filename = buff;
-            if (!write(unorm_to_float(g_buffers[f]->material.cast<vsg::ubvec4Array2D>()), filename, options))
+            if (!write(unorm_to_float(g_buffer->material.cast<vsg::ubvec4Array2D>()), filename, options))
             {
                 std::cerr << "Failed to store image: " << filename << std::endl;
                 fine = false;
@@ -283,13 +320,15 @@ bool GBufferIO::export_g_buffer(const std::string& position_format, const std::s
         {
             snprintf(buff, sizeof(buff), albedo_format.c_str(), f);
             filename = buff;
-            if (!write(unorm_to_float(g_buffers[f]->albedo.cast<vsg::ubvec4Array2D>()), filename, options))
+            if (!write(unorm_to_float(g_buffer->albedo.cast<vsg::ubvec4Array2D>()), filename, options))
             {
                 std::cerr << "Failed to store image: " << filename << std::endl;
                 fine = false;
                 return;
             }
         }
+        vkpbrt::Instrumentation::instance().add_counter("io.bytes_written", data_bytes(g_buffer->depth) +
+            data_bytes(g_buffer->normal) + data_bytes(g_buffer->material) + data_bytes(g_buffer->albedo));
         if (verbosity > 1)
         {
             std::cout << "GBuffer: Stored frame " << f << std::endl << std::flush;
@@ -318,11 +357,8 @@ vsg::ref_ptr<vsg::Data> GBufferIO::spherical_to_cartesian(vsg::ref_ptr<vsg::vec2
     auto* res = new vsg::vec4[normals->valueCount()];
     for (uint32_t i = 0; i < normals->valueCount(); ++i)
     {
-        vsg::vec2 cur_normal = normals->data()[i];
-        res[i].x = cos(cur_normal.y) * sin(cur_normal.x);
-        res[i].y = sin(cur_normal.y) * sin(cur_normal.x);
-        res[i].z = cos(cur_normal.x);
-        res[i].w = 1;
+        vsg::vec3 cur_normal = GBufferEncoder::decode_spherical(normals->data()[i]);
+        res[i] = vsg::vec4(cur_normal.x, cur_normal.y, cur_normal.z, 1);
     }
     return vsg::vec4Array2D::create(
         normals->width(), normals->height(), res, vsg::Data::Layout{VK_FORMAT_R32G32B32A32_SFLOAT});
@@ -502,6 +538,7 @@ void OfflineIllumination::setup_staging_buffer(uint32_t width, uint32_t height)
 std::vector<vsg::ref_ptr<OfflineIllumination>> IlluminationBufferIO::import_illumination(
     const std::string& illumination_format, int num_frames, int verbosity)
 {
+    vkpbrt::ScopedTimer timer("illumination import", "io");
     if (verbosity > 0)
     {
         std::cout << "Start loading Illumination" << std::endl;
@@ -510,6 +547,7 @@ std::vector<vsg::ref_ptr<OfflineIllumination>> IlluminationBufferIO::import_illu
     std::vector<vsg::ref_ptr<OfflineIllumination>> illuminations(num_frames);
     auto exec_load = [&](int f)
     {
+        vkpbrt::ScopedTimer frame_timer("illumination import frame " + std::to_string(f), "io");
         if (verbosity > 1)
         {
             std::cout << "Illumination: Loading frame " << f << std::endl << std::flush;
@@ -527,6 +565,7 @@ std::vector<vsg::ref_ptr<OfflineIllumination>> IlluminationBufferIO::import_illu
             std::cerr << "Failed to load image: " << filename << " texPath = " << buff << std::endl;
             return;
         }
+        vkpbrt::Instrumentation::instance().add_counter("io.bytes_read", data_bytes(illuminations[f]->noisy));
         if (verbosity > 1)
         {
             std::cout << "Illumination: Loaded frame " << f << std::endl << std::flush;
@@ -549,6 +588,7 @@ std::vector<vsg::ref_ptr<OfflineIllumination>> IlluminationBufferIO::import_illu
 bool IlluminationBufferIO::export_illumination(
     const std::string& illumination_format, int num_frames, const OfflineIlluminations& illus, int verbosity)
 {
+    vkpbrt::ScopedTimer timer("illumination export", "io");
     if (verbosity > 0)
     {
         std::cout << "Start exporting Illumination" << std::endl;
@@ -557,6 +597,7 @@ bool IlluminationBufferIO::export_illumination(
     bool fine = true;
     auto exec_store = [&](int f)
     {
+        vkpbrt::ScopedTimer frame_timer("illumination export frame " + std::to_string(f), "io");
         if (verbosity > 1)
         {
             std::cout << "IlluminationBuffer: Storing frame" << f << std::endl << std::flush;
@@ -571,6 +612,7 @@ bool IlluminationBufferIO::export_illumination(
             fine = false;
             return;
         }
+        vkpbrt::Instrumentation::instance().add_counter("io.bytes_written", data_bytes(illus[f]->noisy));
         if (verbosity > 1)
         {
             std::cout << "IlluminationBuffer: Stored frame" << f << std::endl << std::flush;
@@ -715,13 +757,65 @@ bool MatrixIO::export_matrices(const std::string& matrix_path, const CameraMatri
     return true;
 }
 
+OfflineGBuffer::OfflineGBuffer(uint32_t width, uint32_t height, GBufferEncoding encoding) : encoding(encoding)
+{
+    auto formats = g_buffer_formats(encoding);
+    if (encoding == GBufferEncoding::COMPACT)
+    {
+        depth = vsg::ushortArray2D::create(width, height, vsg::Data::Layout{formats.depth});
+        normal = vsg::svec2Array2D::create(width, height, vsg::Data::Layout{formats.normal});
+        material = vsg::ubyteArray2D::create(width, height, vsg::Data::Layout{formats.material});
+    }
+    else
+    {
+        depth = vsg::floatArray2D::create(width, height, vsg::Data::Layout{formats.depth});
+        normal = vsg::vec2Array2D::create(width, height, vsg::Data::Layout{formats.normal});
+        material = vsg::ubvec4Array2D::create(width, height, vsg::Data::Layout{formats.material});
+    }
+    albedo = vsg::ubvec4Array2D::create(width, height, vsg::Data::Layout{formats.albedo});
+}
+
+vsg::ref_ptr<OfflineGBuffer> OfflineGBuffer::converted(GBufferEncoding target) const
+{
+    auto result = OfflineGBuffer::create();
+    result->encoding = target;
+    result->albedo = albedo;
+    if (target == encoding)
+    {
+        result->depth = depth;
+        result->normal = normal;
+        result->material = material;
+        return result;
+    }
+    auto formats = g_buffer_formats(target);
+    if (target == GBufferEncoding::COMPACT)
+    {
+        result->depth = convert_image<vsg::ushortArray2D, vsg::floatArray2D>(
+            depth, formats.depth, [](float d) { return GBufferEncoder::encode_half(d); });
+        result->normal = convert_image<vsg::svec2Array2D, vsg::vec2Array2D>(normal, formats.normal,
+            [](const vsg::vec2& n) { return GBufferEncoder::encode_octahedral(GBufferEncoder::decode_spherical(n)); });
+        result->material = convert_image<vsg::ubyteArray2D, vsg::ubvec4Array2D>(
+            material, formats.material, [](const vsg::ubvec4& m) { return m.x; });
+    }
+    else
+    {
+        result->depth = convert_image<vsg::floatArray2D, vsg::ushortArray2D>(
+            depth, formats.depth, [](uint16_t d) { return GBufferEncoder::decode_half(d); });
+        result->normal = convert_image<vsg::vec2Array2D, vsg::svec2Array2D>(normal, formats.normal,
+            [](const vsg::svec2& n) { return GBufferEncoder::encode_spherical(GBufferEncoder::decode_octahedral(n)); });
+        result->material = convert_image<vsg::ubvec4Array2D, vsg::ubyteArray2D>(
+            material, formats.material, [](uint8_t m) { return vsg::ubvec4(m, 0, 0, 0); });
+    }
+    return result;
+}
+
 void OfflineGBuffer::upload_to_g_buffer_command(
     vsg::ref_ptr<GBuffer>& g_buffer, vsg::ref_ptr<vsg::Commands> commands, vsg::Context& context)
 {
     _staging_memory_buffer_pools = context.stagingMemoryBufferPools;
     if (!_depth_staging || !_normal_staging || !_albedo_staging || !_material_staging)
     {
-        setup_staging_buffer(g_buffer->width, g_buffer->height);
+        setup_staging_buffer(*g_buffer);
     }
     if (g_buffer->depth)
     {
@@ -751,7 +845,7 @@ void OfflineGBuffer::download_from_g_buffer_command(
     _staging_memory_buffer_pools = context.stagingMemoryBufferPools;
     if (!_depth_staging || !_normal_staging || !_albedo_staging || !_material_staging)
     {
-        setup_staging_buffer(g_buffer->width, g_buffer->height);
+        setup_staging_buffer(*g_buffer);
     }
     if (g_buffer->depth)
     {
@@ -980,29 +1074,21 @@ void OfflineGBuffer::transfer_staging_data_from(vsg::ref_ptr<OfflineGBuffer> oth
     }
 }
 
-void OfflineGBuffer::setup_staging_buffer(uint32_t width, uint32_t height)
+void OfflineGBuffer::setup_staging_buffer(const GBuffer& g_buffer)
 {
-    VkDeviceSize image_total_size = sizeof(float) * width * height;
-    VkDeviceSize alignment = 4;
+    // sized for the formats of the g-buffer images, the alignment is the texel size but at least 4
+    auto formats = g_buffer_formats(g_buffer.encoding);
+    VkDeviceSize pixel_count = static_cast<VkDeviceSize>(g_buffer.width) * g_buffer.height;
     VkMemoryPropertyFlags memory_property_flags
         = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    _depth_staging = _staging_memory_buffer_pools->reserveBuffer(image_total_size, alignment,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE,
-        memory_property_flags);
-
-    image_total_size = sizeof(vsg::vec2) * width * height;
-    alignment = 8;  // sizeof vsg::vec2
-    _normal_staging = _staging_memory_buffer_pools->reserveBuffer(image_total_size, alignment,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE,
-        memory_property_flags);
-
-    image_total_size = sizeof(vsg::ubvec4) * width * height;
-    alignment = 4;
-    _albedo_staging = _staging_memory_buffer_pools->reserveBuffer(image_total_size, alignment,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE,
-        memory_property_flags);
-
-    _material_staging = _staging_memory_buffer_pools->reserveBuffer(image_total_size, alignment,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE,
-        memory_property_flags);
+    auto reserve = [&](uint32_t texel_size)
+    {
+        return _staging_memory_buffer_pools->reserveBuffer(pixel_count * texel_size, std::max(texel_size, 4U),
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE,
+            memory_property_flags);
+    };
+    _depth_staging = reserve(formats.depth_size);
+    _normal_staging = reserve(formats.normal_size);
+    _albedo_staging = reserve(formats.albedo_size);
+    _material_staging = reserve(formats.material_size);
 }
@@ -45,7 +45,16 @@ public:
 class OfflineGBuffer : public vsg::Inherit<vsg::Object, OfflineGBuffer>
 {
 public:
+    OfflineGBuffer() = default;
+    // allocates the images with the formats of the encoding
+    OfflineGBuffer(uint32_t width, uint32_t height, GBufferEncoding encoding);
+
     vsg::ref_ptr<vsg::Data> depth, normal, material, albedo;
+    // has to match the encoding of the GBuffer the data is transferred from or to
+    GBufferEncoding encoding = GBufferEncoding::FULL;
+
+    // copy of the g-buffer in the target encoding, images that do not change are shared
+    vsg::ref_ptr<OfflineGBuffer> converted(GBufferEncoding target) const;
     // automatically adds correct image usag eflags to the gBuffer images
     void upload_to_g_buffer_command(
         vsg::ref_ptr<GBuffer>& g_buffer, vsg::ref_ptr<vsg::Commands> commands, vsg::Context& context);
@@ -58,7 +67,7 @@ public:
 private:
     vsg::ref_ptr<vsg::BufferInfo> _depth_staging, _normal_staging, _material_staging, _albedo_staging;
     vsg::ref_ptr<vsg::MemoryBufferPools> _staging_memory_buffer_pools;
-    void setup_staging_buffer(uint32_t width, uint32_t height);
+    void setup_staging_buffer(const GBuffer& g_buffer);
 };
 using OfflineGBuffers = std::vector<vsg::ref_ptr<OfflineGBuffer>>;
 
@@ -1,38 +1,40 @@
 #include <renderModules/Accumulator.hpp>
+#include <util/ShaderCache.hpp>
 #include <vsgXchange/glsl.h>
 
 Accumulator::Accumulator(vsg::ref_ptr<GBuffer> g_buffer, vsg::ref_ptr<IlluminationBuffer> illumination_buffer,
     bool separate_matrices, int work_width, int work_height)
-    : _width(g_buffer->depth->imageInfoList[0]->imageView->image->extent.width),
-      _height(g_buffer->depth->imageInfoList[0]->imageView->image->extent.height),
+    : _width(static_cast<int>(g_buffer->width)),
+      _height(static_cast<int>(g_buffer->height)),
       accumulated_illumination(IlluminationBufferDemodulated::create(_width, _height)),
-      accumulation_buffer(AccumulationBuffer::create(_width, _height)),
+      accumulation_buffer(AccumulationBuffer::create(_width, _height, g_buffer->layout, g_buffer->encoding)),
       _work_width(work_width),
       _work_height(work_height),
       _original_illumination(illumination_buffer),
       _separate_matrices(separate_matrices)
 {
-    auto options = vsg::Options::create(vsgXchange::glsl::create());
-    auto compute_stage = vsg::ShaderStage::read(VK_SHADER_STAGE_COMPUTE_BIT, "main", _shader_path, options);
-    if (!compute_stage)
+    bool visibility_buffer = g_buffer->layout == GBufferLayout::VISIBILITY;
+    if (visibility_buffer && !separate_matrices)
     {
-        throw vsg::Exception{"Accumulator::create() could not open compute shader stage"};
+        throw vsg::Exception{
+            "Error: Accumulator::Accumulator(...) A visibility g-buffer needs separate camera matrices."};
     }
+    auto compute_stage
+        = load_shader(separate_matrices, visibility_buffer, g_buffer->encoding == GBufferEncoding::COMPACT);
     compute_stage->specializationConstants = vsg::ShaderStage::SpecializationConstants{
         {0, vsg::intValue::create(work_width) },
         {1, vsg::intValue::create(work_height)}
     };
-    if (separate_matrices)
-    {
-        auto compile_hints = vsg::ShaderCompileSettings::create();
-        compile_hints->defines = {"SEPARATE_MATRICES"};
-        compute_stage->module->hints = compile_hints;
-    }
 
     auto binding_map = compute_stage->getDescriptorSetLayoutBindingsMap();
     auto descriptor_set_layout = vsg::DescriptorSetLayout::create(binding_map.begin()->second.bindings);
-    auto pipeline_layout = vsg::PipelineLayout::create(
-        vsg::DescriptorSetLayouts{descriptor_set_layout}, compute_stage->getPushConstantRanges());
+    vsg::DescriptorSetLayouts descriptor_set_layouts{descriptor_set_layout};
+    if (visibility_buffer)
+    {
+        descriptor_set_layouts.push_back(g_buffer->scene_geometry->setLayout);
+    }
+    auto pipeline_layout
+        = vsg::PipelineLayout::create(descriptor_set_layouts, compute_stage->getPushConstantRanges());
     auto pipeline = vsg::ComputePipeline::create(pipeline_layout, compute_stage);
     _bind_pipeline = vsg::BindComputePipeline::create(pipeline);
 
@@ -50,6 +52,10 @@ Accumulator::Accumulator(vsg::ref_ptr<GBuffer> g_buffer, vsg::ref_ptr<Illuminati
         = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, descriptor_set);
 
     g_buffer->update_descriptor(_bind_descriptor_set, binding_map);
+    if (visibility_buffer)
+    {
+        _bind_scene_geometry = g_buffer->bind_scene_geometry(pipeline_layout);
+    }
     accumulation_buffer->update_descriptor(_bind_descriptor_set, binding_map);
     accumulated_illumination->update_descriptor(_bind_descriptor_set, binding_map);
 
@@ -75,6 +81,10 @@ void Accumulator::add_dispatch_to_command_graph(vsg::ref_ptr<vsg::Commands> comm
         = vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0);
     command_graph->addChild(_bind_pipeline);
     command_graph->addChild(_bind_descriptor_set);
+    if (_bind_scene_geometry)
+    {
+        command_graph->addChild(_bind_scene_geometry);
+    }
     command_graph->addChild(_push_constants);
     command_graph->addChild(
         vsg::Dispatch::create(uint32_t(ceil(static_cast<float>(_width) / static_cast<float>(_work_width))),
@@ -115,3 +125,35 @@ void Accumulator::set_camera_matrices(int frame_index, const CameraMatrices& cur
         _push_constants_value->value().frame_number = frame_index;
     }
 }
+vsg::ref_ptr<vsg::ShaderStage> Accumulator::load_shader(
+    bool separate_matrices, bool visibility_buffer, bool compact_g_buffer)
+{
+    auto options = vsg::Options::create(vsgXchange::glsl::create());
+    auto compute_stage = vsg::ShaderStage::read(VK_SHADER_STAGE_COMPUTE_BIT, "main", _shader_path, options);
+    if (!compute_stage)
+    {
+        throw vsg::Exception{"Accumulator::create() could not open compute shader stage"};
+    }
+    auto compile_hints = vsg::ShaderCompileSettings::create();
+    if (separate_matrices)
+    {
+        compile_hints->defines = {"SEPARATE_MATRICES"};
+        if (visibility_buffer)
+        {
+            // the geometry is read through storage buffer arrays indexed non uniformly
+            compile_hints->vulkanVersion = VK_API_VERSION_1_2;
+            compile_hints->target = vsg::ShaderCompileSettings::SPIRV_1_4;
+            compile_hints->defines.push_back("VISIBILITY_BUFFER");
+        }
+    }
+    if (compact_g_buffer && !(separate_matrices && visibility_buffer))
+    {
+        compile_hints->defines.push_back("GBUFFER_COMPACT");
+    }
+    if (!compile_hints->defines.empty())
+    {
+        compute_stage->module->hints = compile_hints;
+    }
+    vkpbrt::compile_shader(compute_stage);
+    return compute_stage;
+}
@@ -21,6 +21,11 @@ public:
     // Frameindex is needed to upload the correct matrix
     void set_camera_matrices(int frame_index, const CameraMatrices& cur, const CameraMatrices& prev);
 
+    // reads the accumulation shader permutation, compiled through the shader cache if one is set. The visibility
+    // buffer permutation needs separate matrices, the compact g-buffer encoding is ignored with it
+    static vsg::ref_ptr<vsg::ShaderStage> load_shader(
+        bool separate_matrices, bool visibility_buffer = false, bool compact_g_buffer = false);
+
     vsg::ref_ptr<IlluminationBuffer> accumulated_illumination;
     vsg::ref_ptr<AccumulationBuffer> accumulation_buffer;
 
@@ -36,13 +41,15 @@ private:
     public:
         PCValue() = default;
     };
-    std::string _shader_path = "shaders/accumulator.comp";  // normal glsl file has to be loaded as the shader has to be
-                                                            // adopted to separateMatrices style
+    static constexpr const char* _shader_path = "shaders/accumulator.comp";  // normal glsl file has to be loaded as the
+                                                                            // shader has to be adopted to
+                                                                            // separateMatrices style
     int _work_width, _work_height;
     vsg::ref_ptr<GBuffer> _g_buffer;
     vsg::ref_ptr<IlluminationBuffer> _original_illumination;
     vsg::ref_ptr<vsg::BindComputePipeline> _bind_pipeline;
     vsg::ref_ptr<vsg::BindDescriptorSet> _bind_descriptor_set;
+    vsg::ref_ptr<vsg::BindDescriptorSet> _bind_scene_geometry;  // only set for a visibility g-buffer
     vsg::ref_ptr<vsg::PushConstants> _push_constants;
     vsg::ref_ptr<PCValue> _push_constants_value;
     bool _separate_matrices;
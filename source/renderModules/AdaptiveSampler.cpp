@@ -0,0 +1,88 @@
+#include <renderModules/AdaptiveSampler.hpp>
+#include <renderModules/PipelineStructs.hpp>
+
+class AdaptiveSampler::ResetCommand : public vsg::Inherit<vsg::Command, ResetCommand>
+{
+public:
+    explicit ResetCommand(vsg::ref_ptr<vsg::Buffer> trace_rays_command) : trace_rays_command(trace_rays_command) {}
+    vsg::ref_ptr<vsg::Buffer> trace_rays_command;
+
+    void record(vsg::CommandBuffer& command_buffer) const override
+    {
+        // the previous trace rays dispatch and readback have to be done reading the command and the active pixels
+        VkMemoryBarrier barrier{
+            VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT};
+        vkCmdPipelineBarrier(command_buffer,
+            VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+                | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0,
+            nullptr);
+        AdaptiveSamplingCommand command{0, 1, 1, 0, 0};
+        vkCmdUpdateBuffer(command_buffer, trace_rays_command->vk(command_buffer.deviceID), 0, sizeof(command),
+            &command);
+        barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+            1, &barrier, 0, nullptr, 0, nullptr);
+    }
+};
+AdaptiveSampler::AdaptiveSampler(vsg::ref_ptr<AdaptiveSamplingBuffer> adaptive_sampling_buffer,
+    float max_relative_error, int min_samples, int work_width, int work_height)
+    : _adaptive_sampling_buffer(adaptive_sampling_buffer), _work_width(work_width), _work_height(work_height)
+{
+    std::string shader_path = "shaders/adaptiveSampling.comp.spv";
+    auto compute_stage = vsg::ShaderStage::read(VK_SHADER_STAGE_COMPUTE_BIT, "main", shader_path);
+    if (!compute_stage)
+    {
+        throw vsg::Exception{"Error: AdaptiveSampler::AdaptiveSampler(...) could not read " + shader_path};
+    }
+    compute_stage->specializationConstants = vsg::ShaderStage::SpecializationConstants{
+        {0, vsg::intValue::create(work_width)           },
+        {1, vsg::intValue::create(work_height)          },
+        {2, vsg::floatValue::create(max_relative_error)},
+        {3, vsg::intValue::create(min_samples)          }
+    };
+
+    auto binding_map = compute_stage->getDescriptorSetLayoutBindingsMap();
+    auto descriptor_set_layout = vsg::DescriptorSetLayout::create(binding_map.begin()->second.bindings);
+    // the camera push constants are shared with the ray tracing pipeline
+    auto pipeline_layout = vsg::PipelineLayout::create(vsg::DescriptorSetLayouts{descriptor_set_layout},
+        vsg::PushConstantRanges{{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RayTracingPushConstants)}});
+
+    auto statistics = vsg::DescriptorImage::create(adaptive_sampling_buffer->sample_statistics->imageInfoList,
+        vsg::ShaderStage::getSetBindingIndex(binding_map, "sampleStatistics").second, 0,
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+    auto& active_pixels_buffer = adaptive_sampling_buffer->active_pixels;
+    auto active_pixels = vsg::DescriptorBuffer::create(
+        vsg::BufferInfoList{vsg::BufferInfo::create(active_pixels_buffer, 0, active_pixels_buffer->size)},
+        vsg::ShaderStage::getSetBindingIndex(binding_map, "ActivePixels").second, 0,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    auto& command_buffer = adaptive_sampling_buffer->trace_rays_command;
+    auto trace_rays_command = vsg::DescriptorBuffer::create(
+        vsg::BufferInfoList{vsg::BufferInfo::create(command_buffer, 0, command_buffer->size)},
+        vsg::ShaderStage::getSetBindingIndex(binding_map, "TraceRaysCommand").second, 0,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+    auto descriptor_set = vsg::DescriptorSet::create(
+        descriptor_set_layout, vsg::Descriptors{statistics, active_pixels, trace_rays_command});
+    _bind_descriptor_set
+        = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, descriptor_set);
+    _bind_pipeline = vsg::BindComputePipeline::create(vsg::ComputePipeline::create(pipeline_layout, compute_stage));
+}
+void AdaptiveSampler::add_dispatch_to_command_graph(
+    vsg::ref_ptr<vsg::Commands> command_graph, vsg::ref_ptr<vsg::PushConstants> push_constants)
+{
+    command_graph->addChild(ResetCommand::create(_adaptive_sampling_buffer->trace_rays_command));
+    command_graph->addChild(_bind_pipeline);
+    command_graph->addChild(_bind_descriptor_set);
+    command_graph->addChild(push_constants);
+    command_graph->addChild(vsg::Dispatch::create(
+        uint32_t(ceil(static_cast<float>(_adaptive_sampling_buffer->width) / static_cast<float>(_work_width))),
+        uint32_t(ceil(static_cast<float>(_adaptive_sampling_buffer->height) / static_cast<float>(_work_height))), 1));
+    _adaptive_sampling_buffer->add_readback_to_command_graph(command_graph);
+    auto list_barrier = vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, 0,
+        vsg::MemoryBarrier::create(
+            VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT));
+    command_graph->addChild(list_barrier);
+}
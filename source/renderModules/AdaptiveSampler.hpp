@@ -0,0 +1,27 @@
+#pragma once
+#include <buffers/AdaptiveSamplingBuffer.hpp>
+
+#include <vsg/all.h>
+
+#include <cstdint>
+
+// fills the active pixel list of an AdaptiveSamplingBuffer with all pixels whose relative standard error is above
+// max_relative_error or which have less than min_samples samples, the trace rays command is set to the list length
+class AdaptiveSampler : public vsg::Inherit<vsg::Object, AdaptiveSampler>
+{
+public:
+    AdaptiveSampler(vsg::ref_ptr<AdaptiveSamplingBuffer> adaptive_sampling_buffer, float max_relative_error,
+        int min_samples, int work_width = 16, int work_height = 16);
+
+    // has to be recorded before the trace rays dispatch, push_constants are the ray tracing push constants
+    void add_dispatch_to_command_graph(
+        vsg::ref_ptr<vsg::Commands> command_graph, vsg::ref_ptr<vsg::PushConstants> push_constants);
+
+private:
+    class ResetCommand;
+
+    vsg::ref_ptr<AdaptiveSamplingBuffer> _adaptive_sampling_buffer;
+    vsg::ref_ptr<vsg::BindComputePipeline> _bind_pipeline;
+    vsg::ref_ptr<vsg::BindDescriptorSet> _bind_descriptor_set;
+    int _work_width, _work_height;
+};
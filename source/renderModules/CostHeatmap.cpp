@@ -0,0 +1,121 @@
+#include <renderModules/CostHeatmap.hpp>
+#include <util/ShaderCache.hpp>
+#include <vsgXchange/glsl.h>
+
+CostHeatmap::CostHeatmap(vsg::ref_ptr<CostBuffer> cost_buffer, int work_width, int work_height)
+    : _width(cost_buffer->width),
+      _height(cost_buffer->height),
+      _work_width(work_width),
+      _work_height(work_height)
+{
+    auto reduce_stage = load_shader(true);
+    auto compute_stage = load_shader(false);
+    compute_stage->specializationConstants = vsg::ShaderStage::SpecializationConstants{
+        {0, vsg::intValue::create(work_width) },
+        {1, vsg::intValue::create(work_height)}
+    };
+
+    auto binding_map = compute_stage->getDescriptorSetLayoutBindingsMap();
+    auto descriptor_set_layout = vsg::DescriptorSetLayout::create(binding_map.begin()->second.bindings);
+    auto pipeline_layout = vsg::PipelineLayout::create(
+        vsg::DescriptorSetLayouts{descriptor_set_layout}, compute_stage->getPushConstantRanges());
+    auto reduce_binding_map = reduce_stage->getDescriptorSetLayoutBindingsMap();
+    auto reduce_descriptor_set_layout
+        = vsg::DescriptorSetLayout::create(reduce_binding_map.begin()->second.bindings);
+    auto reduce_pipeline_layout = vsg::PipelineLayout::create(
+        vsg::DescriptorSetLayouts{reduce_descriptor_set_layout}, vsg::PushConstantRanges{});
+
+    int final_index = vsg::ShaderStage::getSetBindingIndex(binding_map, "heatmap").second;
+    auto image = vsg::Image::create();
+    image->imageType = VK_IMAGE_TYPE_2D;
+    image->format = VK_FORMAT_B8G8R8A8_UNORM;
+    image->extent = VkExtent3D{cost_buffer->width, cost_buffer->height, 1};
+    image->mipLevels = 1;
+    image->arrayLayers = 1;
+    image->usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    auto image_view = vsg::ImageView::create(image, VK_IMAGE_ASPECT_COLOR_BIT);
+    auto image_info = vsg::ImageInfo::create(vsg::ref_ptr<vsg::Sampler>{}, image_view, VK_IMAGE_LAYOUT_GENERAL);
+    final_image = vsg::DescriptorImage::create(image_info, final_index, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+
+    int cost_index = vsg::ShaderStage::getSetBindingIndex(binding_map, "costImage").second;
+    auto cost_image = vsg::DescriptorImage::create(
+        cost_buffer->illumination_images[0]->imageInfoList, cost_index, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+    int maxima_index = vsg::ShaderStage::getSetBindingIndex(binding_map, "CostMaxima").second;
+    auto maxima = vsg::DescriptorBuffer::create(
+        vsg::vec4Array::create(1), maxima_index, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+    auto descriptor_set
+        = vsg::DescriptorSet::create(descriptor_set_layout, vsg::Descriptors{cost_image, maxima, final_image});
+    _bind_descriptor_set
+        = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, descriptor_set);
+    auto reduce_descriptor_set
+        = vsg::DescriptorSet::create(reduce_descriptor_set_layout, vsg::Descriptors{cost_image, maxima});
+    _bind_reduce_descriptor_set = vsg::BindDescriptorSet::create(
+        VK_PIPELINE_BIND_POINT_COMPUTE, reduce_pipeline_layout, 0, reduce_descriptor_set);
+
+    _bind_pipeline = vsg::BindComputePipeline::create(vsg::ComputePipeline::create(pipeline_layout, compute_stage));
+    _bind_reduce_pipeline
+        = vsg::BindComputePipeline::create(vsg::ComputePipeline::create(reduce_pipeline_layout, reduce_stage));
+    _channel = vsg::intValue::create(static_cast<int>(Channel::SHADER_TIME));
+    _push_constants = vsg::PushConstants::create(VK_SHADER_STAGE_COMPUTE_BIT, 0, _channel);
+}
+void CostHeatmap::compile_images(vsg::Context& context) const
+{
+    final_image->compile(context);
+}
+void CostHeatmap::update_image_layouts(vsg::Context& context) const
+{
+    VkImageSubresourceRange resource_range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    auto final_layout
+        = vsg::ImageMemoryBarrier::create(VK_ACCESS_NONE_KHR, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_GENERAL, 0, 0, final_image->imageInfoList[0]->imageView->image, resource_range);
+    auto pipeline_barrier = vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_DEPENDENCY_BY_REGION_BIT, final_layout);
+    context.commands.emplace_back(pipeline_barrier);
+}
+void CostHeatmap::add_dispatch_to_command_graph(vsg::ref_ptr<vsg::Commands> command_graph)
+{
+    auto cost_barrier = vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        vsg::MemoryBarrier::create(VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+    command_graph->addChild(cost_barrier);
+    // the whole image is reduced by a single work group, the heatmap is only a debug view
+    command_graph->addChild(_bind_reduce_pipeline);
+    command_graph->addChild(_bind_reduce_descriptor_set);
+    command_graph->addChild(vsg::Dispatch::create(1, 1, 1));
+    auto maxima_barrier = vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        vsg::MemoryBarrier::create(VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+    command_graph->addChild(maxima_barrier);
+    command_graph->addChild(_bind_pipeline);
+    command_graph->addChild(_bind_descriptor_set);
+    command_graph->addChild(_push_constants);
+    command_graph->addChild(
+        vsg::Dispatch::create(uint32_t(ceil(static_cast<float>(_width) / static_cast<float>(_work_width))),
+            uint32_t(ceil(static_cast<float>(_height) / static_cast<float>(_work_height))), 1));
+}
+void CostHeatmap::set_channel(Channel channel)
+{
+    _channel->value() = static_cast<int>(channel);
+}
+vsg::ref_ptr<vsg::ShaderStage> CostHeatmap::load_shader(bool reduce_max)
+{
+    std::vector<std::string> defines;
+    if (reduce_max)
+    {
+        defines.emplace_back("REDUCE_MAX");
+    }
+    auto options = vsg::Options::create(vsgXchange::glsl::create());
+    auto compute_stage = vsg::ShaderStage::read(VK_SHADER_STAGE_COMPUTE_BIT, "main", _shader_path, options);
+    if (!compute_stage)
+    {
+        throw vsg::Exception{"CostHeatmap::load_shader() could not open compute shader stage"};
+    }
+    auto compile_hints = vsg::ShaderCompileSettings::create();
+    compile_hints->vulkanVersion = VK_API_VERSION_1_2;
+    compile_hints->target = vsg::ShaderCompileSettings::SPIRV_1_4;
+    compile_hints->defines = defines;
+    compute_stage->module->hints = compile_hints;
+    vkpbrt::compile_shader(compute_stage);
+    return compute_stage;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <buffers/CostBuffer.hpp>
+
+#include <vsg/all.h>
+
+// false colour view of one channel of a CostBuffer, normalized by the maximum of the current frame
+// the result is a B8G8R8A8 image, which can be shown in place of the final image
+class CostHeatmap : public vsg::Inherit<vsg::Object, CostHeatmap>
+{
+public:
+    enum class Channel
+    {
+        SHADER_TIME,
+        BOUNCE_RAYS,
+        SHADOW_RAYS,
+        ANY_HIT_INVOCATIONS
+    };
+
+    CostHeatmap(vsg::ref_ptr<CostBuffer> cost_buffer, int work_width = 16, int work_height = 16);
+
+    void compile_images(vsg::Context& context) const;
+    void update_image_layouts(vsg::Context& context) const;
+    void add_dispatch_to_command_graph(vsg::ref_ptr<vsg::Commands> command_graph);
+    void set_channel(Channel channel);
+    vsg::ref_ptr<vsg::DescriptorImage> final_image;
+
+    // reads the maximum reduction or the colouring shader, compiled through the shader cache if one is set
+    static vsg::ref_ptr<vsg::ShaderStage> load_shader(bool reduce_max);
+
+private:
+    static constexpr const char* _shader_path = "shaders/costHeatmap.comp";
+    vsg::ref_ptr<vsg::BindDescriptorSet> _bind_reduce_descriptor_set, _bind_descriptor_set;
+    vsg::ref_ptr<vsg::BindComputePipeline> _bind_reduce_pipeline, _bind_pipeline;
+    vsg::ref_ptr<vsg::intValue> _channel;
+    vsg::ref_ptr<vsg::PushConstants> _push_constants;
+    int _width, _height, _work_width, _work_height;
+};
@@ -1,4 +1,5 @@
 #include <renderModules/FormatConverter.hpp>
+#include <util/ShaderCache.hpp>
 #include <vsgXchange/glsl.h>
 
 FormatConverter::FormatConverter(
@@ -8,26 +9,11 @@ FormatConverter::FormatConverter(
       _work_width(work_width),
       _work_height(work_height)
 {
-    std::vector<std::string> defines;
-    switch (dst_format)
-    {
-    case VK_FORMAT_B8G8R8A8_UNORM:
-        defines.emplace_back("FORMAT rgba8");
-        break;
-    default:
-        throw vsg::Exception{"FormatConverter::Unknown format"};
-    }
-    auto options = vsg::Options::create(vsgXchange::glsl::create());
-    auto compute_stage = vsg::ShaderStage::read(VK_SHADER_STAGE_COMPUTE_BIT, "main", _shader_path, options);
+    auto compute_stage = load_shader(dst_format);
     compute_stage->specializationConstants = vsg::ShaderStage::SpecializationConstants{
         {0, vsg::intValue::create(work_width) },
         {1, vsg::intValue::create(work_height)}
     };
-    auto compile_hints = vsg::ShaderCompileSettings::create();
-    compile_hints->vulkanVersion = VK_API_VERSION_1_2;
-    compile_hints->target = vsg::ShaderCompileSettings::SPIRV_1_4;
-    compile_hints->defines = defines;
-    compute_stage->module->hints = compile_hints;
 
     auto binding_map = compute_stage->getDescriptorSetLayoutBindingsMap();
     auto descriptor_set_layout = vsg::DescriptorSetLayout::create(binding_map.begin()->second.bindings);
@@ -80,3 +66,28 @@ void FormatConverter::add_dispatch_to_command_graph(vsg::ref_ptr<vsg::Commands>
         vsg::Dispatch::create(uint32_t(ceil(static_cast<float>(_width) / static_cast<float>(_work_width))),
             uint32_t(ceil(static_cast<float>(_height) / static_cast<float>(_work_height))), 1));
 }
+vsg::ref_ptr<vsg::ShaderStage> FormatConverter::load_shader(VkFormat dst_format)
+{
+    std::vector<std::string> defines;
+    switch (dst_format)
+    {
+    case VK_FORMAT_B8G8R8A8_UNORM:
+        defines.emplace_back("FORMAT rgba8");
+        break;
+    default:
+        throw vsg::Exception{"FormatConverter::Unknown format"};
+    }
+    auto options = vsg::Options::create(vsgXchange::glsl::create());
+    auto compute_stage = vsg::ShaderStage::read(VK_SHADER_STAGE_COMPUTE_BIT, "main", _shader_path, options);
+    if (!compute_stage)
+    {
+        throw vsg::Exception{"FormatConverter::load_shader() could not open compute shader stage"};
+    }
+    auto compile_hints = vsg::ShaderCompileSettings::create();
+    compile_hints->vulkanVersion = VK_API_VERSION_1_2;
+    compile_hints->target = vsg::ShaderCompileSettings::SPIRV_1_4;
+    compile_hints->defines = defines;
+    compute_stage->module->hints = compile_hints;
+    vkpbrt::compile_shader(compute_stage);
+    return compute_stage;
+}
@@ -12,8 +12,11 @@ public:
     void add_dispatch_to_command_graph(vsg::ref_ptr<vsg::Commands> command_graph);
     vsg::ref_ptr<vsg::DescriptorImage> final_image;
 
+    // reads the conversion shader for dst_format, compiled through the shader cache if one is set
+    static vsg::ref_ptr<vsg::ShaderStage> load_shader(VkFormat dst_format);
+
 private:
-    std::string _shader_path = "shaders/formatConverter.comp";
+    static constexpr const char* _shader_path = "shaders/formatConverter.comp";
     vsg::ref_ptr<vsg::BindDescriptorSet> _bind_descriptor_set;
     vsg::ref_ptr<vsg::BindComputePipeline> _bind_pipeline;
     int _width, _height, _work_width, _work_height;
@@ -1,150 +1,218 @@
 #include <renderModules/GBufferRasterizer.hpp>
+#include <renderModules/PipelineStructs.hpp>
+#include <util/ShaderCache.hpp>
 
-GBufferRasterizer::GBufferRasterizer(
-    vsg::Device* device, uint32_t width, uint32_t height, bool double_sided, bool blend)
-    : _g_buffer(GBuffer::create(width, height)),
-      _width(width),
-      _height(height),
-      _double_sided(double_sided),
-      _blend(blend),
-      _device(device)
+#include <vsgXchange/glsl.h>
+
+#include <array>
+
+namespace
+{
+const char* vertex_shader_path = "shaders/rasterizer.vert";
+const char* fragment_shader_path = "shaders/rasterizer.frag";
+// c_NoPrimaryHit in shaders/ptConstants.glsl
+const uint32_t no_primary_hit = 0xffffffff;
+}  // namespace
+
+// renders both draw groups into the primary hit image, recorded outside of any render pass
+class GBufferRasterizer::RasterPass : public vsg::Inherit<vsg::Command, RasterPass>
+{
+public:
+    RasterPass(vsg::ref_ptr<const GBufferRasterizer> rasterizer, vsg::ref_ptr<vsg::PushConstants> push_constants)
+        : rasterizer(rasterizer), push_constants(push_constants)
+    {
+    }
+    vsg::ref_ptr<const GBufferRasterizer> rasterizer;
+    vsg::ref_ptr<vsg::PushConstants> push_constants;
+    vsg::ref_ptr<vsg::RenderPass> render_pass;
+    vsg::ref_ptr<vsg::Framebuffer> framebuffer;
+
+    void compile(vsg::Context& context) override
+    {
+        rasterizer->primary_hits->compile(context);
+        rasterizer->_depth->compile(context);
+        if (!render_pass)
+        {
+            vsg::AttachmentDescription primary_hit = vsg::defaultColorAttachment(primary_hit_format);
+            primary_hit.finalLayout = VK_IMAGE_LAYOUT_GENERAL;
+            vsg::AttachmentDescription depth = vsg::defaultDepthAttachment(depth_format);
+            VkAttachmentReference primary_hit_ref{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+            VkAttachmentReference depth_ref{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+            vsg::SubpassDescription subpass{
+                0, VK_PIPELINE_BIND_POINT_GRAPHICS, {}, {primary_hit_ref}, {}, {depth_ref}, {}};
+            // the path tracer of the last frame has to be done reading the primary hits before they are cleared, and
+            // the new ones have to be written before it starts
+            VkSubpassDependency before{VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT, 0,
+                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, 0};
+            VkSubpassDependency after{0, VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, 0};
+            render_pass = vsg::RenderPass::create(context.device, vsg::RenderPass::Attachments{primary_hit, depth},
+                vsg::RenderPass::Subpasses{subpass}, vsg::RenderPass::Dependencies{before, after});
+            framebuffer = vsg::Framebuffer::create(render_pass,
+                vsg::ImageViews{rasterizer->primary_hits->imageInfoList[0]->imageView, rasterizer->_depth},
+                rasterizer->width, rasterizer->height, 1);
+        }
+        // the pipelines are created for the render pass of the context
+        auto window_render_pass = context.renderPass;
+        context.renderPass = render_pass;
+        rasterizer->_bind_opaque_pipeline->compile(context);
+        rasterizer->_bind_alpha_test_pipeline->compile(context);
+        context.renderPass = window_render_pass;
+        rasterizer->_bind_descriptor_set->compile(context);
+    }
+    void record(vsg::CommandBuffer& command_buffer) const override
+    {
+        std::array<VkClearValue, 2> clear_values{};
+        clear_values[0].color.uint32[0] = no_primary_hit;
+        clear_values[0].color.uint32[1] = no_primary_hit;
+        clear_values[0].color.uint32[2] = no_primary_hit;
+        clear_values[0].color.uint32[3] = no_primary_hit;
+        clear_values[1].depthStencil = {1, 0};
+        VkRenderPassBeginInfo begin_info{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+        begin_info.renderPass = *render_pass;
+        begin_info.framebuffer = *framebuffer;
+        begin_info.renderArea = {{0, 0}, {rasterizer->width, rasterizer->height}};
+        begin_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+        begin_info.pClearValues = clear_values.data();
+        vkCmdBeginRenderPass(command_buffer, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+
+        const auto& constants = *static_cast<const RayTracingPushConstants*>(push_constants->data->dataPointer());
+        vsg::mat4 view_projection = vsg::inverse(constants.proj_inverse) * vsg::inverse(constants.view_inverse);
+        auto pipeline_layout = rasterizer->_bind_descriptor_set->layout->vk(command_buffer.deviceID);
+        for (const auto& [bind_pipeline, draws] :
+            {std::make_pair(rasterizer->_bind_opaque_pipeline, &rasterizer->_opaque_draws),
+                std::make_pair(rasterizer->_bind_alpha_test_pipeline, &rasterizer->_alpha_test_draws)})
+        {
+            if (draws->empty())
+            {
+                continue;
+            }
+            bind_pipeline->record(command_buffer);
+            rasterizer->_bind_descriptor_set->record(command_buffer);
+            vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(view_projection),
+                view_projection.data());
+            for (const auto& [instance, triangle_count] : *draws)
+            {
+                vkCmdDraw(command_buffer, 3 * triangle_count, 1, 0, instance);
+            }
+        }
+        vkCmdEndRenderPass(command_buffer);
+    }
+};
+
+GBufferRasterizer::GBufferRasterizer(uint32_t width, uint32_t height, bool double_sided)
+    : width(width), height(height), _double_sided(double_sided)
 {
-    setup_graphics_pipeline();
+    auto image = vsg::Image::create();
+    image->imageType = VK_IMAGE_TYPE_2D;
+    image->format = primary_hit_format;
+    image->extent = {width, height, 1};
+    image->mipLevels = 1;
+    image->arrayLayers = 1;
+    image->samples = VK_SAMPLE_COUNT_1_BIT;
+    image->tiling = VK_IMAGE_TILING_OPTIMAL;
+    image->usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    image->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image->sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    auto image_view = vsg::ImageView::create(image, VK_IMAGE_ASPECT_COLOR_BIT);
+    auto image_info = vsg::ImageInfo::create(vsg::ref_ptr<vsg::Sampler>{}, image_view, VK_IMAGE_LAYOUT_GENERAL);
+    primary_hits = vsg::DescriptorImage::create(image_info, 0, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+
+    image = vsg::Image::create();
+    image->imageType = VK_IMAGE_TYPE_2D;
+    image->format = depth_format;
+    image->extent = {width, height, 1};
+    image->mipLevels = 1;
+    image->arrayLayers = 1;
+    image->samples = VK_SAMPLE_COUNT_1_BIT;
+    image->tiling = VK_IMAGE_TILING_OPTIMAL;
+    image->usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    image->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image->sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    _depth = vsg::ImageView::create(image, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+    setup_pipelines();
 }
-void GBufferRasterizer::compile(vsg::Context& context) const
+void GBufferRasterizer::setup_scene(RayTracingSceneDescriptorCreationVisitor& scene)
 {
-    _g_buffer->compile(context);
+    scene.update_descriptor(_bind_descriptor_set, _binding_map);
+    _opaque_draws.clear();
+    _alpha_test_draws.clear();
+    for (int instance = 0; instance < scene.instance_count(); ++instance)
+    {
+        uint32_t triangle_count = scene.triangle_count(instance);
+        if (triangle_count == 0)
+        {
+            continue;
+        }
+        bool opaque = instance >= scene.is_opaque.size() || scene.is_opaque[instance];
+        (opaque ? _opaque_draws : _alpha_test_draws).emplace_back(instance, triangle_count);
+    }
 }
-void GBufferRasterizer::update_image_layouts(vsg::Context& context) const
+void GBufferRasterizer::update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const
 {
-    _g_buffer->update_image_layouts(context);
+    int primary_hit_ind = vsg::ShaderStage::getSetBindingIndex(binding_map, "primaryHitImage").second;
+    auto primary_hit_bind = vsg::DescriptorImage::create(
+        primary_hits->imageInfoList, primary_hit_ind, 0, primary_hits->descriptorType);
+    desc_set->descriptorSet->descriptors.push_back(primary_hit_bind);
 }
-void GBufferRasterizer::setup_graphics_pipeline()
+void GBufferRasterizer::add_draw_to_command_graph(
+    vsg::ref_ptr<vsg::Commands> command_graph, vsg::ref_ptr<vsg::PushConstants> push_constants) const
 {
-    // loading shaders and getting the descriptor set layout from the shader
-    std::string vertex_path = "shaders/rasterizer.vert.spv";
-    std::string fragment_path = "shaders/rasterizer.frag.spv";
-
-    auto vertex_shader = vsg::ShaderStage::read(VK_SHADER_STAGE_VERTEX_BIT, "main", vertex_path);
-    auto fragment_shader = vsg::ShaderStage::read(VK_SHADER_STAGE_FRAGMENT_BIT, "main", fragment_path);
-    vsg::BindingMap binding_map = vsg::ShaderStage::mergeBindingMaps(
-        {vertex_shader->getDescriptorSetLayoutBindingsMap(), fragment_shader->getDescriptorSetLayoutBindingsMap()});
-
-    auto descriptor_set_layout = vsg::DescriptorSetLayout::create(binding_map.begin()->second.bindings);
-
-    // code mostly copied from vsg::src::vsgXchange::assimp::assimp.cpp
-    vsg::PushConstantRanges push_constant_ranges{
-        {VK_SHADER_STAGE_VERTEX_BIT, 0, 128}
-  // projection view, and model matrices, actual push constant calls autoaatically provided by the VSG's
-  // DispatchTraversal
-    };
-
-    vsg::VertexInputState::Bindings vertex_bindings_descriptions{
-        VkVertexInputBindingDescription{0, sizeof(vsg::vec3), VK_VERTEX_INPUT_RATE_VERTEX}, // vertex data
-        VkVertexInputBindingDescription{1, sizeof(vsg::vec3), VK_VERTEX_INPUT_RATE_VERTEX}, // normal data
-        VkVertexInputBindingDescription{2, sizeof(vsg::vec2), VK_VERTEX_INPUT_RATE_VERTEX}  // texcoord data
-    };
-
-    vsg::VertexInputState::Attributes vertex_attribute_descriptions{
-        VkVertexInputAttributeDescription{0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0}, // vertex data
-        VkVertexInputAttributeDescription{1, 1, VK_FORMAT_R32G32B32_SFLOAT, 0}, // normal data
-        VkVertexInputAttributeDescription{2, 2, VK_FORMAT_R32G32_SFLOAT,    0}  // texcoord data
-    };
-
+    command_graph->addChild(RasterPass::create(vsg::ref_ptr<const GBufferRasterizer>(this), push_constants));
+}
+vsg::ShaderStages GBufferRasterizer::load_shaders(bool alpha_test)
+{
+    std::vector<std::string> fragment_defines;
+    if (alpha_test)
+    {
+        fragment_defines.emplace_back("ALPHA_TEST");
+    }
+    return {load_shader(VK_SHADER_STAGE_VERTEX_BIT, vertex_shader_path, {}),
+        load_shader(VK_SHADER_STAGE_FRAGMENT_BIT, fragment_shader_path, fragment_defines)};
+}
+vsg::ref_ptr<vsg::ShaderStage> GBufferRasterizer::load_shader(
+    VkShaderStageFlagBits stage, const std::string& path, const std::vector<std::string>& defines)
+{
+    auto options = vsg::Options::create(vsgXchange::glsl::create());
+    auto shader = vsg::ShaderStage::read(stage, "main", path, options);
+    if (!shader)
+    {
+        throw vsg::Exception{"Error: GBufferRasterizer::load_shader(...) could not read " + path};
+    }
+    auto compile_hints = vsg::ShaderCompileSettings::create();
+    compile_hints->vulkanVersion = VK_API_VERSION_1_2;
+    compile_hints->target = vsg::ShaderCompileSettings::SPIRV_1_4;
+    compile_hints->defines = defines;
+    shader->module->hints = compile_hints;
+    vkpbrt::compile_shader(shader);
+    return shader;
+}
+void GBufferRasterizer::setup_pipelines()
+{
+    auto opaque_shaders = load_shaders(false);
+    auto alpha_test_shaders = load_shaders(true);
+    // both pipelines share the layout and the descriptor set, so the scene descriptors are only bound once
+    _binding_map = vsg::ShaderStage::mergeBindingMaps({opaque_shaders[0]->getDescriptorSetLayoutBindingsMap(),
+        opaque_shaders[1]->getDescriptorSetLayoutBindingsMap(),
+        alpha_test_shaders[1]->getDescriptorSetLayoutBindingsMap()});
+    auto descriptor_set_layout = vsg::DescriptorSetLayout::create(_binding_map.begin()->second.bindings);
+    auto pipeline_layout = vsg::PipelineLayout::create(
+        vsg::DescriptorSetLayouts{descriptor_set_layout}, opaque_shaders[0]->getPushConstantRanges());
+
+    // no vertex buffers, the vertex shader reads the vertices of gl_VertexIndex from the scene descriptors
     auto raster_state = vsg::RasterizationState::create();
     raster_state->cullMode = _double_sided ? VK_CULL_MODE_NONE : VK_CULL_MODE_BACK_BIT;
-
-    auto color_blend_state = vsg::ColorBlendState::create();
-    color_blend_state->attachments = vsg::ColorBlendState::ColorBlendAttachments{
-        {static_cast<VkBool32>(_blend), VK_BLEND_FACTOR_SRC_ALPHA, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, VK_BLEND_OP_ADD,
-         VK_BLEND_FACTOR_SRC_ALPHA, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, VK_BLEND_OP_SUBTRACT,
-         VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT}
-    };
-
-    vsg::GraphicsPipelineStates pipeline_states{
-        vsg::VertexInputState::create(vertex_bindings_descriptions, vertex_attribute_descriptions),
-        vsg::InputAssemblyState::create(), raster_state, vsg::MultisampleState::create(), color_blend_state,
-        vsg::DepthStencilState::create()};
-
-    auto pipeline_layout
-        = vsg::PipelineLayout::create(vsg::DescriptorSetLayouts{descriptor_set_layout}, push_constant_ranges);
-    auto pipeline = vsg::GraphicsPipeline::create(
-        pipeline_layout, vsg::ShaderStages{vertex_shader, fragment_shader}, pipeline_states);
-    _bind_graphics_pipeline = vsg::BindGraphicsPipeline::create(pipeline);
-
-    // creating framebuffers and attachments
-    vsg::AttachmentDescription albedo = vsg::defaultColorAttachment(VK_FORMAT_R8G8B8A8_UNORM);
-    albedo.finalLayout = VK_IMAGE_LAYOUT_GENERAL;
-    vsg::AttachmentDescription position = vsg::defaultColorAttachment(VK_FORMAT_R32G32B32_SFLOAT);
-    position.finalLayout = VK_IMAGE_LAYOUT_GENERAL;
-    vsg::AttachmentDescription normal = vsg::defaultColorAttachment(VK_FORMAT_R32G32_SFLOAT);
-    normal.finalLayout = VK_IMAGE_LAYOUT_GENERAL;
-    vsg::AttachmentDescription material = vsg::defaultColorAttachment(VK_FORMAT_R32G32B32A32_SFLOAT);
-    material.finalLayout = VK_IMAGE_LAYOUT_GENERAL;
-    vsg::AttachmentDescription depth = vsg::defaultDepthAttachment(VK_FORMAT_R32_SFLOAT);
-    vsg::RenderPass::Attachments attachments{albedo, position, normal, material, depth};
-
-    VkAttachmentReference albedo_attachment_ref{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
-    VkAttachmentReference position_attachment_ref{1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
-    VkAttachmentReference normal_attachment_ref{2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
-    VkAttachmentReference material_attachment_ref{3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
-    VkAttachmentReference depthl_attachment_ref{4, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL};
-
-    vsg::SubpassDescription subpass{
-        0, VK_PIPELINE_BIND_POINT_GRAPHICS, {                     },
-        {albedo_attachment_ref,  position_attachment_ref, normal_attachment_ref, material_attachment_ref},
-          {           },
-        {depthl_attachment_ref                      },
-          {                      }
-    };
-    vsg::RenderPass::Subpasses subpasses{subpass};
-
-    VkSubpassDependency albedo_dependency{VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
-        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, 0,
-        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0};
-    VkSubpassDependency position_dependency{VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
-        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, 0,
-        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0};
-    VkSubpassDependency normal_dependency{VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
-        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, 0,
-        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0};
-    VkSubpassDependency materiall_dependency{VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
-        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, 0,
-        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0};
-    VkSubpassDependency depth_dependency{VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
-        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, 0,
-        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, 0};
-
-    vsg::RenderPass::Dependencies dependencies{
-        albedo_dependency, position_dependency, normal_dependency, materiall_dependency, depth_dependency};
-
-    auto render_pass = vsg::RenderPass::create(_device, attachments, subpasses, dependencies);
-
-    auto depth_image = vsg::Image::create();
-    depth_image->format = VK_FORMAT_R32_SFLOAT;
-    depth_image->extent = {_width, _height, 1};
-    depth_image->mipLevels = 1;
-    depth_image->arrayLayers = 1;
-    depth_image->usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-
-    vsg::ImageViews attachment_views{_g_buffer->albedo->imageInfoList[0]->imageView,
-        _g_buffer->depth->imageInfoList[0]->imageView, _g_buffer->normal->imageInfoList[0]->imageView,
-        _g_buffer->material->imageInfoList[0]->imageView, vsg::ImageView::create(depth_image)};
-
-    _frame_buffer = vsg::Framebuffer::create(render_pass, attachment_views, _width, _height, 1);
-
-    // we are using a rendergraph to set the framebuffer and renderpass
-    // see https://github.com/vsg-dev/vsgExamples/blob/master/examples/viewer/vsgrendertotexture/vsgrendertotexture.cpp
-    // for usage of offline rendering
-    auto render_graph = vsg::RenderGraph::create();
-    render_graph->renderArea.offset = {0, 0};
-    render_graph->renderArea.extent = {_width, _height};
-    render_graph->framebuffer = _frame_buffer;
-
-    render_graph->clearValues.resize(dependencies.size(), {});
-    render_graph->clearValues.back().depthStencil = {1, 0};
-
-    // TODO: maybe create viewer already here, however requires scenen information.
-    //  According to my current knowledge this is preferred, as the scene graph has to be transformed anyway to only use
-    //  this graphics pipeline
+    vsg::GraphicsPipelineStates pipeline_states{vsg::VertexInputState::create(), vsg::InputAssemblyState::create(),
+        raster_state, vsg::MultisampleState::create(), vsg::ColorBlendState::create(),
+        vsg::DepthStencilState::create(), vsg::ViewportState::create(0, 0, width, height)};
+    _bind_opaque_pipeline = vsg::BindGraphicsPipeline::create(
+        vsg::GraphicsPipeline::create(pipeline_layout, opaque_shaders, pipeline_states));
+    _bind_alpha_test_pipeline = vsg::BindGraphicsPipeline::create(
+        vsg::GraphicsPipeline::create(pipeline_layout, alpha_test_shaders, pipeline_states));
+
+    auto descriptor_set = vsg::DescriptorSet::create(descriptor_set_layout, vsg::Descriptors{});
+    _bind_descriptor_set
+        = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, descriptor_set);
 }
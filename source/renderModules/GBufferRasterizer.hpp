@@ -1,32 +1,52 @@
 #pragma once
-#include <buffers/GBuffer.hpp>
+#include <scene/RayTracingVisitor.hpp>
 
 #include <vsg/all.h>
 
 #include <cstdint>
-
-class GBufferRasterizer
+#include <string>
+#include <utility>
+#include <vector>
+
+// Rasterizes the primary visibility of the path tracer instead of tracing the primary rays. Every pixel center gets
+// the instance index, primitive index and barycentrics of its closest triangle in primary_hits, the path tracer then
+// reconstructs the surface from them with RAY_ORIGIN_GBUFFER (see loadPrimaryHit() in shaders/trace.glsl).
+// The vertices are pulled from the scene descriptors of the path tracer (shaders/rasterizer.vert), the opaque instances
+// are drawn first with the early depth test, the alpha tested ones afterwards with a discarding fragment shader.
+class GBufferRasterizer : public vsg::Inherit<vsg::Object, GBufferRasterizer>
 {
 public:
-    GBufferRasterizer(
-        vsg::Device* device, uint32_t width, uint32_t height, bool double_sided = false, bool blend = false);
+    GBufferRasterizer(uint32_t width, uint32_t height, bool double_sided = true);
 
-    void compile(vsg::Context& context) const;
+    const uint32_t width, height;
+    // storage image in general layout, pixels without a hit hold c_NoPrimaryHit of shaders/ptConstants.glsl
+    vsg::ref_ptr<vsg::DescriptorImage> primary_hits;
 
-    void update_image_layouts(vsg::Context& context) const;
+    // binds the scene descriptors of the visitor and sets up one draw per instance of the visited scene
+    void setup_scene(RayTracingSceneDescriptorCreationVisitor& scene);
+    void update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const;
+    // the view projection is taken from the push constants of the path tracer at every record
+    void add_draw_to_command_graph(
+        vsg::ref_ptr<vsg::Commands> command_graph, vsg::ref_ptr<vsg::PushConstants> push_constants) const;
 
-protected:
-    void setup_graphics_pipeline();
+    // reads the vertex and fragment shader, compiled through the shader cache if one is set
+    static vsg::ShaderStages load_shaders(bool alpha_test);
 
-    uint32_t _width, _height;
-    bool _double_sided, _blend;
-    vsg::Device* _device;
+    static constexpr VkFormat primary_hit_format = VK_FORMAT_R32G32B32A32_UINT;
+    static constexpr VkFormat depth_format = VK_FORMAT_D32_SFLOAT;
 
-    vsg::ref_ptr<GBuffer> _g_buffer;
-    vsg::ref_ptr<vsg::BindGraphicsPipeline> _bind_graphics_pipeline;
-    vsg::ref_ptr<vsg::BindDescriptorSet> _bind_descriptor_set;
-    vsg::ref_ptr<vsg::RenderPass> _render_pass;
-    vsg::ref_ptr<vsg::Framebuffer> _frame_buffer;
+private:
+    class RasterPass;
+
+    static vsg::ref_ptr<vsg::ShaderStage> load_shader(
+        VkShaderStageFlagBits stage, const std::string& path, const std::vector<std::string>& defines);
+    void setup_pipelines();
+
+    bool _double_sided;
     vsg::ref_ptr<vsg::ImageView> _depth;
-    vsg::ref_ptr<vsg::RenderGraph> _render_graph;
-};
\ No newline at end of file
+    vsg::ref_ptr<vsg::BindGraphicsPipeline> _bind_opaque_pipeline, _bind_alpha_test_pipeline;
+    vsg::ref_ptr<vsg::BindDescriptorSet> _bind_descriptor_set;
+    vsg::BindingMap _binding_map;
+    // instance index and triangle count of every draw, the instance index is passed as first instance
+    std::vector<std::pair<uint32_t, uint32_t>> _opaque_draws, _alpha_test_draws;
+};
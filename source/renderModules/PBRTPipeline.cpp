@@ -1,4 +1,6 @@
 #include <renderModules/PBRTPipeline.hpp>
+#include <util/Instrumentation.hpp>
+#include <util/ShaderCache.hpp>
 
 #include <cassert>
 
@@ -21,12 +23,24 @@ public:
 
 PBRTPipeline::PBRTPipeline(vsg::ref_ptr<vsg::Node> scene, vsg::ref_ptr<GBuffer> g_buffer,
     vsg::ref_ptr<IlluminationBuffer> illumination_buffer, bool write_g_buffer,
-    RayTracingRayOrigin ray_tracing_ray_origin)
+    RayTracingRayOrigin ray_tracing_ray_origin, vsg::ref_ptr<RayStatisticsBuffer> ray_statistics_buffer,
+    vsg::ref_ptr<CostBuffer> cost_buffer, vsg::ref_ptr<AdaptiveSamplingBuffer> adaptive_sampling_buffer,
+    SamplerType sampler_type, vsg::ref_ptr<ReservoirBuffer> reservoir_buffer,
+    vsg::ref_ptr<RadianceCacheBuffer> radiance_cache_buffer, vsg::ref_ptr<WavefrontBuffer> wavefront_buffer,
+    TracingBackend tracing_backend)
     : _width(illumination_buffer->illumination_images[0]->imageInfoList[0]->imageView->image->extent.width),
       _height(illumination_buffer->illumination_images[0]->imageInfoList[0]->imageView->image->extent.height),
       _max_recursion_depth(2),
+      _sampler_type(sampler_type),
+      _tracing_backend(tracing_backend),
       _g_buffer(g_buffer),
-      _illumination_buffer(illumination_buffer)
+      _illumination_buffer(illumination_buffer),
+      _ray_statistics_buffer(ray_statistics_buffer),
+      _cost_buffer(cost_buffer),
+      _adaptive_sampling_buffer(adaptive_sampling_buffer),
+      _reservoir_buffer(reservoir_buffer),
+      _radiance_cache_buffer(radiance_cache_buffer),
+      _wavefront_buffer(wavefront_buffer)
 {
     if (write_g_buffer)
     {
@@ -57,37 +71,149 @@ void PBRTPipeline::set_tlas(vsg::ref_ptr<vsg::AccelerationStructure> as)
 void PBRTPipeline::compile(vsg::Context& context)
 {
     _illumination_buffer->compile(context);
+    if (_ray_statistics_buffer)
+    {
+        _ray_statistics_buffer->compile(context);
+    }
+    if (_cost_buffer)
+    {
+        _cost_buffer->compile(context);
+    }
+    if (_adaptive_sampling_buffer)
+    {
+        _adaptive_sampling_buffer->compile(context);
+    }
+    if (_reservoir_buffer)
+    {
+        _reservoir_buffer->compile(context);
+    }
+    if (_radiance_cache_buffer)
+    {
+        _radiance_cache_buffer->compile(context);
+    }
+    if (_wavefront_buffer)
+    {
+        _wavefront_buffer->compile(context);
+    }
 }
 void PBRTPipeline::update_image_layouts(vsg::Context& context)
 {
     _illumination_buffer->update_image_layouts(context);
+    if (_cost_buffer)
+    {
+        _cost_buffer->update_image_layouts(context);
+    }
+    if (_adaptive_sampling_buffer)
+    {
+        _adaptive_sampling_buffer->update_image_layouts(context);
+    }
+    if (_reservoir_buffer)
+    {
+        _reservoir_buffer->update_image_layouts(context);
+    }
 }
 void PBRTPipeline::add_trace_rays_to_command_graph(
     vsg::ref_ptr<vsg::Commands> command_graph, vsg::ref_ptr<vsg::PushConstants> push_constants)
 {
     auto pipeline_barrier = vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_DEPENDENCY_DEVICE_GROUP_BIT);
-    command_graph->addChild(_bind_ray_tracing_pipeline);
-    command_graph->addChild(_bind_ray_tracing_descriptor_set);
-    command_graph->addChild(push_constants);
-    auto trace_rays = vsg::TraceRays::create();
-    trace_rays->bindingTable = _shader_binding_table;
-    trace_rays->width = _width;
-    trace_rays->height = _height;
-    trace_rays->depth = 1;
-    command_graph->addChild(trace_rays);
+    if (_g_buffer_rasterizer)
+    {
+        // before the path tracer is bound, the render pass synchronizes the primary hits with it
+        _g_buffer_rasterizer->add_draw_to_command_graph(command_graph, push_constants);
+    }
+    if (_bind_compute_pipeline)
+    {
+        command_graph->addChild(_bind_compute_pipeline);
+        command_graph->addChild(_bind_ray_tracing_descriptor_set);
+        command_graph->addChild(vsg::PushConstants::create(VK_SHADER_STAGE_COMPUTE_BIT, 0, push_constants->data));
+    }
+    else
+    {
+        command_graph->addChild(_bind_ray_tracing_pipeline);
+        command_graph->addChild(_bind_ray_tracing_descriptor_set);
+        command_graph->addChild(push_constants);
+    }
+    if (_ray_statistics_buffer)
+    {
+        _ray_statistics_buffer->add_reset_to_command_graph(command_graph);
+    }
+    if (_wavefront_path_tracer)
+    {
+        // the final image is written by the accumulation stage
+        _wavefront_path_tracer->add_stages_to_command_graph(
+            command_graph, push_constants, _shader_binding_table, _max_recursion_depth);
+        pipeline_barrier->srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
+    else if (_bind_compute_pipeline)
+    {
+        command_graph->addChild(vsg::Dispatch::create((_width + _compute_tile_size - 1) / _compute_tile_size,
+            (_height + _compute_tile_size - 1) / _compute_tile_size, 1));
+        pipeline_barrier->srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
+    else
+    {
+        auto trace_rays = vsg::TraceRays::create();
+        trace_rays->bindingTable = _shader_binding_table;
+        trace_rays->width = _width;
+        trace_rays->height = _height;
+        trace_rays->depth = 1;
+        if (_adaptive_sampling_buffer)
+        {
+            // launched over the active pixel list written by the AdaptiveSampler
+            trace_rays->indirectBuffer = _adaptive_sampling_buffer->trace_rays_command;
+        }
+        command_graph->addChild(trace_rays);
+    }
+    if (_ray_statistics_buffer)
+    {
+        _ray_statistics_buffer->add_readback_to_command_graph(command_graph);
+    }
     command_graph->addChild(pipeline_barrier);
 }
 vsg::ref_ptr<IlluminationBuffer> PBRTPipeline::get_illumination_buffer() const
 {
     return _illumination_buffer;
 }
+void PBRTPipeline::set_samples_per_launch(uint32_t samples_per_launch)
+{
+    _raygen_shader->specializationConstants[0] = vsg::uintValue::create(samples_per_launch);
+    if (_wavefront_path_tracer)
+    {
+        _wavefront_path_tracer->set_samples_per_launch(samples_per_launch);
+    }
+}
+void PBRTPipeline::set_samples_per_frame(uint32_t samples_per_frame)
+{
+    // blueNoiseLog2Samples has to be even, a base 4 digit must not mix sample and pixel bits
+    uint32_t log2_samples = 0;
+    while (log2_samples < 4 && (1u << log2_samples) < samples_per_frame)
+    {
+        log2_samples += 2;
+    }
+    _raygen_shader->specializationConstants[1] = vsg::uintValue::create(log2_samples);
+    if (_wavefront_path_tracer)
+    {
+        _wavefront_path_tracer->set_blue_noise_log2_samples(log2_samples);
+    }
+}
+void PBRTPipeline::set_max_recursion_depth(uint32_t max_recursion_depth)
+{
+    _max_recursion_depth = max_recursion_depth;
+    _constant_infos.cast<ConstantInfosValue>()->value().max_recursion_depth = max_recursion_depth;
+}
 void PBRTPipeline::setup_pipeline(vsg::Node* scene, bool use_external_gbuffer)
 {
     // parsing data from scene
     RayTracingSceneDescriptorCreationVisitor build_descriptor_binding;
-    scene->accept(build_descriptor_binding);
+    {
+        vkpbrt::ScopedTimer timer("scene descriptors", "cpu");
+        scene->accept(build_descriptor_binding);
+    }
     _opaque_geometries = build_descriptor_binding.is_opaque;
+    auto& instrumentation = vkpbrt::Instrumentation::instance();
+    instrumentation.add_counter("scene.instances", static_cast<double>(build_descriptor_binding.is_opaque.size()));
+    instrumentation.add_counter("scene.lights", static_cast<double>(build_descriptor_binding.packed_lights.size()));
 
     const int max_lights = 800;
     if (build_descriptor_binding.packed_lights.size() > max_lights)
@@ -95,25 +221,132 @@ void PBRTPipeline::setup_pipeline(vsg::Node* scene, bool use_external_gbuffer)
         light_sampling_method = LightSamplingMethod::SAMPLE_UNIFORM;
     }
 
+    if (_tracing_backend == TracingBackend::RAY_TRACING_PIPELINE)
+    {
+        setup_ray_tracing_pipeline(use_external_gbuffer);
+    }
+    else
+    {
+        setup_compute_pipeline(use_external_gbuffer);
+    }
+
+    build_descriptor_binding.update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
+    if (_tracing_backend == TracingBackend::SOFTWARE_BVH)
+    {
+        {
+            vkpbrt::ScopedTimer timer("software bvh", "cpu");
+            _software_bvh = SoftwareBVH::create(build_descriptor_binding);
+        }
+        instrumentation.add_counter("scene.bvh_nodes", static_cast<double>(_software_bvh->nodes.size()));
+        // after the scene descriptors, update_descriptor() of the visitor replaces all descriptors
+        _software_bvh->update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
+    }
+    if (use_external_gbuffer)
+    {
+        _g_buffer_rasterizer = GBufferRasterizer::create(_width, _height);
+        _g_buffer_rasterizer->setup_scene(build_descriptor_binding);
+        _g_buffer_rasterizer->update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
+    }
+    // creating the constant infos uniform buffer object
+    auto constant_infos = ConstantInfosValue::create();
+    _constant_infos = constant_infos;
+    constant_infos->value().light_count = build_descriptor_binding.packed_lights.size();
+    constant_infos->value().light_strength_sum = build_descriptor_binding.packed_lights.back().inclusiveStrength;
+    constant_infos->value().max_recursion_depth = _max_recursion_depth;
+    uint32_t uniform_buffer_binding = vsg::ShaderStage::getSetBindingIndex(_binding_map, "Infos").second;
+    auto constant_infos_descriptor = vsg::DescriptorBuffer::create(constant_infos, uniform_buffer_binding, 0);
+    _bind_ray_tracing_descriptor_set->descriptorSet->descriptors.push_back(constant_infos_descriptor);
+
+    // update the descriptor sets
+    _illumination_buffer->update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
+    if (_g_buffer)
+    {
+        _g_buffer->update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
+        if (_g_buffer->layout == GBufferLayout::VISIBILITY)
+        {
+            // the consumers of the visibility buffer intersect the stored triangles with the scene geometry
+            _g_buffer->set_scene_geometry(_bind_ray_tracing_descriptor_set->descriptorSet->descriptors, _binding_map);
+        }
+    }
+    if (_ray_statistics_buffer)
+    {
+        _ray_statistics_buffer->update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
+    }
+    if (_cost_buffer)
+    {
+        _cost_buffer->update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
+    }
+    if (_adaptive_sampling_buffer)
+    {
+        _adaptive_sampling_buffer->update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
+    }
+    if (_reservoir_buffer)
+    {
+        _reservoir_buffer->update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
+    }
+    if (_radiance_cache_buffer)
+    {
+        _radiance_cache_buffer->update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
+    }
+    if (_wavefront_buffer)
+    {
+        _wavefront_buffer->update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
+    }
+}
+void PBRTPipeline::setup_ray_tracing_pipeline(bool use_external_gbuffer)
+{
     // creating the shader stages and shader binding table
-    std::string raygen_path = "shaders/ptRaygen.rgen";  // raygen shader not yet precompiled
+    // raygen shader not yet precompiled, the wavefront path tracer only traces rays in its raygen shader
+    std::string raygen_path = _wavefront_buffer ? WavefrontPathTracer::trace_shader_path : _raygen_path;
     std::string raymiss_path = "shaders/ptMiss.rmiss.spv";
     std::string shadow_miss_path = "shaders/shadow.rmiss.spv";
     std::string closesthit_path = "shaders/ptClosesthit.rchit.spv";
     std::string any_hit_path = "shaders/ptAlphaHit.rahit.spv";
 
     auto raygen_shader = setup_raygen_shader(raygen_path, use_external_gbuffer);
+    _raygen_shader = raygen_shader;
     auto raymiss_shader = vsg::ShaderStage::read(VK_SHADER_STAGE_MISS_BIT_KHR, "main", raymiss_path);
     auto shadow_miss_shader = vsg::ShaderStage::read(VK_SHADER_STAGE_MISS_BIT_KHR, "main", shadow_miss_path);
     auto closesthit_shader = vsg::ShaderStage::read(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR, "main", closesthit_path);
-    auto any_hit_shader = vsg::ShaderStage::read(VK_SHADER_STAGE_ANY_HIT_BIT_KHR, "main", any_hit_path);
+    vsg::ref_ptr<vsg::ShaderStage> any_hit_shader;
+    if (auto defines = debug_defines(_ray_statistics_buffer.valid(), _cost_buffer.valid()); !defines.empty())
+    {
+        // the precompiled any hit shader has no debug counters
+        if (_adaptive_sampling_buffer)
+        {
+            defines.emplace_back("ADAPTIVE_SAMPLING");
+        }
+        any_hit_shader = load_shader(VK_SHADER_STAGE_ANY_HIT_BIT_KHR, _any_hit_source_path, defines);
+    }
+    else
+    {
+        any_hit_shader = vsg::ShaderStage::read(VK_SHADER_STAGE_ANY_HIT_BIT_KHR, "main", any_hit_path);
+    }
     if (!raygen_shader || !raymiss_shader || !closesthit_shader || !shadow_miss_shader || !any_hit_shader)
     {
         throw vsg::Exception{"Error: PBRTPipeline::PBRTPipeline(...) failed to create shader stages."};
     }
-    _binding_map = vsg::ShaderStage::mergeBindingMaps({raygen_shader->getDescriptorSetLayoutBindingsMap(),
+    std::vector<vsg::BindingMap> binding_maps{raygen_shader->getDescriptorSetLayoutBindingsMap(),
         raymiss_shader->getDescriptorSetLayoutBindingsMap(), shadow_miss_shader->getDescriptorSetLayoutBindingsMap(),
-        closesthit_shader->getDescriptorSetLayoutBindingsMap(), any_hit_shader->getDescriptorSetLayoutBindingsMap()});
+        closesthit_shader->getDescriptorSetLayoutBindingsMap(), any_hit_shader->getDescriptorSetLayoutBindingsMap()};
+    if (_wavefront_buffer)
+    {
+        if (!_illumination_buffer.cast<IlluminationBufferFinalFloat>() || _g_buffer || _adaptive_sampling_buffer
+            || _reservoir_buffer || _radiance_cache_buffer || _cost_buffer)
+        {
+            throw vsg::Exception{
+                "Error: PBRTPipeline::PBRTPipeline(...) the wavefront path tracer only writes the final image."};
+        }
+        if (use_external_gbuffer)
+        {
+            throw vsg::Exception{"Error: PBRTPipeline::PBRTPipeline(...) the wavefront path tracer traces its primary "
+                                 "rays, it can not start from rasterized primary hits."};
+        }
+        // the compute stages use the descriptor set of the ray tracing pipeline
+        _wavefront_path_tracer = WavefrontPathTracer::create(_wavefront_buffer, shader_defines(use_external_gbuffer));
+        binding_maps.push_back(_wavefront_path_tracer->get_binding_map());
+    }
+    _binding_map = vsg::ShaderStage::mergeBindingMaps(binding_maps);
 
     auto descriptor_set_layout = vsg::DescriptorSetLayout::create(_binding_map.begin()->second.bindings);
     // auto rayTracingPipelineLayout = vsg::PipelineLayout::create(vsg::DescriptorSetLayouts{descriptorSetLayout},
@@ -150,57 +383,119 @@ void PBRTPipeline::setup_pipeline(vsg::Node* scene, bool use_external_gbuffer)
     auto descriptor_set = vsg::DescriptorSet::create(descriptor_set_layout, vsg::Descriptors{});
     _bind_ray_tracing_descriptor_set = vsg::BindDescriptorSet::create(
         VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, ray_tracing_pipeline_layout, descriptor_set);
-
-    build_descriptor_binding.update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
-    // creating the constant infos uniform buffer object
-    auto constant_infos = ConstantInfosValue::create();
-    constant_infos->value().light_count = build_descriptor_binding.packed_lights.size();
-    constant_infos->value().light_strength_sum = build_descriptor_binding.packed_lights.back().inclusiveStrength;
-    constant_infos->value().max_recursion_depth = _max_recursion_depth;
-    uint32_t uniform_buffer_binding = vsg::ShaderStage::getSetBindingIndex(_binding_map, "Infos").second;
-    auto constant_infos_descriptor = vsg::DescriptorBuffer::create(constant_infos, uniform_buffer_binding, 0);
-    _bind_ray_tracing_descriptor_set->descriptorSet->descriptors.push_back(constant_infos_descriptor);
-
-    // update the descriptor sets
-    _illumination_buffer->update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
-    if (_g_buffer)
+    if (_wavefront_path_tracer)
     {
-        _g_buffer->update_descriptor(_bind_ray_tracing_descriptor_set, _binding_map);
+        _wavefront_path_tracer->setup_pipelines(descriptor_set_layout, descriptor_set);
+    }
+}
+void PBRTPipeline::setup_compute_pipeline(bool use_external_gbuffer)
+{
+    if (_wavefront_buffer || _adaptive_sampling_buffer)
+    {
+        throw vsg::Exception{"Error: PBRTPipeline::PBRTPipeline(...) the compute backends do not support the "
+                             "wavefront path tracer and adaptive sampling."};
+    }
+    auto shader_path = _tracing_backend == TracingBackend::SOFTWARE_BVH ? _software_bvh_path : _ray_query_path;
+    auto shader = load_shader(VK_SHADER_STAGE_COMPUTE_BIT, shader_path, shader_defines(use_external_gbuffer));
+    if (!shader)
+    {
+        throw vsg::Exception{"Error: PBRTPipeline::PBRTPipeline(...) failed to create the compute backend shader."};
     }
+    _raygen_shader = shader;
+    // launchWidth and launchHeight, the dispatch is rounded up to whole tiles
+    shader->specializationConstants[2] = vsg::uintValue::create(_width);
+    shader->specializationConstants[3] = vsg::uintValue::create(_height);
+    // the hit and miss shaders are inlined, so the compute shader holds every binding
+    _binding_map = shader->getDescriptorSetLayoutBindingsMap();
+
+    auto descriptor_set_layout = vsg::DescriptorSetLayout::create(_binding_map.begin()->second.bindings);
+    auto pipeline_layout = vsg::PipelineLayout::create(
+        vsg::DescriptorSetLayouts{descriptor_set_layout}, shader->getPushConstantRanges());
+    _bind_compute_pipeline = vsg::BindComputePipeline::create(vsg::ComputePipeline::create(pipeline_layout, shader));
+    auto descriptor_set = vsg::DescriptorSet::create(descriptor_set_layout, vsg::Descriptors{});
+    _bind_ray_tracing_descriptor_set
+        = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, descriptor_set);
 }
 vsg::ref_ptr<vsg::ShaderStage> PBRTPipeline::setup_raygen_shader(std::string raygen_path, bool use_external_g_buffer)
+{
+    return load_raygen_shader(raygen_path, shader_defines(use_external_g_buffer));
+}
+std::vector<std::string> PBRTPipeline::shader_defines(bool use_external_g_buffer) const
+{
+    auto defines = raygen_defines(
+        _illumination_buffer, _g_buffer, light_sampling_method, use_external_g_buffer, _sampler_type);
+    auto additional_defines = debug_defines(_ray_statistics_buffer.valid(), _cost_buffer.valid());
+    defines.insert(defines.end(), additional_defines.begin(), additional_defines.end());
+    if (_adaptive_sampling_buffer)
+    {
+        defines.emplace_back("ADAPTIVE_SAMPLING");
+    }
+    if (_reservoir_buffer && _reservoir_buffer->direct_lighting)
+    {
+        defines.emplace_back("RESTIR_DI");
+    }
+    if (_reservoir_buffer && _reservoir_buffer->global_illumination)
+    {
+        defines.emplace_back("RESTIR_GI");
+    }
+    if (_radiance_cache_buffer)
+    {
+        defines.emplace_back("RADIANCE_CACHE");
+    }
+    return defines;
+}
+std::vector<std::string> PBRTPipeline::debug_defines(bool ray_statistics, bool cost_heatmap)
+{
+    std::vector<std::string> defines;
+    if (ray_statistics)
+    {
+        defines.emplace_back("RAY_STATISTICS");
+    }
+    if (cost_heatmap)
+    {
+        defines.emplace_back("COST_HEATMAP");
+    }
+    return defines;
+}
+std::vector<std::string> PBRTPipeline::raygen_defines(vsg::ref_ptr<IlluminationBuffer> illumination_buffer,
+    vsg::ref_ptr<GBuffer> g_buffer, LightSamplingMethod light_sampling_method, bool use_external_g_buffer,
+    SamplerType sampler_type)
 {
     std::vector<std::string> defines;  // needed defines for the correct illumination buffer
 
-    // set different raygen shaders according to state of external gbuffer and illumination buffer type
-    if (use_external_g_buffer)
+    // set different raygen shaders according to the illumination buffer type and the origin of the primary hits
+    if (illumination_buffer.cast<IlluminationBufferFinalFloat>())
+    {
+        defines.emplace_back("FINAL_IMAGE");
+    }
+    else if (illumination_buffer.cast<IlluminationBufferDemodulatedFloat>())
+    {
+        defines.emplace_back("DEMOD_ILLUMINATION_FLOAT");
+    }
+    else if (illumination_buffer.cast<IlluminationBufferFinalDirIndir>())
     {
-        // TODO: implement things for external gBuffer
-        // raygenPath = "shaders/raygen.rgen.spv";
+        // TODO:
     }
     else
     {
-        if (_illumination_buffer.cast<IlluminationBufferFinalFloat>())
-        {
-            defines.emplace_back("FINAL_IMAGE");
-        }
-        else if (_illumination_buffer.cast<IlluminationBufferDemodulatedFloat>())
-        {
-            defines.emplace_back("DEMOD_ILLUMINATION_FLOAT");
-        }
-        else if (_illumination_buffer.cast<IlluminationBufferFinalDirIndir>())
+        throw vsg::Exception{"Error: PBRTPipeline::setupRaygenShader(...) Illumination buffer not supported."};
+    }
+    if (use_external_g_buffer)
+    {
+        defines.emplace_back("RAY_ORIGIN_GBUFFER");
+    }
+    if (g_buffer)
+    {
+        defines.emplace_back("GBUFFER");
+        if (g_buffer->layout == GBufferLayout::VISIBILITY)
         {
-            // TODO:
+            defines.emplace_back("VISIBILITY_BUFFER");
         }
-        else
+        else if (g_buffer->encoding == GBufferEncoding::COMPACT)
         {
-            throw vsg::Exception{"Error: PBRTPipeline::setupRaygenShader(...) Illumination buffer not supported."};
+            defines.emplace_back("GBUFFER_COMPACT");
         }
     }
-    if (_g_buffer)
-    {
-        defines.emplace_back("GBUFFER");
-    }
 
     switch (light_sampling_method)
     {
@@ -214,17 +509,121 @@ vsg::ref_ptr<vsg::ShaderStage> PBRTPipeline::setup_raygen_shader(std::string ray
         break;
     }
 
-    auto options = vsg::Options::create(vsgXchange::glsl::create());
-    auto raygen_shader = vsg::ShaderStage::read(VK_SHADER_STAGE_RAYGEN_BIT_KHR, "main", raygen_path, options);
+    switch (sampler_type)
+    {
+    case SamplerType::SOBOL:
+        defines.emplace_back("SAMPLER_SOBOL");
+        break;
+    case SamplerType::BLUE_NOISE:
+        defines.emplace_back("SAMPLER_BLUE_NOISE");
+        break;
+    default:
+        break;
+    }
+    return defines;
+}
+vsg::ref_ptr<vsg::ShaderStage> PBRTPipeline::load_raygen_shader(
+    const std::string& raygen_path, const std::vector<std::string>& defines)
+{
+    auto raygen_shader = load_shader(VK_SHADER_STAGE_RAYGEN_BIT_KHR, raygen_path, defines);
     if (!raygen_shader)
     {
         throw vsg::Exception{"Error: PBRTPipeline::setupRaygenShader() Could not load ray generation shader."};
     }
+    return raygen_shader;
+}
+vsg::ref_ptr<vsg::ShaderStage> PBRTPipeline::load_shader(
+    VkShaderStageFlagBits stage, const std::string& path, const std::vector<std::string>& defines)
+{
+    auto options = vsg::Options::create(vsgXchange::glsl::create());
+    auto shader = vsg::ShaderStage::read(stage, "main", path, options);
+    if (!shader)
+    {
+        return {};
+    }
     auto compile_hints = vsg::ShaderCompileSettings::create();
     compile_hints->vulkanVersion = VK_API_VERSION_1_2;
     compile_hints->target = vsg::ShaderCompileSettings::SPIRV_1_4;
     compile_hints->defines = defines;
-    raygen_shader->module->hints = compile_hints;
+    shader->module->hints = compile_hints;
+    vkpbrt::compile_shader(shader);
 
-    return raygen_shader;
+    return shader;
+}
+void PBRTPipeline::prepare_raygen_shader(vsg::ref_ptr<IlluminationBuffer> illumination_buffer,
+    vsg::ref_ptr<GBuffer> g_buffer, SamplerType sampler_type, TracingBackend tracing_backend,
+    RayTracingRayOrigin ray_origin)
+{
+    auto defines = raygen_defines(illumination_buffer, g_buffer, LightSamplingMethod::SAMPLE_SURFACE_STRENGTH,
+        ray_origin == RayTracingRayOrigin::GBUFFER, sampler_type);
+    if (ray_origin == RayTracingRayOrigin::GBUFFER)
+    {
+        GBufferRasterizer::load_shaders(false);
+        GBufferRasterizer::load_shaders(true);
+    }
+    if (tracing_backend == TracingBackend::RAY_QUERY)
+    {
+        load_shader(VK_SHADER_STAGE_COMPUTE_BIT, _ray_query_path, defines);
+        return;
+    }
+    if (tracing_backend == TracingBackend::SOFTWARE_BVH)
+    {
+        load_shader(VK_SHADER_STAGE_COMPUTE_BIT, _software_bvh_path, defines);
+        return;
+    }
+    load_raygen_shader(_raygen_path, defines);
+}
+void PBRTPipeline::precompile_shaders()
+{
+    // the permutations of raygen_defines() for all backends. The defines of the optional features (ADAPTIVE_SAMPLING,
+    // RESTIR_DI, RESTIR_GI, RADIANCE_CACHE and the debug counters) are left out, their shaders are compiled on first
+    // use. The buffers are only created to select the defines, nothing is allocated on the device
+    const std::vector<vsg::ref_ptr<IlluminationBuffer>> illumination_buffers{
+        IlluminationBufferFinalFloat::create(1, 1), IlluminationBufferDemodulatedFloat::create(1, 1)};
+    const std::vector<vsg::ref_ptr<GBuffer>> g_buffers{vsg::ref_ptr<GBuffer>{}, GBuffer::create(1, 1),
+        GBuffer::create(1, 1, GBufferLayout::VISIBILITY),
+        GBuffer::create(1, 1, GBufferLayout::ATTRIBUTES, GBufferEncoding::COMPACT)};
+    const std::vector<LightSamplingMethod> light_sampling_methods{LightSamplingMethod::SAMPLE_SURFACE_STRENGTH,
+        LightSamplingMethod::SAMPLE_LIGHT_STRENGTH, LightSamplingMethod::SAMPLE_UNIFORM};
+    const std::vector<SamplerType> sampler_types{SamplerType::RANDOM, SamplerType::SOBOL, SamplerType::BLUE_NOISE};
+    for (const auto& illumination_buffer : illumination_buffers)
+    {
+        for (const auto& g_buffer : g_buffers)
+        {
+            for (auto light_sampling : light_sampling_methods)
+            {
+                for (auto sampler_type : sampler_types)
+                {
+                    for (bool use_external_g_buffer : {false, true})
+                    {
+                        auto defines = raygen_defines(
+                            illumination_buffer, g_buffer, light_sampling, use_external_g_buffer, sampler_type);
+                        load_raygen_shader(_raygen_path, defines);
+                        load_shader(VK_SHADER_STAGE_COMPUTE_BIT, _ray_query_path, defines);
+                        load_shader(VK_SHADER_STAGE_COMPUTE_BIT, _software_bvh_path, defines);
+                    }
+                }
+            }
+        }
+    }
+    // the any hit shader is only compiled at runtime with debug counters, see setup_ray_tracing_pipeline()
+    for (auto [ray_statistics, cost_heatmap] : {std::pair{true, false}, std::pair{false, true}, std::pair{true, true}})
+    {
+        auto defines = debug_defines(ray_statistics, cost_heatmap);
+        load_shader(VK_SHADER_STAGE_ANY_HIT_BIT_KHR, _any_hit_source_path, defines);
+        defines.emplace_back("ADAPTIVE_SAMPLING");
+        load_shader(VK_SHADER_STAGE_ANY_HIT_BIT_KHR, _any_hit_source_path, defines);
+    }
+    GBufferRasterizer::load_shaders(false);
+    GBufferRasterizer::load_shaders(true);
+    // the wavefront path tracer only writes the final image and has no g-buffer
+    for (auto light_sampling : light_sampling_methods)
+    {
+        for (auto sampler_type : sampler_types)
+        {
+            auto defines = raygen_defines(illumination_buffers.front(), {}, light_sampling, false, sampler_type);
+            load_raygen_shader(WavefrontPathTracer::trace_shader_path, defines);
+            WavefrontPathTracer::load_shaders(defines);
+        }
+    }
 }
@@ -3,17 +3,43 @@
 #include <buffers/GBuffer.hpp>
 #include <buffers/IlluminationBuffer.hpp>
 #include <scene/RayTracingVisitor.hpp>
+#include <scene/SoftwareBVH.hpp>
 #include <buffers/AccumulationBuffer.hpp>
+#include <buffers/AdaptiveSamplingBuffer.hpp>
+#include <buffers/CostBuffer.hpp>
+#include <buffers/RayStatisticsBuffer.hpp>
+#include <buffers/ReservoirBuffer.hpp>
+#include <buffers/RadianceCacheBuffer.hpp>
+#include <buffers/WavefrontBuffer.hpp>
+#include <renderModules/GBufferRasterizer.hpp>
+#include <renderModules/WavefrontPathTracer.hpp>
 
 #include <vsg/all.h>
 #include <vsgXchange/glsl.h>
 
 #include <cstdint>
 
+// where the paths of the path tracer start
 enum class RayTracingRayOrigin
 {
-    CAMERA,
-    GBUFFER,
+    CAMERA,   // primary rays are traced from the camera
+    GBUFFER,  // the primary hits are rasterized by a GBufferRasterizer
+};
+
+// random numbers used for the decisions of a path
+enum class SamplerType
+{
+    RANDOM,      // white noise
+    SOBOL,       // owen scrambled sobol, converges faster for offline renders
+    BLUE_NOISE,  // z-order sobol, the error of low sample counts is distributed as blue noise over the screen
+};
+
+// how the rays of the path tracer are traced, all trace the same paths with the same scene descriptors
+enum class TracingBackend
+{
+    RAY_TRACING_PIPELINE,  // ptRaygen.rgen with the hit and miss shaders of the shader binding table
+    RAY_QUERY,             // ptRayQuery.comp, inline ray queries from a compute shader (VK_KHR_ray_query)
+    SOFTWARE_BVH,          // ptSoftwareBVH.comp, traverses a SoftwareBVH, needs no ray tracing support and no tlas
 };
 
 class PBRTPipeline : public vsg::Inherit<vsg::Object, PBRTPipeline>
@@ -21,7 +47,12 @@ class PBRTPipeline : public vsg::Inherit<vsg::Object, PBRTPipeline>
 public:
     PBRTPipeline(vsg::ref_ptr<vsg::Node> scene, vsg::ref_ptr<GBuffer> g_buffer,
         vsg::ref_ptr<IlluminationBuffer> illumination_buffer, bool write_g_buffer,
-        RayTracingRayOrigin ray_tracing_ray_origin);
+        RayTracingRayOrigin ray_tracing_ray_origin, vsg::ref_ptr<RayStatisticsBuffer> ray_statistics_buffer = {},
+        vsg::ref_ptr<CostBuffer> cost_buffer = {}, vsg::ref_ptr<AdaptiveSamplingBuffer> adaptive_sampling_buffer = {},
+        SamplerType sampler_type = SamplerType::RANDOM, vsg::ref_ptr<ReservoirBuffer> reservoir_buffer = {},
+        vsg::ref_ptr<RadianceCacheBuffer> radiance_cache_buffer = {},
+        vsg::ref_ptr<WavefrontBuffer> wavefront_buffer = {},
+        TracingBackend tracing_backend = TracingBackend::RAY_TRACING_PIPELINE);
 
     void set_tlas(vsg::ref_ptr<vsg::AccelerationStructure> as);
     void compile(vsg::Context& context);
@@ -29,6 +60,26 @@ public:
     void add_trace_rays_to_command_graph(
         vsg::ref_ptr<vsg::Commands> command_graph, vsg::ref_ptr<vsg::PushConstants> push_constants);
     vsg::ref_ptr<IlluminationBuffer> get_illumination_buffer() const;
+    // samples traced by every raygen invocation per trace rays, has to be set before the pipeline is compiled
+    void set_samples_per_launch(uint32_t samples_per_launch);
+    // samples per output frame, the blue noise sampler distributes the error of this many samples over the screen
+    void set_samples_per_frame(uint32_t samples_per_frame);
+    // bounces of a path after the primary hit (default 2), has to be set before the pipeline is compiled
+    void set_max_recursion_depth(uint32_t max_recursion_depth);
+
+    // reads the raygen shader with the given defines, compiled through the shader cache if one is set
+    static vsg::ref_ptr<vsg::ShaderStage> load_raygen_shader(
+        const std::string& raygen_path, const std::vector<std::string>& defines);
+    // compiles the raygen and compute backend shader permutations of the illumination buffers, g-buffers, light
+    // sampling methods, samplers and ray origins, the debug any hit shaders, the wavefront path tracer stages and the
+    // rasterizer shaders into the shader cache. The optional feature defines are not included
+    static void precompile_shaders();
+    // compiles the raygen shader a pipeline with these buffers uses for the default light sampling into the shader
+    // cache, so it can be done while the scene is still loading
+    static void prepare_raygen_shader(vsg::ref_ptr<IlluminationBuffer> illumination_buffer,
+        vsg::ref_ptr<GBuffer> g_buffer, SamplerType sampler_type = SamplerType::RANDOM,
+        TracingBackend tracing_backend = TracingBackend::RAY_TRACING_PIPELINE,
+        RayTracingRayOrigin ray_origin = RayTracingRayOrigin::CAMERA);
     enum class LightSamplingMethod
     {
         SAMPLE_SURFACE_STRENGTH,
@@ -38,19 +89,59 @@ public:
 
 private:
     void setup_pipeline(vsg::Node* scene, bool use_external_gbuffer);
+    // both set the shader, the binding map and the descriptor set binding of the chosen backend
+    void setup_ray_tracing_pipeline(bool use_external_gbuffer);
+    // the ray query and the software bvh backend
+    void setup_compute_pipeline(bool use_external_gbuffer);
     vsg::ref_ptr<vsg::ShaderStage> setup_raygen_shader(std::string raygen_path, bool use_external_g_buffer);
+    // defines of the raygen shader for the buffers of this pipeline
+    std::vector<std::string> shader_defines(bool use_external_g_buffer) const;
+    // RAY_STATISTICS and COST_HEATMAP, shared by the raygen and any hit shader
+    static std::vector<std::string> debug_defines(bool ray_statistics, bool cost_heatmap);
+    static vsg::ref_ptr<vsg::ShaderStage> load_shader(
+        VkShaderStageFlagBits stage, const std::string& path, const std::vector<std::string>& defines);
+    static std::vector<std::string> raygen_defines(vsg::ref_ptr<IlluminationBuffer> illumination_buffer,
+        vsg::ref_ptr<GBuffer> g_buffer, LightSamplingMethod light_sampling_method, bool use_external_g_buffer,
+        SamplerType sampler_type);
+
+    static constexpr const char* _raygen_path = "shaders/ptRaygen.rgen";
+    static constexpr const char* _any_hit_source_path = "shaders/ptAlphaHit.rahit";
+    static constexpr const char* _ray_query_path = "shaders/ptRayQuery.comp";
+    static constexpr const char* _software_bvh_path = "shaders/ptSoftwareBVH.comp";
+    // workgroup size of ptRayQuery.comp and ptSoftwareBVH.comp
+    static constexpr uint32_t _compute_tile_size = 8;
 
     std::vector<bool> _opaque_geometries;
     uint32_t _width, _height, _max_recursion_depth, _sample_per_pixel;
+    SamplerType _sampler_type;
+    TracingBackend _tracing_backend;
 
     // TODO: add buffers here
     vsg::ref_ptr<GBuffer> _g_buffer;
     vsg::ref_ptr<IlluminationBuffer> _illumination_buffer;
+    vsg::ref_ptr<RayStatisticsBuffer> _ray_statistics_buffer;
+    vsg::ref_ptr<CostBuffer> _cost_buffer;
+    vsg::ref_ptr<AdaptiveSamplingBuffer> _adaptive_sampling_buffer;
+    vsg::ref_ptr<ReservoirBuffer> _reservoir_buffer;
+    vsg::ref_ptr<RadianceCacheBuffer> _radiance_cache_buffer;
+    vsg::ref_ptr<WavefrontBuffer> _wavefront_buffer;
+    // traces the paths in stages instead of the ptRaygen.rgen megakernel if a wavefront buffer is given
+    vsg::ref_ptr<WavefrontPathTracer> _wavefront_path_tracer;
+    // scene of the software bvh backend, replaces the tlas
+    vsg::ref_ptr<SoftwareBVH> _software_bvh;
+    // rasterizes the primary hits for RayTracingRayOrigin::GBUFFER
+    vsg::ref_ptr<GBufferRasterizer> _g_buffer_rasterizer;
 
     // resources which have to be added as childs to a scenegraph for rendering
+    // the raygen shader or the compute shader of the compute backends
+    vsg::ref_ptr<vsg::ShaderStage> _raygen_shader;
     vsg::ref_ptr<vsg::BindRayTracingPipeline> _bind_ray_tracing_pipeline;
+    vsg::ref_ptr<vsg::BindComputePipeline> _bind_compute_pipeline;
+    // bound to the compute bind point for the compute backends
     vsg::ref_ptr<vsg::BindDescriptorSet> _bind_ray_tracing_descriptor_set;
     vsg::ref_ptr<vsg::PushConstants> _push_constants;
+    // uniform with the light count and recursion depths
+    vsg::ref_ptr<vsg::Data> _constant_infos;
 
     // shader binding table for trace rays
     vsg::ref_ptr<vsg::RayTracingShaderBindingTable> _shader_binding_table;
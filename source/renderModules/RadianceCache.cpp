@@ -0,0 +1,51 @@
+#include <renderModules/RadianceCache.hpp>
+
+RadianceCache::RadianceCache(vsg::ref_ptr<RadianceCacheBuffer> radiance_cache_buffer, uint32_t max_age,
+    uint32_t max_history_length, int work_size)
+    : _radiance_cache_buffer(radiance_cache_buffer), _work_size(work_size)
+{
+    std::string shader_path = "shaders/radianceCache.comp.spv";
+    auto compute_stage = vsg::ShaderStage::read(VK_SHADER_STAGE_COMPUTE_BIT, "main", shader_path);
+    if (!compute_stage)
+    {
+        throw vsg::Exception{"Error: RadianceCache::RadianceCache(...) could not read " + shader_path};
+    }
+    compute_stage->specializationConstants = vsg::ShaderStage::SpecializationConstants{
+        {0, vsg::intValue::create(work_size)           },
+        {1, vsg::uintValue::create(max_age)            },
+        {2, vsg::uintValue::create(max_history_length)}
+    };
+
+    auto binding_map = compute_stage->getDescriptorSetLayoutBindingsMap();
+    auto descriptor_set_layout = vsg::DescriptorSetLayout::create(binding_map.begin()->second.bindings);
+    auto pipeline_layout
+        = vsg::PipelineLayout::create(vsg::DescriptorSetLayouts{descriptor_set_layout}, vsg::PushConstantRanges{});
+
+    auto& entries = radiance_cache_buffer->entries;
+    auto cache = vsg::DescriptorBuffer::create(vsg::BufferInfoList{vsg::BufferInfo::create(entries, 0, entries->size)},
+        vsg::ShaderStage::getSetBindingIndex(binding_map, "RadianceCache").second, 0,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+    auto descriptor_set = vsg::DescriptorSet::create(descriptor_set_layout, vsg::Descriptors{cache});
+    _bind_descriptor_set
+        = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, descriptor_set);
+    _bind_pipeline = vsg::BindComputePipeline::create(vsg::ComputePipeline::create(pipeline_layout, compute_stage));
+}
+void RadianceCache::add_dispatch_to_command_graph(vsg::ref_ptr<vsg::Commands> command_graph)
+{
+    // the accumulated radiance of the trace rays has to be complete, the next trace rays reads the resolved one
+    auto accumulate_barrier = vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        vsg::MemoryBarrier::create(
+            VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT));
+    command_graph->addChild(accumulate_barrier);
+    command_graph->addChild(_bind_pipeline);
+    command_graph->addChild(_bind_descriptor_set);
+    command_graph->addChild(vsg::Dispatch::create(
+        (_radiance_cache_buffer->entry_count + _work_size - 1) / static_cast<uint32_t>(_work_size), 1, 1));
+    auto resolve_barrier = vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, 0,
+        vsg::MemoryBarrier::create(
+            VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT));
+    command_graph->addChild(resolve_barrier);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <buffers/RadianceCacheBuffer.hpp>
+
+#include <vsg/all.h>
+
+#include <cstdint>
+
+// resolves the radiance the raygen shader accumulated in a RadianceCacheBuffer into the cached running averages,
+// cells which got no samples for max_age frames are evicted, so the table stays free for the visible part of the scene
+class RadianceCache : public vsg::Inherit<vsg::Object, RadianceCache>
+{
+public:
+    RadianceCache(vsg::ref_ptr<RadianceCacheBuffer> radiance_cache_buffer, uint32_t max_age = 32,
+        uint32_t max_history_length = 256, int work_size = 256);
+
+    // has to be recorded after the trace rays dispatch
+    void add_dispatch_to_command_graph(vsg::ref_ptr<vsg::Commands> command_graph);
+
+private:
+    vsg::ref_ptr<RadianceCacheBuffer> _radiance_cache_buffer;
+    vsg::ref_ptr<vsg::BindComputePipeline> _bind_pipeline;
+    vsg::ref_ptr<vsg::BindDescriptorSet> _bind_descriptor_set;
+    int _work_size;
+};
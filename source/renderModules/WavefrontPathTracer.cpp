@@ -0,0 +1,219 @@
+#include <renderModules/PipelineStructs.hpp>
+#include <renderModules/WavefrontPathTracer.hpp>
+#include <util/ShaderCache.hpp>
+
+#include <vsgXchange/glsl.h>
+
+#include <cstddef>
+
+namespace
+{
+// shaders in the order of WavefrontPathTracer::load_shaders()
+const std::vector<std::string> shader_paths{
+    "shaders/wfGenerate.comp", "shaders/wfShade.comp", "shaders/wfQueues.comp", "shaders/wfAccumulate.comp"};
+// queueStage constants of wfQueues.comp
+const uint32_t prepare_trace = 0;
+const uint32_t prepare_shade = 1;
+
+vsg::ref_ptr<vsg::PipelineBarrier> stage_barrier(VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage)
+{
+    return vsg::PipelineBarrier::create(src_stage, dst_stage, 0,
+        vsg::MemoryBarrier::create(VK_ACCESS_SHADER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT));
+}
+}  // namespace
+
+class WavefrontPathTracer::BeginSample : public vsg::Inherit<vsg::Command, BeginSample>
+{
+public:
+    BeginSample(vsg::ref_ptr<vsg::Buffer> queue_counters, uint32_t launch_sample)
+        : queue_counters(queue_counters), launch_sample(launch_sample)
+    {
+    }
+    vsg::ref_ptr<vsg::Buffer> queue_counters;
+    uint32_t launch_sample;
+
+    void record(vsg::CommandBuffer& command_buffer) const override
+    {
+        // the previous sample has to be done with the queues
+        VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_WRITE_BIT};
+        vkCmdPipelineBarrier(command_buffer,
+            VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+                | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        WavefrontQueueCounters counters{};
+        counters.launch_sample = launch_sample;
+        vkCmdUpdateBuffer(
+            command_buffer, queue_counters->vk(command_buffer.deviceID), 0, sizeof(counters), &counters);
+        barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+            1, &barrier, 0, nullptr, 0, nullptr);
+    }
+};
+class WavefrontPathTracer::DispatchIndirect : public vsg::Inherit<vsg::Command, DispatchIndirect>
+{
+public:
+    DispatchIndirect(vsg::ref_ptr<vsg::Buffer> buffer, VkDeviceSize offset) : buffer(buffer), offset(offset) {}
+    vsg::ref_ptr<vsg::Buffer> buffer;
+    VkDeviceSize offset;
+
+    void record(vsg::CommandBuffer& command_buffer) const override
+    {
+        vkCmdDispatchIndirect(command_buffer, buffer->vk(command_buffer.deviceID), offset);
+    }
+};
+
+WavefrontPathTracer::WavefrontPathTracer(
+    vsg::ref_ptr<WavefrontBuffer> wavefront_buffer, const std::vector<std::string>& defines, uint32_t work_size)
+    : _wavefront_buffer(wavefront_buffer), _work_size(work_size), _samples_per_launch(1)
+{
+    auto shaders = load_shaders(defines);
+    _generate_stage = shaders[0];
+    _accumulate_stage = shaders[3];
+    // constant_id 2 selects the material class of a shading stage and the step of a queue stage
+    auto variant = [&](const vsg::ref_ptr<vsg::ShaderStage>& shader, uint32_t value) {
+        auto stage = vsg::ShaderStage::create(VK_SHADER_STAGE_COMPUTE_BIT, "main", shader->module);
+        stage->specializationConstants[2] = vsg::uintValue::create(value);
+        return stage;
+    };
+    for (uint32_t material_class = 0; material_class < WavefrontQueueCounters::material_class_count;
+         ++material_class)
+    {
+        _shade_stages.push_back(variant(shaders[1], material_class));
+    }
+    for (uint32_t queue_stage : {prepare_trace, prepare_shade})
+    {
+        _queue_stages.push_back(variant(shaders[2], queue_stage));
+    }
+    std::vector<vsg::ref_ptr<vsg::ShaderStage>> stages{_generate_stage, _accumulate_stage};
+    stages.insert(stages.end(), _shade_stages.begin(), _shade_stages.end());
+    stages.insert(stages.end(), _queue_stages.begin(), _queue_stages.end());
+    for (const auto& stage : stages)
+    {
+        stage->specializationConstants[0] = vsg::uintValue::create(work_size);
+    }
+    set_samples_per_launch(1);
+}
+vsg::BindingMap WavefrontPathTracer::get_binding_map() const
+{
+    return vsg::ShaderStage::mergeBindingMaps({_generate_stage->getDescriptorSetLayoutBindingsMap(),
+        _shade_stages[0]->getDescriptorSetLayoutBindingsMap(), _queue_stages[0]->getDescriptorSetLayoutBindingsMap(),
+        _accumulate_stage->getDescriptorSetLayoutBindingsMap()});
+}
+void WavefrontPathTracer::setup_pipelines(
+    vsg::ref_ptr<vsg::DescriptorSetLayout> descriptor_set_layout, vsg::ref_ptr<vsg::DescriptorSet> descriptor_set)
+{
+    // the camera push constants are shared with the ray tracing pipeline
+    auto pipeline_layout = vsg::PipelineLayout::create(vsg::DescriptorSetLayouts{descriptor_set_layout},
+        vsg::PushConstantRanges{{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RayTracingPushConstants)}});
+    auto bind_pipeline = [&](vsg::ref_ptr<vsg::ShaderStage> stage) {
+        return vsg::BindComputePipeline::create(vsg::ComputePipeline::create(pipeline_layout, stage));
+    };
+    _bind_generate_pipeline = bind_pipeline(_generate_stage);
+    _bind_accumulate_pipeline = bind_pipeline(_accumulate_stage);
+    for (const auto& stage : _shade_stages)
+    {
+        _bind_shade_pipelines.push_back(bind_pipeline(stage));
+    }
+    for (const auto& stage : _queue_stages)
+    {
+        _bind_queue_pipelines.push_back(bind_pipeline(stage));
+    }
+    _bind_descriptor_set
+        = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, descriptor_set);
+}
+void WavefrontPathTracer::set_samples_per_launch(uint32_t samples_per_launch)
+{
+    _samples_per_launch = samples_per_launch;
+    _generate_stage->specializationConstants[2] = vsg::uintValue::create(samples_per_launch);
+    _accumulate_stage->specializationConstants[2] = vsg::uintValue::create(samples_per_launch);
+}
+void WavefrontPathTracer::set_blue_noise_log2_samples(uint32_t log2_samples)
+{
+    _generate_stage->specializationConstants[1] = vsg::uintValue::create(log2_samples);
+    for (const auto& stage : _shade_stages)
+    {
+        stage->specializationConstants[1] = vsg::uintValue::create(log2_samples);
+    }
+}
+void WavefrontPathTracer::add_stages_to_command_graph(vsg::ref_ptr<vsg::Commands> command_graph,
+    vsg::ref_ptr<vsg::PushConstants> push_constants,
+    vsg::ref_ptr<vsg::RayTracingShaderBindingTable> shader_binding_table, uint32_t max_depth)
+{
+    auto& queue_counters = _wavefront_buffer->queue_counters;
+    // only the generation and accumulation stages read the camera, the trace stage has no push constants
+    auto compute_constants = vsg::PushConstants::create(VK_SHADER_STAGE_COMPUTE_BIT, 0, push_constants->data);
+    auto trace_rays = vsg::TraceRays::create();
+    trace_rays->bindingTable = shader_binding_table;
+    trace_rays->indirectBuffer = queue_counters;
+    uint32_t path_count = _wavefront_buffer->width * _wavefront_buffer->height;
+    uint32_t path_groups = (path_count + _work_size - 1) / _work_size;
+    // a path traces at most one extension ray per bounce or transmission, the last trace only has shadow rays
+    uint32_t trace_count = 1 + max_depth + max_transmission_depth + 1;
+    for (uint32_t launch_sample = 0; launch_sample < _samples_per_launch; ++launch_sample)
+    {
+        command_graph->addChild(BeginSample::create(queue_counters, launch_sample));
+        command_graph->addChild(_bind_generate_pipeline);
+        command_graph->addChild(_bind_descriptor_set);
+        command_graph->addChild(compute_constants);
+        command_graph->addChild(vsg::Dispatch::create(path_groups, 1, 1));
+        for (uint32_t trace = 0; trace < trace_count; ++trace)
+        {
+            command_graph->addChild(
+                stage_barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT));
+            command_graph->addChild(_bind_queue_pipelines[prepare_trace]);
+            command_graph->addChild(vsg::Dispatch::create(1, 1, 1));
+            command_graph->addChild(stage_barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR));
+            command_graph->addChild(trace_rays);
+            command_graph->addChild(stage_barrier(
+                VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT));
+            if (trace + 1 == trace_count)
+            {
+                break;
+            }
+            command_graph->addChild(_bind_queue_pipelines[prepare_shade]);
+            command_graph->addChild(vsg::Dispatch::create(1, 1, 1));
+            command_graph->addChild(stage_barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT));
+            // the shading queues are sorted by material class, every class is shaded by its own pipeline
+            for (uint32_t material_class = 0; material_class < _bind_shade_pipelines.size(); ++material_class)
+            {
+                command_graph->addChild(_bind_shade_pipelines[material_class]);
+                command_graph->addChild(DispatchIndirect::create(queue_counters,
+                    offsetof(WavefrontQueueCounters, shade_dispatch) + material_class * 4 * sizeof(uint32_t)));
+            }
+        }
+        command_graph->addChild(_bind_accumulate_pipeline);
+        command_graph->addChild(compute_constants);
+        command_graph->addChild(vsg::Dispatch::create(path_groups, 1, 1));
+    }
+}
+std::vector<vsg::ref_ptr<vsg::ShaderStage>> WavefrontPathTracer::load_shaders(const std::vector<std::string>& defines)
+{
+    std::vector<vsg::ref_ptr<vsg::ShaderStage>> shaders;
+    for (const auto& path : shader_paths)
+    {
+        shaders.push_back(load_shader(path, defines));
+    }
+    return shaders;
+}
+vsg::ref_ptr<vsg::ShaderStage> WavefrontPathTracer::load_shader(
+    const std::string& path, const std::vector<std::string>& defines)
+{
+    auto options = vsg::Options::create(vsgXchange::glsl::create());
+    auto shader = vsg::ShaderStage::read(VK_SHADER_STAGE_COMPUTE_BIT, "main", path, options);
+    if (!shader)
+    {
+        throw vsg::Exception{"Error: WavefrontPathTracer::load_shader(...) could not read " + path};
+    }
+    auto compile_hints = vsg::ShaderCompileSettings::create();
+    compile_hints->vulkanVersion = VK_API_VERSION_1_2;
+    compile_hints->target = vsg::ShaderCompileSettings::SPIRV_1_4;
+    compile_hints->defines = defines;
+    shader->module->hints = compile_hints;
+    vkpbrt::compile_shader(shader);
+    return shader;
+}
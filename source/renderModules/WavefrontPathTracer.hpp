@@ -0,0 +1,59 @@
+#pragma once
+#include <buffers/WavefrontBuffer.hpp>
+
+#include <vsg/all.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Compute stages of the wavefront path tracer. Instead of following a whole path in one raygen invocation like
+// ptRaygen.rgen, every path vertex runs through separate stages connected by the queues of a WavefrontBuffer:
+// generation (wfGenerate.comp) -> trace (wfTrace.rgen, launched with the PBRTPipeline's ray tracing pipeline) ->
+// shading (wfShade.comp, one dispatch per material class) -> trace -> ... -> accumulation (wfAccumulate.comp)
+// The stages are bound to the descriptor set of the ray tracing pipeline, their bindings are merged into its layout.
+class WavefrontPathTracer : public vsg::Inherit<vsg::Object, WavefrontPathTracer>
+{
+public:
+    // defines are the raygen defines of the PBRTPipeline
+    WavefrontPathTracer(vsg::ref_ptr<WavefrontBuffer> wavefront_buffer, const std::vector<std::string>& defines,
+        uint32_t work_size = 256);
+
+    // descriptor bindings of all stages, have to be merged into the binding map of the ray tracing pipeline
+    vsg::BindingMap get_binding_map() const;
+    // creates the compute pipelines, descriptor_set is the one of the ray tracing pipeline
+    void setup_pipelines(vsg::ref_ptr<vsg::DescriptorSetLayout> descriptor_set_layout,
+        vsg::ref_ptr<vsg::DescriptorSet> descriptor_set);
+    // have to be set before the pipelines are compiled, see PBRTPipeline
+    void set_samples_per_launch(uint32_t samples_per_launch);
+    void set_blue_noise_log2_samples(uint32_t log2_samples);
+
+    // records every sample of a launch, the ray tracing pipeline and its descriptor set have to be bound
+    // a sample runs through the trace and shading stages until no path can continue after max_depth bounces
+    void add_stages_to_command_graph(vsg::ref_ptr<vsg::Commands> command_graph,
+        vsg::ref_ptr<vsg::PushConstants> push_constants,
+        vsg::ref_ptr<vsg::RayTracingShaderBindingTable> shader_binding_table, uint32_t max_depth);
+
+    // reads the compute stages with the given defines, compiled through the shader cache if one is set
+    static std::vector<vsg::ref_ptr<vsg::ShaderStage>> load_shaders(const std::vector<std::string>& defines);
+
+    static constexpr const char* trace_shader_path = "shaders/wfTrace.rgen";
+    // transmissions a path can take on top of its bounces, c_MaxTransmissionDepth in wfShade.comp
+    static constexpr uint32_t max_transmission_depth = 10;
+
+private:
+    class BeginSample;
+    class DispatchIndirect;
+
+    static vsg::ref_ptr<vsg::ShaderStage> load_shader(const std::string& path, const std::vector<std::string>& defines);
+
+    vsg::ref_ptr<WavefrontBuffer> _wavefront_buffer;
+    uint32_t _work_size, _samples_per_launch;
+    // the shading and queue stages have one stage per material class and queue step, sharing the shader module
+    vsg::ref_ptr<vsg::ShaderStage> _generate_stage, _accumulate_stage;
+    std::vector<vsg::ref_ptr<vsg::ShaderStage>> _shade_stages, _queue_stages;
+
+    vsg::ref_ptr<vsg::BindComputePipeline> _bind_generate_pipeline, _bind_accumulate_pipeline;
+    std::vector<vsg::ref_ptr<vsg::BindComputePipeline>> _bind_shade_pipelines, _bind_queue_pipelines;
+    vsg::ref_ptr<vsg::BindDescriptorSet> _bind_descriptor_set;
+};
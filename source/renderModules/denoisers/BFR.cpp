@@ -21,7 +21,9 @@ BFR::BFR(uint32_t width, uint32_t height, uint32_t work_width, uint32_t work_hei
     auto illumination = illu_buffer;
     // adding usage bits to illumination buffer
     illumination->illumination_images[0]->imageInfoList[0]->imageView->image->usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
-    std::string shader_path = "shaders/bfr.comp.spv";
+    // visibility and compact g-buffers are read by the precompiled VISIBILITY_BUFFER and GBUFFER_COMPACT permutations
+    bool visibility_buffer = g_buffer->layout == GBufferLayout::VISIBILITY;
+    std::string shader_path = "shaders/bfr.comp" + g_buffer->shader_variant() + ".spv";
     auto compute_stage = vsg::ShaderStage::read(VK_SHADER_STAGE_COMPUTE_BIT, "main", shader_path);
     compute_stage->specializationConstants = vsg::ShaderStage::SpecializationConstants{
         {0, vsg::intValue::create(width)      },
@@ -76,30 +78,47 @@ BFR::BFR(uint32_t width, uint32_t height, uint32_t work_width, uint32_t work_hei
     auto illumination_info = illumination->illumination_images[0]->imageInfoList[0];
     illumination_info->sampler = _sampler;
     // filling descriptor set
-    vsg::Descriptors descriptors{vsg::DescriptorImage::create(g_buffer->depth->imageInfoList[0], _depth_binding, 0,
+    vsg::Descriptors descriptors{vsg::DescriptorImage::create(g_buffer->albedo->imageInfoList[0], _albedo_binding, 0,
                                      VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
-        vsg::DescriptorImage::create(
-            g_buffer->normal->imageInfoList[0], _normal_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
-        vsg::DescriptorImage::create(
-            g_buffer->material->imageInfoList[0], _material_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
-        vsg::DescriptorImage::create(
-            g_buffer->albedo->imageInfoList[0], _albedo_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
         vsg::DescriptorImage::create(
             acc_buffer->motion->imageInfoList[0], _motion_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
         vsg::DescriptorImage::create(
             acc_buffer->spp->imageInfoList[0], _sample_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
         vsg::DescriptorImage::create(illumination_info, _noisy_binding, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER),
         _accumulated_illumination, _final_illumination, _sampled_acc_illu};
+    if (visibility_buffer)
+    {
+        descriptors.push_back(vsg::DescriptorImage::create(
+            g_buffer->visibility->imageInfoList[0], _visibility_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE));
+    }
+    else
+    {
+        descriptors.push_back(vsg::DescriptorImage::create(
+            g_buffer->depth->imageInfoList[0], _depth_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE));
+        descriptors.push_back(vsg::DescriptorImage::create(
+            g_buffer->normal->imageInfoList[0], _normal_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE));
+        descriptors.push_back(vsg::DescriptorImage::create(
+            g_buffer->material->imageInfoList[0], _material_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE));
+    }
     auto descriptor_set = vsg::DescriptorSet::create(descriptor_set_layout, descriptors);
 
     VkPushConstantRange push_constant_range;
     push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
     push_constant_range.offset = 0;
     push_constant_range.size = sizeof(RayTracingPushConstants);
-    auto pipeline_layout = vsg::PipelineLayout::create(
-        vsg::DescriptorSetLayouts{descriptor_set_layout}, vsg::PushConstantRanges{push_constant_range});
+    vsg::DescriptorSetLayouts descriptor_set_layouts{descriptor_set_layout};
+    if (visibility_buffer)
+    {
+        descriptor_set_layouts.push_back(g_buffer->scene_geometry->setLayout);
+    }
+    auto pipeline_layout
+        = vsg::PipelineLayout::create(descriptor_set_layouts, vsg::PushConstantRanges{push_constant_range});
     _bind_descriptor_set
         = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, descriptor_set);
+    if (visibility_buffer)
+    {
+        _bind_scene_geometry = g_buffer->bind_scene_geometry(pipeline_layout);
+    }
 
     _bfr_pipeline = vsg::ComputePipeline::create(pipeline_layout, compute_stage);
     _bind_bfr_pipeline = vsg::BindComputePipeline::create(_bfr_pipeline);
@@ -130,6 +149,10 @@ void BFR::add_dispatch_to_command_graph(
 {
     command_graph->addChild(_bind_bfr_pipeline);
     command_graph->addChild(_bind_descriptor_set);
+    if (_bind_scene_geometry)
+    {
+        command_graph->addChild(_bind_scene_geometry);
+    }
     command_graph->addChild(push_constants);
     command_graph->addChild(vsg::Dispatch::create((_width / _work_width + 2), (_height / _work_height + 2), 1));
     auto pipeline_barrier = vsg::PipelineBarrier::create(
@@ -22,6 +22,7 @@ private:
     vsg::ref_ptr<GBuffer> _g_buffer;
 
     uint32_t _depth_binding = 0;
+    uint32_t _visibility_binding = 0;
     uint32_t _normal_binding = 1;
     uint32_t _material_binding = 2;
     uint32_t _albedo_binding = 3;
@@ -38,6 +39,7 @@ private:
     vsg::ref_ptr<vsg::ComputePipeline> _bfr_pipeline;
     vsg::ref_ptr<vsg::BindComputePipeline> _bind_bfr_pipeline;
     vsg::ref_ptr<vsg::BindDescriptorSet> _bind_descriptor_set;
+    vsg::ref_ptr<vsg::BindDescriptorSet> _bind_scene_geometry;  // only set for a visibility g-buffer
 
     vsg::ref_ptr<vsg::DescriptorImage> _accumulated_illumination, _sampled_acc_illu, _final_illumination;
 
@@ -23,9 +23,12 @@ BMFR::BMFR(uint32_t width, uint32_t height, uint32_t work_width, uint32_t work_h
     auto illumination = illu_buffer;
     // adding usage bits to illumination buffer
     illumination->illumination_images[0]->imageInfoList[0]->imageView->image->usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
-    std::string pre_shader_path = "shaders/bmfrPre.comp.spv";
-    std::string fit_shader_path = "shaders/bmfrFit.comp.spv";
-    std::string post_shader_path = "shaders/bmfrPost.comp.spv";
+    // visibility and compact g-buffers are read by the precompiled VISIBILITY_BUFFER and GBUFFER_COMPACT permutations
+    bool visibility_buffer = g_buffer->layout == GBufferLayout::VISIBILITY;
+    std::string shader_suffix = ".comp" + g_buffer->shader_variant() + ".spv";
+    std::string pre_shader_path = "shaders/bmfrPre" + shader_suffix;
+    std::string fit_shader_path = "shaders/bmfrFit" + shader_suffix;
+    std::string post_shader_path = "shaders/bmfrPost" + shader_suffix;
     auto pre_compute_stage = vsg::ShaderStage::read(VK_SHADER_STAGE_COMPUTE_BIT, "main", pre_shader_path);
     auto fit_compute_stage = vsg::ShaderStage::read(VK_SHADER_STAGE_COMPUTE_BIT, "main", fit_shader_path);
     auto post_compute_stage = vsg::ShaderStage::read(VK_SHADER_STAGE_COMPUTE_BIT, "main", post_shader_path);
@@ -137,30 +140,47 @@ BMFR::BMFR(uint32_t width, uint32_t height, uint32_t work_width, uint32_t work_h
     auto illumination_info = illumination->illumination_images[0]->imageInfoList[0];
     illumination_info->sampler = _sampler;
     // filling descriptor set
-    vsg::Descriptors descriptors{vsg::DescriptorImage::create(g_buffer->depth->imageInfoList[0], _depth_binding, 0,
+    vsg::Descriptors descriptors{vsg::DescriptorImage::create(g_buffer->albedo->imageInfoList[0], _albedo_binding, 0,
                                      VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
-        vsg::DescriptorImage::create(
-            g_buffer->normal->imageInfoList[0], _normal_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
-        vsg::DescriptorImage::create(
-            g_buffer->material->imageInfoList[0], _material_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
-        vsg::DescriptorImage::create(
-            g_buffer->albedo->imageInfoList[0], _albedo_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
         vsg::DescriptorImage::create(
             acc_buffer->motion->imageInfoList[0], _motion_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
         vsg::DescriptorImage::create(
             acc_buffer->spp->imageInfoList[0], _sample_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
         vsg::DescriptorImage::create(illumination_info, _noisy_binding, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER),
         _accumulated_illumination, _final_illumination, sampled_acc_illu, _feature_buffer, _weights};
+    if (visibility_buffer)
+    {
+        descriptors.push_back(vsg::DescriptorImage::create(
+            g_buffer->visibility->imageInfoList[0], _visibility_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE));
+    }
+    else
+    {
+        descriptors.push_back(vsg::DescriptorImage::create(
+            g_buffer->depth->imageInfoList[0], _depth_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE));
+        descriptors.push_back(vsg::DescriptorImage::create(
+            g_buffer->normal->imageInfoList[0], _normal_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE));
+        descriptors.push_back(vsg::DescriptorImage::create(
+            g_buffer->material->imageInfoList[0], _material_binding, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE));
+    }
     auto descriptor_set = vsg::DescriptorSet::create(descriptor_set_layout, descriptors);
 
     VkPushConstantRange push_constant_range;
     push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
     push_constant_range.offset = 0;
     push_constant_range.size = sizeof(RayTracingPushConstants);
-    auto pipeline_layout = vsg::PipelineLayout::create(
-        vsg::DescriptorSetLayouts{descriptor_set_layout}, vsg::PushConstantRanges{push_constant_range});
+    vsg::DescriptorSetLayouts descriptor_set_layouts{descriptor_set_layout};
+    if (visibility_buffer)
+    {
+        descriptor_set_layouts.push_back(g_buffer->scene_geometry->setLayout);
+    }
+    auto pipeline_layout
+        = vsg::PipelineLayout::create(descriptor_set_layouts, vsg::PushConstantRanges{push_constant_range});
     _bind_descriptor_set
         = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, descriptor_set);
+    if (visibility_buffer)
+    {
+        _bind_scene_geometry = g_buffer->bind_scene_geometry(pipeline_layout);
+    }
 
     _bmfr_pre_pipeline = vsg::ComputePipeline::create(pipeline_layout, pre_compute_stage);
     _bmfr_fit_pipeline = vsg::ComputePipeline::create(pipeline_layout, fit_compute_stage);
@@ -210,6 +230,10 @@ void BMFR::add_dispatch_to_command_graph(
     // pre pipeline
     command_graph->addChild(_bind_pre_pipeline);
     command_graph->addChild(_bind_descriptor_set);
+    if (_bind_scene_geometry)
+    {
+        command_graph->addChild(_bind_scene_geometry);
+    }
     command_graph->addChild(push_constants);
     command_graph->addChild(vsg::Dispatch::create(dispatch_x, dispatch_y, 1));
     command_graph->addChild(pipeline_barrier);
@@ -25,9 +25,10 @@ public:
     vsg::ref_ptr<vsg::DescriptorImage> get_final_descriptor_image() const;
 
 private:
-    uint32_t _depth_binding = 0, _normal_binding = 1, _material_binding = 2, _albedo_binding = 3, _motion_binding = 4,
-             _sample_binding = 5, _sampled_den_illu_binding = 6, _final_binding = 7, _noisy_binding = 8,
-             _denoised_binding = 9, _feature_buffer_binding = 10, _weights_binding = 11;
+    uint32_t _depth_binding = 0, _visibility_binding = 0, _normal_binding = 1, _material_binding = 2,
+             _albedo_binding = 3, _motion_binding = 4, _sample_binding = 5, _sampled_den_illu_binding = 6,
+             _final_binding = 7, _noisy_binding = 8, _denoised_binding = 9, _feature_buffer_binding = 10,
+             _weights_binding = 11;
     uint32_t _amt_of_features = 13;
 
     uint32_t _width, _height, _work_width, _work_height, _fitting_kernel, _width_padded, _height_padded;
@@ -38,4 +39,5 @@ private:
     vsg::ref_ptr<vsg::DescriptorImage> _accumulated_illumination, _final_illumination, _feature_buffer, _r_mat,
         _weights;
     vsg::ref_ptr<vsg::BindDescriptorSet> _bind_descriptor_set;
+    vsg::ref_ptr<vsg::BindDescriptorSet> _bind_scene_geometry;  // only set for a visibility g-buffer
 };
@@ -317,6 +317,12 @@ void RayTracingSceneDescriptorCreationVisitor::apply(vsg::BindDescriptorSet& bds
             _diffuse.push_back(texture);
             set_textures.insert(6);
             // check for opaqueness
+            if (bool alpha_mask = false; d->imageInfoList[0]->imageView->image->data->getValue("alpha_mask", alpha_mask))
+            {
+                // block compressed textures carry the result of the check done before compression
+                is_opaque.back() = is_opaque.back() && !alpha_mask;
+            }
+            else
             {
                 auto data = d->imageInfoList[0]->imageView->image->data;
                 // int amt = data->dataSize() / data->stride();
@@ -558,3 +564,37 @@ void RayTracingSceneDescriptorCreationVisitor::update_descriptor(
     }
     desc_set->descriptorSet->descriptors = desc_list;
 }
+void RayTracingSceneDescriptorCreationVisitor::for_each_triangle(const std::function<void(int instance,
+        int primitive, const vsg::vec3& v0, const vsg::vec3& v1, const vsg::vec3& v2)>& triangle) const
+{
+    for (int instance = 0; instance < _instances_array.size(); ++instance)
+    {
+        const ObjectInstance& object_instance = _instances_array[instance];
+        auto positions = _positions[object_instance.mesh_id]->bufferInfoList[0]->data;
+        auto indices = _indices[object_instance.mesh_id]->bufferInfoList[0]->data;
+        auto index = [&](uint32_t i) -> uint32_t {
+            if (object_instance.index_stride == 2)
+            {
+                return static_cast<uint16_t*>(indices->dataPointer())[i];
+            }
+            return static_cast<uint32_t*>(indices->dataPointer())[i];
+        };
+        auto corner = [&](uint32_t i) {
+            vsg::vec3 p = static_cast<vsg::vec3*>(positions->dataPointer())[index(i)];
+            auto t = object_instance.object_mat * vsg::vec4{p.x, p.y, p.z, 1};
+            return vsg::vec3{t.x, t.y, t.z};
+        };
+        for (int primitive = 0; primitive < indices->valueCount() / 3; ++primitive)
+        {
+            triangle(instance, primitive, corner(3 * primitive), corner(3 * primitive + 1), corner(3 * primitive + 2));
+        }
+    }
+}
+int RayTracingSceneDescriptorCreationVisitor::instance_count() const
+{
+    return static_cast<int>(_instances_array.size());
+}
+uint32_t RayTracingSceneDescriptorCreationVisitor::triangle_count(int instance) const
+{
+    return _indices[_instances_array[instance].mesh_id]->bufferInfoList[0]->data->valueCount() / 3;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vsg/all.h>
+#include <functional>
 #include <vector>
 
 class RayTracingSceneDescriptorCreationVisitor : public vsg::Visitor
@@ -28,6 +29,15 @@ public:
 
     void update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map);
 
+    // calls triangle with the instance index, the primitive index and the world space corners of every triangle in
+    // the visited scene, the indices are the ones of the tlas built from the same scene
+    void for_each_triangle(const std::function<void(int instance, int primitive, const vsg::vec3& v0,
+            const vsg::vec3& v1, const vsg::vec3& v2)>& triangle) const;
+    // number of instances in the visited scene, instance indices are the ones of the tlas
+    int instance_count() const;
+    // number of triangles of the mesh of an instance
+    uint32_t triangle_count(int instance) const;
+
     // holds the binding command for the raytracing decriptor
     std::vector<vsg::Light::PackedLight> packed_lights;
     // holds information about each geometry if it is opaque
@@ -0,0 +1,217 @@
+#include <scene/SoftwareBVH.hpp>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+// split candidates per axis of the binned sah build
+constexpr int bin_count = 16;
+// nodes with at most this many triangles are not split further
+constexpr uint32_t leaf_size = 2;
+
+struct Bounds
+{
+    vsg::vec3 min{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+        std::numeric_limits<float>::max()};
+    vsg::vec3 max{-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(),
+        -std::numeric_limits<float>::max()};
+
+    void grow(const vsg::vec3& p)
+    {
+        min = {std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z)};
+        max = {std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z)};
+    }
+    void grow(const Bounds& b)
+    {
+        if (b.empty())
+        {
+            return;
+        }
+        grow(b.min);
+        grow(b.max);
+    }
+    bool empty() const
+    {
+        return min.x > max.x;
+    }
+    // half the surface area, enough for comparing sah costs
+    float area() const
+    {
+        if (empty())
+        {
+            return 0;
+        }
+        vsg::vec3 e = max - min;
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+};
+}  // namespace
+
+SoftwareBVH::SoftwareBVH(const RayTracingSceneDescriptorCreationVisitor& scene)
+{
+    std::vector<vsg::vec3> aabb_mins, aabb_maxs;
+    scene.for_each_triangle(
+        [&](int instance, int primitive, const vsg::vec3& v0, const vsg::vec3& v1, const vsg::vec3& v2) {
+            Triangle triangle;
+            triangle.v0 = v0;
+            triangle.instance_index = instance;
+            triangle.edge1 = v1 - v0;
+            triangle.primitive_id = primitive;
+            triangle.edge2 = v2 - v0;
+            triangle.shader_offset = instance < scene.is_opaque.size() && !scene.is_opaque[instance] ? 1 : 0;
+            triangles.push_back(triangle);
+            Bounds bounds;
+            bounds.grow(v0);
+            bounds.grow(v1);
+            bounds.grow(v2);
+            aabb_mins.push_back(bounds.min);
+            aabb_maxs.push_back(bounds.max);
+        });
+    if (triangles.empty())
+    {
+        // the shaders need a root node and a non empty buffer, a degenerate triangle is never hit
+        triangles.push_back({});
+        aabb_mins.emplace_back(0, 0, 0);
+        aabb_maxs.emplace_back(0, 0, 0);
+    }
+
+    std::vector<uint32_t> order(triangles.size());
+    std::iota(order.begin(), order.end(), 0);
+    build(aabb_mins, aabb_maxs, order);
+
+    // the leaves reference the triangles in build order
+    std::vector<Triangle> ordered_triangles(triangles.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        ordered_triangles[i] = triangles[order[i]];
+    }
+    triangles = std::move(ordered_triangles);
+}
+void SoftwareBVH::update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const
+{
+    auto node_data = vsg::Array<Node>::create(nodes.size());
+    std::copy(nodes.begin(), nodes.end(), node_data->data());
+    auto triangle_data = vsg::Array<Triangle>::create(triangles.size());
+    std::copy(triangles.begin(), triangles.end(), triangle_data->data());
+
+    auto nodes_descriptor = vsg::DescriptorBuffer::create(node_data,
+        vsg::ShaderStage::getSetBindingIndex(binding_map, "BVHNodes").second, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    auto triangles_descriptor = vsg::DescriptorBuffer::create(triangle_data,
+        vsg::ShaderStage::getSetBindingIndex(binding_map, "BVHTriangles").second, 0,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    desc_set->descriptorSet->descriptors.push_back(nodes_descriptor);
+    desc_set->descriptorSet->descriptors.push_back(triangles_descriptor);
+}
+void SoftwareBVH::build(const std::vector<vsg::vec3>& aabb_mins, const std::vector<vsg::vec3>& aabb_maxs,
+    std::vector<uint32_t>& order)
+{
+    auto triangle_bounds = [&](uint32_t first, uint32_t count) {
+        Bounds bounds;
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            bounds.grow(aabb_mins[order[i]]);
+            bounds.grow(aabb_maxs[order[i]]);
+        }
+        return bounds;
+    };
+    auto centroid = [&](uint32_t triangle) { return (aabb_mins[triangle] + aabb_maxs[triangle]) * .5F; };
+    auto add_leaf = [&](uint32_t first, uint32_t count) {
+        Bounds bounds = triangle_bounds(first, count);
+        nodes.push_back({bounds.min, first, bounds.max, count});
+    };
+
+    nodes.clear();
+    nodes.reserve(2 * order.size());
+    add_leaf(0, static_cast<uint32_t>(order.size()));
+    // the leaves are split depth first, every entry is a node index with its depth
+    std::vector<std::pair<uint32_t, uint32_t>> work{{0, 0}};
+    while (!work.empty())
+    {
+        auto [node_index, depth] = work.back();
+        work.pop_back();
+        uint32_t first = nodes[node_index].left_first;
+        uint32_t count = nodes[node_index].triangle_count;
+        if (count <= leaf_size || depth >= max_depth)
+        {
+            continue;
+        }
+
+        Bounds centroid_bounds;
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            centroid_bounds.grow(centroid(order[i]));
+        }
+        // the best binned split over all axes, splitting has to be cheaper than intersecting all triangles
+        Bounds node_bounds{nodes[node_index].aabb_min, nodes[node_index].aabb_max};
+        float best_cost = count * node_bounds.area();
+        int best_axis = -1, best_split = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float extent = centroid_bounds.max[axis] - centroid_bounds.min[axis];
+            if (extent <= 0)
+            {
+                continue;
+            }
+            std::array<Bounds, bin_count> bins;
+            std::array<uint32_t, bin_count> bin_counts{};
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                uint32_t triangle = order[i];
+                int bin = std::min(
+                    static_cast<int>((centroid(triangle)[axis] - centroid_bounds.min[axis]) / extent * bin_count),
+                    bin_count - 1);
+                bins[bin].grow(aabb_mins[triangle]);
+                bins[bin].grow(aabb_maxs[triangle]);
+                ++bin_counts[bin];
+            }
+            // sweeping from the right gives the costs of all right sides, then from the left the full costs
+            std::array<float, bin_count> right_costs{};
+            Bounds right;
+            uint32_t right_count = 0;
+            for (int bin = bin_count - 1; bin > 0; --bin)
+            {
+                right.grow(bins[bin]);
+                right_count += bin_counts[bin];
+                right_costs[bin] = right_count * right.area();
+            }
+            Bounds left;
+            uint32_t left_count = 0;
+            for (int split = 1; split < bin_count; ++split)
+            {
+                left.grow(bins[split - 1]);
+                left_count += bin_counts[split - 1];
+                float cost = left_count * left.area() + right_costs[split];
+                if (left_count > 0 && left_count < count && cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_split = split;
+                }
+            }
+        }
+        if (best_axis < 0)
+        {
+            continue;
+        }
+
+        float extent = centroid_bounds.max[best_axis] - centroid_bounds.min[best_axis];
+        auto middle = std::partition(order.begin() + first, order.begin() + first + count, [&](uint32_t triangle) {
+            int bin = std::min(
+                static_cast<int>((centroid(triangle)[best_axis] - centroid_bounds.min[best_axis]) / extent * bin_count),
+                bin_count - 1);
+            return bin < best_split;
+        });
+        auto left_count = static_cast<uint32_t>(middle - (order.begin() + first));
+
+        auto left_child = static_cast<uint32_t>(nodes.size());
+        add_leaf(first, left_count);
+        add_leaf(first + left_count, count - left_count);
+        nodes[node_index].left_first = left_child;
+        nodes[node_index].triangle_count = 0;
+        work.emplace_back(left_child, depth + 1);
+        work.emplace_back(left_child + 1, depth + 1);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <scene/RayTracingVisitor.hpp>
+
+#include <vsg/all.h>
+
+#include <cstdint>
+#include <vector>
+
+// bvh over the world space triangles of a scene for the software backend of the path tracer (shaders/bvh.glsl)
+// built once on the cpu with binned sah splits. Instances are not reused, every instance adds its own triangles.
+class SoftwareBVH : public vsg::Inherit<vsg::Object, SoftwareBVH>
+{
+public:
+    // std430 layouts of BVHNode and BVHTriangle in shaders/layoutPTBVH.glsl
+    struct Node
+    {
+        vsg::vec3 aabb_min;
+        uint32_t left_first;  // first triangle of a leaf, left child of an inner node (the right one follows it)
+        vsg::vec3 aabb_max;
+        uint32_t triangle_count;  // 0 for inner nodes
+    };
+    struct Triangle
+    {
+        vsg::vec3 v0;
+        int32_t instance_index;
+        vsg::vec3 edge1;
+        int32_t primitive_id;
+        vsg::vec3 edge2;
+        uint32_t shader_offset;  // 1 for alpha tested instances like the tlas instances (see PBRTPipeline::set_tlas())
+    };
+
+    // scene has to have visited the scene graph
+    explicit SoftwareBVH(const RayTracingSceneDescriptorCreationVisitor& scene);
+
+    void update_descriptor(vsg::BindDescriptorSet* desc_set, const vsg::BindingMap& binding_map) const;
+
+    std::vector<Node> nodes;
+    std::vector<Triangle> triangles;
+
+    // deeper nodes become leaves, the traversal stack c_BVHStackSize in bvh.glsl has to hold one node per level
+    static constexpr uint32_t max_depth = 60;
+
+private:
+    void build(const std::vector<vsg::vec3>& aabb_mins, const std::vector<vsg::vec3>& aabb_maxs,
+        std::vector<uint32_t>& order);
+};
+static_assert(sizeof(SoftwareBVH::Node) == 8 * sizeof(uint32_t), "SoftwareBVH::Node has to match the shader layout");
+static_assert(
+    sizeof(SoftwareBVH::Triangle) == 12 * sizeof(uint32_t), "SoftwareBVH::Triangle has to match the shader layout");
@@ -0,0 +1,77 @@
+#include <util/GpuTimer.hpp>
+
+namespace vkpbrt
+{
+GpuTimer::GpuTimer(vsg::ref_ptr<vsg::Device> device, int queue_family, uint32_t max_timestamps)
+    : _device(device),
+      _timestamp_period(device->getPhysicalDevice()->getProperties().limits.timestampPeriod),
+      _timestamp_valid_bits(0)
+{
+    const auto& physical_device = device->getPhysicalDevice();
+    if (queue_family < 0)
+    {
+        queue_family = physical_device->getQueueFamily(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+    }
+    const auto& queue_families = physical_device->getQueueFamilyProperties();
+    if (queue_family >= 0 && static_cast<size_t>(queue_family) < queue_families.size())
+    {
+        _timestamp_valid_bits = queue_families[queue_family].timestampValidBits;
+    }
+    _query_pool = vsg::QueryPool::create();
+    _query_pool->queryType = VK_QUERY_TYPE_TIMESTAMP;
+    _query_pool->queryCount = max_timestamps;
+}
+void GpuTimer::add_begin_to_command_graph(vsg::ref_ptr<vsg::Commands> commands)
+{
+    if (!supported())
+    {
+        return;
+    }
+    commands->addChild(vsg::ResetQueryPool::create(_query_pool));
+    commands->addChild(vsg::WriteTimestamp::create(_query_pool, 0, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT));
+}
+void GpuTimer::add_timestamp_to_command_graph(vsg::ref_ptr<vsg::Commands> commands, std::string name)
+{
+    auto index = static_cast<uint32_t>(_names.size()) + 1;
+    if (index >= _query_pool->queryCount)
+    {
+        throw vsg::Exception{"Error: GpuTimer::add_timestamp_to_command_graph(...) too many timestamps."};
+    }
+    _names.push_back(std::move(name));
+    if (!supported())
+    {
+        return;
+    }
+    // bottom of pipe waits for all previously submitted work of the frame
+    commands->addChild(vsg::WriteTimestamp::create(_query_pool, index, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT));
+}
+std::vector<std::pair<std::string, double>> GpuTimer::read_results() const
+{
+    if (_names.empty() || !supported())
+    {
+        return {};
+    }
+    auto query_count = static_cast<uint32_t>(_names.size()) + 1;
+    std::vector<uint64_t> timestamps(query_count);
+    auto result = vkGetQueryPoolResults(*_device, *_query_pool, 0, query_count, timestamps.size() * sizeof(uint64_t),
+        timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result == VK_NOT_READY)
+    {
+        return {};
+    }
+    if (result != VK_SUCCESS)
+    {
+        throw vsg::Exception{"Error: GpuTimer::read_results() failed to get the query pool results.", result};
+    }
+
+    // only the valid bits count, the masked difference also stays correct if the counter wrapped between two stamps
+    uint64_t mask = _timestamp_valid_bits >= 64 ? ~uint64_t{0} : (uint64_t{1} << _timestamp_valid_bits) - 1;
+    std::vector<std::pair<std::string, double>> durations;
+    for (size_t i = 0; i < _names.size(); ++i)
+    {
+        uint64_t ticks = ((timestamps[i + 1] & mask) - (timestamps[i] & mask)) & mask;
+        durations.emplace_back(_names[i], static_cast<double>(ticks) * _timestamp_period * 1e-6);
+    }
+    return durations;
+}
+}  // namespace vkpbrt
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vsg/all.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vkpbrt
+{
+// Measures the gpu time between consecutive timestamps in a command graph, e.g. one timestamp after every render
+// module. The query pool is reset at the begin of each frame, so the results always belong to a single frame.
+// Nothing is recorded if the queue family the commands are submitted to has no timestamp support.
+class GpuTimer : public vsg::Inherit<vsg::Object, GpuTimer>
+{
+public:
+    // queue_family is the family the command graph is submitted to, -1 selects the first graphics and compute family
+    explicit GpuTimer(vsg::ref_ptr<vsg::Device> device, int queue_family = -1, uint32_t max_timestamps = 16);
+
+    // false if the queue family has no valid timestamp bits
+    bool supported() const { return _timestamp_valid_bits > 0; }
+
+    // resets the queries and writes the first timestamp, has to be added before the timed commands
+    void add_begin_to_command_graph(vsg::ref_ptr<vsg::Commands> commands);
+    // the time between the previous timestamp and this one is reported as name
+    void add_timestamp_to_command_graph(vsg::ref_ptr<vsg::Commands> commands, std::string name);
+
+    // durations in milliseconds of the last finished frame, empty if no frame has finished since the last reset
+    std::vector<std::pair<std::string, double>> read_results() const;
+
+private:
+    vsg::ref_ptr<vsg::Device> _device;
+    vsg::ref_ptr<vsg::QueryPool> _query_pool;
+    std::vector<std::string> _names;
+    double _timestamp_period;
+    uint32_t _timestamp_valid_bits;
+};
+}  // namespace vkpbrt
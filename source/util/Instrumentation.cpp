@@ -0,0 +1,190 @@
+#include <util/Instrumentation.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace vkpbrt
+{
+namespace
+{
+nlohmann::json summarize(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    auto percentile = [&](double p) {
+        return values[std::min(values.size() - 1, static_cast<size_t>(p * values.size()))];
+    };
+    nlohmann::json summary;
+    summary["count"] = values.size();
+    summary["mean"] = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+    summary["min"] = values.front();
+    summary["p50"] = percentile(.5);
+    summary["p90"] = percentile(.9);
+    summary["p95"] = percentile(.95);
+    summary["p99"] = percentile(.99);
+    summary["max"] = values.back();
+    return summary;
+}
+double peak_memory_mb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return static_cast<double>(counters.PeakWorkingSetSize) / (1024. * 1024.);
+    }
+    return 0.;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<double>(usage.ru_maxrss) / (1024. * 1024.);  // bytes
+#else
+    return static_cast<double>(usage.ru_maxrss) / 1024.;  // kilobytes
+#endif
+#endif
+}
+}  // namespace
+
+Instrumentation& Instrumentation::instance()
+{
+    static Instrumentation instrumentation;
+    return instrumentation;
+}
+void Instrumentation::enable(std::string trace_path)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _trace_path = std::move(trace_path);
+    _start = Clock::now();
+    _enabled = true;
+}
+void Instrumentation::add_event(std::string name, const char* category, Clock::time_point start, Clock::time_point end)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _events.push_back({std::move(name), category, start, end, _thread_index(std::this_thread::get_id())});
+}
+void Instrumentation::add_counter(const std::string& name, double value)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _counters[name] += value;
+}
+void Instrumentation::add_frame_time(double milliseconds)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _frame_times.push_back(milliseconds);
+}
+void Instrumentation::add_gpu_time(const std::string& name, double milliseconds)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _gpu_times[name].push_back(milliseconds);
+}
+void Instrumentation::add_frame_value(const std::string& name, double value)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _frame_values[name].push_back(value);
+}
+uint32_t Instrumentation::_thread_index(std::thread::id id)
+{
+    // small, stable thread ids make the trace viewer group the rows in creation order
+    return _threads.emplace(id, static_cast<uint32_t>(_threads.size())).first->second;
+}
+void Instrumentation::write() const
+{
+    if (!_enabled)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto to_us = [&](Clock::time_point t) {
+        return std::chrono::duration<double, std::micro>(t - _start).count();
+    };
+
+    nlohmann::json trace;
+    auto& trace_events = trace["traceEvents"] = nlohmann::json::array();
+    for (const auto& event : _events)
+    {
+        trace_events.push_back({{"name", event.name}, {"cat", event.category}, {"ph", "X"}, {"pid", 0},
+            {"tid", event.thread}, {"ts", to_us(event.start)}, {"dur", to_us(event.end) - to_us(event.start)}});
+    }
+    trace["displayTimeUnit"] = "ms";
+    trace["counters"] = _counters;
+
+    std::cout << "Instrumentation:" << std::endl;
+    for (const auto& [name, value] : _counters)
+    {
+        std::cout << "  " << name << ": " << value << std::endl;
+    }
+    if (!_frame_times.empty())
+    {
+        trace["frameTimes"] = summarize(_frame_times);
+        std::cout << "  frame time ms: " << trace["frameTimes"].dump() << std::endl;
+    }
+    for (const auto& [name, times] : _gpu_times)
+    {
+        trace["gpuTimes"][name] = summarize(times);
+        std::cout << "  gpu " << name << " ms: " << trace["gpuTimes"][name].dump() << std::endl;
+    }
+    for (const auto& [name, values] : _frame_values)
+    {
+        trace["frameValues"][name] = values;
+        std::cout << "  " << name << " per frame: " << summarize(values).dump() << std::endl;
+    }
+    trace["peakMemoryMB"] = peak_memory_mb();
+    std::cout << "  peak memory MB: " << trace["peakMemoryMB"] << std::endl;
+
+    std::ofstream file(_trace_path);
+    file << trace.dump(1);
+    if (!file)
+    {
+        std::cerr << "Failed to write trace file " << _trace_path << "." << std::endl;
+        return;
+    }
+    std::cout << "Trace written to " << _trace_path << std::endl;
+}
+
+ScopedTimer::ScopedTimer(std::string name, const char* category)
+    : _name(std::move(name)), _category(category), _start(Instrumentation::Clock::now())
+{
+}
+ScopedTimer::~ScopedTimer()
+{
+    auto& instrumentation = Instrumentation::instance();
+    if (instrumentation.enabled())
+    {
+        instrumentation.add_event(std::move(_name), _category, _start, Instrumentation::Clock::now());
+    }
+}
+}  // namespace vkpbrt
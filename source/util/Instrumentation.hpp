@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vkpbrt
+{
+// Lightweight per run instrumentation: timed events, counters and frame times.
+// Recording is off until enable() is called, after that ScopedTimer and the add_*() calls are collected and write()
+// stores them as a Chrome trace (chrome://tracing, ui.perfetto.dev). The counters, the frame and gpu time percentiles
+// and the peak memory are written to the same JSON file under "counters", "frameTimes", "gpuTimes" and
+// "peakMemoryMB", so runs can be diffed. Per output frame values are written unsummarized under "frameValues".
+class Instrumentation
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static Instrumentation& instance();
+
+    void enable(std::string trace_path);
+    bool enabled() const { return _enabled; }
+
+    void add_event(std::string name, const char* category, Clock::time_point start, Clock::time_point end);
+    // counters accumulate, e.g. bytes read by all import threads
+    void add_counter(const std::string& name, double value);
+    void add_frame_time(double milliseconds);
+    void add_gpu_time(const std::string& name, double milliseconds);
+    // one value per output frame, e.g. the samples a frame needed to converge
+    void add_frame_value(const std::string& name, double value);
+
+    // writes the trace file and prints the counters and frame time percentiles
+    void write() const;
+
+private:
+    struct Event
+    {
+        std::string name;
+        const char* category;
+        Clock::time_point start, end;
+        uint32_t thread;
+    };
+
+    uint32_t _thread_index(std::thread::id id);
+
+    std::atomic<bool> _enabled{false};
+    std::string _trace_path;
+    Clock::time_point _start = Clock::now();
+    mutable std::mutex _mutex;
+    std::vector<Event> _events;
+    std::map<std::string, double> _counters;
+    std::vector<double> _frame_times;
+    std::map<std::string, std::vector<double>> _gpu_times;
+    std::map<std::string, std::vector<double>> _frame_values;
+    std::map<std::thread::id, uint32_t> _threads;
+};
+
+// records the time between construction and destruction as an event
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(std::string name, const char* category = "cpu");
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    std::string _name;
+    const char* _category;
+    Instrumentation::Clock::time_point _start;
+};
+}  // namespace vkpbrt
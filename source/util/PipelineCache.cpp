@@ -0,0 +1,151 @@
+#include <util/PipelineCache.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace vkpbrt
+{
+namespace
+{
+const uint32_t pipeline_cache_magic = 0x43505256;  // "VRPC"
+const uint32_t pipeline_cache_version = 1;
+
+struct PipelineCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t device_uuid[VK_UUID_SIZE];
+    uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+    uint64_t data_size;
+    uint64_t data_hash;
+};
+
+uint64_t hash_bytes(const std::vector<char>& data)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : data)
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+PipelineCacheHeader device_header(vsg::Device* device)
+{
+    auto physical_device = device->getPhysicalDevice();
+    const auto& properties = physical_device->getProperties();
+    using IDProperties = VkPhysicalDeviceIDProperties;
+    auto id_properties
+        = physical_device->getProperties<IDProperties, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES>();
+
+    PipelineCacheHeader header{};
+    header.magic = pipeline_cache_magic;
+    header.version = pipeline_cache_version;
+    header.vendor_id = properties.vendorID;
+    header.device_id = properties.deviceID;
+    header.driver_version = properties.driverVersion;
+    std::memcpy(header.device_uuid, id_properties.deviceUUID, VK_UUID_SIZE);
+    std::memcpy(header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    return header;
+}
+
+// returns the cache data stored in cache_path, empty if the file is missing, corrupt or from another device/driver
+std::vector<char> read_cache_data(const vsg::Path& cache_path, const PipelineCacheHeader& expected)
+{
+    std::ifstream file(cache_path, std::ios::binary);
+    if (!file)
+    {
+        return {};
+    }
+    PipelineCacheHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != expected.magic || header.version != expected.version
+        || header.vendor_id != expected.vendor_id || header.device_id != expected.device_id
+        || header.driver_version != expected.driver_version
+        || std::memcmp(header.device_uuid, expected.device_uuid, VK_UUID_SIZE) != 0
+        || std::memcmp(header.pipeline_cache_uuid, expected.pipeline_cache_uuid, VK_UUID_SIZE) != 0)
+    {
+        std::cout << "Pipeline cache " << cache_path << " was created for another device or driver, ignoring it."
+                  << std::endl;
+        return {};
+    }
+    std::vector<char> data(header.data_size);
+    file.read(data.data(), data.size());
+    if (!file || hash_bytes(data) != header.data_hash)
+    {
+        std::cout << "Pipeline cache " << cache_path << " is corrupt, ignoring it." << std::endl;
+        return {};
+    }
+    return data;
+}
+}  // namespace
+
+PipelineCache::PipelineCache(vsg::ref_ptr<vsg::Device> device, vsg::Path cache_path)
+    : _device(device), _cache_path(std::move(cache_path))
+{
+    auto initial_data = read_cache_data(_cache_path, device_header(_device));
+
+    VkPipelineCacheCreateInfo create_info{};
+    create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    create_info.initialDataSize = initial_data.size();
+    create_info.pInitialData = initial_data.empty() ? nullptr : initial_data.data();
+    VkResult result
+        = vkCreatePipelineCache(*_device, &create_info, _device->getAllocationCallbacks(), &_pipeline_cache);
+    if (result != VK_SUCCESS)
+    {
+        throw vsg::Exception{"Error: PipelineCache::PipelineCache(...) failed to create VkPipelineCache.", result};
+    }
+    _device->pipelineCache = _pipeline_cache;
+    std::cout << "Pipeline cache " << _cache_path << ": loaded " << initial_data.size() << " bytes" << std::endl;
+}
+PipelineCache::~PipelineCache()
+{
+    if (_device->pipelineCache == _pipeline_cache)
+    {
+        _device->pipelineCache = VK_NULL_HANDLE;
+    }
+    vkDestroyPipelineCache(*_device, _pipeline_cache, _device->getAllocationCallbacks());
+}
+void PipelineCache::save() const
+{
+    size_t data_size = 0;
+    vkGetPipelineCacheData(*_device, _pipeline_cache, &data_size, nullptr);
+    std::vector<char> data(data_size);
+    if (vkGetPipelineCacheData(*_device, _pipeline_cache, &data_size, data.data()) != VK_SUCCESS)
+    {
+        std::cerr << "Failed to retrieve the pipeline cache data." << std::endl;
+        return;
+    }
+    data.resize(data_size);
+
+    auto header = device_header(_device);
+    header.data_size = data.size();
+    header.data_hash = hash_bytes(data);
+
+    // write to a temporary file and rename it, so a concurrently starting process never reads a partial cache
+    std::random_device random;
+    auto temp_path = _cache_path + "." + std::to_string(random()) + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(data.data(), data.size());
+        if (!file)
+        {
+            std::cerr << "Failed to write pipeline cache " << temp_path << "." << std::endl;
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp_path, _cache_path, error);
+    if (error)
+    {
+        std::cerr << "Failed to write pipeline cache " << _cache_path << ": " << error.message() << std::endl;
+        std::filesystem::remove(temp_path, error);
+    }
+}
+}  // namespace vkpbrt
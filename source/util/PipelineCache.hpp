@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vsg/all.h>
+
+namespace vkpbrt
+{
+// Persistent VkPipelineCache shared by all pipelines created on a device.
+// The cache file starts with a header holding the device and pipeline cache UUIDs and the driver version, a file
+// written with a different device or driver is discarded instead of being handed to the driver.
+class PipelineCache : public vsg::Inherit<vsg::Object, PipelineCache>
+{
+public:
+    // Creates the pipeline cache, seeded with the content of cache_path if it matches the device, and sets it as
+    // device->pipelineCache so every pipeline compiled afterwards uses it.
+    PipelineCache(vsg::ref_ptr<vsg::Device> device, vsg::Path cache_path);
+
+    // writes the current cache content to the cache path
+    void save() const;
+
+protected:
+    ~PipelineCache() override;
+
+private:
+    vsg::ref_ptr<vsg::Device> _device;
+    vsg::Path _cache_path;
+    VkPipelineCache _pipeline_cache = VK_NULL_HANDLE;
+};
+}  // namespace vkpbrt
@@ -0,0 +1,159 @@
+#include <util/ShaderCache.hpp>
+#include <util/Instrumentation.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+namespace vkpbrt
+{
+namespace
+{
+// bump when the key layout changes or the shader compiler is updated
+const uint32_t shader_cache_version = 1;
+const uint32_t spirv_magic = 0x07230203;
+
+uint64_t hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+    auto bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+template<class T>
+uint64_t hash_value(uint64_t hash, const T& value)
+{
+    return hash_bytes(hash, &value, sizeof(value));
+}
+uint64_t hash_string(uint64_t hash, const std::string& str)
+{
+    hash = hash_value(hash, str.size());
+    return hash_bytes(hash, str.data(), str.size());
+}
+
+std::string cache_key(const vsg::ShaderStage& shader_stage, const vsg::ShaderCompileSettings& settings)
+{
+    uint64_t hash = 14695981039346656037ull;
+    hash = hash_value(hash, shader_cache_version);
+    hash = hash_value(hash, shader_stage.stage);
+    hash = hash_value(hash, settings.vulkanVersion);
+    hash = hash_value(hash, settings.clientInputVersion);
+    hash = hash_value(hash, settings.language);
+    hash = hash_value(hash, settings.defaultVersion);
+    hash = hash_value(hash, settings.target);
+    hash = hash_value(hash, settings.forwardCompatible);
+    hash = hash_value(hash, settings.defines.size());
+    for (const auto& define : settings.defines)
+    {
+        hash = hash_string(hash, define);
+    }
+    hash = hash_string(hash, shader_stage.module->source);
+
+    std::stringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return key.str();
+}
+
+bool read_spirv(const std::filesystem::path& path, vsg::ShaderModule::SPIRV& code)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    size_t size = file.tellg();
+    if (size == 0 || size % sizeof(uint32_t) != 0)
+    {
+        return false;
+    }
+    code.resize(size / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(code.data()), size);
+    return file && code[0] == spirv_magic;
+}
+
+void write_spirv(const std::filesystem::path& path, const vsg::ShaderModule::SPIRV& code)
+{
+    // write to a unique temporary file first, renaming it is atomic so concurrent readers never see partial entries
+    std::random_device random;
+    auto temp_path = path;
+    temp_path += "." + std::to_string(random()) + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(code.data()), code.size() * sizeof(uint32_t));
+        if (!file)
+        {
+            std::cerr << "Failed to write shader cache entry " << temp_path << "." << std::endl;
+            std::filesystem::remove(temp_path);
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    if (error)
+    {
+        // another process stored the same entry in the meantime
+        std::filesystem::remove(temp_path, error);
+    }
+}
+}  // namespace
+
+vsg::ref_ptr<ShaderCache> ShaderCache::global;
+
+ShaderCache::ShaderCache(vsg::Path cache_directory) : _cache_directory(std::move(cache_directory))
+{
+    std::error_code error;
+    std::filesystem::create_directories(_cache_directory, error);
+    if (error)
+    {
+        throw vsg::Exception{"Error: ShaderCache::ShaderCache(...) could not create cache directory " + _cache_directory
+                             + ": " + error.message()};
+    }
+}
+bool ShaderCache::compile(vsg::ref_ptr<vsg::ShaderStage> shader_stage)
+{
+    auto& module = shader_stage->module;
+    if (!module || !module->code.empty() || module->source.empty())
+    {
+        return true;
+    }
+
+    ScopedTimer timer("shader compile", "shader");
+    auto settings = module->hints ? module->hints : vsg::ShaderCompileSettings::create();
+    auto entry_path = std::filesystem::path(_cache_directory) / (cache_key(*shader_stage, *settings) + ".spv");
+    if (read_spirv(entry_path, module->code))
+    {
+        ++_hits;
+        Instrumentation::instance().add_counter("shader_cache.hits", 1);
+        return true;
+    }
+    module->code.clear();
+    ++_misses;
+    Instrumentation::instance().add_counter("shader_cache.misses", 1);
+
+    auto shader_compiler = vsg::ShaderCompiler::create();
+    if (!shader_compiler->compile(shader_stage))
+    {
+        return false;
+    }
+    write_spirv(entry_path, module->code);
+    return true;
+}
+void ShaderCache::print_statistics() const
+{
+    std::cout << "Shader cache " << _cache_directory << ": " << _hits << " hits, " << _misses << " misses"
+              << std::endl;
+}
+
+void compile_shader(vsg::ref_ptr<vsg::ShaderStage> shader_stage)
+{
+    if (ShaderCache::global && !ShaderCache::global->compile(shader_stage))
+    {
+        throw vsg::Exception{"Error: compile_shader(...) failed to compile shader."};
+    }
+}
+}  // namespace vkpbrt
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vsg/all.h>
+
+#include <atomic>
+
+namespace vkpbrt
+{
+// Content addressed on-disk cache for the SPIR-V of shaders which are compiled from glsl at runtime.
+// Entries are keyed by the include expanded source, the defines, the shader stage and the compile settings, so
+// every shader permutation gets its own entry and editing a shader never hits stale code.
+// Entries are written to a temporary file and renamed into place, so several processes can share one directory.
+class ShaderCache : public vsg::Inherit<vsg::Object, ShaderCache>
+{
+public:
+    explicit ShaderCache(vsg::Path cache_directory);
+
+    // Fills in the SPIR-V of a shader stage read from glsl, either from the cache or by compiling it with glslang
+    // and storing the result. Stages which already contain SPIR-V are left untouched.
+    bool compile(vsg::ref_ptr<vsg::ShaderStage> shader_stage);
+
+    uint32_t hits() const { return _hits; }
+    uint32_t misses() const { return _misses; }
+    void print_statistics() const;
+
+    // process wide cache used by compile_shader(), caching is disabled if not set
+    static vsg::ref_ptr<ShaderCache> global;
+
+private:
+    vsg::Path _cache_directory;
+    std::atomic<uint32_t> _hits{0}, _misses{0};
+};
+
+// Compiles the shader stage through the global shader cache, if there is one. Otherwise the stage is left to be
+// compiled by vsg when it is first used.
+void compile_shader(vsg::ref_ptr<vsg::ShaderStage> shader_stage);
+}  // namespace vkpbrt
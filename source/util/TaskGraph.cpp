@@ -0,0 +1,166 @@
+#include <util/TaskGraph.hpp>
+#include <util/Instrumentation.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace vkpbrt
+{
+TaskGraph::TaskId TaskGraph::add(
+    std::string name, std::function<void()> func, std::vector<TaskId> dependencies, bool main_thread)
+{
+    TaskId id = _tasks.size();
+    for (auto dependency : dependencies)
+    {
+        if (dependency >= id)
+        {
+            throw std::invalid_argument("TaskGraph::add(...) dependency on a task that was not added before");
+        }
+        _tasks[dependency].dependents.push_back(id);
+    }
+    Task task;
+    task.name = std::move(name);
+    task.func = std::move(func);
+    task.open_dependencies = dependencies.size();
+    task.dependencies = std::move(dependencies);
+    task.main_thread = main_thread;
+    _tasks.push_back(std::move(task));
+    return id;
+}
+void TaskGraph::run()
+{
+    std::mutex mutex;
+    std::condition_variable ready_condition;
+    std::deque<TaskId> ready_main, ready_worker;
+    size_t finished = 0;
+    std::exception_ptr error;
+
+    for (TaskId id = 0; id < _tasks.size(); ++id)
+    {
+        if (_tasks[id].open_dependencies == 0)
+        {
+            (_tasks[id].main_thread ? ready_main : ready_worker).push_back(id);
+        }
+    }
+
+    auto graph_start = Clock::now();
+    // pulls tasks from the given queue until every task has finished
+    auto process = [&](std::deque<TaskId>& queue) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            ready_condition.wait(lock, [&] { return !queue.empty() || finished == _tasks.size(); });
+            if (queue.empty())
+            {
+                return;
+            }
+            TaskId id = queue.front();
+            queue.pop_front();
+            auto& task = _tasks[id];
+            bool skip = static_cast<bool>(error);
+            lock.unlock();
+
+            task.start = Clock::now();
+            if (!skip)
+            {
+                try
+                {
+                    task.func();
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> error_lock(mutex);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+            }
+            task.end = Clock::now();
+            if (!skip)
+            {
+                Instrumentation::instance().add_event(task.name, "startup", task.start, task.end);
+            }
+
+            lock.lock();
+            ++finished;
+            for (auto dependent : task.dependents)
+            {
+                auto& dependent_task = _tasks[dependent];
+                if (--dependent_task.open_dependencies == 0)
+                {
+                    (dependent_task.main_thread ? ready_main : ready_worker).push_back(dependent);
+                }
+            }
+            ready_condition.notify_all();
+        }
+    };
+
+    size_t worker_tasks = std::count_if(_tasks.begin(), _tasks.end(), [](const Task& t) { return !t.main_thread; });
+    size_t worker_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), worker_tasks);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < worker_count; ++i)
+    {
+        workers.emplace_back(process, std::ref(ready_worker));
+    }
+    process(ready_main);
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+    log_timings(graph_start);
+}
+void TaskGraph::log_timings(Clock::time_point graph_start) const
+{
+    auto to_ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+    std::stringstream log;  // not formatting std::cout directly keeps its flags untouched
+    log << "Startup phases:" << std::endl;
+    TaskId last = 0;
+    for (TaskId id = 0; id < _tasks.size(); ++id)
+    {
+        const auto& task = _tasks[id];
+        log << "  " << std::left << std::setw(24) << task.name << std::right << " start " << std::setw(9)
+            << std::fixed << std::setprecision(1) << to_ms(task.start - graph_start) << " ms, took " << std::setw(9)
+            << to_ms(task.end - task.start) << " ms" << std::endl;
+        if (task.end > _tasks[last].end)
+        {
+            last = id;
+        }
+    }
+    if (_tasks.empty())
+    {
+        std::cout << log.str();
+        return;
+    }
+
+    // the critical path ends at the last task and follows the dependency which finished latest
+    std::vector<TaskId> critical_path{last};
+    while (!_tasks[critical_path.back()].dependencies.empty())
+    {
+        const auto& dependencies = _tasks[critical_path.back()].dependencies;
+        critical_path.push_back(*std::max_element(dependencies.begin(), dependencies.end(),
+            [&](TaskId a, TaskId b) { return _tasks[a].end < _tasks[b].end; }));
+    }
+    log << "  critical path (" << to_ms(_tasks[last].end - graph_start) << " ms):";
+    for (auto it = critical_path.rbegin(); it != critical_path.rend(); ++it)
+    {
+        log << (it == critical_path.rbegin() ? " " : " -> ") << _tasks[*it].name;
+    }
+    log << std::endl;
+    std::cout << log.str();
+}
+}  // namespace vkpbrt
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace vkpbrt
+{
+// Runs a set of tasks with dependencies on a pool of threads, each task starts as soon as all of its dependencies
+// have finished. Tasks which have to stay on the calling thread (e.g. window creation) are flagged as main thread
+// tasks. After run() the start and duration of every task and the critical path are logged.
+class TaskGraph
+{
+public:
+    using TaskId = size_t;
+
+    TaskId add(std::string name, std::function<void()> func, std::vector<TaskId> dependencies = {},
+        bool main_thread = false);
+
+    // executes all tasks and blocks until they are done. The first exception thrown by a task is rethrown after all
+    // running tasks have finished, tasks which had not started when it was thrown are skipped.
+    void run();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct Task
+    {
+        std::string name;
+        std::function<void()> func;
+        std::vector<TaskId> dependencies;
+        std::vector<TaskId> dependents;
+        bool main_thread;
+        size_t open_dependencies = 0;
+        Clock::time_point start, end;
+    };
+
+    void log_timings(Clock::time_point graph_start) const;
+
+    std::vector<Task> _tasks;
+};
+}  // namespace vkpbrt